@@ -12,6 +12,12 @@ if(CUBBYFLOW_WARNINGS_AS_ERRORS)
 	endif()
 endif()
 
+# Store particle neighbor indices as 32-bit integers
+option(CUBBYFLOW_32BIT_NEIGHBOR_INDEX "Use 32-bit indices for particle neighbor lists" OFF)
+if(CUBBYFLOW_32BIT_NEIGHBOR_INDEX)
+	add_definitions(-DCUBBYFLOW_32BIT_NEIGHBOR_INDEX)
+endif()
+
 # Get upper case system name
 string(TOUPPER ${CMAKE_SYSTEM_NAME} SYSTEM_NAME_UPPER)
 
@@ -0,0 +1,16 @@
+/*************************************************************************
+> File Name: FastSweepingLevelSetSolver.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: FastSweepingLevelSetSolver functions for CubbyFlow Python API.
+> Created Time: 2018/06/18
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_PYTHON_FAST_SWEEPING_LEVEL_SET_SOLVER_H
+#define CUBBYFLOW_PYTHON_FAST_SWEEPING_LEVEL_SET_SOLVER_H
+
+#include <pybind11/pybind11.h>
+
+void AddFastSweepingLevelSetSolver3(pybind11::module& m);
+
+#endif
\ No newline at end of file
@@ -14,7 +14,11 @@
 #include <Core/Utils/Parallel.h>
 #include <Core/Utils/TypeHelpers.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <type_traits>
 
 namespace CubbyFlow
 {
@@ -78,6 +82,53 @@ namespace CubbyFlow
 		});
 	}
 
+	template <typename ArrayType1, typename ArrayType2>
+	auto DotRange1(const ArrayType1& a, const ArrayType2& b, size_t size)
+	{
+		using ValueType = std::decay_t<decltype(a[0] * b[0])>;
+
+		return ParallelDeterministicReduce(ZERO_SIZE, size, ValueType(0),
+			[&](size_t start, size_t end, ValueType init)
+		{
+			ValueType result = init;
+
+			for (size_t i = start; i < end; ++i)
+			{
+				result += a[i] * b[i];
+			}
+
+			return result;
+		}, std::plus<ValueType>());
+	}
+
+	template <typename ArrayType>
+	auto L2NormRange1(const ArrayType& a, size_t size)
+	{
+		return std::sqrt(DotRange1(a, a, size));
+	}
+
+	template <typename ArrayType>
+	auto LInfNormRange1(const ArrayType& a, size_t size)
+	{
+		using ValueType = std::decay_t<decltype(a[0])>;
+
+		return ParallelDeterministicReduce(ZERO_SIZE, size, ValueType(0),
+			[&](size_t start, size_t end, ValueType init)
+		{
+			ValueType result = init;
+
+			for (size_t i = start; i < end; ++i)
+			{
+				result = std::max(result, std::abs(a[i]));
+			}
+
+			return result;
+		}, [](ValueType x, ValueType y)
+		{
+			return std::max(x, y);
+		});
+	}
+
 	template <typename T>
 	void ExtrapolateToRegion(const ConstArrayAccessor2<T>& input, const ConstArrayAccessor2<char>& valid, unsigned int numberOfIterations, ArrayAccessor2<T> output)
 	{
@@ -97,7 +148,9 @@ namespace CubbyFlow
 
 		for (unsigned int iter = 0; iter < numberOfIterations; ++iter)
 		{
-			valid0.ForEachIndex([&](size_t i, size_t j)
+			// Only the invalid cells are written and only the valid cells are
+			// read, so the cells are independent within an iteration.
+			valid0.ParallelForEachIndex([&](size_t i, size_t j)
 			{
 				T sum = Zero<T>();
 				unsigned int count = 0;
@@ -163,7 +216,9 @@ namespace CubbyFlow
 
 		for (unsigned int iter = 0; iter < numberOfIterations; ++iter)
 		{
-			valid0.ForEachIndex([&](size_t i, size_t j, size_t k)
+			// Only the invalid cells are written and only the valid cells are
+			// read, so the cells are independent within an iteration.
+			valid0.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
 			{
 				T sum = Zero<T>();
 				unsigned int count = 0;
@@ -94,6 +94,35 @@ namespace CubbyFlow
 	template <typename ArrayType1, typename ArrayType2>
 	void CopyRange3(const ArrayType1& input, size_t beginX, size_t endX, size_t beginY, size_t endY, size_t beginZ, size_t endZ, ArrayType2* output);
 
+	//!
+	//! \brief Returns the dot product of 1-D arrays \p a and \p b with \p size.
+	//!
+	//! This function computes the dot product in parallel with a fixed
+	//! partition (see ParallelDeterministicReduce), so the result does not
+	//! change from run to run. The arrays must support random access operator [].
+	//!
+	template <typename ArrayType1, typename ArrayType2>
+	auto DotRange1(const ArrayType1& a, const ArrayType2& b, size_t size);
+
+	//!
+	//! \brief Returns the L2 norm of 1-D array \p a with \p size.
+	//!
+	//! This function computes the norm in parallel with a fixed partition, so
+	//! the result does not change from run to run. The array must support
+	//! random access operator [].
+	//!
+	template <typename ArrayType>
+	auto L2NormRange1(const ArrayType& a, size_t size);
+
+	//!
+	//! \brief Returns the L-inf norm of 1-D array \p a with \p size.
+	//!
+	//! This function computes the largest absolute value in parallel. The array
+	//! must support random access operator [].
+	//!
+	template <typename ArrayType>
+	auto LInfNormRange1(const ArrayType& a, size_t size);
+
 	//!
 	//! \brief Extrapolates 2-D input data from 'valid' (1) to 'invalid' (0) region.
 	//!
@@ -9,6 +9,7 @@
 #ifndef CUBBYFLOW_COLLIDER3_H
 #define CUBBYFLOW_COLLIDER3_H
 
+#include <Core/Array/Array1.h>
 #include <Core/Surface/Surface3.h>
 
 #include <functional>
@@ -54,6 +55,20 @@ namespace CubbyFlow
 		//!
 		void ResolveCollision(double radius, double restitutionCoefficient, Vector3D* position, Vector3D* velocity);
 
+		//!
+		//! \brief Resolves collisions for given points.
+		//!
+		//! This function gives the same results as calling ResolveCollision for
+		//! each point. The closest points on a TriangleMesh3 surface are found
+		//! with a single batched query. See TriangleMesh3::ClosestPoints.
+		//!
+		//! \param radius Radius of the colliding points.
+		//! \param restitutionCoefficient Defines the restitution effect.
+		//! \param positions Input and output positions of the points.
+		//! \param velocities Input and output velocities of the points.
+		//!
+		void ResolveCollisions(double radius, double restitutionCoefficient, ArrayAccessor1<Vector3D> positions, ArrayAccessor1<Vector3D> velocities);
+
 		//! Returns friction coefficient.
 		double GetFrictionCoefficient() const;
 
@@ -99,10 +114,16 @@ namespace CubbyFlow
 		//! Outputs closest point's information.
 		void GetClosestPoint(const Surface3Ptr& surface, const Vector3D& queryPoint, ColliderQueryResult* result) const;
 
+		//! Outputs closest points' information for given \p queryPoints.
+		void GetClosestPoints(const Surface3Ptr& surface, const ConstArrayAccessor1<Vector3D>& queryPoints, Array1<ColliderQueryResult>* results) const;
+
 		//! Returns true if given point is in the opposite side of the surface.
 		bool IsPenetrating(const ColliderQueryResult& colliderPoint, const Vector3D& position, double radius);
 
 	private:
+		//! Resolves collision for given point and its closest point's information.
+		void ResolveCollision(const ColliderQueryResult& colliderPoint, double radius, double restitutionCoefficient, Vector3D* position, Vector3D* velocity);
+
 		Surface3Ptr m_surface;
 		double m_frictionCoeffient = 0.0;
 		OnBeginUpdateCallback m_onUpdateCallback;
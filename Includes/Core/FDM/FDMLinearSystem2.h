@@ -89,7 +89,8 @@ namespace CubbyFlow
 		//! Copies entire element of given matrix \p result with other matrix \p v.
 		static void Set(const MatrixType& m, MatrixType* result);
 
-		//! Performs dot product with vector \p a and \p b.
+		//! Performs dot product with vector \p a and \p b. The sum is computed in
+		//! parallel with a fixed partition, so the result is reproducible.
 		static double Dot(const VectorType& a, const VectorType& b);
 
 		//! Performs ax + y operation where \p a is a matrix and \p x and \p y are vectors.
@@ -127,7 +128,8 @@ namespace CubbyFlow
 		//! Copies entire element of given matrix \p result with other matrix \p v.
 		static void Set(const MatrixType& m, MatrixType* result);
 
-		//! Performs dot product with vector \p a and \p b.
+		//! Performs dot product with vector \p a and \p b. The sum is computed in
+		//! parallel with a fixed partition, so the result is reproducible.
 		static double Dot(const VectorType& a, const VectorType& b);
 
 		//! Performs ax + y operation where \p a is a matrix and \p x and \p y are vectors.
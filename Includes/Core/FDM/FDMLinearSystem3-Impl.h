@@ -0,0 +1,78 @@
+/*************************************************************************
+> File Name: FDMLinearSystem3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Linear system (Ax=b) for 3-D finite differencing.
+> Created Time: 2017/08/12
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_FDM_LINEAR_SYSTEM3_IMPL_H
+#define CUBBYFLOW_FDM_LINEAR_SYSTEM3_IMPL_H
+
+namespace CubbyFlow
+{
+	// The row functions are inlined, so the stencil kernels and the
+	// preconditioners only evaluate the coefficients they use.
+	inline Size3 FDMMatrixFree3::size() const
+	{
+		return markers.size();
+	}
+
+	inline FDMMatrixRow3 FDMMatrixFree3::operator()(size_t i, size_t j, size_t k) const
+	{
+		const Size3 n = markers.size();
+		FDMMatrixRow3 row;
+
+		if (markers(i, j, k) != FLUID)
+		{
+			row.center = 1.0;
+			return row;
+		}
+
+		if (i + 1 < n.x && markers(i + 1, j, k) != BOUNDARY)
+		{
+			row.center += invHSqr.x;
+			if (markers(i + 1, j, k) == FLUID)
+			{
+				row.right -= invHSqr.x;
+			}
+		}
+
+		if (i > 0 && markers(i - 1, j, k) != BOUNDARY)
+		{
+			row.center += invHSqr.x;
+		}
+
+		if (j + 1 < n.y && markers(i, j + 1, k) != BOUNDARY)
+		{
+			row.center += invHSqr.y;
+			if (markers(i, j + 1, k) == FLUID)
+			{
+				row.up -= invHSqr.y;
+			}
+		}
+
+		if (j > 0 && markers(i, j - 1, k) != BOUNDARY)
+		{
+			row.center += invHSqr.y;
+		}
+
+		if (k + 1 < n.z && markers(i, j, k + 1) != BOUNDARY)
+		{
+			row.center += invHSqr.z;
+			if (markers(i, j, k + 1) == FLUID)
+			{
+				row.front -= invHSqr.z;
+			}
+		}
+
+		if (k > 0 && markers(i, j, k - 1) != BOUNDARY)
+		{
+			row.center += invHSqr.z;
+		}
+
+		return row;
+	}
+}
+
+#endif
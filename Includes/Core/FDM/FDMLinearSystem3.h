@@ -12,6 +12,7 @@
 #include <Core/Array/Array3.h>
 #include <Core/Matrix/MatrixCSR.h>
 #include <Core/Size/Size3.h>
+#include <Core/Vector/Vector3.h>
 #include <Core/Vector/VectorN.h>
 
 namespace CubbyFlow
@@ -38,6 +39,63 @@ namespace CubbyFlow
 	//! Matrix type for 3-D finite differencing.
 	using FDMMatrix3 = Array3<FDMMatrixRow3>;
 
+	//! Single precision row of FDMMatrix3F, see FDMMatrixRow3.
+	struct FDMMatrixRow3F
+	{
+		//! Diagonal component of the matrix (row, row).
+		float center = 0.0f;
+
+		//! Off-diagonal element where column refers to (i+1, j, k) grid point.
+		float right = 0.0f;
+
+		//! Off-diagonal element where column refers to (i, j+1, k) grid point.
+		float up = 0.0f;
+
+		//! Off-diagonal element where column refers to (i, j, k+1) grid point.
+		float front = 0.0f;
+	};
+
+	//! Single precision vector type for 3-D finite differencing.
+	using FDMVector3F = Array3<float>;
+
+	//! Single precision matrix type for 3-D finite differencing.
+	using FDMMatrix3F = Array3<FDMMatrixRow3F>;
+
+	//!
+	//! \brief Matrix-free Poisson matrix for 3-D finite differencing.
+	//!
+	//! This matrix stores no coefficients. The rows are derived on the fly from
+	//! the cell markers and the grid spacing, in the same way as the rows of
+	//! the single-phase pressure system: a fluid cell couples with its non
+	//! boundary neighbors, and any other cell has identity row. Compared to
+	//! FDMMatrix3, it only reads one byte per cell instead of four doubles.
+	//! The marker values below are the ones GridSinglePhasePressureSolver3
+	//! builds its markers with; the solver uses these definitions.
+	//!
+	struct FDMMatrixFree3
+	{
+		//! Marker of a fluid cell.
+		static constexpr char FLUID = 0;
+
+		//! Marker of an air cell.
+		static constexpr char AIR = 1;
+
+		//! Marker of a boundary cell.
+		static constexpr char BOUNDARY = 2;
+
+		//! The cell markers.
+		ConstArrayAccessor3<char> markers;
+
+		//! The inverse of the squared grid spacing.
+		Vector3D invHSqr;
+
+		//! Returns the size of the matrix grid.
+		Size3 size() const;
+
+		//! Returns the row where row corresponds to (i, j, k) grid point.
+		FDMMatrixRow3 operator()(size_t i, size_t j, size_t k) const;
+	};
+
 	//! Linear system (Ax=b) for 3-D finite differencing.
 	struct FDMLinearSystem3
 	{
@@ -73,6 +131,25 @@ namespace CubbyFlow
 		void Clear();
 	};
 
+	//! Matrix-free linear system (Ax=b) for 3-D finite differencing.
+	struct FDMMatrixFreeLinearSystem3
+	{
+		//! System matrix.
+		FDMMatrixFree3 A;
+
+		//! Solution vector.
+		FDMVector3 x;
+
+		//! RHS vector.
+		FDMVector3 b;
+
+		//! Clears all the data.
+		void Clear();
+
+		//! Resizes the vectors with given grid size.
+		void Resize(const Size3& size);
+	};
+
 	//! BLAS operator wrapper for 3-D finite differencing.
 	struct FDMBLAS3
 	{
@@ -92,6 +169,128 @@ namespace CubbyFlow
 		//! Copies entire element of given matrix \p result with other matrix \p v.
 		static void Set(const MatrixType& m, MatrixType* result);
 
+		//! Performs dot product with vector \p a and \p b. The sum is computed in
+		//! parallel with a fixed partition, so the result is reproducible.
+		static double Dot(const VectorType& a, const VectorType& b);
+
+		//! Performs ax + y operation where \p a is a matrix and \p x and \p y are vectors.
+		static void AXPlusY(double a, const VectorType& x, const VectorType& y, VectorType* result);
+
+		//! Performs matrix-vector multiplication.
+		static void MVM(const MatrixType& m, const VectorType& v, VectorType* result);
+
+		//! Computes residual vector (b - ax).
+		static void Residual(const MatrixType& a, const VectorType& x, const VectorType& b, VectorType* result);
+
+		//! Returns L2-norm of the given vector \p v.
+		static ScalarType L2Norm(const VectorType& v);
+
+		//! Returns Linf-norm of the given vector \p v.
+		static ScalarType LInfNorm(const VectorType& v);
+
+		//!
+		//! \brief Performs matrix-vector multiplication and returns the dot
+		//!        product of \p v and the result, in a single pass.
+		//!
+		static double MVMDot(const MatrixType& m, const VectorType& v, VectorType* result);
+
+		//!
+		//! \brief Performs x = x + a * d and r = r - a * q, and returns the
+		//!        squared L2-norm of the new r, in a single pass.
+		//!
+		static double UpdateSolutionAndResidual(
+			double a, const VectorType& d, const VectorType& q, VectorType* x, VectorType* r);
+	};
+
+	//!
+	//! \brief Single precision BLAS operator wrapper for 3-D finite differencing.
+	//!
+	//! The matrix and the vectors are stored in single precision, which halves
+	//! the memory traffic of the solvers, while the dot products and the norms
+	//! are accumulated in double precision. The functions taking FDMMatrix3 or
+	//! FDMVector3 convert between the two precisions.
+	//!
+	struct FDMBLAS3F
+	{
+		using ScalarType = float;
+		using VectorType = FDMVector3F;
+		using MatrixType = FDMMatrix3F;
+
+		//! Sets entire element of given vector \p result with scalar \p s.
+		static void Set(ScalarType s, VectorType* result);
+
+		//! Copies entire element of given vector \p result with other vector \p v.
+		static void Set(const VectorType& v, VectorType* result);
+
+		//! Copies double precision vector \p v to \p result, rounding the elements.
+		static void Set(const FDMVector3& v, VectorType* result);
+
+		//! Sets entire element of given matrix \p result with scalar \p s.
+		static void Set(ScalarType s, MatrixType* result);
+
+		//! Copies entire element of given matrix \p result with other matrix \p v.
+		static void Set(const MatrixType& m, MatrixType* result);
+
+		//! Copies double precision matrix \p m to \p result, rounding the elements.
+		static void Set(const FDMMatrix3& m, MatrixType* result);
+
+		//! Performs dot product with vector \p a and \p b.
+		static double Dot(const VectorType& a, const VectorType& b);
+
+		//! Performs ax + y operation where \p a is a matrix and \p x and \p y are vectors.
+		static void AXPlusY(double a, const VectorType& x, const VectorType& y, VectorType* result);
+
+		//! Performs ax + y operation into double precision vector \p result.
+		static void AXPlusY(double a, const VectorType& x, const FDMVector3& y, FDMVector3* result);
+
+		//! Performs matrix-vector multiplication.
+		static void MVM(const MatrixType& m, const VectorType& v, VectorType* result);
+
+		//! Computes residual vector (b - ax).
+		static void Residual(const MatrixType& a, const VectorType& x, const VectorType& b, VectorType* result);
+
+		//! Computes residual vector (b - ax) in double precision and stores it in \p result.
+		static void Residual(const FDMMatrix3& a, const FDMVector3& x, const FDMVector3& b, VectorType* result);
+
+		//! Returns L2-norm of the given vector \p v.
+		static double L2Norm(const VectorType& v);
+
+		//! Returns Linf-norm of the given vector \p v.
+		static double LInfNorm(const VectorType& v);
+
+		//! Same as FDMBLAS3::MVMDot.
+		static double MVMDot(const MatrixType& m, const VectorType& v, VectorType* result);
+
+		//! Same as FDMBLAS3::UpdateSolutionAndResidual.
+		static double UpdateSolutionAndResidual(
+			double a, const VectorType& d, const VectorType& q, VectorType* x, VectorType* r);
+	};
+
+	//!
+	//! \brief BLAS operator wrapper for matrix-free 3-D finite differencing.
+	//!
+	//! The vector operations are the same as FDMBLAS3. The matrix operations
+	//! evaluate the stencil of FDMMatrixFree3 from the markers, and give the
+	//! same results as FDMBLAS3 with the assembled matrix.
+	//!
+	struct FDMMatrixFreeBLAS3
+	{
+		using ScalarType = double;
+		using VectorType = FDMVector3;
+		using MatrixType = FDMMatrixFree3;
+
+		//! Sets entire element of given vector \p result with scalar \p s.
+		static void Set(ScalarType s, VectorType* result);
+
+		//! Copies entire element of given vector \p result with other vector \p v.
+		static void Set(const VectorType& v, VectorType* result);
+
+		//! Copies entire element of given matrix \p result with other matrix \p v.
+		static void Set(const MatrixType& m, MatrixType* result);
+
+		//! Assembles the rows of \p m into \p result.
+		static void Set(const MatrixType& m, FDMMatrix3* result);
+
 		//! Performs dot product with vector \p a and \p b.
 		static double Dot(const VectorType& a, const VectorType& b);
 
@@ -109,6 +308,13 @@ namespace CubbyFlow
 
 		//! Returns Linf-norm of the given vector \p v.
 		static ScalarType LInfNorm(const VectorType& v);
+
+		//! Same as FDMBLAS3::MVMDot.
+		static double MVMDot(const MatrixType& m, const VectorType& v, VectorType* result);
+
+		//! Same as FDMBLAS3::UpdateSolutionAndResidual.
+		static double UpdateSolutionAndResidual(
+			double a, const VectorType& d, const VectorType& q, VectorType* x, VectorType* r);
 	};
 
 	//! BLAS operator wrapper for compressed 3-D finite differencing.
@@ -130,7 +336,8 @@ namespace CubbyFlow
 		//! Copies entire element of given matrix \p result with other matrix \p v.
 		static void Set(const MatrixType& m, MatrixType* result);
 
-		//! Performs dot product with vector \p a and \p b.
+		//! Performs dot product with vector \p a and \p b. The sum is computed in
+		//! parallel with a fixed partition, so the result is reproducible.
 		static double Dot(const VectorType& a, const VectorType& b);
 
 		//! Performs ax + y operation where \p a is a matrix and \p x and \p y are vectors.
@@ -150,4 +357,6 @@ namespace CubbyFlow
 	};
 }
 
+#include <Core/FDM/FDMLinearSystem3-Impl.h>
+
 #endif
\ No newline at end of file
@@ -9,30 +9,40 @@
 #ifndef CUBBYFLOW_BVH3_IMPL_H
 #define CUBBYFLOW_BVH3_IMPL_H
 
+#include <Core/Math/MathUtils.h>
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <functional>
 #include <numeric>
+#include <vector>
 
 namespace CubbyFlow
 {
 	template <typename T>
 	BVH3<T>::Node::Node() : flags(0)
 	{
-		child = std::numeric_limits<size_t>::max();
+		child = std::numeric_limits<uint32_t>::max();
 	}
 
 	template <typename T>
 	void BVH3<T>::Node::InitLeaf(size_t it, const BoundingBox3D& b)
 	{
 		flags = 3;
-		item = it;
-		bound = b;
+		item = static_cast<uint32_t>(it);
+		SetBound(b);
 	}
 
 	template <typename T>
 	void BVH3<T>::Node::InitInternal(uint8_t axis, size_t c, const BoundingBox3D& b)
 	{
 		flags = axis;
-		child = c;
-		bound = b;
+		child = static_cast<uint32_t>(c);
+		SetBound(b);
 	}
 
 	template <typename T>
@@ -41,6 +51,93 @@ namespace CubbyFlow
 		return flags == 3;
 	}
 
+	template <typename T>
+	void BVH3<T>::Node::SetBound(const BoundingBox3D& b)
+	{
+		// Rounds the bounds outward so that the single precision box contains
+		// the double precision one.
+		const double maxValue = std::numeric_limits<float>::max();
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			float lower = static_cast<float>(CubbyFlow::Clamp(b.lowerCorner[i], -maxValue, maxValue));
+			if (lower > b.lowerCorner[i])
+			{
+				lower = std::nextafter(lower, -std::numeric_limits<float>::infinity());
+			}
+
+			float upper = static_cast<float>(CubbyFlow::Clamp(b.upperCorner[i], -maxValue, maxValue));
+			if (upper < b.upperCorner[i])
+			{
+				upper = std::nextafter(upper, std::numeric_limits<float>::infinity());
+			}
+
+			bound.lowerCorner[i] = lower;
+			bound.upperCorner[i] = upper;
+		}
+	}
+
+	template <typename T>
+	bool BVH3<T>::Node::Overlaps(const BoundingBox3D& box) const
+	{
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (bound.upperCorner[i] < box.lowerCorner[i] || bound.lowerCorner[i] > box.upperCorner[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <typename T>
+	bool BVH3<T>::Node::Intersects(const Ray3D& ray, const Vector3D& rayInvDir) const
+	{
+		double min = 0;
+		double max = std::numeric_limits<double>::max();
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			double near = (bound.lowerCorner[i] - ray.origin[i]) * rayInvDir[i];
+			double far = (bound.upperCorner[i] - ray.origin[i]) * rayInvDir[i];
+
+			if (near > far)
+			{
+				std::swap(near, far);
+			}
+
+			min = std::max(near, min);
+			max = std::min(far, max);
+
+			if (min > max)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <typename T>
+	Vector3D BVH3<T>::Node::Clamp(const Vector3D& pt) const
+	{
+		return Vector3D(
+			CubbyFlow::Clamp<double>(pt.x, bound.lowerCorner.x, bound.upperCorner.x),
+			CubbyFlow::Clamp<double>(pt.y, bound.lowerCorner.y, bound.upperCorner.y),
+			CubbyFlow::Clamp<double>(pt.z, bound.lowerCorner.z, bound.upperCorner.z));
+	}
+
+	template <typename T>
+	double BVH3<T>::Node::SurfaceArea() const
+	{
+		const double width = static_cast<double>(bound.upperCorner.x) - bound.lowerCorner.x;
+		const double height = static_cast<double>(bound.upperCorner.y) - bound.lowerCorner.y;
+		const double depth = static_cast<double>(bound.upperCorner.z) - bound.lowerCorner.z;
+
+		return 2.0 * (width * height + height * depth + depth * width);
+	}
+
 	template <typename T>
 	BVH3<T>::BVH3()
 	{
@@ -53,23 +150,156 @@ namespace CubbyFlow
 	{
 		m_items = items;
 		m_itemBounds = itemsBounds;
+		m_bound = BoundingBox3D();
+		m_nodes.clear();
 
 		if (m_items.empty())
 		{
 			return;
 		}
 
-		m_nodes.clear();
+		// Every leaf holds one item, so a subtree of n items has 2n - 1 nodes
+		// and the index of each node is known before its subtree is built.
+		const size_t numItems = m_items.size();
+		assert(2 * numItems - 1 <= std::numeric_limits<uint32_t>::max());
+		m_nodes.resize(2 * numItems - 1);
 
-		for (size_t i = 0; i < m_items.size(); ++i)
+		m_bound = ParallelReduce(ZERO_SIZE, numItems, BoundingBox3D(),
+			[&](size_t begin, size_t end, BoundingBox3D bound)
 		{
-			m_bound.Merge(m_itemBounds[i]);
-		}
+			for (size_t i = begin; i < end; ++i)
+			{
+				bound.Merge(m_itemBounds[i]);
+			}
+
+			return bound;
+		}, [](const BoundingBox3D& a, const BoundingBox3D& b)
+		{
+			BoundingBox3D bound = a;
+			bound.Merge(b);
+			return bound;
+		});
+
+		std::vector<Vector3D> centroids(numItems);
+		ParallelFor(ZERO_SIZE, numItems, [&](size_t i)
+		{
+			centroids[i] = m_itemBounds[i].MidPoint();
+		});
 
-		std::vector<size_t> itemIndices(m_items.size());
+		std::vector<size_t> itemIndices(numItems);
 		std::iota(std::begin(itemIndices), std::end(itemIndices), 0);
 
-		Build(0, itemIndices.data(), m_items.size(), 0);
+		// The top levels are split level by level until the subtrees are small
+		// enough to balance the load. A level with fewer nodes than threads
+		// splits each node in parallel, and a wider level splits its nodes in
+		// parallel. Then the subtrees are built in parallel.
+		const size_t numThreads = GetMaxNumberOfThreads();
+		const size_t maxTaskSize = std::max(numItems / (8 * numThreads), static_cast<size_t>(256));
+		std::vector<BuildTask> tasks;
+		std::vector<BuildTask> level{ BuildTask{ 0, 0, numItems, 0 } };
+
+		while (!level.empty())
+		{
+			std::vector<BuildTask> nodes;
+			for (const BuildTask& task : level)
+			{
+				(task.numItems <= maxTaskSize ? tasks : nodes).push_back(task);
+			}
+
+			const bool isNarrow = nodes.size() < numThreads;
+			level.resize(2 * nodes.size());
+
+			ParallelFor(ZERO_SIZE, nodes.size(), [&](size_t n)
+			{
+				const auto children = SplitNode(nodes[n], itemIndices.data(), centroids.data(),
+					isNarrow ? ExecutionPolicy::Parallel : ExecutionPolicy::Serial);
+				level[2 * n] = children[0];
+				level[2 * n + 1] = children[1];
+			}, isNarrow ? ExecutionPolicy::Serial : ExecutionPolicy::Parallel);
+		}
+
+		ParallelFor(ZERO_SIZE, tasks.size(), [&](size_t i)
+		{
+			Build(tasks[i], itemIndices.data(), centroids.data());
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+
+		const double internalArea = ParallelDeterministicReduce(ZERO_SIZE, m_nodes.size(), 0.0,
+			[&](size_t begin, size_t end, double area)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				area += m_nodes[i].IsLeaf() ? 0.0 : m_nodes[i].SurfaceArea();
+			}
+
+			return area;
+		}, std::plus<double>());
+
+		m_buildCost = GetRelativeCost(internalArea);
+	}
+
+	template <typename T>
+	bool BVH3<T>::Refit(const std::vector<BoundingBox3D>& itemsBounds, double maxCostRatio)
+	{
+		assert(itemsBounds.size() == m_items.size());
+
+		m_itemBounds = itemsBounds;
+		m_bound = BoundingBox3D();
+
+		if (m_nodes.empty())
+		{
+			return true;
+		}
+
+		for (const BoundingBox3D& itemBound : m_itemBounds)
+		{
+			m_bound.Merge(itemBound);
+		}
+
+		// Splits the tree into the top nodes, which are listed before their
+		// descendants, and the subtrees below them. A subtree starting at a
+		// node is stored contiguously, and its children follow their parent.
+		const size_t maxSubtreeSize = std::max(m_nodes.size() / (8 * GetMaxNumberOfThreads()), static_cast<size_t>(512));
+		std::vector<size_t> topNodes;
+		std::vector<std::pair<size_t, size_t>> subtrees;
+		std::vector<std::pair<size_t, size_t>> stack{ { 0, m_nodes.size() } };
+
+		while (!stack.empty())
+		{
+			const size_t nodeIndex = stack.back().first;
+			const size_t numNodes = stack.back().second;
+			stack.pop_back();
+
+			if (numNodes <= maxSubtreeSize)
+			{
+				subtrees.emplace_back(nodeIndex, nodeIndex + numNodes);
+				continue;
+			}
+
+			const size_t rightIndex = m_nodes[nodeIndex].child;
+			topNodes.push_back(nodeIndex);
+			stack.emplace_back(nodeIndex + 1, rightIndex - nodeIndex - 1);
+			stack.emplace_back(rightIndex, nodeIndex + numNodes - rightIndex);
+		}
+
+		std::vector<double> subtreeAreas(subtrees.size());
+		ParallelFor(ZERO_SIZE, subtrees.size(), [&](size_t i)
+		{
+			subtreeAreas[i] = RefitNodes(subtrees[i].first, subtrees[i].second);
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+
+		double internalArea = std::accumulate(subtreeAreas.begin(), subtreeAreas.end(), 0.0);
+		for (auto iter = topNodes.rbegin(); iter != topNodes.rend(); ++iter)
+		{
+			internalArea += RefitNodes(*iter, *iter + 1);
+		}
+
+		if (GetRelativeCost(internalArea) > maxCostRatio * m_buildCost)
+		{
+			Build(m_items, m_itemBounds);
+			return false;
+		}
+
+		return true;
 	}
 
 	template <typename T>
@@ -79,17 +309,72 @@ namespace CubbyFlow
 		m_items.clear();
 		m_itemBounds.clear();
 		m_nodes.clear();
+		m_buildCost = 0.0;
 	}
 
 	template <typename T>
 	inline NearestNeighborQueryResult3<T> BVH3<T>::GetNearestNeighbor(
 		const Vector3D& pt,
 		const NearestNeighborDistanceFunc3<T>& distanceFunc) const
+	{
+		return FindNearestNeighbor(pt, distanceFunc, nullptr);
+	}
+
+	template <typename T>
+	template <typename DistanceFunc>
+	void BVH3<T>::GetNearestNeighbors(
+		const ConstArrayAccessor1<Vector3D>& points,
+		const DistanceFunc& distanceFunc,
+		ArrayAccessor1<NearestNeighborQueryResult3<T>> results,
+		ExecutionPolicy policy) const
+	{
+		assert(points.size() == results.size());
+
+		const size_t numPoints = points.size();
+		std::vector<uint64_t> codes(numPoints);
+		std::vector<size_t> order(numPoints);
+
+		ParallelFor(ZERO_SIZE, numPoints, [&](size_t i)
+		{
+			codes[i] = GetMortonCode(points[i], 21);
+			order[i] = i;
+		}, policy);
+
+		ParallelRadixSort(codes.begin(), codes.end(), order.begin(), policy);
+
+		ParallelRangeFor(ZERO_SIZE, numPoints, [&](size_t begin, size_t end)
+		{
+			const T* hint = nullptr;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const size_t q = order[i];
+				results[q] = FindNearestNeighbor(points[q], distanceFunc, hint);
+				hint = results[q].item;
+			}
+		}, policy);
+	}
+
+	template <typename T>
+	template <typename DistanceFunc>
+	NearestNeighborQueryResult3<T> BVH3<T>::FindNearestNeighbor(
+		const Vector3D& pt, const DistanceFunc& distanceFunc, const T* hint) const
 	{
 		NearestNeighborQueryResult3<T> best;
 		best.distance = std::numeric_limits<double>::max();
 		best.item = nullptr;
 
+		// The distance to the hint bounds the search from the beginning. Until
+		// an item as near as the hint is visited, the ties are kept, so the
+		// search finds the same item as the one without the hint.
+		bool isBoundedByHint = false;
+		if (hint != nullptr)
+		{
+			best.distance = distanceFunc(*hint, pt);
+			best.item = hint;
+			isBoundedByHint = true;
+		}
+
 		// Prepare to traverse BVH
 		static const int maxTreeDepth = 8 * sizeof(size_t);
 		const Node* todo[maxTreeDepth];
@@ -102,10 +387,11 @@ namespace CubbyFlow
 			if (node->IsLeaf())
 			{
 				double dist = distanceFunc(m_items[node->item], pt);
-				if (dist < best.distance)
+				if (dist < best.distance || (isBoundedByHint && dist == best.distance))
 				{
 					best.distance = dist;
 					best.item = &m_items[node->item];
+					isBoundedByHint = false;
 				}
 
 				// Grab next node to process from todo stack
@@ -131,14 +417,14 @@ namespace CubbyFlow
 				// identical to pt. This will make distMinLeftSqr and
 				// distMinRightSqr zero, meaning that such a box will have higher
 				// priority.
-				Vector3D closestLeft = left->bound.Clamp(pt);
-				Vector3D closestRight = right->bound.Clamp(pt);
+				Vector3D closestLeft = left->Clamp(pt);
+				Vector3D closestRight = right->Clamp(pt);
 
 				double distMinLeftSqr = closestLeft.DistanceSquaredTo(pt);
 				double distMinRightSqr = closestRight.DistanceSquaredTo(pt);
 
-				bool shouldVisitLeft = distMinLeftSqr < bestDistSqr;
-				bool shouldVisitRight = distMinRightSqr < bestDistSqr;
+				bool shouldVisitLeft = distMinLeftSqr < bestDistSqr || (isBoundedByHint && distMinLeftSqr == bestDistSqr);
+				bool shouldVisitRight = distMinRightSqr < bestDistSqr || (isBoundedByHint && distMinRightSqr == bestDistSqr);
 
 				const Node* firstChild;
 				const Node* secondChild;
@@ -233,11 +519,11 @@ namespace CubbyFlow
 				const Node* secondChild = const_cast<Node*>(&m_nodes[node->child]);
 
 				// advance to next child node, possibly enqueue other child
-				if (!firstChild->bound.Overlaps(box))
+				if (!firstChild->Overlaps(box))
 				{
 					node = secondChild;
 				}
-				else if (!secondChild->bound.Overlaps(box))
+				else if (!secondChild->Overlaps(box))
 				{
 					node = firstChild;
 				}
@@ -264,6 +550,7 @@ namespace CubbyFlow
 		}
 
 		// prepare to traverse BVH for ray
+		const Vector3D rayInvDir = ray.direction.RDiv(1);
 		static const int maxTreeDepth = 8 * sizeof(size_t);
 		const Node* todo[maxTreeDepth];
 		size_t todoPos = 0;
@@ -310,11 +597,11 @@ namespace CubbyFlow
 				}
 
 				// advance to next child node, possibly enqueue other child
-				if (!firstChild->bound.Intersects(ray))
+				if (!firstChild->Intersects(ray, rayInvDir))
 				{
 					node = secondChild;
 				}
-				else if (!secondChild->bound.Intersects(ray))
+				else if (!secondChild->Intersects(ray, rayInvDir))
 				{
 					node = firstChild;
 				}
@@ -377,11 +664,11 @@ namespace CubbyFlow
 				const Node* secondChild = const_cast<Node*>(&m_nodes[node->child]);
 
 				// advance to next child node, possibly enqueue other child
-				if (!firstChild->bound.Overlaps(box))
+				if (!firstChild->Overlaps(box))
 				{
 					node = secondChild;
 				}
-				else if (!secondChild->bound.Overlaps(box))
+				else if (!secondChild->Overlaps(box))
 				{
 					node = firstChild;
 				}
@@ -407,6 +694,7 @@ namespace CubbyFlow
 		}
 
 		// prepare to traverse BVH for ray
+		const Vector3D rayInvDir = ray.direction.RDiv(1);
 		static const int maxTreeDepth = 8 * sizeof(size_t);
 		const Node* todo[maxTreeDepth];
 		size_t todoPos = 0;
@@ -453,11 +741,11 @@ namespace CubbyFlow
 				}
 
 				// advance to next child node, possibly enqueue other child
-				if (!firstChild->bound.Intersects(ray))
+				if (!firstChild->Intersects(ray, rayInvDir))
 				{
 					node = secondChild;
 				}
-				else if (!secondChild->bound.Intersects(ray))
+				else if (!secondChild->Intersects(ray, rayInvDir))
 				{
 					node = firstChild;
 				}
@@ -475,6 +763,50 @@ namespace CubbyFlow
 	template <typename T>
 	inline ClosestIntersectionQueryResult3<T> BVH3<T>::GetClosestIntersection(
 		const Ray3D& ray, const GetRayIntersectionFunc3<T>& testFunc) const
+	{
+		return FindClosestIntersection(ray, testFunc);
+	}
+
+	template <typename T>
+	template <typename TestFunc>
+	void BVH3<T>::GetClosestIntersections(
+		const ConstArrayAccessor1<Ray3D>& rays,
+		const TestFunc& testFunc,
+		ArrayAccessor1<ClosestIntersectionQueryResult3<T>> results,
+		ExecutionPolicy policy) const
+	{
+		assert(rays.size() == results.size());
+
+		const size_t numRays = rays.size();
+		std::vector<uint64_t> codes(numRays);
+		std::vector<size_t> order(numRays);
+
+		ParallelFor(ZERO_SIZE, numRays, [&](size_t i)
+		{
+			const Vector3D& direction = rays[i].direction;
+			const uint64_t octant =
+				(direction.x < 0.0 ? 1 : 0) | (direction.y < 0.0 ? 2 : 0) | (direction.z < 0.0 ? 4 : 0);
+
+			codes[i] = (octant << 60) | GetMortonCode(rays[i].origin, 20);
+			order[i] = i;
+		}, policy);
+
+		ParallelRadixSort(codes.begin(), codes.end(), order.begin(), policy);
+
+		ParallelRangeFor(ZERO_SIZE, numRays, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const size_t q = order[i];
+				results[q] = FindClosestIntersection(rays[q], testFunc);
+			}
+		}, policy);
+	}
+
+	template <typename T>
+	template <typename TestFunc>
+	ClosestIntersectionQueryResult3<T> BVH3<T>::FindClosestIntersection(
+		const Ray3D& ray, const TestFunc& testFunc) const
 	{
 		ClosestIntersectionQueryResult3<T> best;
 		best.distance = std::numeric_limits<double>::max();
@@ -486,6 +818,7 @@ namespace CubbyFlow
 		}
 
 		// prepare to traverse BVH for ray
+		const Vector3D rayInvDir = ray.direction.RDiv(1);
 		static const int maxTreeDepth = 8 * sizeof(size_t);
 		const Node* todo[maxTreeDepth];
 		size_t todoPos = 0;
@@ -534,11 +867,11 @@ namespace CubbyFlow
 				}
 
 				// advance to next child node, possibly enqueue other child
-				if (!firstChild->bound.Intersects(ray))
+				if (!firstChild->Intersects(ray, rayInvDir))
 				{
 					node = secondChild;
 				}
-				else if (!secondChild->bound.Intersects(ray))
+				else if (!secondChild->Intersects(ray, rayInvDir))
 				{
 					node = firstChild;
 				}
@@ -585,6 +918,39 @@ namespace CubbyFlow
 		return m_items.end();
 	}
 
+	template <typename T>
+	double BVH3<T>::GetRelativeCost(double internalArea) const
+	{
+		// The cost of the leaves is the same for any hierarchy of the items
+		const double rootArea = m_nodes[0].SurfaceArea();
+		return (rootArea > 0.0) ? internalArea / rootArea : 0.0;
+	}
+
+	template <typename T>
+	double BVH3<T>::RefitNodes(size_t nodeBegin, size_t nodeEnd)
+	{
+		double internalArea = 0.0;
+
+		// The children have greater indices than their parents
+		for (size_t i = nodeEnd; i > nodeBegin; --i)
+		{
+			Node& node = m_nodes[i - 1];
+
+			if (node.IsLeaf())
+			{
+				node.SetBound(m_itemBounds[node.item]);
+			}
+			else
+			{
+				node.bound = m_nodes[i].bound;
+				node.bound.Merge(m_nodes[node.child].bound);
+				internalArea += node.SurfaceArea();
+			}
+		}
+
+		return internalArea;
+	}
+
 	template <typename T>
 	size_t BVH3<T>::GetNumberOfItems() const
 	{
@@ -598,74 +964,327 @@ namespace CubbyFlow
 	}
 
 	template <typename T>
-	size_t BVH3<T>::Build(size_t nodeIndex, size_t* itemIndices, size_t nItems, size_t currentDepth)
+	uint64_t BVH3<T>::GetMortonCode(const Vector3D& pt, uint32_t bitsPerAxis) const
 	{
-		// add a node
-		m_nodes.push_back(Node());
+		// The points outside the bounding box are clamped onto it
+		const double maxCell = static_cast<double>((1u << bitsPerAxis) - 1);
+		const Vector3D extent = m_bound.upperCorner - m_bound.lowerCorner;
 
+		uint32_t cell[3] = { 0, 0, 0 };
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (extent[i] > 0.0)
+			{
+				const double x = (pt[i] - m_bound.lowerCorner[i]) / extent[i] * maxCell;
+				cell[i] = static_cast<uint32_t>(CubbyFlow::Clamp(x, 0.0, maxCell));
+			}
+		}
+
+		return MortonCode(cell[0], cell[1], cell[2]);
+	}
+
+	template <typename T>
+	void BVH3<T>::Build(const BuildTask& task, size_t* itemIndices, const Vector3D* centroids)
+	{
 		// Initialize leaf node if termination criteria met
-		if (nItems == 1)
+		if (task.numItems == 1)
 		{
-			m_nodes[nodeIndex].InitLeaf(itemIndices[0], m_itemBounds[itemIndices[0]]);
-			return currentDepth + 1;
+			const size_t item = itemIndices[task.itemBegin];
+			m_nodes[task.nodeIndex].InitLeaf(item, m_itemBounds[item]);
+			return;
 		}
 
-		// find the mid-point of the bounding box to use as a qsplit pivot
+		const auto children = SplitNode(task, itemIndices, centroids, ExecutionPolicy::Serial);
+		Build(children[0], itemIndices, centroids);
+		Build(children[1], itemIndices, centroids);
+	}
+
+	template <typename T>
+	std::array<typename BVH3<T>::BuildTask, 2> BVH3<T>::SplitNode(
+		const BuildTask& task, size_t* itemIndices, const Vector3D* centroids, ExecutionPolicy policy)
+	{
 		BoundingBox3D nodeBound;
-		for (size_t i = 0; i < nItems; ++i)
+		uint8_t axis;
+		const size_t midPoint = Split(itemIndices + task.itemBegin, task.numItems, task.depth, centroids, &nodeBound, &axis, policy);
+
+		// The left subtree follows its parent and takes 2 * midPoint - 1 nodes
+		const size_t leftIndex = task.nodeIndex + 1;
+		const size_t rightIndex = task.nodeIndex + 2 * midPoint;
+		m_nodes[task.nodeIndex].InitInternal(axis, rightIndex, nodeBound);
+
+		return {
+			{
+				BuildTask{ leftIndex, task.itemBegin, midPoint, task.depth + 1 },
+				BuildTask{ rightIndex, task.itemBegin + midPoint, task.numItems - midPoint, task.depth + 1 }
+			}
+		};
+	}
+
+	template <typename T>
+	size_t BVH3<T>::Split(size_t* itemIndices, size_t numItems, size_t depth,
+		const Vector3D* centroids, BoundingBox3D* nodeBound, uint8_t* axis,
+		ExecutionPolicy policy) const
+	{
+		// Number of the centroid bins per axis
+		static const size_t numBins = 16;
+
+		// Depth below which the surface area heuristic is used. The deeper
+		// nodes are split at the median, which keeps the tree depth within the
+		// traversal stack size.
+		static const size_t maxSAHDepth = 32;
+
+		// Number of items below which the nodes are split at the median, since
+		// binning costs more than it saves for a few items.
+		static const size_t minSAHItems = 8;
+
+		// Number of items per chunk below which a node is binned and
+		// partitioned on a single thread.
+		static const size_t minChunkItems = 4096;
+
+		// The items of a large node are bounded, binned and partitioned in
+		// chunks in parallel. The chunk results are merged in chunk order and
+		// the partition is stable, so the split does not depend on the number
+		// of chunks.
+		size_t numChunks = 1;
+		if (policy == ExecutionPolicy::Parallel)
 		{
-			nodeBound.Merge(m_itemBounds[itemIndices[i]]);
+			numChunks = std::max(ONE_SIZE, std::min(numItems / minChunkItems, static_cast<size_t>(4 * GetMaxNumberOfThreads())));
 		}
 
-		Vector3D d = nodeBound.upperCorner - nodeBound.lowerCorner;
+		const auto GetChunkBegin = [&](size_t c)
+		{
+			return c * numItems / numChunks;
+		};
 
-		// choose which axis to split along
-		uint8_t axis;
-		if (d.x > d.y && d.x > d.z)
+		const auto MergeBounds = [&](size_t begin, size_t end, BoundingBox3D* itemsBound, BoundingBox3D* centroidsBound)
 		{
-			axis = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				itemsBound->Merge(m_itemBounds[itemIndices[i]]);
+				centroidsBound->Merge(centroids[itemIndices[i]]);
+			}
+		};
+
+		BoundingBox3D centroidBound;
+		if (numChunks == 1)
+		{
+			MergeBounds(0, numItems, nodeBound, &centroidBound);
 		}
 		else
 		{
-			axis = (d.y > d.z) ? 1 : 2;
+			std::vector<std::array<BoundingBox3D, 2>> chunkBounds(numChunks);
+			ParallelFor(ZERO_SIZE, numChunks, [&](size_t c)
+			{
+				MergeBounds(GetChunkBegin(c), GetChunkBegin(c + 1), &chunkBounds[c][0], &chunkBounds[c][1]);
+			});
+
+			for (const auto& bounds : chunkBounds)
+			{
+				nodeBound->Merge(bounds[0]);
+				centroidBound.Merge(bounds[1]);
+			}
 		}
 
-		double pivot = 0.5 * (nodeBound.upperCorner[axis] + nodeBound.lowerCorner[axis]);
+		const Vector3D extent = centroidBound.upperCorner - centroidBound.lowerCorner;
 
-		// classify primitives with respect to split
-		size_t midPoint = QSplit(itemIndices, nItems, pivot, axis);
+		// choose the longest axis of the centroids unless SAH finds a better one
+		if (extent.x > extent.y && extent.x > extent.z)
+		{
+			*axis = 0;
+		}
+		else
+		{
+			*axis = (extent.y > extent.z) ? 1 : 2;
+		}
 
-		// recursively Initialize children m_nodes
-		size_t d0 = Build(nodeIndex + 1, itemIndices, midPoint, currentDepth + 1);
-		m_nodes[nodeIndex].InitInternal(axis, m_nodes.size(), nodeBound);
-		size_t d1 = Build(m_nodes[nodeIndex].child, itemIndices + midPoint, nItems - midPoint, currentDepth + 1);
+		// all the centroids are at the same point, so any split is as good.
+		// The halves are chosen by item index to keep the tree independent of
+		// the item order.
+		if (extent[*axis] <= 0.0)
+		{
+			std::nth_element(itemIndices, itemIndices + (numItems >> 1), itemIndices + numItems);
 
-		return std::max(d0, d1);
-	}
+			return numItems >> 1;
+		}
 
-	template <typename T>
-	size_t BVH3<T>::QSplit(size_t* itemIndices, size_t numItems, double pivot, uint8_t axis)
-	{
-		size_t ret = 0;
+		if (depth >= maxSAHDepth || numItems < minSAHItems)
+		{
+			const uint8_t medianAxis = *axis;
+			std::nth_element(itemIndices, itemIndices + (numItems >> 1), itemIndices + numItems,
+				[&](size_t a, size_t b)
+			{
+				const double centroidA = centroids[a][medianAxis];
+				const double centroidB = centroids[b][medianAxis];
+
+				return centroidA < centroidB || (centroidA == centroidB && a < b);
+			});
+
+			return numItems >> 1;
+		}
+
+		auto halfArea = [](const BoundingBox3D& box)
+		{
+			const Vector3D d = box.upperCorner - box.lowerCorner;
+			return d.x * d.y + d.y * d.z + d.z * d.x;
+		};
+
+		Vector3D scale;
+		for (size_t i = 0; i < 3; ++i)
+		{
+			scale[i] = (extent[i] > 0.0) ? numBins / extent[i] : 0.0;
+		}
+
+		auto binIndex = [&](const Vector3D& centroid, size_t binAxis)
+		{
+			const double t = (centroid[binAxis] - centroidBound.lowerCorner[binAxis]) * scale[binAxis];
+			return std::min(static_cast<size_t>(t), numBins - 1);
+		};
+
+		// bin the items along all the axes in a single pass
+		struct Bins
+		{
+			std::array<std::array<BoundingBox3D, numBins>, 3> bounds;
+			std::array<std::array<size_t, numBins>, 3> counts{};
+		};
+
+		const auto BinItems = [&](size_t begin, size_t end, Bins* bins)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const Vector3D& centroid = centroids[itemIndices[i]];
+				const BoundingBox3D& itemBound = m_itemBounds[itemIndices[i]];
+
+				for (size_t binAxis = 0; binAxis < 3; ++binAxis)
+				{
+					const size_t bin = binIndex(centroid, binAxis);
+					bins->bounds[binAxis][bin].Merge(itemBound);
+					++bins->counts[binAxis][bin];
+				}
+			}
+		};
 
-		for (size_t i = 0; i < numItems; ++i)
+		Bins bins;
+		if (numChunks == 1)
 		{
-			BoundingBox3D b = m_itemBounds[itemIndices[i]];
-			double centroid = 0.5f * (b.lowerCorner[axis] + b.upperCorner[axis]);
-			
-			if (centroid < pivot)
+			BinItems(0, numItems, &bins);
+		}
+		else
+		{
+			std::vector<Bins> chunkBins(numChunks);
+			ParallelFor(ZERO_SIZE, numChunks, [&](size_t c)
 			{
-				std::swap(itemIndices[i], itemIndices[ret]);
-				ret++;
+				BinItems(GetChunkBegin(c), GetChunkBegin(c + 1), &chunkBins[c]);
+			});
+
+			for (const Bins& chunk : chunkBins)
+			{
+				for (size_t binAxis = 0; binAxis < 3; ++binAxis)
+				{
+					for (size_t bin = 0; bin < numBins; ++bin)
+					{
+						bins.bounds[binAxis][bin].Merge(chunk.bounds[binAxis][bin]);
+						bins.counts[binAxis][bin] += chunk.counts[binAxis][bin];
+					}
+				}
 			}
 		}
 
-		if (ret == 0 || ret == numItems)
+		double bestCost = std::numeric_limits<double>::max();
+		size_t bestBin = numBins;
+
+		for (uint8_t binAxis = 0; binAxis < 3; ++binAxis)
 		{
-			ret = numItems >> 1;
+			if (extent[binAxis] <= 0.0)
+			{
+				continue;
+			}
+
+			// cost of the items right of each split, which is between bin - 1
+			// and bin
+			std::array<double, numBins> rightCosts{};
+			BoundingBox3D rightBound;
+			size_t rightCount = 0;
+
+			for (size_t bin = numBins - 1; bin > 0; --bin)
+			{
+				rightBound.Merge(bins.bounds[binAxis][bin]);
+				rightCount += bins.counts[binAxis][bin];
+				rightCosts[bin] = (rightCount > 0) ? rightCount * halfArea(rightBound) : 0.0;
+			}
+
+			BoundingBox3D leftBound;
+			size_t leftCount = 0;
+
+			for (size_t bin = 1; bin < numBins; ++bin)
+			{
+				leftBound.Merge(bins.bounds[binAxis][bin - 1]);
+				leftCount += bins.counts[binAxis][bin - 1];
+
+				if (leftCount == 0 || leftCount == numItems)
+				{
+					continue;
+				}
+
+				const double cost = leftCount * halfArea(leftBound) + rightCosts[bin];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestBin = bin;
+					*axis = binAxis;
+				}
+			}
 		}
 
-		return ret;
+		// the centroids span more than one bin, so a split has been found
+		assert(bestBin < numBins);
+
+		const uint8_t splitAxis = *axis;
+		const auto IsLeft = [&](size_t item)
+		{
+			return binIndex(centroids[item], splitAxis) < bestBin;
+		};
+
+		if (numChunks == 1)
+		{
+			return static_cast<size_t>(std::partition(itemIndices, itemIndices + numItems, IsLeft) - itemIndices);
+		}
+
+		// Each chunk counts its left items, then writes its left and right
+		// items at the offsets given by the exclusive scan of the counts.
+		std::vector<size_t> leftOffsets(numChunks + 1, 0);
+		ParallelFor(ZERO_SIZE, numChunks, [&](size_t c)
+		{
+			leftOffsets[c + 1] = static_cast<size_t>(std::count_if(
+				itemIndices + GetChunkBegin(c), itemIndices + GetChunkBegin(c + 1), IsLeft));
+		});
+
+		for (size_t c = 0; c < numChunks; ++c)
+		{
+			leftOffsets[c + 1] += leftOffsets[c];
+		}
+
+		const size_t numLeftItems = leftOffsets[numChunks];
+		std::vector<size_t> partitioned(numItems);
+
+		ParallelFor(ZERO_SIZE, numChunks, [&](size_t c)
+		{
+			size_t left = leftOffsets[c];
+			size_t right = numLeftItems + GetChunkBegin(c) - leftOffsets[c];
+
+			for (size_t i = GetChunkBegin(c); i < GetChunkBegin(c + 1); ++i)
+			{
+				const size_t item = itemIndices[i];
+				partitioned[IsLeft(item) ? left++ : right++] = item;
+			}
+		});
+
+		ParallelFor(ZERO_SIZE, numChunks, [&](size_t c)
+		{
+			std::copy(partitioned.begin() + GetChunkBegin(c), partitioned.begin() + GetChunkBegin(c + 1),
+				itemIndices + GetChunkBegin(c));
+		});
+
+		return numLeftItems;
 	}
 }
 
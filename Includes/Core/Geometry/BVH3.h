@@ -9,8 +9,13 @@
 #ifndef CUBBYFLOW_BVH3_H
 #define CUBBYFLOW_BVH3_H
 
+#include <Core/Array/ArrayAccessor1.h>
 #include <Core/QueryEngine/IntersectionQueryEngine3.h>
 #include <Core/QueryEngine/NearestNeighborQueryEngine3.h>
+#include <Core/Utils/Parallel.h>
+
+#include <array>
+#include <vector>
 
 namespace CubbyFlow
 {
@@ -22,6 +27,12 @@ namespace CubbyFlow
 	//! intersection tests. Also, NearestNeighborQueryEngine3 is implemented to
 	//! provide nearest neighbor query.
 	//!
+	//! The hierarchy is built with the binned surface area heuristic (SAH), and
+	//! the subtrees below the top levels are built in parallel. The nodes store
+	//! their bounds in single precision, rounded outward, so that a node takes
+	//! 32 bytes. When the items move, the hierarchy can be refitted to their new
+	//! bounds instead of being rebuilt.
+	//!
 	template <typename T>
 	class BVH3 final : public IntersectionQueryEngine3<T>, public NearestNeighborQueryEngine3<T>
 	{
@@ -37,6 +48,23 @@ namespace CubbyFlow
 		void Build(const std::vector<T>& items,
 			const std::vector<BoundingBox3D>& itemsBounds);
 
+		//!
+		//! \brief Updates the bounds of the items while keeping the hierarchy.
+		//!
+		//! The bounds of the nodes are recomputed bottom-up, and the subtrees
+		//! below the top levels are refitted in parallel. The quality of the
+		//! hierarchy is measured by its surface area heuristic cost relative to
+		//! the bound of the root. If the refitted cost exceeds \p maxCostRatio
+		//! times the cost of the last build, the hierarchy is rebuilt instead.
+		//!
+		//! \param[in] itemsBounds  The new bounds of the items, in the order
+		//!     of the items given to Build.
+		//! \param[in] maxCostRatio The cost increase that triggers a rebuild.
+		//!
+		//! \return True if the hierarchy is kept, false if it is rebuilt.
+		//!
+		bool Refit(const std::vector<BoundingBox3D>& itemsBounds, double maxCostRatio = 1.5);
+
 		//! Clears all the contents of this instance.
 		void Clear();
 
@@ -69,6 +97,42 @@ namespace CubbyFlow
 			const Ray3D& ray,
 			const GetRayIntersectionFunc3<T>& testFunc) const override;
 
+		//!
+		//! \brief Returns the nearest neighbors of \p points.
+		//!
+		//! The points are visited in Morton order, and each query is bounded by
+		//! the distance to the nearest item of the previous point from the
+		//! beginning, so the nearby points skip most of the traversal. The
+		//! results are the same as the ones from GetNearestNeighbor, except
+		//! between the items whose distances only differ by rounding.
+		//!
+		//! \tparam DistanceFunc Function type which has the same signature as
+		//!     NearestNeighborDistanceFunc3.
+		//!
+		template <typename DistanceFunc>
+		void GetNearestNeighbors(
+			const ConstArrayAccessor1<Vector3D>& points,
+			const DistanceFunc& distanceFunc,
+			ArrayAccessor1<NearestNeighborQueryResult3<T>> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
+		//!
+		//! \brief Returns the closest intersections for \p rays.
+		//!
+		//! The rays are visited in the order of their direction octants and the
+		//! Morton codes of their origins, so the consecutive rays traverse
+		//! similar nodes.
+		//!
+		//! \tparam TestFunc Function type which has the same signature as
+		//!     GetRayIntersectionFunc3.
+		//!
+		template <typename TestFunc>
+		void GetClosestIntersections(
+			const ConstArrayAccessor1<Ray3D>& rays,
+			const TestFunc& testFunc,
+			ArrayAccessor1<ClosestIntersectionQueryResult3<T>> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
 		//! Returns bounding box of every items.
 		const BoundingBox3D& GetBoundingBox() const;
 
@@ -93,28 +157,63 @@ namespace CubbyFlow
 	private:
 		struct Node
 		{
-			char flags;
+			BoundingBox3F bound;
 			union
 			{
-				size_t child;
-				size_t item;
+				uint32_t child;
+				uint32_t item;
 			};
-			BoundingBox3D bound;
+			uint32_t flags;
 
 			Node();
 			void InitLeaf(size_t it, const BoundingBox3D& b);
 			void InitInternal(uint8_t axis, size_t c, const BoundingBox3D& b);
 			bool IsLeaf() const;
+			void SetBound(const BoundingBox3D& b);
+
+			bool Overlaps(const BoundingBox3D& box) const;
+			bool Intersects(const Ray3D& ray, const Vector3D& rayInvDir) const;
+			Vector3D Clamp(const Vector3D& pt) const;
+
+			double SurfaceArea() const;
+		};
+
+		struct BuildTask
+		{
+			size_t nodeIndex;
+			size_t itemBegin;
+			size_t numItems;
+			size_t depth;
 		};
 
 		BoundingBox3D m_bound;
 		ContainerType m_items;
 		std::vector<BoundingBox3D> m_itemBounds;
 		std::vector<Node> m_nodes;
+		double m_buildCost = 0.0;
+
+		template <typename DistanceFunc>
+		NearestNeighborQueryResult3<T> FindNearestNeighbor(
+			const Vector3D& pt, const DistanceFunc& distanceFunc, const T* hint) const;
+
+		template <typename TestFunc>
+		ClosestIntersectionQueryResult3<T> FindClosestIntersection(
+			const Ray3D& ray, const TestFunc& testFunc) const;
+
+		uint64_t GetMortonCode(const Vector3D& pt, uint32_t bitsPerAxis) const;
+
+		double GetRelativeCost(double internalArea) const;
+
+		double RefitNodes(size_t nodeBegin, size_t nodeEnd);
+
+		void Build(const BuildTask& task, size_t* itemIndices, const Vector3D* centroids);
 
-		size_t Build(size_t nodeIndex, size_t* itemIndices, size_t nItems, size_t currentDepth);
+		std::array<BuildTask, 2> SplitNode(const BuildTask& task, size_t* itemIndices,
+			const Vector3D* centroids, ExecutionPolicy policy);
 
-		size_t QSplit(size_t* itemIndices, size_t numItems, double pivot, uint8_t axis);
+		size_t Split(size_t* itemIndices, size_t numItems, size_t depth,
+			const Vector3D* centroids, BoundingBox3D* nodeBound, uint8_t* axis,
+			ExecutionPolicy policy) const;
 	};
 }
 
@@ -69,9 +69,9 @@ namespace CubbyFlow
 	}
 
 	template <typename T, size_t K>
+	template <typename Callback>
 	void KdTree<T, K>::ForEachNearbyPoint(
-		const Point& origin, T radius,
-		const std::function<void(size_t, const Point&)>& callback) const
+		const Point& origin, T radius, const Callback& callback) const
 	{
 		const T r2 = radius * radius;
 
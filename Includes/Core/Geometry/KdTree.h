@@ -71,11 +71,12 @@ namespace CubbyFlow
 		//!
 		//! \param[in]  origin   The origin position.
 		//! \param[in]  radius   The search radius.
-		//! \param[in]  callback The callback function.
+		//! \param[in]  callback The callback function which takes
+		//!                      (size_t index, const Point& point).
 		//!
+		template <typename Callback>
 		void ForEachNearbyPoint(
-			const Point& origin, T radius,
-			const std::function<void(size_t, const Point&)>& callback) const;
+			const Point& origin, T radius, const Callback& callback) const;
 
 		//!
 		//! Returns true if there are any nearby points for given origin within
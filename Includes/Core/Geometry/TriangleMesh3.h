@@ -59,6 +59,51 @@ namespace CubbyFlow
 		//! Updates internal spatial query engine.
 		void UpdateQueryEngine() override;
 
+		//!
+		//! \brief Computes the closest points on the mesh from \p otherPoints.
+		//!
+		//! This function gives the same results as calling ClosestPoint for
+		//! each point, up to the rounding between equally near triangles. The
+		//! queries are sorted so that the nearby points share their traversal
+		//! of the BVH. See BVH3::GetNearestNeighbors.
+		//!
+		void ClosestPoints(
+			const ConstArrayAccessor1<Vector3D>& otherPoints,
+			ArrayAccessor1<Vector3D> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
+		//! Computes the closest distances from \p otherPoints to the mesh.
+		void ClosestDistances(
+			const ConstArrayAccessor1<Vector3D>& otherPoints,
+			ArrayAccessor1<double> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
+		//! Computes the normals at the closest points from \p otherPoints.
+		void ClosestNormals(
+			const ConstArrayAccessor1<Vector3D>& otherPoints,
+			ArrayAccessor1<Vector3D> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
+		//!
+		//! \brief Computes the closest points, normals and distances from
+		//!        \p otherPoints with a single batched query.
+		//!
+		//! This function is the same as calling ClosestPoints, ClosestNormals
+		//! and ClosestDistances, but traverses the BVH only once.
+		//!
+		void ClosestPointsAndNormals(
+			const ConstArrayAccessor1<Vector3D>& otherPoints,
+			ArrayAccessor1<Vector3D> points,
+			ArrayAccessor1<Vector3D> normals,
+			ArrayAccessor1<double> distances,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
+		//! Computes the closest intersections of \p rays with the mesh.
+		void ClosestIntersections(
+			const ConstArrayAccessor1<Ray3D>& rays,
+			ArrayAccessor1<SurfaceRayIntersection3> results,
+			ExecutionPolicy policy = ExecutionPolicy::Parallel) const;
+
 		//! Clears all content.
 		void Clear();
 
@@ -77,7 +122,12 @@ namespace CubbyFlow
 		//! Returns constant reference to the i-th point.
 		const Vector3D& Point(size_t i) const;
 
-		//! Returns reference to the i-th point.
+		//!
+		//! \brief Returns reference to the i-th point.
+		//!
+		//! Moving the points keeps the spatial query engine, which is refitted
+		//! to the new positions on the next query.
+		//!
 		Vector3D& Point(size_t i);
 
 		//! Returns constant reference to the i-th normal.
@@ -183,12 +233,50 @@ namespace CubbyFlow
 		//! Writes the mesh in obj format to the file.
 		bool WriteObj(const std::string& fileName) const;
 
-		//! Reads the mesh in obj format from the input stream.
+		//!
+		//! \brief Reads the mesh in obj format from the input stream.
+		//!
+		//! The mesh read is appended to this mesh. Polygons are triangulated
+		//! as fans, and the UV coordinates or the normals are only kept if
+		//! every face refers to them. Returns false and leaves the mesh
+		//! unchanged if the stream is not a valid obj file.
+		//!
 		bool ReadObj(std::istream* stream);
 
-		//! Reads the mesh in obj format from the file.
+		//!
+		//! \brief Reads the mesh in obj format from the file.
+		//!
+		//! The file is memory-mapped and split into line-aligned chunks which
+		//! are parsed in parallel. The lines are counted first so that the
+		//! storage of the mesh is allocated only once.
+		//!
 		bool ReadObj(const std::string& fileName);
 
+		//!
+		//! \brief Writes the mesh in binary ply format to the output stream.
+		//!
+		//! Since ply stores a single index per vertex, the normals and the UV
+		//! coordinates are only written if they are indexed the same way as
+		//! the points.
+		//!
+		void WritePly(std::ostream* stream) const;
+
+		//! Writes the mesh in binary ply format to the file.
+		bool WritePly(const std::string& fileName) const;
+
+		//!
+		//! \brief Reads the mesh in binary ply format from the input stream.
+		//!
+		//! Both little and big endian files are supported. The mesh read is
+		//! appended to this mesh, and polygons are triangulated as fans.
+		//! Returns false and leaves the mesh unchanged if the stream is not a
+		//! valid binary ply file.
+		//!
+		bool ReadPly(std::istream* stream);
+
+		//! Reads the mesh in binary ply format from the file.
+		bool ReadPly(const std::string& fileName);
+
 		//! Copies \p other mesh.
 		TriangleMesh3& operator=(const TriangleMesh3& other);
 
@@ -218,10 +306,23 @@ namespace CubbyFlow
 
 		mutable BVH3<size_t> m_bvh;
 		mutable bool m_bvhInvalidated = true;
+		mutable bool m_bvhBoundsInvalidated = false;
 
 		void InvalidateBVH() const;
 
+		void InvalidateBVHBounds() const;
+
+		bool ParseObj(const char* begin, const char* end);
+
+		bool ParsePly(const char* begin, const char* end);
+
 		void BuildBVH() const;
+
+		void GetNearestTriangles(
+			const ConstArrayAccessor1<Vector3D>& otherPoints,
+			Array1<Vector3D>* localPoints,
+			Array1<NearestNeighborQueryResult3<size_t>>* queryResults,
+			ExecutionPolicy policy) const;
 	};
 
 	//! Shared pointer for the TriangleMesh3 type.
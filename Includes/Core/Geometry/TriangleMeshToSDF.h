@@ -34,6 +34,7 @@
 
 #include <Core/Geometry/TriangleMesh3.h>
 #include <Core/Grid/ScalarGrid3.h>
+#include <Core/Utils/Parallel.h>
 
 namespace CubbyFlow
 {
@@ -57,14 +58,21 @@ namespace CubbyFlow
 	//!
 	//! \see https://github.com/christopherbatty/SDFGen
 	//!
+	//! With the parallel execution policy, the triangles are binned into slabs
+	//! of z-slices which are initialized in parallel, and the fast sweeping
+	//! visits the x-rows wavefront by wavefront. The result is the same as the
+	//! serial execution.
+	//!
 	//! \param[in]      mesh      The mesh.
 	//! \param[in,out]  sdf       The output signed-distance field.
 	//! \param[in]      exactBand The bandwidth for exact distance computation.
+	//! \param[in]      policy    The execution policy (parallel or serial).
 	//!
 	void TriangleMeshToSDF(
 		const TriangleMesh3& mesh,
 		ScalarGrid3* sdf,
-		const unsigned int exactBand = 1);
+		const unsigned int exactBand = 1,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
 }
 
 #endif
\ No newline at end of file
@@ -9,10 +9,15 @@
 #ifndef CUBBYFLOW_MARCHING_CUBES_H
 #define CUBBYFLOW_MARCHING_CUBES_H
 
+#include <Core/Array/ArrayAccessor2.h>
 #include <Core/Array/ArrayAccessor3.h>
 #include <Core/Geometry/TriangleMesh3.h>
+#include <Core/Utils/Parallel.h>
 #include <Core/Vector/Vector3.h>
 
+#include <functional>
+#include <ostream>
+
 namespace CubbyFlow
 {
 	//!
@@ -23,12 +28,17 @@ namespace CubbyFlow
 	//! the iso-value can be specified. For the boundaries (or the walls), it can be
 	//! specified whether to close or open.
 	//!
+	//! The parallel version splits the grid into slabs along the z-axis which
+	//! are meshed concurrently, and then merges them. The resulting mesh is
+	//! identical to the one from the serial version.
+	//!
 	//! \param[in]  grid     The grid.
 	//! \param[in]  gridSize The grid size.
 	//! \param[in]  origin   The origin.
 	//! \param      mesh     The output triangle mesh.
 	//! \param[in]  isoValue The iso-surface value.
 	//! \param[in]  bndFlag  The boundary direction flag.
+	//! \param[in]  policy   The execution policy.
 	//!
 	void MarchingCubes(
 		const ConstArrayAccessor3<double>& grid,
@@ -36,6 +46,71 @@ namespace CubbyFlow
 		const Vector3D& origin,
 		TriangleMesh3* mesh,
 		double isoValue = 0,
+		int bndFlag = DIRECTION_ALL,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
+	//!
+	//! \brief      Computes marching cubes from a grid which is streamed slice
+	//!     by slice.
+	//!
+	//! This function extracts the same iso-surface as the function above, but
+	//! only four z-slices of the grid are kept in memory, so the grid does not
+	//! have to fit in memory. The slices are requested in increasing order of
+	//! k by calling \p slice with k and an accessor of size (resolution.x,
+	//! resolution.y) to be filled with the grid values of the slice. The
+	//! vertices and the triangles are passed to \p addVertex and
+	//! \p addTriangle as soon as they are created. The vertices are numbered
+	//! by the order of the calls, starting from zero, and each triangle is
+	//! passed after its vertices.
+	//!
+	//! Without the boundary faces, the vertices and the triangles come in the
+	//! same order as in the mesh from the function above. The boundary faces
+	//! are extracted layer by layer, so they come in a different order.
+	//!
+	//! \param[in]  slice       The function which fills the z-slice k.
+	//! \param[in]  resolution  The grid resolution.
+	//! \param[in]  gridSize    The grid size.
+	//! \param[in]  origin      The origin.
+	//! \param[in]  addVertex   The function which receives the position and
+	//!     the normal of each vertex.
+	//! \param[in]  addTriangle The function which receives each triangle.
+	//! \param[in]  isoValue    The iso-surface value.
+	//! \param[in]  bndFlag     The boundary direction flag.
+	//!
+	void MarchingCubes(
+		const std::function<void(size_t, ArrayAccessor2<double>)>& slice,
+		const Size3& resolution,
+		const Vector3D& gridSize,
+		const Vector3D& origin,
+		const std::function<void(const Vector3D&, const Vector3D&)>& addVertex,
+		const std::function<void(const Point3UI&)>& addTriangle,
+		double isoValue = 0,
+		int bndFlag = DIRECTION_ALL);
+
+	//!
+	//! \brief      Computes marching cubes from a grid which is streamed slice
+	//!     by slice, and writes the mesh to \p objStream in OBJ format.
+	//!
+	//! The vertices and the faces are written as soon as they are created, so
+	//! the memory usage does not depend on the size of the mesh. Formats which
+	//! store the number of elements in the header, such as PLY, can be written
+	//! from the callbacks of the function above once the counts are known.
+	//!
+	//! \param[in]  slice      The function which fills the z-slice k.
+	//! \param[in]  resolution The grid resolution.
+	//! \param[in]  gridSize   The grid size.
+	//! \param[in]  origin     The origin.
+	//! \param      objStream  The output stream.
+	//! \param[in]  isoValue   The iso-surface value.
+	//! \param[in]  bndFlag    The boundary direction flag.
+	//!
+	void MarchingCubes(
+		const std::function<void(size_t, ArrayAccessor2<double>)>& slice,
+		const Size3& resolution,
+		const Vector3D& gridSize,
+		const Vector3D& origin,
+		std::ostream* objStream,
+		double isoValue = 0,
 		int bndFlag = DIRECTION_ALL);
 }
 
@@ -11,8 +11,128 @@
 
 #include <Core/Math/MathUtils.h>
 
+#include <type_traits>
+#include <utility>
+
 namespace CubbyFlow
 {
+	namespace Internal
+	{
+		template <typename BLASType, typename = void>
+		struct HasFusedCGKernels : std::false_type
+		{
+			// Do nothing
+		};
+
+		template <typename BLASType>
+		struct HasFusedCGKernels<BLASType, std::void_t<
+			decltype(BLASType::MVMDot(
+				std::declval<const typename BLASType::MatrixType&>(),
+				std::declval<const typename BLASType::VectorType&>(),
+				std::declval<typename BLASType::VectorType*>())),
+			decltype(BLASType::UpdateSolutionAndResidual(
+				0.0,
+				std::declval<const typename BLASType::VectorType&>(),
+				std::declval<const typename BLASType::VectorType&>(),
+				std::declval<typename BLASType::VectorType*>(),
+				std::declval<typename BLASType::VectorType*>()))>> : std::true_type
+		{
+			// Do nothing
+		};
+
+		template <typename BLASType, typename PrecondType>
+		void FusedPCG(
+			const typename BLASType::MatrixType& A,
+			const typename BLASType::VectorType& b,
+			unsigned int maxNumberOfIterations,
+			double tolerance,
+			PrecondType* M,
+			typename BLASType::VectorType* x,
+			typename BLASType::VectorType* r,
+			typename BLASType::VectorType* d,
+			typename BLASType::VectorType* q,
+			typename BLASType::VectorType* s,
+			unsigned int* lastNumberOfIterations,
+			double* lastResidualNorm)
+		{
+			// With the null preconditioner s = r, so r is used directly
+			constexpr bool isPreconditioned = !std::is_same<PrecondType, NullCGPreconditioner<BLASType>>::value;
+
+			// Clear
+			BLASType::Set(0, r);
+			BLASType::Set(0, d);
+			BLASType::Set(0, q);
+			BLASType::Set(0, s);
+
+			// r = b - Ax
+			BLASType::Residual(A, *x, b, r);
+
+			// d = M^-1r
+			M->Solve(*r, d);
+
+			// sigmaNew = r.d
+			double sigmaNew = BLASType::Dot(*r, *d);
+
+			unsigned int iter = 0;
+			bool trigger = false;
+
+			while (sigmaNew > Square(tolerance) && iter < maxNumberOfIterations)
+			{
+				// q = Ad, alpha = sigmaNew / d.q
+				double alpha = sigmaNew / BLASType::MVMDot(A, *d, q);
+
+				double residualNormSquared;
+
+				// if i is divisible by 50...
+				if (trigger || (iter % 50 == 0 && iter > 0))
+				{
+					// x = x + alpha * d, r = b - Ax
+					BLASType::AXPlusY(alpha, *d, *x, x);
+					BLASType::Residual(A, *x, b, r);
+					residualNormSquared = isPreconditioned ? 0.0 : BLASType::Dot(*r, *r);
+					trigger = false;
+				}
+				else
+				{
+					// x = x + alpha * d, r = r - alpha * q
+					residualNormSquared = BLASType::UpdateSolutionAndResidual(alpha, *d, *q, x, r);
+				}
+
+				// sigmaOld = sigmaNew
+				double sigmaOld = sigmaNew;
+
+				if (isPreconditioned)
+				{
+					// s = M^-1r, sigmaNew = r.s
+					M->Solve(*r, s);
+					sigmaNew = BLASType::Dot(*r, *s);
+				}
+				else
+				{
+					sigmaNew = residualNormSquared;
+				}
+
+				if (sigmaNew > sigmaOld)
+				{
+					trigger = true;
+				}
+
+				// beta = sigmaNew / sigmaOld
+				double beta = sigmaNew / sigmaOld;
+
+				// d = s + beta*d
+				BLASType::AXPlusY(beta, *d, isPreconditioned ? *s : *r, d);
+
+				++iter;
+			}
+
+			*lastNumberOfIterations = iter;
+
+			// std::fabs(sigmaNew) - Workaround for negative zero
+			*lastResidualNorm = std::sqrt(std::fabs(sigmaNew));
+		}
+	}
+
 	template <typename BLASType>
 	void CG(
 		const typename BLASType::MatrixType& A,
@@ -60,6 +180,14 @@ namespace CubbyFlow
 		unsigned int* lastNumberOfIterations,
 		double* lastResidualNorm)
 	{
+		if constexpr (Internal::HasFusedCGKernels<BLASType>::value)
+		{
+			Internal::FusedPCG<BLASType, PrecondType>(
+				A, b, maxNumberOfIterations, tolerance, M, x, r, d, q, s,
+				lastNumberOfIterations, lastResidualNorm);
+			return;
+		}
+
 		// Clear
 		BLASType::Set(0, r);
 		BLASType::Set(0, d);
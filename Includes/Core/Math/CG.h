@@ -53,6 +53,11 @@ namespace CubbyFlow
 	//!
 	//! \brief Solves pre-conditioned conjugate gradient.
 	//!
+	//! If \p BLASType provides the fused kernels MVMDot and
+	//! UpdateSolutionAndResidual (see FDMBLAS3), each iteration uses them to
+	//! make fewer passes over the vectors. With NullCGPreconditioner, the
+	//! copy to \p s and its dot product are skipped as well.
+	//!
 	template <typename BLASType, typename PrecondType>
 	void PCG(
 		const typename BLASType::MatrixType& A,
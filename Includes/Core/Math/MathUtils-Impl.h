@@ -253,6 +253,40 @@ namespace CubbyFlow
 
 		return a3 * Cubic(f) + a2 * Square(f) + a1 * f + a0;
 	}
+
+	inline uint64_t MortonCode(uint32_t x, uint32_t y)
+	{
+		// Spreads the 32 bits of v so that there is a zero bit between each.
+		const auto spread = [](uint64_t v)
+		{
+			v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+			v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+			v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+			v = (v | (v << 2)) & 0x3333333333333333ull;
+			v = (v | (v << 1)) & 0x5555555555555555ull;
+			return v;
+		};
+
+		return spread(x) | (spread(y) << 1);
+	}
+
+	inline uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z)
+	{
+		// Spreads the lower 21 bits of v so that there are two zero bits
+		// between each.
+		const auto spread = [](uint64_t v)
+		{
+			v &= 0x1FFFFFull;
+			v = (v | (v << 32)) & 0x001F00000000FFFFull;
+			v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+			v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+			v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+			v = (v | (v << 2)) & 0x1249249249249249ull;
+			return v;
+		};
+
+		return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+	}
 }
 
 #endif
\ No newline at end of file
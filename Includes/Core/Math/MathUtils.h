@@ -12,6 +12,7 @@
 #include <Core/Utils/Macros.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 
 namespace CubbyFlow
@@ -202,6 +203,29 @@ namespace CubbyFlow
 	//! \brief      Computes monotonic Catmull-Rom interpolation.
 	template <typename T>
 	inline T MonotonicCatmullRom(const T& f0, const T& f1, const T& f2, const T& f3, T t);
+
+	//!
+	//! \brief      Returns the 2-D Morton (Z-order) code of a cell index.
+	//!
+	//! \param[in]  x     The x index.
+	//! \param[in]  y     The y index.
+	//!
+	//! \return     The bits of \p x and \p y interleaved.
+	//!
+	inline uint64_t MortonCode(uint32_t x, uint32_t y);
+
+	//!
+	//! \brief      Returns the 3-D Morton (Z-order) code of a cell index.
+	//!
+	//! Only the lower 21 bits of each index are used.
+	//!
+	//! \param[in]  x     The x index.
+	//! \param[in]  y     The y index.
+	//! \param[in]  z     The z index.
+	//!
+	//! \return     The bits of \p x, \p y and \p z interleaved.
+	//!
+	inline uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z);
 }
 
 #include <Core/Math/MathUtils-Impl.h>
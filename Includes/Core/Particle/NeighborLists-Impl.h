@@ -0,0 +1,160 @@
+/*************************************************************************
+> File Name: NeighborLists-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Compressed (CSR) particle neighbor lists.
+> Created Time: 2018/06/11
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_NEIGHBOR_LISTS_IMPL_H
+#define CUBBYFLOW_NEIGHBOR_LISTS_IMPL_H
+
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
+
+#include <cassert>
+#include <limits>
+
+namespace CubbyFlow
+{
+	template <typename IndexType>
+	NeighborLists<IndexType>::NeighborLists() :
+		m_offsets(1, 0)
+	{
+		// Do nothing
+	}
+
+	template <typename IndexType>
+	NeighborLists<IndexType>::NeighborLists(const std::vector<std::vector<size_t>>& lists)
+	{
+		Set(lists);
+	}
+
+	template <typename IndexType>
+	size_t NeighborLists<IndexType>::size() const
+	{
+		return m_offsets.size() - 1;
+	}
+
+	template <typename IndexType>
+	bool NeighborLists<IndexType>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename IndexType>
+	size_t NeighborLists<IndexType>::NumberOfNeighbors() const
+	{
+		return m_indices.size();
+	}
+
+	template <typename IndexType>
+	typename NeighborLists<IndexType>::ConstList NeighborLists<IndexType>::operator[](size_t i) const
+	{
+		assert(i < size());
+
+		return ConstList(m_offsets[i + 1] - m_offsets[i], m_indices.data() + m_offsets[i]);
+	}
+
+	template <typename IndexType>
+	const std::vector<size_t>& NeighborLists<IndexType>::Offsets() const
+	{
+		return m_offsets;
+	}
+
+	template <typename IndexType>
+	const std::vector<IndexType>& NeighborLists<IndexType>::Indices() const
+	{
+		return m_indices;
+	}
+
+	template <typename IndexType>
+	void NeighborLists<IndexType>::Clear()
+	{
+		m_offsets.resize(1);
+		m_offsets[0] = 0;
+		m_indices.clear();
+	}
+
+	template <typename IndexType>
+	void NeighborLists<IndexType>::AddNeighbor(size_t j)
+	{
+		assert(j <= static_cast<size_t>(std::numeric_limits<IndexType>::max()));
+
+		m_indices.push_back(static_cast<IndexType>(j));
+	}
+
+	template <typename IndexType>
+	void NeighborLists<IndexType>::EndList()
+	{
+		m_offsets.push_back(m_indices.size());
+	}
+
+	template <typename IndexType>
+	template <typename CountFunc, typename FillFunc>
+	void NeighborLists<IndexType>::Build(size_t numberOfLists, const CountFunc& countFunc, const FillFunc& fillFunc)
+	{
+		m_offsets.resize(numberOfLists + 1);
+		m_offsets[0] = 0;
+
+		// Count pass
+		ParallelFor(ZERO_SIZE, numberOfLists, [&](size_t i)
+		{
+			m_offsets[i + 1] = countFunc(i);
+		});
+
+		// Exclusive scan of the counts
+		for (size_t i = 0; i < numberOfLists; ++i)
+		{
+			m_offsets[i + 1] += m_offsets[i];
+		}
+
+		m_indices.resize(m_offsets[numberOfLists]);
+
+		// Fill pass
+		ParallelFor(ZERO_SIZE, numberOfLists, [&](size_t i)
+		{
+			fillFunc(i, m_indices.data() + m_offsets[i]);
+		});
+	}
+
+	template <typename IndexType>
+	void NeighborLists<IndexType>::Set(const std::vector<std::vector<size_t>>& lists)
+	{
+		size_t numberOfNeighbors = 0;
+		for (const auto& list : lists)
+		{
+			numberOfNeighbors += list.size();
+		}
+
+		Clear();
+		m_offsets.reserve(lists.size() + 1);
+		m_indices.reserve(numberOfNeighbors);
+
+		for (const auto& list : lists)
+		{
+			for (size_t j : list)
+			{
+				AddNeighbor(j);
+			}
+
+			EndList();
+		}
+	}
+
+	template <typename IndexType>
+	std::vector<std::vector<size_t>> NeighborLists<IndexType>::ToNestedLists() const
+	{
+		std::vector<std::vector<size_t>> lists(size());
+
+		for (size_t i = 0; i < size(); ++i)
+		{
+			const ConstList list = (*this)[i];
+			lists[i].assign(list.begin(), list.end());
+		}
+
+		return lists;
+	}
+}
+
+#endif
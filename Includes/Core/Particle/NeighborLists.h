@@ -0,0 +1,110 @@
+/*************************************************************************
+> File Name: NeighborLists.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Compressed (CSR) particle neighbor lists.
+> Created Time: 2018/06/11
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_NEIGHBOR_LISTS_H
+#define CUBBYFLOW_NEIGHBOR_LISTS_H
+
+#include <Core/Array/ArrayAccessor1.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace CubbyFlow
+{
+	//!
+	//! \brief Compressed (CSR) neighbor lists.
+	//!
+	//! This class stores the neighbor lists of all the particles in two flat
+	//! arrays: the indices of all the neighbors, one list after another, and
+	//! the offsets where each list starts. Compared to a vector of vectors, the
+	//! whole structure is rebuilt with two allocations and each list is a
+	//! contiguous range.
+	//!
+	//! \tparam IndexType - Integer type of the stored neighbor indices.
+	//!
+	template <typename IndexType>
+	class NeighborLists final
+	{
+	public:
+		//! Read-only view of a single neighbor list.
+		using ConstList = ConstArrayAccessor1<IndexType>;
+
+		//! Constructs empty neighbor lists.
+		NeighborLists();
+
+		//! Constructs neighbor lists from the nested lists.
+		explicit NeighborLists(const std::vector<std::vector<size_t>>& lists);
+
+		//! Returns the number of lists.
+		size_t size() const;
+
+		//! Returns true if there is no list.
+		bool empty() const;
+
+		//! Returns the total number of neighbors over all the lists.
+		size_t NumberOfNeighbors() const;
+
+		//! Returns the neighbor list of the i-th particle.
+		ConstList operator[](size_t i) const;
+
+		//! Returns the offsets; list i is [offsets[i], offsets[i + 1]).
+		const std::vector<size_t>& Offsets() const;
+
+		//! Returns the neighbor indices of all the lists.
+		const std::vector<IndexType>& Indices() const;
+
+		//! Removes all the lists while keeping the allocated memory.
+		void Clear();
+
+		//! Appends neighbor \p j to the list currently being built.
+		void AddNeighbor(size_t j);
+
+		//! Closes the list currently being built and starts the next one.
+		void EndList();
+
+		//!
+		//! \brief Builds \p numberOfLists lists in parallel.
+		//!
+		//! The lists are built in two passes. \p countFunc(i) returns the length
+		//! of the i-th list, the offsets are computed by an exclusive scan of the
+		//! lengths, and \p fillFunc(i, dest) writes exactly that many indices
+		//! of the i-th list to \p dest.
+		//!
+		//! \param[in]  numberOfLists The number of lists.
+		//! \param[in]  countFunc     The function returning the list lengths.
+		//! \param[in]  fillFunc      The function writing the list indices.
+		//!
+		template <typename CountFunc, typename FillFunc>
+		void Build(size_t numberOfLists, const CountFunc& countFunc, const FillFunc& fillFunc);
+
+		//! Replaces the content with the nested lists.
+		void Set(const std::vector<std::vector<size_t>>& lists);
+
+		//! Returns a copy of the lists as a vector of vectors.
+		std::vector<std::vector<size_t>> ToNestedLists() const;
+
+	private:
+		std::vector<size_t> m_offsets;
+		std::vector<IndexType> m_indices;
+	};
+
+#ifdef CUBBYFLOW_32BIT_NEIGHBOR_INDEX
+	//! Index type of the particle neighbor lists.
+	using ParticleNeighborIndex = uint32_t;
+#else
+	//! Index type of the particle neighbor lists.
+	using ParticleNeighborIndex = size_t;
+#endif
+
+	//! Neighbor lists type used by the particle system data.
+	using ParticleNeighborLists = NeighborLists<ParticleNeighborIndex>;
+}
+
+#include <Core/Particle/NeighborLists-Impl.h>
+
+#endif
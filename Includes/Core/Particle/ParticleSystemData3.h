@@ -10,6 +10,7 @@
 #define CUBBYFLOW_PARTICLE_SYSTEM_DATA3_H
 
 #include <Core/Array/Array1.h>
+#include <Core/Particle/NeighborLists.h>
 #include <Core/Searcher/PointNeighborSearcher3.h>
 #include <Core/Utils/Serialization.h>
 #include <Core/Vector/Vector3.h>
@@ -198,11 +199,13 @@ namespace CubbyFlow
 		//!
 		//! This function returns neighbor lists which is available after calling
 		//! PointParallelHashGridSearcher3::BuildNeighborLists. Each list stores
-		//! indices of the neighbors.
+		//! indices of the neighbors. The lists are stored in a single compressed
+		//! (CSR) buffer; use ParticleNeighborLists::ToNestedLists to get a copy
+		//! as a vector of vectors.
 		//!
 		//! \return     Neighbor lists.
 		//!
-		const std::vector<std::vector<size_t>>& GetNeighborLists() const;
+		const ParticleNeighborLists& GetNeighborLists() const;
 
 		//! Builds neighbor searcher with given search radius.
 		void BuildNeighborSearcher(double maxSearchRadius);
@@ -210,6 +213,30 @@ namespace CubbyFlow
 		//! Builds neighbor lists with given search radius.
 		void BuildNeighborLists(double maxSearchRadius);
 
+		//!
+		//! \brief      Sorts the particles in Morton (Z-order) of their grid cells.
+		//!
+		//! This function permutes positions, velocities, forces and all the
+		//! custom data layers so that particles which are close in space are
+		//! also close in memory. The neighbor searcher is rebuilt and the
+		//! neighbor lists are remapped to the new order.
+		//!
+		//! \param[in]  gridSpacing The cell size used for the ordering.
+		//!
+		void SortParticles(double gridSpacing);
+
+		//!
+		//! \brief      Returns the permutation applied by the last sort.
+		//!
+		//! This function returns the permutation computed by
+		//! ParticleSystemData3::SortParticles. It maps new particle index i to
+		//! the index before sorting, so that user data can follow with
+		//! newData[i] = oldData[sortedIndices[i]].
+		//!
+		//! \return     The sorted indices of the particles.
+		//!
+		const std::vector<size_t>& GetSortedIndices() const;
+
 		//! Serializes this particle system data to the buffer.
 		void Serialize(std::vector<uint8_t>* buffer) const override;
 
@@ -243,7 +270,8 @@ namespace CubbyFlow
 		std::vector<VectorData> m_vectorDataList;
 
 		PointNeighborSearcher3Ptr m_neighborSearcher;
-		std::vector<std::vector<size_t>> m_neighborLists;
+		ParticleNeighborLists m_neighborLists;
+		std::vector<size_t> m_sortedIndices;
 	};
 
 	//! Shared pointer type of ParticleSystemData3.
@@ -0,0 +1,45 @@
+/*************************************************************************
+> File Name: PointHashGridSearcher2-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Hash grid-based 2-D point searcher.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_HASH_GRID_SEARCHER2_IMPL_H
+#define CUBBYFLOW_POINT_HASH_GRID_SEARCHER2_IMPL_H
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointHashGridSearcher2::ForEachNearbyPoint(const Vector2D& origin, double radius, const Callback& callback) const
+	{
+		if (m_buckets.empty())
+		{
+			return;
+		}
+
+		size_t nearByKeys[4];
+		GetNearbyKeys(origin, nearByKeys);
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			const auto& bucket = m_buckets[nearByKeys[i]];
+			size_t numberOfPointsInBucket = bucket.size();
+
+			for (size_t j = 0; j < numberOfPointsInBucket; ++j)
+			{
+				size_t pointIndex = bucket[j];
+				double rSquared = (m_points[pointIndex] - origin).LengthSquared();
+				if (rSquared <= queryRadiusSquared)
+				{
+					callback(pointIndex, m_points[pointIndex]);
+				}
+			}
+		}
+	}
+}
+
+#endif
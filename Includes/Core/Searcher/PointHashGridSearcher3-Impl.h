@@ -0,0 +1,98 @@
+/*************************************************************************
+> File Name: PointHashGridSearcher3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Hash grid-based 3-D point searcher.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_HASH_GRID_SEARCHER3_IMPL_H
+#define CUBBYFLOW_POINT_HASH_GRID_SEARCHER3_IMPL_H
+
+#include <Core/Searcher/PointHashGridSearcherUtils3.h>
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointHashGridSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const
+	{
+		if (m_buckets.empty())
+		{
+			return;
+		}
+
+		size_t nearByKeys[8];
+		GetNearbyKeys(origin, nearByKeys);
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (size_t i = 0; i < 8; ++i)
+		{
+			const auto& bucket = m_buckets[nearByKeys[i]];
+			size_t numberOfPointsInBucket = bucket.size();
+
+			for (size_t j = 0; j < numberOfPointsInBucket; ++j)
+			{
+				size_t pointIndex = bucket[j];
+				double rSquared = (m_points[pointIndex] - origin).LengthSquared();
+				if (rSquared <= queryRadiusSquared)
+				{
+					callback(pointIndex, m_points[pointIndex]);
+				}
+			}
+		}
+	}
+
+	template <typename Callback>
+	void PointHashGridSearcher3::ForEachNearbyPoints(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		const Callback& callback) const
+	{
+		std::vector<size_t> queryOrder, groupStarts;
+		Internal::GroupHashGridQueries(*this, m_gridSpacing, origins, &queryOrder, &groupStarts);
+
+		ParallelFor(ZERO_SIZE, groupStarts.size() - 1, [&](size_t g)
+		{
+			ForEachNearbyPointInGroup(origins, radius, queryOrder, groupStarts[g], groupStarts[g + 1], callback);
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+	}
+
+	template <typename Callback>
+	void PointHashGridSearcher3::ForEachNearbyPointInGroup(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		const std::vector<size_t>& queryOrder, size_t begin, size_t end,
+		const Callback& callback) const
+	{
+		if (m_buckets.empty())
+		{
+			return;
+		}
+
+		// All the queries of a group visit the same buckets
+		size_t nearbyKeys[8];
+		GetNearbyKeys(origins[queryOrder[begin]], nearbyKeys);
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (size_t q = begin; q < end; ++q)
+		{
+			const size_t i = queryOrder[q];
+			const Vector3D& origin = origins[i];
+
+			for (int k = 0; k < 8; ++k)
+			{
+				for (size_t pointIndex : m_buckets[nearbyKeys[k]])
+				{
+					if ((m_points[pointIndex] - origin).LengthSquared() <= queryRadiusSquared)
+					{
+						callback(i, pointIndex, m_points[pointIndex]);
+					}
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -75,6 +75,56 @@ namespace CubbyFlow
 			double radius,
 			const ForEachNearbyPointFunc& callback) const override;
 
+		//!
+		//! \brief Invokes the callback for each nearby point around the origin
+		//!        within given radius.
+		//!
+		//! Same as the virtual overload, but the callback is called directly
+		//! instead of through ForEachNearbyPointFunc, so it can be inlined.
+		//! The callback takes (size_t index, const Vector3D& position).
+		//!
+		//! \param[in]  origin   The origin position.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const;
+
+		//!
+		//! \brief Invokes the callback for each nearby point of each origin.
+		//!
+		//! The queries are grouped by the buckets they visit and each group is
+		//! processed in parallel, so the bucket tables are read once per group
+		//! instead of once per query. Origins which are already sorted by bucket
+		//! give the best locality. The callback takes (size_t originIndex,
+		//! size_t pointIndex, const Vector3D& position) and is invoked
+		//! concurrently for different origins, but all the neighbors of a given
+		//! origin are visited by the same thread.
+		//!
+		//! \param[in]  origins  The origin positions.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoints(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			const Callback& callback) const;
+
+		//!
+		//! \brief Finds the nearby points of each origin into flat buffers.
+		//!
+		//! The result is stored in compressed (CSR) form: the nearby points of
+		//! origin i are indices[offsets[i]] to indices[offsets[i + 1] - 1].
+		//!
+		//! \param[in]  origins The origin positions.
+		//! \param[in]  radius  The search radius.
+		//! \param[out] offsets The offsets of the lists (size origins + 1).
+		//! \param[out] indices The indices of the nearby points.
+		//!
+		void FindNearbyPoints(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			std::vector<size_t>* offsets, std::vector<size_t>* indices) const;
+
 		//!
 		//! Returns true if there are any nearby points for given origin within
 		//! radius.
@@ -157,6 +207,12 @@ namespace CubbyFlow
 		size_t GetHashKeyFromPosition(const Vector3D& position) const;
 
 		void GetNearbyKeys(const Vector3D& position, size_t* nearbyKeys) const;
+
+		template <typename Callback>
+		void ForEachNearbyPointInGroup(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			const std::vector<size_t>& queryOrder, size_t begin, size_t end,
+			const Callback& callback) const;
 	};
 
 	//! Shared pointer for the PointHashGridSearcher3 type.
@@ -189,4 +245,6 @@ namespace CubbyFlow
 	};
 }
 
+#include <Core/Searcher/PointHashGridSearcher3-Impl.h>
+
 #endif
\ No newline at end of file
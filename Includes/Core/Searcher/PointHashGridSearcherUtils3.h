@@ -0,0 +1,161 @@
+/*************************************************************************
+> File Name: PointHashGridSearcherUtils3.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Batched query helpers shared by the 3-D hash grid searchers.
+> Created Time: 2018/06/15
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_HASH_GRID_SEARCHER_UTILS3_H
+#define CUBBYFLOW_POINT_HASH_GRID_SEARCHER_UTILS3_H
+
+#include <Core/Array/ArrayAccessor1.h>
+#include <Core/Point/Point3.h>
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
+#include <Core/Vector/Vector3.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace CubbyFlow
+{
+	namespace Internal
+	{
+		//!
+		//! \brief Groups the queries which visit the same nearby buckets.
+		//!
+		//! Origins in the same bucket and on the same side of its center along
+		//! each axis visit the same eight buckets (see GetNearbyKeys of the
+		//! searchers). The origins are sorted by that key, so the g-th group is
+		//! origins[queryOrder[groupStarts[g]]] to
+		//! origins[queryOrder[groupStarts[g + 1] - 1]].
+		//!
+		//! \param[in]  searcher    The hash grid searcher.
+		//! \param[in]  gridSpacing The grid spacing of the searcher.
+		//! \param[in]  origins     The origin positions.
+		//! \param[out] queryOrder  The origin indices sorted by group.
+		//! \param[out] groupStarts The offsets of the groups in queryOrder.
+		//!
+		template <typename Searcher>
+		void GroupHashGridQueries(
+			const Searcher& searcher, double gridSpacing,
+			const ConstArrayAccessor1<Vector3D>& origins,
+			std::vector<size_t>* queryOrder, std::vector<size_t>* groupStarts)
+		{
+			const size_t numberOfOrigins = origins.size();
+			std::vector<size_t> groupKeys(numberOfOrigins);
+			queryOrder->resize(numberOfOrigins);
+
+			ParallelFor(ZERO_SIZE, numberOfOrigins, [&](size_t i)
+			{
+				const Vector3D& origin = origins[i];
+				const Point3I bucketIndex = searcher.GetBucketIndex(origin);
+
+				size_t side = 0;
+				if ((bucketIndex.x + 0.5f) * gridSpacing <= origin.x)
+				{
+					side |= 4;
+				}
+				if ((bucketIndex.y + 0.5f) * gridSpacing <= origin.y)
+				{
+					side |= 2;
+				}
+				if ((bucketIndex.z + 0.5f) * gridSpacing <= origin.z)
+				{
+					side |= 1;
+				}
+
+				groupKeys[i] = (searcher.GetHashKeyFromBucketIndex(bucketIndex) << 3) | side;
+				(*queryOrder)[i] = i;
+			});
+
+			ParallelRadixSort(groupKeys.begin(), groupKeys.end(), queryOrder->begin());
+
+			groupStarts->clear();
+
+			for (size_t q = 0; q < numberOfOrigins; ++q)
+			{
+				if (q == 0 || groupKeys[q] != groupKeys[q - 1])
+				{
+					groupStarts->push_back(q);
+				}
+			}
+			groupStarts->push_back(numberOfOrigins);
+		}
+
+		//!
+		//! \brief Collects the nearby points of grouped queries into CSR lists.
+		//!
+		//! The groups are split into chunks and each chunk collects the nearby
+		//! points of its queries into its own buffer in a single pass. The
+		//! buffers are then scattered into the lists of the queries, so the
+		//! nearby points of origin i are indices[offsets[i]] to
+		//! indices[offsets[i + 1] - 1], in the order they were visited.
+		//!
+		//! \param[in]  numberOfOrigins The number of origins.
+		//! \param[in]  queryOrder      The origin indices sorted by group.
+		//! \param[in]  groupStarts     The offsets of the groups in queryOrder.
+		//! \param[in]  forEachInGroup  The function taking (begin, end,
+		//!                             callback) which invokes
+		//!                             callback(originIndex, pointIndex,
+		//!                             position) for each nearby point of the
+		//!                             queries queryOrder[begin, end).
+		//! \param[out] offsets         The offsets of the lists.
+		//! \param[out] indices         The indices of the nearby points.
+		//!
+		template <typename ForEachInGroup>
+		void CollectNearbyPointsOfGroups(
+			size_t numberOfOrigins, const std::vector<size_t>& queryOrder,
+			const std::vector<size_t>& groupStarts, const ForEachInGroup& forEachInGroup,
+			std::vector<size_t>* offsets, std::vector<size_t>* indices)
+		{
+			const size_t numberOfGroups = groupStarts.size() - 1;
+			const size_t numberOfChunks = std::min(numberOfGroups, static_cast<size_t>(8 * GetMaxNumberOfThreads()));
+			const auto GetChunkGroupBegin = [&](size_t c)
+			{
+				return c * numberOfGroups / numberOfChunks;
+			};
+
+			std::vector<std::vector<size_t>> chunkIndices(numberOfChunks);
+			offsets->assign(numberOfOrigins + 1, 0);
+
+			ParallelFor(ZERO_SIZE, numberOfChunks, [&](size_t c)
+			{
+				std::vector<size_t>& chunk = chunkIndices[c];
+
+				for (size_t g = GetChunkGroupBegin(c); g < GetChunkGroupBegin(c + 1); ++g)
+				{
+					forEachInGroup(groupStarts[g], groupStarts[g + 1], [&](size_t i, size_t j, const Vector3D&)
+					{
+						chunk.push_back(j);
+						++(*offsets)[i + 1];
+					});
+				}
+			}, PartitionPolicy{ PartitionMode::Dynamic });
+
+			for (size_t i = 0; i < numberOfOrigins; ++i)
+			{
+				(*offsets)[i + 1] += (*offsets)[i];
+			}
+
+			indices->resize(offsets->back());
+
+			ParallelFor(ZERO_SIZE, numberOfChunks, [&](size_t c)
+			{
+				auto src = chunkIndices[c].begin();
+
+				for (size_t q = groupStarts[GetChunkGroupBegin(c)]; q < groupStarts[GetChunkGroupBegin(c + 1)]; ++q)
+				{
+					const size_t i = queryOrder[q];
+					const size_t count = (*offsets)[i + 1] - (*offsets)[i];
+
+					std::copy(src, src + count, indices->begin() + (*offsets)[i]);
+					src += count;
+				}
+			});
+		}
+	}
+}
+
+#endif
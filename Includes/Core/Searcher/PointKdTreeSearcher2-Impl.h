@@ -0,0 +1,21 @@
+/*************************************************************************
+> File Name: PointKdTreeSearcher2-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: KdTree-based 2-D point searcher.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_KD_TREE_SEARCHER2_IMPL_H
+#define CUBBYFLOW_POINT_KD_TREE_SEARCHER2_IMPL_H
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointKdTreeSearcher2::ForEachNearbyPoint(const Vector2D& origin, double radius, const Callback& callback) const
+	{
+		m_tree.ForEachNearbyPoint(origin, radius, callback);
+	}
+}
+
+#endif
@@ -0,0 +1,21 @@
+/*************************************************************************
+> File Name: PointKdTreeSearcher3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: KdTree-based 3-D point searcher.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_KD_TREE_SEARCHER3_IMPL_H
+#define CUBBYFLOW_POINT_KD_TREE_SEARCHER3_IMPL_H
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointKdTreeSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const
+	{
+		m_tree.ForEachNearbyPoint(origin, radius, callback);
+	}
+}
+
+#endif
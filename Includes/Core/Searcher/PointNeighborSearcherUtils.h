@@ -0,0 +1,115 @@
+/*************************************************************************
+> File Name: PointNeighborSearcherUtils.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Static dispatch helpers for point neighbor searchers.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_NEIGHBOR_SEARCHER_UTILS_H
+#define CUBBYFLOW_POINT_NEIGHBOR_SEARCHER_UTILS_H
+
+#include <Core/Searcher/PointHashGridSearcher2.h>
+#include <Core/Searcher/PointHashGridSearcher3.h>
+#include <Core/Searcher/PointKdTreeSearcher2.h>
+#include <Core/Searcher/PointKdTreeSearcher3.h>
+#include <Core/Searcher/PointParallelHashGridSearcher2.h>
+#include <Core/Searcher/PointParallelHashGridSearcher3.h>
+#include <Core/Searcher/PointSimpleListSearcher2.h>
+#include <Core/Searcher/PointSimpleListSearcher3.h>
+
+#include <typeinfo>
+
+namespace CubbyFlow
+{
+	namespace Internal
+	{
+		//!
+		//! Returns \p searcher as a pointer to \p Searcher if that is its
+		//! exact dynamic type, or nullptr otherwise. Subclasses of \p Searcher
+		//! are rejected so that their overrides of the virtual queries are kept.
+		//!
+		template <typename Searcher, typename Base>
+		const Searcher* ExactCast(const Base& searcher)
+		{
+			const auto* result = dynamic_cast<const Searcher*>(&searcher);
+			return (result != nullptr && typeid(*result) == typeid(Searcher)) ? result : nullptr;
+		}
+	}
+
+	//!
+	//! \brief      Invokes \p function with the concrete type of \p searcher.
+	//!
+	//! This function resolves the type of the searcher once and calls
+	//! \p function(concreteSearcher), so that the neighbor queries inside the
+	//! function use the templated ForEachNearbyPoint of the concrete searcher
+	//! instead of the virtual one. Unknown searcher types are passed as
+	//! PointNeighborSearcher2.
+	//!
+	//! \param[in]  searcher The searcher.
+	//! \param[in]  function The function taking the searcher.
+	//!
+	template <typename Function>
+	void VisitPointNeighborSearcher(const PointNeighborSearcher2& searcher, const Function& function)
+	{
+		if (const auto* parallelHashGrid = Internal::ExactCast<PointParallelHashGridSearcher2>(searcher))
+		{
+			function(*parallelHashGrid);
+		}
+		else if (const auto* hashGrid = Internal::ExactCast<PointHashGridSearcher2>(searcher))
+		{
+			function(*hashGrid);
+		}
+		else if (const auto* kdTree = Internal::ExactCast<PointKdTreeSearcher2>(searcher))
+		{
+			function(*kdTree);
+		}
+		else if (const auto* simpleList = Internal::ExactCast<PointSimpleListSearcher2>(searcher))
+		{
+			function(*simpleList);
+		}
+		else
+		{
+			function(searcher);
+		}
+	}
+
+	//!
+	//! \brief      Invokes \p function with the concrete type of \p searcher.
+	//!
+	//! This function resolves the type of the searcher once and calls
+	//! \p function(concreteSearcher), so that the neighbor queries inside the
+	//! function use the templated ForEachNearbyPoint of the concrete searcher
+	//! instead of the virtual one. Unknown searcher types are passed as
+	//! PointNeighborSearcher3.
+	//!
+	//! \param[in]  searcher The searcher.
+	//! \param[in]  function The function taking the searcher.
+	//!
+	template <typename Function>
+	void VisitPointNeighborSearcher(const PointNeighborSearcher3& searcher, const Function& function)
+	{
+		if (const auto* parallelHashGrid = Internal::ExactCast<PointParallelHashGridSearcher3>(searcher))
+		{
+			function(*parallelHashGrid);
+		}
+		else if (const auto* hashGrid = Internal::ExactCast<PointHashGridSearcher3>(searcher))
+		{
+			function(*hashGrid);
+		}
+		else if (const auto* kdTree = Internal::ExactCast<PointKdTreeSearcher3>(searcher))
+		{
+			function(*kdTree);
+		}
+		else if (const auto* simpleList = Internal::ExactCast<PointSimpleListSearcher3>(searcher))
+		{
+			function(*simpleList);
+		}
+		else
+		{
+			function(searcher);
+		}
+	}
+}
+
+#endif
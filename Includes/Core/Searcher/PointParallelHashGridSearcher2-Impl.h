@@ -0,0 +1,49 @@
+/*************************************************************************
+> File Name: PointParallelHashGridSearcher2-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Parallel version of hash grid-based 2-D point searcher.
+> Created Time: 2018/06/12
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_PARALLEL_HASH_GRID_SEARCHER2_IMPL_H
+#define CUBBYFLOW_POINT_PARALLEL_HASH_GRID_SEARCHER2_IMPL_H
+
+#include <limits>
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointParallelHashGridSearcher2::ForEachNearbyPoint(const Vector2D& origin, double radius, const Callback& callback) const
+	{
+		size_t nearbyKeys[4];
+		GetNearbyKeys(origin, nearbyKeys);
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			size_t nearbyKey = nearbyKeys[i];
+			size_t start = m_startIndexTable[nearbyKey];
+			size_t end = m_endIndexTable[nearbyKey];
+
+			// Empty bucket -- continue to next bucket
+			if (start == std::numeric_limits<size_t>::max())
+			{
+				continue;
+			}
+
+			for (size_t j = start; j < end; ++j)
+			{
+				Vector2D direction = m_points[j] - origin;
+				double distanceSquared = direction.LengthSquared();
+				if (distanceSquared <= queryRadiusSquared)
+				{
+					callback(m_sortedIndices[j], m_points[j]);
+				}
+			}
+		}
+	}
+}
+
+#endif
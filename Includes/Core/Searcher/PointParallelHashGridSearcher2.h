@@ -75,6 +75,21 @@ namespace CubbyFlow
 		//!
 		void ForEachNearbyPoint(const Vector2D& origin, double radius, const ForEachNearbyPointFunc& callback) const override;
 
+		//!
+		//! \brief Invokes the callback for each nearby point around the origin
+		//!        within given radius.
+		//!
+		//! Same as the virtual overload, but the callback is called directly
+		//! instead of through ForEachNearbyPointFunc, so it can be inlined.
+		//! The callback takes (size_t index, const Vector2D& position).
+		//!
+		//! \param[in]  origin   The origin position.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoint(const Vector2D& origin, double radius, const Callback& callback) const;
+
 		//!
 		//! Returns true if there are any nearby points for given origin within
 		//! radius.
@@ -243,4 +258,6 @@ namespace CubbyFlow
 	};
 }
 
+#include <Core/Searcher/PointParallelHashGridSearcher2-Impl.h>
+
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*************************************************************************
+> File Name: PointParallelHashGridSearcher3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Parallel version of hash grid-based 3-D point searcher.
+> Created Time: 2018/06/12
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_PARALLEL_HASH_GRID_SEARCHER3_IMPL_H
+#define CUBBYFLOW_POINT_PARALLEL_HASH_GRID_SEARCHER3_IMPL_H
+
+#include <Core/Searcher/PointHashGridSearcherUtils3.h>
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
+
+#include <limits>
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointParallelHashGridSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const
+	{
+		size_t nearbyKeys[8];
+		GetNearbyKeys(origin, nearbyKeys);
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			size_t nearbyKey = nearbyKeys[i];
+			size_t start = m_startIndexTable[nearbyKey];
+			size_t end = m_endIndexTable[nearbyKey];
+
+			// Empty bucket -- continue to next bucket
+			if (start == std::numeric_limits<size_t>::max())
+			{
+				continue;
+			}
+
+			for (size_t j = start; j < end; ++j)
+			{
+				Vector3D direction = m_points[j] - origin;
+				double distanceSquared = direction.LengthSquared();
+				if (distanceSquared <= queryRadiusSquared)
+				{
+					callback(m_sortedIndices[j], m_points[j]);
+				}
+			}
+		}
+	}
+
+	template <typename Callback>
+	void PointParallelHashGridSearcher3::ForEachNearbyPoints(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		const Callback& callback) const
+	{
+		std::vector<size_t> queryOrder, groupStarts;
+		Internal::GroupHashGridQueries(*this, m_gridSpacing, origins, &queryOrder, &groupStarts);
+
+		ParallelFor(ZERO_SIZE, groupStarts.size() - 1, [&](size_t g)
+		{
+			ForEachNearbyPointInGroup(origins, radius, queryOrder, groupStarts[g], groupStarts[g + 1], callback);
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+	}
+
+	template <typename Callback>
+	void PointParallelHashGridSearcher3::ForEachNearbyPointInGroup(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		const std::vector<size_t>& queryOrder, size_t begin, size_t end,
+		const Callback& callback) const
+	{
+		// All the queries of a group visit the same buckets
+		size_t nearbyKeys[8];
+		GetNearbyKeys(origins[queryOrder[begin]], nearbyKeys);
+
+		size_t starts[8], ends[8];
+		for (int k = 0; k < 8; ++k)
+		{
+			starts[k] = m_startIndexTable[nearbyKeys[k]];
+			ends[k] = m_endIndexTable[nearbyKeys[k]];
+		}
+
+		const double queryRadiusSquared = radius * radius;
+
+		for (size_t q = begin; q < end; ++q)
+		{
+			const size_t i = queryOrder[q];
+			const Vector3D& origin = origins[i];
+
+			for (int k = 0; k < 8; ++k)
+			{
+				// Empty bucket -- continue to next bucket
+				if (starts[k] == std::numeric_limits<size_t>::max())
+				{
+					continue;
+				}
+
+				for (size_t j = starts[k]; j < ends[k]; ++j)
+				{
+					if ((m_points[j] - origin).LengthSquared() <= queryRadiusSquared)
+					{
+						callback(i, m_sortedIndices[j], m_points[j]);
+					}
+				}
+			}
+		}
+	}
+}
+
+#endif
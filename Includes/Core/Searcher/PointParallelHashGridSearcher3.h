@@ -61,11 +61,41 @@ namespace CubbyFlow
 		//! \brief Builds internal acceleration structure for given points list.
 		//!
 		//! This function builds the hash grid for given points in parallel.
+		//! If the max churn ratio is positive and the number of points did not
+		//! change since the last build, only the points whose bucket changed
+		//! are moved in the sorted arrays and tables. When the ratio of such
+		//! points is larger than the max churn ratio, the grid is fully rebuilt.
 		//!
 		//! \param[in]  points The points to be added.
 		//!
 		void Build(const ConstArrayAccessor1<Vector3D>& points) override;
 
+		//!
+		//! \brief Sets the max ratio of points changing bucket for the
+		//!        incremental update.
+		//!
+		//! Zero (default) disables the incremental update, so that every Build
+		//! call rebuilds the whole grid.
+		//!
+		//! \param[in]  ratio The max churn ratio in [0, 1].
+		//!
+		void SetMaxChurnRatio(double ratio);
+
+		//! Returns the max ratio of points changing bucket for the incremental update.
+		double GetMaxChurnRatio() const;
+
+		//! Returns the grid spacing.
+		double GetGridSpacing() const;
+
+		//! Returns the resolution of the hash table.
+		Size3 GetResolution() const;
+
+		//! Returns the number of Build calls which rebuilt the whole grid.
+		size_t GetNumberOfFullBuilds() const;
+
+		//! Returns the number of Build calls which updated the grid incrementally.
+		size_t GetNumberOfIncrementalUpdates() const;
+
 		//!
 		//! Invokes the callback function for each nearby point around the origin
 		//! within given radius.
@@ -76,6 +106,56 @@ namespace CubbyFlow
 		//!
 		void ForEachNearbyPoint(const Vector3D& origin, double radius, const ForEachNearbyPointFunc& callback) const override;
 
+		//!
+		//! \brief Invokes the callback for each nearby point around the origin
+		//!        within given radius.
+		//!
+		//! Same as the virtual overload, but the callback is called directly
+		//! instead of through ForEachNearbyPointFunc, so it can be inlined.
+		//! The callback takes (size_t index, const Vector3D& position).
+		//!
+		//! \param[in]  origin   The origin position.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const;
+
+		//!
+		//! \brief Invokes the callback for each nearby point of each origin.
+		//!
+		//! The queries are grouped by the buckets they visit and each group is
+		//! processed in parallel, so the bucket tables are read once per group
+		//! instead of once per query. Origins which are already sorted by bucket
+		//! give the best locality. The callback takes (size_t originIndex,
+		//! size_t pointIndex, const Vector3D& position) and is invoked
+		//! concurrently for different origins, but all the neighbors of a given
+		//! origin are visited by the same thread.
+		//!
+		//! \param[in]  origins  The origin positions.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoints(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			const Callback& callback) const;
+
+		//!
+		//! \brief Finds the nearby points of each origin into flat buffers.
+		//!
+		//! The result is stored in compressed (CSR) form: the nearby points of
+		//! origin i are indices[offsets[i]] to indices[offsets[i + 1] - 1].
+		//!
+		//! \param[in]  origins The origin positions.
+		//! \param[in]  radius  The search radius.
+		//! \param[out] offsets The offsets of the lists (size origins + 1).
+		//! \param[out] indices The indices of the nearby points.
+		//!
+		void FindNearbyPoints(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			std::vector<size_t>* offsets, std::vector<size_t>* indices) const;
+
 		//!
 		//! Returns true if there are any nearby points for given origin within
 		//! radius.
@@ -208,10 +288,23 @@ namespace CubbyFlow
 		std::vector<size_t> m_startIndexTable;
 		std::vector<size_t> m_endIndexTable;
 		std::vector<size_t> m_sortedIndices;
+		double m_maxChurnRatio = 0.0;
+		size_t m_numberOfFullBuilds = 0;
+		size_t m_numberOfIncrementalUpdates = 0;
+
+		void BuildFull(const ConstArrayAccessor1<Vector3D>& points);
+
+		bool UpdateIncrementally(const ConstArrayAccessor1<Vector3D>& points);
 
 		size_t GetHashKeyFromPosition(const Vector3D& position) const;
 
 		void GetNearbyKeys(const Vector3D& position, size_t* bucketIndices) const;
+
+		template <typename Callback>
+		void ForEachNearbyPointInGroup(
+			const ConstArrayAccessor1<Vector3D>& origins, double radius,
+			const std::vector<size_t>& queryOrder, size_t begin, size_t end,
+			const Callback& callback) const;
 	};
 
 	//! Shared pointer for the PointParallelHashGridSearcher3 type.
@@ -244,4 +337,6 @@ namespace CubbyFlow
 	};
 }
 
+#include <Core/Searcher/PointParallelHashGridSearcher3-Impl.h>
+
 #endif
\ No newline at end of file
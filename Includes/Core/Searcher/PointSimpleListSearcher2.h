@@ -56,6 +56,21 @@ namespace CubbyFlow
 			double radius,
 			const ForEachNearbyPointFunc& callback) const override;
 
+		//!
+		//! \brief Invokes the callback for each nearby point around the origin
+		//!        within given radius.
+		//!
+		//! Same as the virtual overload, but the callback is called directly
+		//! instead of through ForEachNearbyPointFunc, so it can be inlined.
+		//! The callback takes (size_t index, const Vector2D& position).
+		//!
+		//! \param[in]  origin   The origin position.
+		//! \param[in]  radius   The search radius.
+		//! \param[in]  callback The callback function.
+		//!
+		template <typename Callback>
+		void ForEachNearbyPoint(const Vector2D& origin, double radius, const Callback& callback) const;
+
 		//!
 		//! Returns true if there are any nearby points for given origin within
 		//! radius.
@@ -114,4 +129,6 @@ namespace CubbyFlow
 	};
 }
 
+#include <Core/Searcher/PointSimpleListSearcher2-Impl.h>
+
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+/*************************************************************************
+> File Name: PointSimpleListSearcher3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Simple ad-hoc 3-D point searcher.
+> Created Time: 2018/06/14
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_POINT_SIMPLE_LIST_SEARCHER3_IMPL_H
+#define CUBBYFLOW_POINT_SIMPLE_LIST_SEARCHER3_IMPL_H
+
+namespace CubbyFlow
+{
+	template <typename Callback>
+	void PointSimpleListSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const Callback& callback) const
+	{
+		double radiusSquared = radius * radius;
+
+		for (size_t i = 0; i < m_points.size(); ++i)
+		{
+			Vector3D r = m_points[i] - origin;
+			double distanceSquared = r.Dot(r);
+			if (distanceSquared <= radiusSquared)
+			{
+				callback(i, m_points[i]);
+			}
+		}
+	}
+}
+
+#endif
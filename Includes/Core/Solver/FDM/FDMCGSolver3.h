@@ -26,6 +26,9 @@ namespace CubbyFlow
 		//! Solves the given compressed linear system.
 		bool SolveCompressed(FDMCompressedLinearSystem3* system) override;
 
+		//! Solves the given matrix-free linear system.
+		bool SolveMatrixFree(FDMMatrixFreeLinearSystem3* system) override;
+
 		//! Returns the max number of Jacobi iterations.
 		unsigned int GetMaxNumberOfIterations() const;
 
@@ -38,11 +41,24 @@ namespace CubbyFlow
 		//! Returns the last residual after the Jacobi iterations.
 		double GetLastResidual() const;
 
+		//!
+		//! \brief Sets the precision of the solve (default is Double).
+		//!
+		//! With Single or Mixed, Solve stores the matrix and the vectors in
+		//! single precision (see FDMPrecision). SolveCompressed and
+		//! SolveMatrixFree always run in double precision.
+		//!
+		void SetPrecision(FDMPrecision precision);
+
+		//! Returns the precision of the solve.
+		FDMPrecision GetPrecision() const;
+
 	private:
 		unsigned int m_maxNumberOfIterations;
 		unsigned int m_lastNumberOfIterations;
 		double m_tolerance;
 		double m_lastResidual;
+		FDMPrecision m_precision = FDMPrecision::Double;
 
 		// Uncompressed vectors
 		FDMVector3 m_r;
@@ -50,13 +66,25 @@ namespace CubbyFlow
 		FDMVector3 m_q;
 		FDMVector3 m_s;
 
+		// Single precision matrix and vectors
+		FDMMatrix3F m_AF;
+		FDMVector3F m_xF;
+		FDMVector3F m_bF;
+		FDMVector3F m_rF;
+		FDMVector3F m_dF;
+		FDMVector3F m_qF;
+		FDMVector3F m_sF;
+
 		// Compressed vectors
 		VectorND m_rComp;
 		VectorND m_dComp;
 		VectorND m_qComp;
 		VectorND m_sComp;
 
+		bool SolveSinglePrecision(FDMLinearSystem3* system);
+
 		void ClearUncompressedVectors();
+		void ClearSinglePrecisionVectors();
 		void ClearCompressedVectors();
 	};
 
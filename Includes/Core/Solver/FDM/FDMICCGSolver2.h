@@ -42,12 +42,29 @@ namespace CubbyFlow
 		//! Returns the last residual after the Jacobi iterations.
 		double GetLastResidual() const;
 
+		//!
+		//! \brief Sets true to run the preconditioner sweeps in parallel.
+		//!
+		//! The incomplete Cholesky factorization and the triangular solves are
+		//! level-scheduled: the unknowns are grouped into wavefronts which only
+		//! depend on the previous wavefront, and each wavefront is processed in
+		//! parallel. The result is the same as the serial preconditioner, so the
+		//! number of iterations does not change. Default is false.
+		//!
+		//! \param[in]  isUsing True to use the parallel preconditioner.
+		//!
+		void SetIsUsingParallelPreconditioner(bool isUsing);
+
+		//! Returns true if the preconditioner sweeps run in parallel.
+		bool GetIsUsingParallelPreconditioner() const;
+
 	private:
 		struct Preconditioner final
 		{
 			ConstArrayAccessor2<FDMMatrixRow2> A;
 			FDMVector2 d;
 			FDMVector2 y;
+			bool isParallel = false;
 
 			void Build(const FDMMatrix2& matrix);
 
@@ -59,6 +76,13 @@ namespace CubbyFlow
 			const MatrixCSRD* A;
 			VectorND d;
 			VectorND y;
+			bool isParallel = false;
+
+			// Segments of consecutive rows grouped by level for the parallel
+			// sweeps
+			std::vector<size_t> segmentBegins;
+			std::vector<size_t> levelOffsets;
+			std::vector<size_t> levelSegments;
 
 			void Build(const MatrixCSRD& matrix);
 
@@ -69,6 +93,7 @@ namespace CubbyFlow
 		unsigned int m_lastNumberOfIterations;
 		double m_tolerance;
 		double m_lastResidualNorm;
+		bool m_isUsingParallelPreconditioner = false;
 
 		// Uncompressed vectors and preconditioner
 		FDMVector2 m_r;
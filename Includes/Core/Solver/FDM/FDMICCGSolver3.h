@@ -30,6 +30,14 @@ namespace CubbyFlow
 		//! Solves the given compressed linear system.
 		bool SolveCompressed(FDMCompressedLinearSystem3* system) override;
 
+		//!
+		//! \brief Solves the given matrix-free linear system.
+		//!
+		//! The preconditioner reads the off-diagonal elements from the
+		//! matrix-free rows, so only its diagonal is stored.
+		//!
+		bool SolveMatrixFree(FDMMatrixFreeLinearSystem3* system) override;
+
 		//! Returns the max number of Jacobi iterations.
 		unsigned int GetMaxNumberOfIterations() const;
 
@@ -42,16 +50,48 @@ namespace CubbyFlow
 		//! Returns the last residual after the Jacobi iterations.
 		double GetLastResidual() const;
 
+		//!
+		//! \brief Sets true to run the preconditioner sweeps in parallel.
+		//!
+		//! The incomplete Cholesky factorization and the triangular solves are
+		//! level-scheduled: the unknowns are grouped into wavefronts which only
+		//! depend on the previous wavefront, and each wavefront is processed in
+		//! parallel. The result is the same as the serial preconditioner, so the
+		//! number of iterations does not change. Default is false.
+		//!
+		//! \param[in]  isUsing True to use the parallel preconditioner.
+		//!
+		void SetIsUsingParallelPreconditioner(bool isUsing);
+
+		//! Returns true if the preconditioner sweeps run in parallel.
+		bool GetIsUsingParallelPreconditioner() const;
+
+		//!
+		//! \brief Sets the precision of the solve (default is Double).
+		//!
+		//! With Single or Mixed, Solve stores the matrix, the preconditioner and
+		//! the vectors in single precision (see FDMPrecision). SolveCompressed
+		//! and SolveMatrixFree always run in double precision.
+		//!
+		void SetPrecision(FDMPrecision precision);
+
+		//! Returns the precision of the solve.
+		FDMPrecision GetPrecision() const;
+
 	private:
+		// MatrixType is a matrix accessor which returns the rows by (i, j, k),
+		// such as ConstArrayAccessor3<FDMMatrixRow3> or FDMMatrixFree3.
+		template <typename T, typename MatrixType>
 		struct Preconditioner final
 		{
-			ConstArrayAccessor3<FDMMatrixRow3> A;
-			FDMVector3 d;
-			FDMVector3 y;
+			MatrixType A;
+			Array3<T> d;
+			Array3<T> y;
+			bool isParallel = false;
 
-			void Build(const FDMMatrix3& matrix);
+			void Build(const MatrixType& matrix);
 
-			void Solve(const FDMVector3& b, FDMVector3* x);
+			void Solve(const Array3<T>& b, Array3<T>* x);
 		};
 
 		struct PreconditionerCompressed final
@@ -59,6 +99,13 @@ namespace CubbyFlow
 			const MatrixCSRD* A;
 			VectorND d;
 			VectorND y;
+			bool isParallel = false;
+
+			// Segments of consecutive rows grouped by level for the parallel
+			// sweeps
+			std::vector<size_t> segmentBegins;
+			std::vector<size_t> levelOffsets;
+			std::vector<size_t> levelSegments;
 
 			void Build(const MatrixCSRD& matrix);
 
@@ -69,13 +116,28 @@ namespace CubbyFlow
 		unsigned int m_lastNumberOfIterations;
 		double m_tolerance;
 		double m_lastResidualNorm;
+		bool m_isUsingParallelPreconditioner = false;
+		FDMPrecision m_precision = FDMPrecision::Double;
 
 		// Uncompressed vectors and preconditioner
 		FDMVector3 m_r;
 		FDMVector3 m_d;
 		FDMVector3 m_q;
 		FDMVector3 m_s;
-		Preconditioner m_precond;
+		Preconditioner<double, ConstArrayAccessor3<FDMMatrixRow3>> m_precond;
+
+		// Matrix-free preconditioner
+		Preconditioner<double, FDMMatrixFree3> m_precondMatrixFree;
+
+		// Single precision matrix, vectors and preconditioner
+		FDMMatrix3F m_AF;
+		FDMVector3F m_xF;
+		FDMVector3F m_bF;
+		FDMVector3F m_rF;
+		FDMVector3F m_dF;
+		FDMVector3F m_qF;
+		FDMVector3F m_sF;
+		Preconditioner<float, ConstArrayAccessor3<FDMMatrixRow3F>> m_precondF;
 
 		// Compressed vectors and preconditioner
 		VectorND m_rComp;
@@ -84,7 +146,10 @@ namespace CubbyFlow
 		VectorND m_sComp;
 		PreconditionerCompressed m_precondComp;
 
+		bool SolveSinglePrecision(FDMLinearSystem3* system);
+
 		void ClearUncompressedVectors();
+		void ClearSinglePrecisionVectors();
 		void ClearCompressedVectors();
 	};
 
@@ -0,0 +1,74 @@
+/*************************************************************************
+> File Name: FDMIterativeRefinement3-Impl.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Single and mixed precision driver for the 3-D Krylov solvers.
+> Created Time: 2018/06/11
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_FDM_ITERATIVE_REFINEMENT3_IMPL_H
+#define CUBBYFLOW_FDM_ITERATIVE_REFINEMENT3_IMPL_H
+
+namespace CubbyFlow
+{
+	namespace Internal
+	{
+		// Max number of single precision solves in the mixed precision mode
+		constexpr unsigned int MAX_NUMBER_OF_REFINEMENTS = 10;
+
+		// Residual reduction asked from each single precision solve
+		constexpr double REFINEMENT_REDUCTION = 1e-4;
+	}
+
+	template <typename InnerSolve>
+	void FDMIterativeRefinement3(
+		const FDMMatrix3& A,
+		const FDMVector3& b,
+		FDMPrecision precision,
+		unsigned int maxNumberOfIterations,
+		double tolerance,
+		const InnerSolve& innerSolve,
+		FDMVector3F* r,
+		FDMVector3F* e,
+		FDMVector3* x,
+		unsigned int* lastNumberOfIterations,
+		double* lastResidualNorm)
+	{
+		const bool isMixed = (precision == FDMPrecision::Mixed);
+		const unsigned int maxNumberOfRefinements = isMixed ? Internal::MAX_NUMBER_OF_REFINEMENTS : 1;
+
+		x->Set(0.0);
+		*lastNumberOfIterations = 0;
+
+		for (unsigned int refinement = 0; ; ++refinement)
+		{
+			// r = b - Ax in double precision, stored in single precision
+			FDMBLAS3F::Residual(A, *x, b, r);
+			*lastResidualNorm = FDMBLAS3F::L2Norm(*r);
+
+			if (*lastResidualNorm <= tolerance ||
+				refinement == maxNumberOfRefinements ||
+				*lastNumberOfIterations >= maxNumberOfIterations)
+			{
+				break;
+			}
+
+			// Solve Ae = r in single precision, then x = x + e
+			const double innerTolerance = isMixed ? Internal::REFINEMENT_REDUCTION * *lastResidualNorm : tolerance;
+			unsigned int numberOfIterations = 0;
+
+			e->Set(0.0f);
+			innerSolve(maxNumberOfIterations - *lastNumberOfIterations, innerTolerance, &numberOfIterations);
+
+			FDMBLAS3F::AXPlusY(1.0, *e, *x, x);
+			*lastNumberOfIterations += numberOfIterations;
+
+			if (numberOfIterations == 0)
+			{
+				break;
+			}
+		}
+	}
+}
+
+#endif
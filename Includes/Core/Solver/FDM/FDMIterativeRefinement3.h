@@ -0,0 +1,47 @@
+/*************************************************************************
+> File Name: FDMIterativeRefinement3.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Single and mixed precision driver for the 3-D Krylov solvers.
+> Created Time: 2018/06/11
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_FDM_ITERATIVE_REFINEMENT3_H
+#define CUBBYFLOW_FDM_ITERATIVE_REFINEMENT3_H
+
+#include <Core/Solver/FDM/FDMLinearSystemSolver3.h>
+
+namespace CubbyFlow
+{
+	//!
+	//! \brief Solves Ax = b with single precision solves of the correction.
+	//!
+	//! The residual r = b - Ax is computed in double precision from the double
+	//! system and stored in \p r. \p innerSolve then solves Ae = r in single
+	//! precision into \p e, and e is added to x in double precision. With
+	//! FDMPrecision::Single this is done once and \p innerSolve is asked for
+	//! \p tolerance. With FDMPrecision::Mixed it is repeated until the true
+	//! residual meets \p tolerance, each solve reducing the residual by a fixed
+	//! factor. \p x is reset to zero first.
+	//!
+	//! \p innerSolve is called as innerSolve(maxNumberOfIterations, tolerance,
+	//! &numberOfIterations), reading \p r and writing \p e.
+	//!
+	template <typename InnerSolve>
+	void FDMIterativeRefinement3(
+		const FDMMatrix3& A,
+		const FDMVector3& b,
+		FDMPrecision precision,
+		unsigned int maxNumberOfIterations,
+		double tolerance,
+		const InnerSolve& innerSolve,
+		FDMVector3F* r,
+		FDMVector3F* e,
+		FDMVector3* x,
+		unsigned int* lastNumberOfIterations,
+		double* lastResidualNorm);
+}
+
+#include <Core/Solver/FDM/FDMIterativeRefinement3-Impl.h>
+
+#endif
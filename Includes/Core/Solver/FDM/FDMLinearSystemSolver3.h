@@ -13,6 +13,30 @@
 
 namespace CubbyFlow
 {
+	//!
+	//! \brief Floating-point precision of the 3-D Krylov solvers.
+	//!
+	//! Double solves in double precision. Single stores the matrix and the
+	//! Krylov vectors in single precision, which halves the memory traffic per
+	//! iteration, but the residual cannot drop much below 1e-6 of the
+	//! right-hand side. Mixed runs the single precision solver inside an
+	//! iterative refinement in double precision, which recovers the accuracy of
+	//! Double at the cost of restarting the Krylov iterations.
+	//!
+	//! The single precision copy of the system is built from the double
+	//! FDMLinearSystem3, which Mixed needs for its residuals, so Single and
+	//! Mixed add to the memory footprint instead of halving it; the gain is
+	//! the memory traffic per iteration. Only FDMCGSolver3 and FDMICCGSolver3
+	//! support it. The Jacobi, Gauss-Seidel, MG and MGPCG solvers always run
+	//! in double precision.
+	//!
+	enum class FDMPrecision
+	{
+		Double,
+		Single,
+		Mixed
+	};
+
 	//! Abstract base class for 3-D finite difference-type linear system solver.
 	class FDMLinearSystemSolver3
 	{
@@ -27,6 +51,28 @@ namespace CubbyFlow
 		{
 			return false;
 		}
+
+		//!
+		//! \brief Solves the given matrix-free linear system.
+		//!
+		//! By default, the matrix is assembled and the system is solved by
+		//! Solve. The solvers which can work on the matrix-free rows directly
+		//! override this function to avoid storing the matrix.
+		//!
+		virtual bool SolveMatrixFree(FDMMatrixFreeLinearSystem3* system)
+		{
+			FDMLinearSystem3 assembled;
+			FDMMatrixFreeBLAS3::Set(system->A, &assembled.A);
+			assembled.x.Swap(system->x);
+			assembled.b.Swap(system->b);
+
+			const bool result = Solve(&assembled);
+
+			assembled.x.Swap(system->x);
+			assembled.b.Swap(system->b);
+
+			return result;
+		}
 	};
 
 	//! Shared pointer type for the FDMLinearSystemSolver3.
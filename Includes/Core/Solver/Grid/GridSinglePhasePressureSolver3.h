@@ -91,10 +91,29 @@ namespace CubbyFlow
 		//! Returns the pressure field.
 		const FDMVector3& GetPressure() const;
 
+		//!
+		//! \brief Sets true to solve the pressure with the matrix-free system.
+		//!
+		//! Instead of assembling FDMMatrix3, the rows of the pressure system are
+		//! derived from the cell markers and the grid spacing whenever they are
+		//! needed (see FDMMatrixFree3). This removes the matrix storage, four
+		//! doubles per cell, and its memory traffic in each iteration of the
+		//! linear system solver. It applies when neither the compressed system
+		//! nor the multigrid solver is used. Default is false.
+		//!
+		//! \param[in]  isUsing True to use the matrix-free system.
+		//!
+		void SetIsUsingMatrixFree(bool isUsing);
+
+		//! Returns true if the pressure is solved with the matrix-free system.
+		bool GetIsUsingMatrixFree() const;
+
 	private:
 		FDMLinearSystem3 m_system;
 		FDMCompressedLinearSystem3 m_compSystem;
+		FDMMatrixFreeLinearSystem3 m_matrixFreeSystem;
 		FDMLinearSystemSolver3Ptr m_systemSolver;
+		bool m_isUsingMatrixFree = false;
 
 		FDMMGLinearSystem3 m_mgSystem;
 		FDMMGSolver3Ptr m_mgSystemSolver;
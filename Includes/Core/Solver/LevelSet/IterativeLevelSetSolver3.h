@@ -9,8 +9,11 @@
 #ifndef CUBBYFLOW_ITERATIVE_LEVEL_SET_SOLVER3_H
 #define CUBBYFLOW_ITERATIVE_LEVEL_SET_SOLVER3_H
 
+#include <Core/Point/Point3.h>
 #include <Core/Solver/LevelSet/LevelSetSolver3.h>
 
+#include <vector>
+
 namespace CubbyFlow
 {
 	//!
@@ -100,6 +103,24 @@ namespace CubbyFlow
 		//!
 		void SetMaxCFL(double newMaxCFL);
 
+		//! Returns true if only the cells in a narrow band are updated.
+		bool GetIsUsingNarrowBand() const;
+
+		//!
+		//! \brief Sets true to update only the cells in a narrow band.
+		//!
+		//! In the narrow band mode, Reinitialize updates the cells whose input
+		//! distance to the surface is within maxDistance, and Extrapolate updates
+		//! the cells outside the surface within maxDistance, plus a margin of a
+		//! few cells for the derivative stencils. The band is stored as a list of
+		//! active cells, so the cost of each iteration is proportional to the
+		//! surface area instead of the volume. The cells outside the band keep
+		//! their input values. Default is false.
+		//!
+		//! \param[in]  isUsing True to use the narrow band.
+		//!
+		void SetIsUsingNarrowBand(bool isUsing);
+
 	protected:
 		//! Computes the derivatives for given grid point.
 		virtual void GetDerivatives(
@@ -110,6 +131,7 @@ namespace CubbyFlow
 
 	private:
 		double m_maxCFL = 0.5;
+		bool m_isUsingNarrowBand = false;
 
 		void Extrapolate(
 			const ConstArrayAccessor3<double>& input,
@@ -118,6 +140,26 @@ namespace CubbyFlow
 			double maxDistance,
 			ArrayAccessor3<double> output);
 
+		double ReinitializeStep(
+			const ConstArrayAccessor3<double>& sdf,
+			const Vector3D& gridSpacing,
+			double dtau,
+			size_t i, size_t j, size_t k) const;
+
+		double ExtrapolateStep(
+			const ConstArrayAccessor3<double>& input,
+			const ConstArrayAccessor3<double>& sdf,
+			const Vector3D& gridSpacing,
+			double dtau,
+			size_t i, size_t j, size_t k) const;
+
+		static void BuildNarrowBand(
+			const ConstArrayAccessor3<double>& sdf,
+			double lower, double upper,
+			std::vector<Point3UI>* band);
+
+		static double NarrowBandMargin(const Vector3D& gridSpacing);
+
 		static unsigned int DistanceToNumberOfIterations(double distance, double dtau);
 
 		static double Sign(
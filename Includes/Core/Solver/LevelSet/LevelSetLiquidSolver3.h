@@ -51,6 +51,18 @@ namespace CubbyFlow
 		//! Sets the level set solver.
 		void SetLevelSetSolver(const LevelSetSolver3Ptr& newSolver);
 
+		//! Returns the level set solver used for velocity extrapolation.
+		LevelSetSolver3Ptr GetVelocityExtrapolator() const;
+
+		//!
+		//! \brief Sets the level set solver used for velocity extrapolation.
+		//!
+		//! The default is FMMLevelSetSolver3. FastSweepingLevelSetSolver3 is
+		//! faster once several cores are available, but slower on a single
+		//! core, and may break ties between equal SDF values differently.
+		//!
+		void SetVelocityExtrapolator(const LevelSetSolver3Ptr& newExtrapolator);
+
 		//! Sets minimum reinitialization distance.
 		void SetMinReinitializeDistance(double distance);
 
@@ -102,6 +114,7 @@ namespace CubbyFlow
 	private:
 		size_t m_signedDistanceFieldId;
 		LevelSetSolver3Ptr m_levelSetSolver;
+		LevelSetSolver3Ptr m_velocityExtrapolator;
 		double m_minReinitializeDistance = 10.0;
 		bool m_isGlobalCompensationEnabled = false;
 		double m_lastKnownVolume = 0.0;
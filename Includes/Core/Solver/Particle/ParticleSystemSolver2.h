@@ -113,6 +113,21 @@ namespace CubbyFlow
 		//!
 		void SetWind(const VectorField2Ptr& newWind);
 
+		//! Returns the number of time-steps between two particle sorts.
+		size_t GetParticleSortingInterval() const;
+
+		//!
+		//! \brief      Sets the number of time-steps between two particle sorts.
+		//!
+		//! When the interval is positive, the particles are sorted in Morton
+		//! order every \p newInterval time-steps using
+		//! ParticleSystemData2::SortParticles, which keeps nearby particles
+		//! close in memory as the fluid mixes. Zero (default) disables sorting.
+		//!
+		//! \param[in]  newInterval The new interval in time-steps.
+		//!
+		void SetParticleSortingInterval(size_t newInterval);
+
 		//! Returns builder fox ParticleSystemSolver2.
 		static Builder GetBuilder();
 
@@ -155,6 +170,8 @@ namespace CubbyFlow
 		Collider2Ptr m_collider;
 		ParticleEmitter2Ptr m_emitter;
 		VectorField2Ptr m_wind;
+		size_t m_particleSortingInterval = 0;
+		size_t m_numberOfStepsSinceSorting = 0;
 
 		void BeginAdvanceTimeStep(double timeStepInSeconds);
 
@@ -113,6 +113,21 @@ namespace CubbyFlow
 		//!
 		void SetWind(const VectorField3Ptr& newWind);
 
+		//! Returns the number of time-steps between two particle sorts.
+		size_t GetParticleSortingInterval() const;
+
+		//!
+		//! \brief      Sets the number of time-steps between two particle sorts.
+		//!
+		//! When the interval is positive, the particles are sorted in Morton
+		//! order every \p newInterval time-steps using
+		//! ParticleSystemData3::SortParticles, which keeps nearby particles
+		//! close in memory as the fluid mixes. Zero (default) disables sorting.
+		//!
+		//! \param[in]  newInterval The new interval in time-steps.
+		//!
+		void SetParticleSortingInterval(size_t newInterval);
+
 		//! Returns builder fox ParticleSystemSolver3.
 		static Builder GetBuilder();
 
@@ -153,6 +168,8 @@ namespace CubbyFlow
 		Collider3Ptr m_collider;
 		ParticleEmitter3Ptr m_emitter;
 		VectorField3Ptr m_wind;
+		size_t m_particleSortingInterval = 0;
+		size_t m_numberOfStepsSinceSorting = 0;
 
 		void BeginAdvanceTimeStep(double timeStepInSeconds);
 
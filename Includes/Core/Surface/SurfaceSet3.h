@@ -40,7 +40,13 @@ namespace CubbyFlow
 		//! Copy constructor.
 		SurfaceSet3(const SurfaceSet3& other);
 
-		//! Updates internal spatial query engine.
+		//!
+		//! \brief Updates internal spatial query engine.
+		//!
+		//! The query engines of the surfaces are updated first. Since the
+		//! surfaces may have moved, the hierarchy is then refitted to their
+		//! current bounds, and rebuilt only if its quality has degraded.
+		//!
 		void UpdateQueryEngine() override;
 
 		//! Returns the number of surfaces.
@@ -59,6 +65,7 @@ namespace CubbyFlow
 		std::vector<Surface3Ptr> m_surfaces;
 		mutable BVH3<Surface3Ptr> m_bvh;
 		mutable bool m_bvhInvalidated = true;
+		mutable bool m_bvhBoundsInvalidated = false;
 
 		// Surface3 implementations
 		Vector3D ClosestPointLocal(const Vector3D& otherPoint) const override;
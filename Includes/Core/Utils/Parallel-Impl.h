@@ -16,6 +16,7 @@
 #include <hpx/include/future.hpp>
 #include <hpx/include/parallel_fill.hpp>
 #include <hpx/include/parallel_for_each.hpp>
+#include <hpx/include/parallel_executor_parameters.hpp>
 #include <hpx/include/parallel_for_loop.hpp>
 #include <hpx/include/parallel_reduce.hpp>
 #include <hpx/include/parallel_sort.hpp>
@@ -27,12 +28,15 @@
 #include <tbb/parallel_sort.h>
 #include <tbb/task.h>
 #elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
-#include <thread>
+#include <Core/Utils/ThreadPool.h>
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <future>
+#include <type_traits>
 #include <vector>
 
 #undef max
@@ -83,6 +87,154 @@ inline auto Async(TASK&& fn) -> future<operator_return_t<TASK>> {
 #endif
 }
 
+#if defined(CUBBYFLOW_TASKING_CPP11THREAD)
+// Splits [beginIndex, endIndex) into at most numThreads slices and runs
+// function(sliceIndex, sliceBegin, sliceEnd) for each of them on the
+// persistent thread pool.
+template <typename IndexType, typename Function>
+void RunSlicesOnThreadPool(IndexType beginIndex, IndexType endIndex,
+                           unsigned int numThreads, const Function& function) {
+    // Size of a slice for the range functions
+    IndexType n = endIndex - beginIndex + 1;
+    IndexType slice = static_cast<IndexType>(
+        std::round(n / static_cast<double>(numThreads)));
+    slice = std::max(slice, IndexType(1));
+
+    std::vector<IndexType> bounds;
+    bounds.reserve(numThreads + 1);
+    bounds.push_back(beginIndex);
+
+    IndexType i1 = beginIndex;
+    IndexType i2 = std::min(beginIndex + slice, endIndex);
+
+    for (unsigned int i = 0; i + 1 < numThreads && i1 < endIndex; ++i) {
+        bounds.push_back(i2);
+        i1 = i2;
+        i2 = std::min(i2 + slice, endIndex);
+    }
+
+    if (i1 < endIndex) {
+        bounds.push_back(endIndex);
+    }
+
+    ThreadPool::GetInstance().Run(bounds.size() - 1, [&](size_t s) {
+        function(s, bounds[s], bounds[s + 1]);
+    });
+}
+#endif
+
+// Returns the number of iterations per chunk for the given partitioning
+// policy. A zero grain size is replaced with a sensible default for the mode.
+inline size_t ChunkSize(size_t n, unsigned int numThreads,
+                        const PartitionPolicy& partition) {
+    if (partition.grainSize > 0) {
+        return partition.grainSize;
+    }
+
+    switch (partition.mode) {
+        case PartitionMode::Static:
+            return std::max((n + numThreads - 1) / numThreads, ONE_SIZE);
+        case PartitionMode::Dynamic:
+            return std::max(n / (8 * numThreads), ONE_SIZE);
+        default:
+            return 1;
+    }
+}
+
+#if defined(CUBBYFLOW_TASKING_TBB)
+template <typename Range, typename Body>
+void TBBParallelFor(const Range& range, const Body& body, PartitionMode mode) {
+    switch (mode) {
+        case PartitionMode::Static:
+            tbb::parallel_for(range, body, tbb::static_partitioner());
+            break;
+        case PartitionMode::Dynamic:
+            tbb::parallel_for(range, body, tbb::simple_partitioner());
+            break;
+        case PartitionMode::Guided:
+            tbb::parallel_for(range, body, tbb::auto_partitioner());
+            break;
+    }
+}
+#elif defined(CUBBYFLOW_TASKING_OPENMP)
+// Chunk indices are signed since some OpenMP implementations only accept
+// signed loop variables.
+template <typename Function>
+void OpenMPForEachChunk(size_t numChunks, PartitionMode mode,
+                        const Function& function) {
+    const std::int64_t n = static_cast<std::int64_t>(numChunks);
+
+    switch (mode) {
+        case PartitionMode::Static:
+#pragma omp parallel for schedule(static, 1)
+            for (std::int64_t c = 0; c < n; ++c) {
+                function(static_cast<size_t>(c));
+            }
+            break;
+        case PartitionMode::Dynamic:
+#pragma omp parallel for schedule(dynamic, 1)
+            for (std::int64_t c = 0; c < n; ++c) {
+                function(static_cast<size_t>(c));
+            }
+            break;
+        case PartitionMode::Guided:
+#pragma omp parallel for schedule(guided, 1)
+            for (std::int64_t c = 0; c < n; ++c) {
+                function(static_cast<size_t>(c));
+            }
+            break;
+    }
+}
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+// Runs function(chunkBegin, chunkEnd) over [beginIndex, endIndex) on the
+// persistent thread pool following the given partitioning policy.
+template <typename IndexType, typename Function>
+void RunPartitionedOnThreadPool(IndexType beginIndex, IndexType endIndex,
+                                unsigned int numThreads,
+                                const PartitionPolicy& partition,
+                                const Function& function) {
+    const size_t n = static_cast<size_t>(endIndex - beginIndex);
+    const size_t grain = ChunkSize(n, numThreads, partition);
+    const size_t numChunks = (n + grain - 1) / grain;
+    const size_t numTasks = std::min<size_t>(numThreads, numChunks);
+
+    auto launchChunk = [&](size_t k1, size_t k2) {
+        function(beginIndex + static_cast<IndexType>(k1),
+                 beginIndex + static_cast<IndexType>(k2));
+    };
+
+    if (partition.mode == PartitionMode::Static) {
+        // Chunks are dealt to the tasks round-robin up front
+        ThreadPool::GetInstance().Run(numTasks, [&](size_t t) {
+            for (size_t c = t; c < numChunks; c += numTasks) {
+                launchChunk(c * grain, std::min(n, (c + 1) * grain));
+            }
+        });
+        return;
+    }
+
+    // Tasks claim their next chunk from a shared counter
+    std::atomic<size_t> next(0);
+
+    ThreadPool::GetInstance().Run(numTasks, [&](size_t) {
+        size_t k1 = next.load();
+
+        while (k1 < n) {
+            size_t chunk = grain;
+            if (partition.mode == PartitionMode::Guided) {
+                chunk = std::max(grain, (n - k1 + numThreads - 1) / numThreads);
+            }
+
+            const size_t k2 = std::min(n, k1 + chunk);
+            if (next.compare_exchange_weak(k1, k2)) {
+                launchChunk(k1, k2);
+                k1 = next.load();
+            }
+        }
+    });
+}
+#endif
+
 // Adopted from:
 // Radenski, A.
 // Shared Memory, Message Passing, and Hybrid Merge Sorts for Standalone and
@@ -133,6 +285,18 @@ void ParallelMergeSort(RandomIterator a, size_t size, RandomIterator2 temp,
     if (numThreads == 1) {
         std::sort(a, a + size, compareFunction);
     } else if (numThreads > 1) {
+#if defined(CUBBYFLOW_TASKING_CPP11THREAD)
+        ThreadPool::GetInstance().Run(2, [&](size_t half) {
+            if (half == 0) {
+                ParallelMergeSort(a, size / 2, temp, numThreads / 2,
+                                  compareFunction);
+            } else {
+                ParallelMergeSort(a + size / 2, size - size / 2,
+                                  temp + size / 2, numThreads - numThreads / 2,
+                                  compareFunction);
+            }
+        });
+#else
         std::vector<CubbyFlow::Internal::future<void>> pool;
         pool.reserve(2);
 
@@ -156,6 +320,7 @@ void ParallelMergeSort(RandomIterator a, size_t size, RandomIterator2 temp,
                 f.wait();
             }
         }
+#endif
 
         Merge(a, size, temp, compareFunction);
     }
@@ -200,41 +365,14 @@ void ParallelFor(IndexType beginIndex, IndexType endIndex,
         const unsigned int numThreads =
             numThreadsHint == 0u ? 8u : numThreadsHint;
 
-        // Size of a slice for the range functions
-        IndexType n = endIndex - beginIndex + 1;
-        IndexType slice = static_cast<IndexType>(
-            std::round(n / static_cast<double>(numThreads)));
-        slice = std::max(slice, IndexType(1));
-
-        // [Helper] Inner loop
-        auto launchRange = [&function](IndexType k1, IndexType k2) {
-            for (IndexType k = k1; k < k2; ++k) {
-                function(k);
-            }
-        };
-
-        // Create pool and launch jobs
-        std::vector<std::thread> pool;
-        pool.reserve(numThreads);
-        IndexType i1 = beginIndex;
-        IndexType i2 = std::min(beginIndex + slice, endIndex);
-
-        for (unsigned int i = 0; i + 1 < numThreads && i1 < endIndex; ++i) {
-            pool.emplace_back(launchRange, i1, i2);
-            i1 = i2;
-            i2 = std::min(i2 + slice, endIndex);
-        }
-
-        if (i1 < endIndex) {
-            pool.emplace_back(launchRange, i1, endIndex);
-        }
-
-        // Wait for jobs to finish
-        for (std::thread& t : pool) {
-            if (t.joinable()) {
-                t.join();
-            }
-        }
+        // Launch jobs on the persistent pool and wait for them to finish
+        Internal::RunSlicesOnThreadPool(
+            beginIndex, endIndex, numThreads,
+            [&function](size_t, IndexType k1, IndexType k2) {
+                for (IndexType k = k1; k < k2; ++k) {
+                    function(k);
+                }
+            });
 #else
         (void)policy;
 
@@ -251,7 +389,6 @@ void ParallelFor(IndexType beginIndex, IndexType endIndex,
         for (auto i = beginIndex; i < endIndex; ++i) {
             function(i);
         }
-    }
 #endif  // CUBBYFLOW_TASKING_OPENMP
 #endif
     } else {
@@ -259,7 +396,7 @@ void ParallelFor(IndexType beginIndex, IndexType endIndex,
             function(i);
         }
     }
-}  // namespace CubbyFlow
+}
 
 template <typename IndexType, typename Function>
 void ParallelRangeFor(IndexType beginIndex, IndexType endIndex,
@@ -275,6 +412,18 @@ void ParallelRangeFor(IndexType beginIndex, IndexType endIndex,
             [&function](const tbb::blocked_range<IndexType>& range) {
                 function(range.begin(), range.end());
             });
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+        // Estimate number of threads in the pool
+        const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+        const unsigned int numThreads =
+            numThreadsHint == 0u ? 8u : numThreadsHint;
+
+        // Launch jobs on the persistent pool and wait for them to finish
+        Internal::RunSlicesOnThreadPool(
+            beginIndex, endIndex, numThreads,
+            [&function](size_t, IndexType k1, IndexType k2) {
+                function(k1, k2);
+            });
 #else
         // Estimate number of threads in the pool
         const unsigned int numThreadsHint = GetMaxNumberOfThreads();
@@ -316,6 +465,106 @@ void ParallelRangeFor(IndexType beginIndex, IndexType endIndex,
     }
 }
 
+template <typename IndexType, typename Function>
+void ParallelRangeFor(IndexType beginIndex, IndexType endIndex,
+                      const Function& function,
+                      const PartitionPolicy& partition,
+                      ExecutionPolicy policy) {
+    if (beginIndex > endIndex) {
+        return;
+    }
+
+    if (policy == ExecutionPolicy::Parallel) {
+        // Estimate number of threads in the pool
+        const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+        const unsigned int numThreads =
+            numThreadsHint == 0u ? 8u : numThreadsHint;
+
+        const size_t n = static_cast<size_t>(endIndex - beginIndex);
+        const size_t grain = Internal::ChunkSize(n, numThreads, partition);
+
+#if defined(CUBBYFLOW_TASKING_TBB)
+        Internal::TBBParallelFor(
+            tbb::blocked_range<IndexType>(beginIndex, endIndex,
+                                          static_cast<IndexType>(grain)),
+            [&function](const tbb::blocked_range<IndexType>& range) {
+                function(range.begin(), range.end());
+            },
+            partition.mode);
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+        (void)grain;
+        Internal::RunPartitionedOnThreadPool(beginIndex, endIndex, numThreads,
+                                             partition, function);
+#else
+        const size_t numChunks = (n + grain - 1) / grain;
+        auto launchChunk = [&](size_t c) {
+            function(beginIndex + static_cast<IndexType>(c * grain),
+                     beginIndex +
+                         static_cast<IndexType>(std::min(n, (c + 1) * grain)));
+        };
+
+#if defined(CUBBYFLOW_TASKING_OPENMP)
+        Internal::OpenMPForEachChunk(numChunks, partition.mode, launchChunk);
+#elif defined(CUBBYFLOW_TASKING_HPX)
+        // One chunk of the range per loop iteration
+        ParallelFor(ZERO_SIZE, numChunks, launchChunk,
+                    PartitionPolicy{ partition.mode, 1 }, policy);
+#else   // CUBBYFLOW_TASKING_SERIAL
+        for (size_t c = 0; c < numChunks; ++c) {
+            launchChunk(c);
+        }
+#endif
+#endif
+    } else {
+        function(beginIndex, endIndex);
+    }
+}
+
+template <typename IndexType, typename Function>
+void ParallelFor(IndexType beginIndex, IndexType endIndex,
+                 const Function& function, const PartitionPolicy& partition,
+                 ExecutionPolicy policy) {
+    if (beginIndex > endIndex) {
+        return;
+    }
+
+#if defined(CUBBYFLOW_TASKING_HPX)
+    if (policy == ExecutionPolicy::Parallel) {
+        using namespace hpx::parallel::execution;
+
+        switch (partition.mode) {
+            case PartitionMode::Static:
+                hpx::parallel::for_loop(
+                    par.with(static_chunk_size(partition.grainSize)),
+                    beginIndex, endIndex, function);
+                break;
+            case PartitionMode::Dynamic:
+                hpx::parallel::for_loop(
+                    par.with(dynamic_chunk_size(
+                        std::max(partition.grainSize, ONE_SIZE))),
+                    beginIndex, endIndex, function);
+                break;
+            case PartitionMode::Guided:
+                hpx::parallel::for_loop(
+                    par.with(guided_chunk_size(
+                        std::max(partition.grainSize, ONE_SIZE))),
+                    beginIndex, endIndex, function);
+                break;
+        }
+
+        return;
+    }
+#endif
+
+    ParallelRangeFor(beginIndex, endIndex,
+                     [&function](IndexType k1, IndexType k2) {
+                         for (IndexType k = k1; k < k2; ++k) {
+                             function(k);
+                         }
+                     },
+                     partition, policy);
+}
+
 template <typename IndexType, typename Function>
 void ParallelFor(IndexType beginIndexX, IndexType endIndexX,
                  IndexType beginIndexY, IndexType endIndexY,
@@ -329,6 +578,20 @@ void ParallelFor(IndexType beginIndexX, IndexType endIndexX,
                 policy);
 }
 
+template <typename IndexType, typename Function>
+void ParallelFor(IndexType beginIndexX, IndexType endIndexX,
+                 IndexType beginIndexY, IndexType endIndexY,
+                 const Function& function, const PartitionPolicy& partition,
+                 ExecutionPolicy policy) {
+    ParallelFor(beginIndexY, endIndexY,
+                [&](IndexType j) {
+                    for (IndexType i = beginIndexX; i < endIndexX; ++i) {
+                        function(i, j);
+                    }
+                },
+                partition, policy);
+}
+
 template <typename IndexType, typename Function>
 void ParallelRangeFor(IndexType beginIndexX, IndexType endIndexX,
                       IndexType beginIndexY, IndexType endIndexY,
@@ -356,6 +619,23 @@ void ParallelFor(IndexType beginIndexX, IndexType endIndexX,
                 policy);
 }
 
+template <typename IndexType, typename Function>
+void ParallelFor(IndexType beginIndexX, IndexType endIndexX,
+                 IndexType beginIndexY, IndexType endIndexY,
+                 IndexType beginIndexZ, IndexType endIndexZ,
+                 const Function& function, const PartitionPolicy& partition,
+                 ExecutionPolicy policy) {
+    ParallelFor(beginIndexZ, endIndexZ,
+                [&](IndexType k) {
+                    for (IndexType j = beginIndexY; j < endIndexY; ++j) {
+                        for (IndexType i = beginIndexX; i < endIndexX; ++i) {
+                            function(i, j, k);
+                        }
+                    }
+                },
+                partition, policy);
+}
+
 template <typename IndexType, typename Function>
 void ParallelRangeFor(IndexType beginIndexX, IndexType endIndexX,
                       IndexType beginIndexY, IndexType endIndexY,
@@ -369,6 +649,84 @@ void ParallelRangeFor(IndexType beginIndexX, IndexType endIndexX,
                      policy);
 }
 
+template <typename SlabFunction, typename Function>
+void ParallelScatter(size_t numItems, size_t numSlabs,
+                     const SlabFunction& slabFunction,
+                     const Function& function, ExecutionPolicy policy) {
+    if (numItems == 0 || numSlabs == 0) {
+        return;
+    }
+
+    // Stable counting sort of the items by slab. The items are split into
+    // contiguous chunks which count and place their own items in parallel;
+    // only the (slab, chunk) prefix sum, which does not depend on the number
+    // of items, is serial.
+    const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+    size_t numChunks = ONE_SIZE;
+    if (policy == ExecutionPolicy::Parallel) {
+        numChunks = std::min(
+            numItems, static_cast<size_t>(
+                          numThreadsHint == 0u ? 8u : numThreadsHint));
+    }
+    const size_t chunkSize = (numItems + numChunks - 1) / numChunks;
+
+    // Slab function is called exactly once per item, before any call to
+    // function
+    std::vector<size_t> slabs(numItems);
+    std::vector<size_t> cursors(numChunks * numSlabs, 0);
+    ParallelFor(ZERO_SIZE, numChunks,
+                [&](size_t c) {
+                    const size_t begin = c * chunkSize;
+                    const size_t end = std::min(begin + chunkSize, numItems);
+                    size_t* counts = cursors.data() + c * numSlabs;
+
+                    for (size_t i = begin; i < end; ++i) {
+                        slabs[i] = slabFunction(i);
+                        ++counts[slabs[i]];
+                    }
+                },
+                PartitionPolicy{ PartitionMode::Static, 1 }, policy);
+
+    // Exclusive prefix sum in (slab, chunk) order turns the counts into the
+    // first output position of each chunk within each slab
+    std::vector<size_t> offsets(numSlabs + 1, 0);
+    size_t sum = 0;
+    for (size_t s = 0; s < numSlabs; ++s) {
+        offsets[s] = sum;
+        for (size_t c = 0; c < numChunks; ++c) {
+            const size_t count = cursors[c * numSlabs + s];
+            cursors[c * numSlabs + s] = sum;
+            sum += count;
+        }
+    }
+    offsets[numSlabs] = sum;
+
+    std::vector<size_t> sortedItems(numItems);
+    ParallelFor(ZERO_SIZE, numChunks,
+                [&](size_t c) {
+                    const size_t begin = c * chunkSize;
+                    const size_t end = std::min(begin + chunkSize, numItems);
+                    size_t* chunkCursors = cursors.data() + c * numSlabs;
+
+                    for (size_t i = begin; i < end; ++i) {
+                        sortedItems[chunkCursors[slabs[i]]++] = i;
+                    }
+                },
+                PartitionPolicy{ PartitionMode::Static, 1 }, policy);
+
+    // Two colors; slabs of the same color never write the same data
+    for (size_t color = 0; color < 2; ++color) {
+        ParallelFor(ZERO_SIZE, (numSlabs + 1 - color) / 2,
+                    [&](size_t t) {
+                        const size_t s = 2 * t + color;
+                        for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+                            function(sortedItems[k]);
+                        }
+                    },
+                    PartitionPolicy{ PartitionMode::Dynamic, 1 }, policy);
+    }
+}
+
 template <typename IndexType, typename Value, typename Function,
           typename Reduce>
 Value ParallelReduce(IndexType beginIndex, IndexType endIndex,
@@ -387,6 +745,29 @@ Value ParallelReduce(IndexType beginIndex, IndexType endIndex,
                 return function(range.begin(), range.end(), init);
             },
             reduce);
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+        // Estimate number of threads in the pool
+        const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+        const unsigned int numThreads =
+            numThreadsHint == 0u ? 8u : numThreadsHint;
+
+        // Results
+        std::vector<Value> results(numThreads, identity);
+
+        // Launch jobs on the persistent pool and wait for them to finish
+        Internal::RunSlicesOnThreadPool(
+            beginIndex, endIndex, numThreads,
+            [&](size_t tid, IndexType k1, IndexType k2) {
+                results[tid] = function(k1, k2, identity);
+            });
+
+        // Gather
+        Value finalResult = identity;
+        for (const Value& val : results) {
+            finalResult = reduce(val, finalResult);
+        }
+
+        return finalResult;
 #else
         // Estimate number of threads in the pool
         const unsigned int numThreadsHint = GetMaxNumberOfThreads();
@@ -448,6 +829,44 @@ Value ParallelReduce(IndexType beginIndex, IndexType endIndex,
     }
 }
 
+template <typename IndexType, typename Value, typename Function,
+          typename Reduce>
+Value ParallelDeterministicReduce(IndexType beginIndex, IndexType endIndex,
+                                  const Value& identity,
+                                  const Function& function,
+                                  const Reduce& reduce,
+                                  ExecutionPolicy policy) {
+    // Fixed number of blocks so that the partition only depends on the range
+    constexpr size_t maxNumBlocks = 64;
+
+    if (beginIndex >= endIndex) {
+        return identity;
+    }
+
+    const size_t size = static_cast<size_t>(endIndex - beginIndex);
+    const size_t numBlocks = std::min(size, maxNumBlocks);
+    const auto blockBegin = [&](size_t b) {
+        return beginIndex + static_cast<IndexType>(b * size / numBlocks);
+    };
+
+    std::vector<Value> results(numBlocks, identity);
+
+    ParallelFor(ZERO_SIZE, numBlocks,
+                [&](size_t b) {
+                    results[b] =
+                        function(blockBegin(b), blockBegin(b + 1), identity);
+                },
+                PartitionPolicy{ PartitionMode::Dynamic, 1 }, policy);
+
+    // Gather in block order
+    Value finalResult = results[0];
+    for (size_t b = 1; b < numBlocks; ++b) {
+        finalResult = reduce(finalResult, results[b]);
+    }
+
+    return finalResult;
+}
+
 template <typename RandomIterator>
 void ParallelSort(RandomIterator begin, RandomIterator end,
                   ExecutionPolicy policy) {
@@ -491,6 +910,104 @@ void ParallelSort(RandomIterator begin, RandomIterator end,
         std::sort(begin, end, compareFunction);
     }
 }
+
+template <typename KeyIterator, typename ValueIterator>
+void ParallelRadixSort(KeyIterator keysBegin, KeyIterator keysEnd,
+                       ValueIterator valuesBegin, ExecutionPolicy policy) {
+    using KeyType = typename std::iterator_traits<KeyIterator>::value_type;
+    using ValueType = typename std::iterator_traits<ValueIterator>::value_type;
+
+    static_assert(std::is_unsigned<KeyType>::value,
+                  "Radix sort keys must be unsigned integers.");
+
+    constexpr size_t numBuckets = 256;
+
+    if (keysBegin >= keysEnd) {
+        return;
+    }
+
+    const size_t size = static_cast<size_t>(keysEnd - keysBegin);
+
+    // Each block histograms and scatters its own contiguous range, in order,
+    // which keeps the sort stable.
+    const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+    const size_t numThreads = numThreadsHint == 0u ? 8u : numThreadsHint;
+    const size_t numBlocks =
+        policy == ExecutionPolicy::Parallel
+            ? std::max(std::min(numThreads, size / numBuckets), ONE_SIZE)
+            : ONE_SIZE;
+    const auto blockBegin = [&](size_t b) { return b * size / numBlocks; };
+
+    std::vector<KeyType> keys(keysBegin, keysEnd);
+    std::vector<ValueType> values(valuesBegin, valuesBegin + size);
+    std::vector<KeyType> tempKeys(size);
+    std::vector<ValueType> tempValues(size);
+
+    const KeyType maxKey =
+        ParallelReduce(ZERO_SIZE, size, KeyType(0),
+                       [&](size_t begin, size_t end, KeyType init) {
+                           for (size_t i = begin; i < end; ++i) {
+                               init = std::max(init, keys[i]);
+                           }
+                           return init;
+                       },
+                       [](KeyType a, KeyType b) { return std::max(a, b); },
+                       policy);
+
+    std::vector<size_t> offsets(numBlocks * numBuckets);
+
+    for (size_t shift = 0; shift < 8 * sizeof(KeyType) && (maxKey >> shift) != 0;
+         shift += 8) {
+        const auto digit = [shift](KeyType key) {
+            return static_cast<size_t>((key >> shift) & (numBuckets - 1));
+        };
+
+        // Histogram of the digits per block
+        ParallelFor(ZERO_SIZE, numBlocks,
+                    [&](size_t b) {
+                        size_t* count = offsets.data() + b * numBuckets;
+                        std::fill(count, count + numBuckets, 0);
+                        for (size_t i = blockBegin(b); i < blockBegin(b + 1);
+                             ++i) {
+                            ++count[digit(keys[i])];
+                        }
+                    },
+                    policy);
+
+        // Exclusive scan in (digit, block) order
+        size_t sum = 0;
+        for (size_t d = 0; d < numBuckets; ++d) {
+            for (size_t b = 0; b < numBlocks; ++b) {
+                const size_t count = offsets[b * numBuckets + d];
+                offsets[b * numBuckets + d] = sum;
+                sum += count;
+            }
+        }
+
+        // Scatter
+        ParallelFor(ZERO_SIZE, numBlocks,
+                    [&](size_t b) {
+                        size_t* cursor = offsets.data() + b * numBuckets;
+                        for (size_t i = blockBegin(b); i < blockBegin(b + 1);
+                             ++i) {
+                            const size_t dest = cursor[digit(keys[i])]++;
+                            tempKeys[dest] = keys[i];
+                            tempValues[dest] = values[i];
+                        }
+                    },
+                    policy);
+
+        keys.swap(tempKeys);
+        values.swap(tempValues);
+    }
+
+    ParallelFor(ZERO_SIZE, size,
+                [&](size_t i) {
+                    keysBegin[i] = keys[i];
+                    valuesBegin[i] = values[i];
+                },
+                policy);
+}
 }  // namespace CubbyFlow
 
 #endif
@@ -9,11 +9,34 @@
 #ifndef CUBBYFLOW_PARALLEL_H
 #define CUBBYFLOW_PARALLEL_H
 
+#include <cstddef>
+
 namespace CubbyFlow
 {
 	//! Execution policy tag.
 	enum class ExecutionPolicy { Serial, Parallel };
 
+	//! Partitioning mode of a parallel loop.
+	//! Static splits the range up front, Dynamic hands out chunks of the grain
+	//! size on demand and Guided hands out chunks which shrink as the remaining
+	//! range shrinks.
+	enum class PartitionMode { Static, Dynamic, Guided };
+
+	//!
+	//! \brief Partitioning policy of a parallel loop.
+	//!
+	//! The grain size is the target number of iterations per chunk. Static and
+	//! Dynamic chunks take at most that many iterations (the TBB backend may
+	//! split them down to half of it). Guided chunks shrink as the range
+	//! drains, down to the grain size, except with TBB where no chunk exceeds
+	//! it. Zero lets the tasking system choose.
+	//!
+	struct PartitionPolicy
+	{
+		PartitionMode mode = PartitionMode::Static;
+		size_t grainSize = 0;
+	};
+
 	//!
 	//! \brief      Fills from \p begin to \p end with \p value in parallel.
 	//!
@@ -79,6 +102,57 @@ namespace CubbyFlow
 		const Function& function,
 		ExecutionPolicy policy = ExecutionPolicy::Parallel);
 
+	//!
+	//! \brief      Makes a for-loop from \p beginIndex \p to endIndex in parallel
+	//!             with the given partitioning policy.
+	//!
+	//! This function makes a for-loop specified by begin and end indices in
+	//! parallel. The index range is split into chunks according to \p partition,
+	//! which is useful when the cost per index is uneven. The order of the visit
+	//! is not guaranteed due to the nature of parallel execution.
+	//!
+	//! \param[in]  beginIndex The begin index.
+	//! \param[in]  endIndex   The end index.
+	//! \param[in]  function   The function to call for each index.
+	//! \param[in]  partition  The partitioning policy (mode and grain size).
+	//! \param[in]  policy     The execution policy (parallel or serial).
+	//!
+	//! \tparam     IndexType  Index type.
+	//! \tparam     Function   Function type.
+	//!
+	template <typename IndexType, typename Function>
+	void ParallelFor(
+		IndexType beginIndex, IndexType endIndex,
+		const Function& function,
+		const PartitionPolicy& partition,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
+	//!
+	//! \brief      Makes a range-loop from \p beginIndex \p to endIndex in
+	//!             parallel with the given partitioning policy.
+	//!
+	//! This function makes a for-loop specified by begin and end indices in
+	//! parallel. Unlike parallelFor function, the input function object takes range
+	//! instead of single index. The index range is split into chunks according to
+	//! \p partition. The order of the visit is not guaranteed due to the nature of
+	//! parallel execution.
+	//!
+	//! \param[in]  beginIndex The begin index.
+	//! \param[in]  endIndex   The end index.
+	//! \param[in]  function   The function to call for each index range.
+	//! \param[in]  partition  The partitioning policy (mode and grain size).
+	//! \param[in]  policy     The execution policy (parallel or serial).
+	//!
+	//! \tparam     IndexType  Index type.
+	//! \tparam     Function   Function type.
+	//!
+	template <typename IndexType, typename Function>
+	void ParallelRangeFor(
+		IndexType beginIndex, IndexType endIndex,
+		const Function& function,
+		const PartitionPolicy& partition,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
 	//!
 	//! \brief      Makes a 2D nested for-loop in parallel.
 	//!
@@ -187,6 +261,95 @@ namespace CubbyFlow
 		const Function& function,
 		ExecutionPolicy policy = ExecutionPolicy::Parallel);
 
+	//!
+	//! \brief      Makes a 2D nested for-loop in parallel with the given
+	//!             partitioning policy.
+	//!
+	//! This function makes a 2D nested for-loop specified by begin and end indices
+	//! for each dimension. X will be the inner-most loop while Y is the outer-most.
+	//! The grain size of \p partition counts rows. The order of the visit is not
+	//! guaranteed due to the nature of parallel execution.
+	//!
+	//! \param[in]  beginIndexX The begin index in X dimension.
+	//! \param[in]  endIndexX   The end index in X dimension.
+	//! \param[in]  beginIndexY The begin index in Y dimension.
+	//! \param[in]  endIndexY   The end index in Y dimension.
+	//! \param[in]  function    The function to call for each index (i, j).
+	//! \param[in]  partition   The partitioning policy (mode and grain size).
+	//! \param[in]  policy      The execution policy (parallel or serial).
+	//!
+	//! \tparam     IndexType   Index type.
+	//! \tparam     Function    Function type.
+	//!
+	template <typename IndexType, typename Function>
+	void ParallelFor(
+		IndexType beginIndexX, IndexType endIndexX,
+		IndexType beginIndexY, IndexType endIndexY,
+		const Function& function,
+		const PartitionPolicy& partition,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
+	//!
+	//! \brief      Makes a 3D nested for-loop in parallel with the given
+	//!             partitioning policy.
+	//!
+	//! This function makes a 3D nested for-loop specified by begin and end indices
+	//! for each dimension. X will be the inner-most loop while Z is the outer-most.
+	//! The grain size of \p partition counts XY-slices. The order of the visit is
+	//! not guaranteed due to the nature of parallel execution.
+	//!
+	//! \param[in]  beginIndexX The begin index in X dimension.
+	//! \param[in]  endIndexX   The end index in X dimension.
+	//! \param[in]  beginIndexY The begin index in Y dimension.
+	//! \param[in]  endIndexY   The end index in Y dimension.
+	//! \param[in]  beginIndexZ The begin index in Z dimension.
+	//! \param[in]  endIndexZ   The end index in Z dimension.
+	//! \param[in]  function    The function to call for each index (i, j, k).
+	//! \param[in]  partition   The partitioning policy (mode and grain size).
+	//! \param[in]  policy      The execution policy (parallel or serial).
+	//!
+	//! \tparam     IndexType   Index type.
+	//! \tparam     Function    Function type.
+	//!
+	template <typename IndexType, typename Function>
+	void ParallelFor(
+		IndexType beginIndexX, IndexType endIndexX,
+		IndexType beginIndexY, IndexType endIndexY,
+		IndexType beginIndexZ, IndexType endIndexZ,
+		const Function& function,
+		const PartitionPolicy& partition,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
+	//!
+	//! \brief      Makes a deterministic scatter loop in parallel.
+	//!
+	//! This function calls \p function for each item in [0, numItems). Items
+	//! are grouped into slabs by \p slabFunction, which returns the slab index
+	//! of an item in [0, numSlabs). The function called for an item in slab s
+	//! may write only to the data owned by slab s and s + 1. Even slabs are
+	//! processed in parallel first, then odd slabs, so no two concurrent items
+	//! write the same data. Within a slab the items are visited in increasing
+	//! order. The visiting order thus does not depend on the number of threads
+	//! or the execution policy, and floating point sums are reproducible.
+	//! \p slabFunction is called exactly once per item, and all those calls
+	//! finish before the first call to \p function.
+	//!
+	//! \param[in]  numItems     The number of items.
+	//! \param[in]  numSlabs     The number of slabs.
+	//! \param[in]  slabFunction The function which returns a slab of an item.
+	//! \param[in]  function     The function to call for each item.
+	//! \param[in]  policy       The execution policy (parallel or serial).
+	//!
+	//! \tparam     SlabFunction Slab function type.
+	//! \tparam     Function     Function type.
+	//!
+	template <typename SlabFunction, typename Function>
+	void ParallelScatter(
+		size_t numItems, size_t numSlabs,
+		const SlabFunction& slabFunction,
+		const Function& function,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
 	//!
 	//! \brief      Performs reduce operation in parallel.
 	//!
@@ -211,6 +374,35 @@ namespace CubbyFlow
 		const Reduce& reduce,
 		ExecutionPolicy policy = ExecutionPolicy::Parallel);
 
+	//!
+	//! \brief      Performs reduce operation in parallel with a fixed
+	//!             partition.
+	//!
+	//! This function works like ParallelReduce, but the range is always split
+	//! into the same blocks for a given range size, regardless of the tasking
+	//! system and the number of threads, and the block results are reduced in
+	//! block order. Floating-point reductions therefore give bitwise identical
+	//! results from run to run, and the serial policy gives the same result as
+	//! the parallel one.
+	//!
+	//! \param[in]  beginIndex The begin index.
+	//! \param[in]  endIndex   The end index.
+	//! \param[in]  identity   Identity value for the reduce operation.
+	//! \param[in]  function   The function for reducing subrange.
+	//! \param[in]  reduce     The reduce operator.
+	//! \param[in]  policy     The execution policy (parallel or serial).
+	//!
+	//! \tparam     IndexType  Index type.
+	//! \tparam     Value      Value type.
+	//! \tparam     Function   Reduce function type.
+	//!
+	template <typename IndexType, typename Value, typename Function, typename Reduce>
+	Value ParallelDeterministicReduce(
+		IndexType beginIndex, IndexType endIndex,
+		const Value& identity, const Function& function,
+		const Reduce& reduce,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
 	//!
 	//! \brief      Sorts a container in parallel.
 	//!
@@ -248,6 +440,28 @@ namespace CubbyFlow
 		CompareFunction compare,
 		ExecutionPolicy policy = ExecutionPolicy::Parallel);
 
+	//!
+	//! \brief      Sorts unsigned integer keys and their values in parallel.
+	//!
+	//! This function sorts the keys in [keysBegin, keysEnd) in ascending order
+	//! with a least significant digit radix sort, and applies the same
+	//! permutation to the values starting at \p valuesBegin. The sort is
+	//! stable and only runs the 8-bit passes needed by the largest key.
+	//!
+	//! \param[in]  keysBegin     The begin iterator of the keys.
+	//! \param[in]  keysEnd       The end iterator of the keys.
+	//! \param[in]  valuesBegin   The begin iterator of the values.
+	//! \param[in]  policy        The execution policy (parallel or serial).
+	//!
+	//! \tparam     KeyIterator   Random access iterator of unsigned integers.
+	//! \tparam     ValueIterator Random access iterator of the values.
+	//!
+	template <typename KeyIterator, typename ValueIterator>
+	void ParallelRadixSort(
+		KeyIterator keysBegin, KeyIterator keysEnd,
+		ValueIterator valuesBegin,
+		ExecutionPolicy policy = ExecutionPolicy::Parallel);
+
 	//! Sets maximum number of threads to use.
 	void SetMaxNumberOfThreads(unsigned int numThreads);
 
@@ -0,0 +1,119 @@
+/*************************************************************************
+> File Name: ThreadPool.h
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Persistent work-stealing thread pool for CubbyFlow.
+> Created Time: 2018/06/04
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#ifndef CUBBYFLOW_THREAD_POOL_H
+#define CUBBYFLOW_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CubbyFlow
+{
+	//!
+	//! \brief Persistent work-stealing thread pool.
+	//!
+	//! This class keeps a fixed set of worker threads alive for the lifetime of
+	//! the pool so that parallel loops do not pay for thread creation on every
+	//! call. Each worker owns a task queue; idle workers steal from the others.
+	//! The thread which submits a batch of tasks also executes tasks while it
+	//! waits, so nested parallel calls from inside a task never deadlock.
+	//!
+	class ThreadPool final
+	{
+	public:
+		//! Task function type which takes the index of the task in its batch.
+		using TaskFunc = std::function<void(size_t)>;
+
+		//! Constructs a pool which runs up to \p numThreads tasks concurrently
+		//! (including the calling thread).
+		explicit ThreadPool(unsigned int numThreads);
+
+		//! Deleted copy constructor.
+		ThreadPool(const ThreadPool&) = delete;
+
+		//! Destructor. Joins all the worker threads.
+		~ThreadPool();
+
+		//! Deleted copy assignment operator.
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		//! Returns the number of tasks that can run concurrently.
+		unsigned int NumberOfThreads() const;
+
+		//!
+		//! \brief Changes the number of threads of the pool.
+		//!
+		//! The worker threads are joined and recreated. Throws
+		//! std::logic_error if the pool is running tasks or if it is called
+		//! from inside a task of this pool.
+		//!
+		void Resize(unsigned int numThreads);
+
+		//!
+		//! \brief Runs \p func(i) for i in [0, numTasks) and waits.
+		//!
+		//! The tasks are distributed over the worker queues and the calling
+		//! thread helps executing queued tasks until the whole batch is done.
+		//! If any task throws, the remaining tasks still run and the first
+		//! exception is rethrown once the whole batch has finished.
+		//!
+		void Run(size_t numTasks, const TaskFunc& func);
+
+		//! Returns the global thread pool sized by GetMaxNumberOfThreads().
+		static ThreadPool& GetInstance();
+
+	private:
+		struct TaskGroup
+		{
+			const TaskFunc* func = nullptr;
+			std::atomic<size_t> numRemaining{ 0 };
+			std::mutex exceptionMutex;
+			std::exception_ptr exception;
+		};
+
+		struct Task
+		{
+			TaskGroup* group = nullptr;
+			size_t index = 0;
+		};
+
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void Start(unsigned int numThreads);
+		void Stop();
+
+		void WorkerLoop(size_t queueIndex);
+		bool PopTask(size_t queueIndex, Task* task);
+		bool StealTask(size_t queueIndex, Task* task);
+		void Execute(const Task& task);
+
+		unsigned int m_numThreads = 1;
+		std::vector<std::unique_ptr<WorkQueue>> m_queues;
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_sleepMutex;
+		std::condition_variable m_sleepCondition;
+		std::atomic<size_t> m_numQueuedTasks{ 0 };
+		std::atomic<size_t> m_nextQueue{ 0 };
+		std::atomic<size_t> m_numRunningBatches{ 0 };
+		bool m_isStopping = false;
+	};
+}
+
+#endif
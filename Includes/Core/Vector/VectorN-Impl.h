@@ -182,7 +182,7 @@ namespace CubbyFlow
 	template <typename T>
 	T VectorN<T>::Sum() const
 	{
-		return ParallelReduce(ZERO_SIZE, size(), T(0),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), T(0),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -207,7 +207,7 @@ namespace CubbyFlow
 	{
 		const T& (*_min)(const T&, const T&) = std::min<T>;
 
-		return ParallelReduce(ZERO_SIZE, size(), std::numeric_limits<T>::max(),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), std::numeric_limits<T>::max(),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -226,7 +226,7 @@ namespace CubbyFlow
 	{
 		const T& (*_max)(const T&, const T&) = std::max<T>;
 
-		return ParallelReduce(ZERO_SIZE, size(), std::numeric_limits<T>::min(),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), std::numeric_limits<T>::min(),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -243,7 +243,7 @@ namespace CubbyFlow
 	template <typename T>
 	T VectorN<T>::AbsMin() const
 	{
-		return ParallelReduce(ZERO_SIZE, size(), std::numeric_limits<T>::max(),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), std::numeric_limits<T>::max(),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -260,7 +260,7 @@ namespace CubbyFlow
 	template <typename T>
 	T VectorN<T>::AbsMax() const
 	{
-		return ParallelReduce(ZERO_SIZE, size(), T(0),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), T(0),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -328,7 +328,7 @@ namespace CubbyFlow
 	{
 		assert(size() == other.size());
 
-		return ParallelReduce(ZERO_SIZE, size(), T(0),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), T(0),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -448,7 +448,7 @@ namespace CubbyFlow
 	{
 		assert(size() == v.size());
 
-		return ParallelReduce(ZERO_SIZE, size(), T(0),
+		return ParallelDeterministicReduce(ZERO_SIZE, size(), T(0),
 			[&](size_t start, size_t end, T init)
 		{
 			T result = init;
@@ -116,7 +116,7 @@ namespace CubbyFlow
 		//! Returns reference to the \p i -th element of the vector.
 		T& At(size_t i);
 
-		//! Returns the sum of all the elements.
+		//! Returns the sum of all the elements, reproducible from run to run.
 		T Sum() const;
 
 		//! Returns the average of all the elements.
@@ -198,7 +198,7 @@ namespace CubbyFlow
 		//! Computes this / (s, s, ... , s).
 		VectorScalarDiv<T, VectorN> Div(const T& s) const;
 
-		//! Computes dot product.
+		//! Computes dot product, reproducible from run to run.
 		template <typename E>
 		T Dot(const E& v) const;
 
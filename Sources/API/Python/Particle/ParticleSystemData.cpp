@@ -12,6 +12,7 @@
 #include <Core/Particle/ParticleSystemData3.h>
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 using namespace CubbyFlow;
 
@@ -193,7 +194,10 @@ void AddParticleSystemData2(pybind11::module& m)
 			This property returns currently set neighbor searcher object. By
 			default, PointParallelHashGridSearcher2 is used.
 		)pbdoc")
-	.def_property_readonly("neighborLists", &ParticleSystemData2::GetNeighborLists,
+	.def_property_readonly("neighborLists", [](ParticleSystemData2& instance)
+	{
+		return instance.GetNeighborLists().ToNestedLists();
+	},
 		R"pbdoc(
 			The neighbor lists.
 
@@ -201,6 +205,24 @@ void AddParticleSystemData2(pybind11::module& m)
 			PointParallelHashGridSearcher2::GetBuildNeighborLists. Each list stores
 			indices of the neighbors.
 		)pbdoc")
+	.def("SortParticles", &ParticleSystemData2::SortParticles,
+		R"pbdoc(
+			Sorts the particles in Morton (Z-order) of their grid cells.
+
+			All the data layers are permuted so that particles which are close
+			in space are also close in memory.
+
+			Parameters
+			----------
+			- gridSpacing : The cell size used for the ordering.
+		)pbdoc",
+		pybind11::arg("gridSpacing"))
+	.def_property_readonly("sortedIndices", &ParticleSystemData2::GetSortedIndices,
+		R"pbdoc(
+			The permutation applied by the last SortParticles call.
+
+			Maps new particle index i to the index before sorting.
+		)pbdoc")
 	.def("Set", [](ParticleSystemData2& instance, const ParticleSystemData2Ptr& other)
 	{
 		instance.Set(*other);
@@ -388,7 +410,10 @@ void AddParticleSystemData3(pybind11::module& m)
 			This property returns currently set neighbor searcher object. By
 			default, PointParallelHashGridSearcher2 is used.
 		)pbdoc")
-	.def_property_readonly("neighborLists", &ParticleSystemData3::GetNeighborLists,
+	.def_property_readonly("neighborLists", [](ParticleSystemData3& instance)
+	{
+		return instance.GetNeighborLists().ToNestedLists();
+	},
 		R"pbdoc(
 			The neighbor lists.
 
@@ -396,6 +421,24 @@ void AddParticleSystemData3(pybind11::module& m)
 			PointParallelHashGridSearcher2::buildNeighborLists. Each list stores
 			indices of the neighbors.
 		)pbdoc")
+	.def("SortParticles", &ParticleSystemData3::SortParticles,
+		R"pbdoc(
+			Sorts the particles in Morton (Z-order) of their grid cells.
+
+			All the data layers are permuted so that particles which are close
+			in space are also close in memory.
+
+			Parameters
+			----------
+			- gridSpacing : The cell size used for the ordering.
+		)pbdoc",
+		pybind11::arg("gridSpacing"))
+	.def_property_readonly("sortedIndices", &ParticleSystemData3::GetSortedIndices,
+		R"pbdoc(
+			The permutation applied by the last SortParticles call.
+
+			Maps new particle index i to the index before sorting.
+		)pbdoc")
 	.def("Set", [](ParticleSystemData3& instance, const ParticleSystemData3Ptr& other)
 	{
 		instance.Set(*other);
@@ -65,5 +65,9 @@ void AddFDMCGSolver3(pybind11::module& m)
 	.def_property_readonly("lastResidual", &FDMCGSolver3::GetLastResidual,
 		R"pbdoc(
 			The last residual after the CG iterations.
+		)pbdoc")
+	.def_property("precision", &FDMCGSolver3::GetPrecision, &FDMCGSolver3::SetPrecision,
+		R"pbdoc(
+			The floating-point precision of the solve (FDMPrecision).
 		)pbdoc");
 }
\ No newline at end of file
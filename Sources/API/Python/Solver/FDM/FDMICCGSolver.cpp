@@ -38,6 +38,12 @@ void AddFDMICCGSolver2(pybind11::module& m)
 	.def_property_readonly("lastResidual", &FDMICCGSolver2::GetLastResidual,
 		R"pbdoc(
 			The last residual after the ICCG iterations.
+		)pbdoc")
+	.def_property("isUsingParallelPreconditioner",
+		&FDMICCGSolver2::GetIsUsingParallelPreconditioner,
+		&FDMICCGSolver2::SetIsUsingParallelPreconditioner,
+		R"pbdoc(
+			True if the preconditioner sweeps run in parallel (level-scheduled).
 		)pbdoc");
 }
 
@@ -65,5 +71,15 @@ void AddFDMICCGSolver3(pybind11::module& m)
 	.def_property_readonly("lastResidual", &FDMICCGSolver3::GetLastResidual,
 		R"pbdoc(
 			The last residual after the ICCG iterations.
+		)pbdoc")
+	.def_property("isUsingParallelPreconditioner",
+		&FDMICCGSolver3::GetIsUsingParallelPreconditioner,
+		&FDMICCGSolver3::SetIsUsingParallelPreconditioner,
+		R"pbdoc(
+			True if the preconditioner sweeps run in parallel (level-scheduled).
+		)pbdoc")
+	.def_property("precision", &FDMICCGSolver3::GetPrecision, &FDMICCGSolver3::SetPrecision,
+		R"pbdoc(
+			The floating-point precision of the solve (FDMPrecision).
 		)pbdoc");
 }
\ No newline at end of file
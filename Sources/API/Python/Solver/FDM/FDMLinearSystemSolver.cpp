@@ -24,6 +24,11 @@ void AddFDMLinearSystemSolver2(pybind11::module& m)
 
 void AddFDMLinearSystemSolver3(pybind11::module& m)
 {
+	pybind11::enum_<FDMPrecision>(m, "FDMPrecision")
+	.value("DOUBLE",	FDMPrecision::Double)
+	.value("SINGLE",	FDMPrecision::Single)
+	.value("MIXED",		FDMPrecision::Mixed);
+
 	pybind11::class_<FDMLinearSystemSolver3, FDMLinearSystemSolver3Ptr>(static_cast<pybind11::handle>(m), "FDMLinearSystemSolver3",
 		R"pbdoc(
 			Abstract base class for 3-D finite difference-type linear system solver.
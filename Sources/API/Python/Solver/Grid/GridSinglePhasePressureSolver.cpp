@@ -59,5 +59,9 @@ void AddGridSinglePhasePressureSolver3(pybind11::module& m)
 	.def_property("linearSystemSolver", &GridSinglePhasePressureSolver3::GetLinearSystemSolver, &GridSinglePhasePressureSolver3::SetLinearSystemSolver,
 		R"pbdoc(
 			"The linear system solver."
+		)pbdoc")
+	.def_property("isUsingMatrixFree", &GridSinglePhasePressureSolver3::GetIsUsingMatrixFree, &GridSinglePhasePressureSolver3::SetIsUsingMatrixFree,
+		R"pbdoc(
+			True if the pressure is solved without assembling the matrix.
 		)pbdoc");
 }
\ No newline at end of file
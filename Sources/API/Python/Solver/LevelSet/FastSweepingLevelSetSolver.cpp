@@ -0,0 +1,94 @@
+/*************************************************************************
+> File Name: FastSweepingLevelSetSolver.cpp
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: FastSweepingLevelSetSolver functions for CubbyFlow Python API.
+> Created Time: 2018/06/18
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#include <API/Python/Solver/LevelSet/FastSweepingLevelSetSolver.h>
+#include <Core/Solver/LevelSet/FastSweepingLevelSetSolver3.h>
+
+#include <pybind11/pybind11.h>
+
+using namespace CubbyFlow;
+
+void AddFastSweepingLevelSetSolver3(pybind11::module& m)
+{
+	pybind11::class_<FastSweepingLevelSetSolver3, FastSweepingLevelSetSolver3Ptr, LevelSetSolver3>(m, "FastSweepingLevelSetSolver3",
+		R"pbdoc(
+			3-D parallel fast sweeping method implementation.
+
+			Like FMMLevelSetSolver3, this class solves the first-order upwind
+			discretization of the Eikonal equation, but with Gauss-Seidel sweeps in
+			the eight diagonal directions. The cells on each diagonal plane are
+			updated in parallel.
+
+			- See Zhao, Hongkai. "A fast sweeping method for eikonal equations."
+			Mathematics of computation 74.250 (2005): 603-627.
+			- See Detrixhe, Miles, Frederic Gibou, and Chohong Min. "A parallel fast
+			sweeping method for the Eikonal equation." Journal of Computational
+			Physics 237 (2013): 46-55.
+		)pbdoc")
+	.def("Reinitialize", [](FastSweepingLevelSetSolver3& instance, const ScalarGrid3Ptr& inputSDF, double maxDistance, ScalarGrid3Ptr outputSDF)
+	{
+		instance.Reinitialize(*inputSDF, maxDistance, outputSDF.get());
+	},
+		R"pbdoc(
+			Reinitializes given scalar field to signed-distance field.
+
+			Parameters
+			----------
+			- inputSDF : Input signed-distance field which can be distorted.
+			- maxDistance : Max range of reinitialization.
+			- outputSDF : Output signed-distance field.
+		)pbdoc",
+		pybind11::arg("inputSDF"),
+		pybind11::arg("maxDistance"),
+		pybind11::arg("outputSDF"))
+	.def("Extrapolate", [](FastSweepingLevelSetSolver3& instance, const Grid3Ptr& input, const ScalarGrid3Ptr& sdf, double maxDistance, Grid3Ptr output)
+	{
+		auto inputSG = std::dynamic_pointer_cast<ScalarGrid3>(input);
+		auto inputCG = std::dynamic_pointer_cast<CollocatedVectorGrid3>(input);
+		auto inputFG = std::dynamic_pointer_cast<FaceCenteredGrid3>(input);
+
+		auto outputSG = std::dynamic_pointer_cast<ScalarGrid3>(output);
+		auto outputCG = std::dynamic_pointer_cast<CollocatedVectorGrid3>(output);
+		auto outputFG = std::dynamic_pointer_cast<FaceCenteredGrid3>(output);
+
+		if (inputSG != nullptr && outputSG != nullptr)
+		{
+			instance.Extrapolate(*inputSG, *sdf, maxDistance, outputSG.get());
+		}
+		else if (inputCG != nullptr && outputCG != nullptr) 
+		{
+			instance.Extrapolate(*inputCG, *sdf, maxDistance, outputCG.get());
+		}
+		else if (inputFG != nullptr && outputFG != nullptr)
+		{
+			instance.Extrapolate(*inputFG, *sdf, maxDistance, outputFG.get());
+		}
+		else
+		{
+			throw std::invalid_argument("Grids input and output must have same type.");
+		}
+	},
+		R"pbdoc(
+			Extrapolates given field from negative to positive SDF region.
+
+			Parameters
+			----------
+			- input : Input field to be extrapolated.
+			- sdf : Reference signed-distance field.
+			- maxDistance : Max range of extrapolation.
+			- output : Output field.
+		)pbdoc",
+		pybind11::arg("input"),
+		pybind11::arg("sdf"),
+		pybind11::arg("maxDistance"),
+		pybind11::arg("output"))
+	.def_property("maxNumberOfIterations", &FastSweepingLevelSetSolver3::GetMaxNumberOfIterations, &FastSweepingLevelSetSolver3::SetMaxNumberOfIterations,
+		R"pbdoc(
+			The maximum number of sweep passes.
+		)pbdoc");
+}
\ No newline at end of file
@@ -165,5 +165,9 @@ void AddIterativeLevelSetSolver3(pybind11::module& m)
 	.def_property("maxCFL", &IterativeLevelSetSolver3::GetMaxCFL, &IterativeLevelSetSolver3::SetMaxCFL,
 		R"pbdoc(
 			The maximum CFL limit.
+		)pbdoc")
+	.def_property("isUsingNarrowBand", &IterativeLevelSetSolver3::GetIsUsingNarrowBand, &IterativeLevelSetSolver3::SetIsUsingNarrowBand,
+		R"pbdoc(
+			True if the solver only updates the cells near the surface.
 		)pbdoc");
 }
\ No newline at end of file
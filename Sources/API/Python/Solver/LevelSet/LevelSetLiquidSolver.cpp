@@ -135,6 +135,10 @@ void AddLevelSetLiquidSolver3(pybind11::module& m)
 		R"pbdoc(
 			The level set solver.
 		)pbdoc")
+	.def_property("velocityExtrapolator", &LevelSetLiquidSolver3::GetVelocityExtrapolator, &LevelSetLiquidSolver3::SetVelocityExtrapolator,
+		R"pbdoc(
+			The level set solver used for velocity extrapolation.
+		)pbdoc")
 	.def("SetMinReinitializeDistance", &LevelSetLiquidSolver3::SetMinReinitializeDistance,
 		R"pbdoc(
 			Sets minimum reinitialization distance.
@@ -78,6 +78,15 @@ void AddParticleSystemSolver2(pybind11::module& m)
 
 			Wind can be applied to the particle system by setting a vector field to
 			the solver.
+		)pbdoc")
+	.def_property("particleSortingInterval",
+		&ParticleSystemSolver2::GetParticleSortingInterval,
+		&ParticleSystemSolver2::SetParticleSortingInterval,
+		R"pbdoc(
+			The number of time-steps between two particle sorts.
+
+			When positive, the particles are sorted in Morton order at this
+			interval to keep nearby particles close in memory. Zero disables it.
 		)pbdoc");
 }
 
@@ -145,5 +154,14 @@ void AddParticleSystemSolver3(pybind11::module& m)
 
 			Wind can be applied to the particle system by setting a vector field to
 			the solver.
+		)pbdoc")
+	.def_property("particleSortingInterval",
+		&ParticleSystemSolver3::GetParticleSortingInterval,
+		&ParticleSystemSolver3::SetParticleSortingInterval,
+		R"pbdoc(
+			The number of time-steps between two particle sorts.
+
+			When positive, the particles are sorted in Morton order at this
+			interval to keep nearby particles close in memory. Zero disables it.
 		)pbdoc");
 }
\ No newline at end of file
@@ -76,6 +76,7 @@
 #include <API/Python/Solver/LevelSet/UpwindLevelSetSolver.h>
 #include <API/Python/Solver/LevelSet/ENOLevelSetSolver.h>
 #include <API/Python/Solver/LevelSet/FMMLevelSetSolver.h>
+#include <API/Python/Solver/LevelSet/FastSweepingLevelSetSolver.h>
 #include <API/Python/Solver/Grid/GridFluidSolver.h>
 #include <API/Python/Solver/Grid/GridSmokeSolver.h>
 #include <API/Python/Solver/LevelSet/LevelSetLiquidSolver.h>
@@ -296,6 +297,7 @@ PYBIND11_MODULE(pyCubbyFlow, m)
 	AddENOLevelSetSolver3(m);
 	AddFMMLevelSetSolver2(m);
 	AddFMMLevelSetSolver3(m);
+	AddFastSweepingLevelSetSolver3(m);
 
 	// Points to implicit functions
 	AddPointsToImplicit2(m);
@@ -7,6 +7,8 @@
 > Copyright (c) 2018, Chan-Ho Chris Ohk
 *************************************************************************/
 #include <Core/Collider/Collider3.h>
+#include <Core/Geometry/TriangleMesh3.h>
+#include <Core/Utils/Parallel.h>
 
 namespace CubbyFlow
 {
@@ -26,6 +28,23 @@ namespace CubbyFlow
 
 		GetClosestPoint(m_surface, *newPosition, &colliderPoint);
 
+		ResolveCollision(colliderPoint, radius, restitutionCoefficient, newPosition, newVelocity);
+	}
+
+	void Collider3::ResolveCollisions(double radius, double restitutionCoefficient, ArrayAccessor1<Vector3D> newPositions, ArrayAccessor1<Vector3D> newVelocities)
+	{
+		Array1<ColliderQueryResult> colliderPoints;
+
+		GetClosestPoints(m_surface, newPositions, &colliderPoints);
+
+		ParallelFor(ZERO_SIZE, newPositions.size(), [&](size_t i)
+		{
+			ResolveCollision(colliderPoints[i], radius, restitutionCoefficient, &newPositions[i], &newVelocities[i]);
+		});
+	}
+
+	void Collider3::ResolveCollision(const ColliderQueryResult& colliderPoint, double radius, double restitutionCoefficient, Vector3D* newPosition, Vector3D* newVelocity)
+	{
 		// Check if the new position is penetrating the surface
 		if (IsPenetrating(colliderPoint, *newPosition, radius))
 		{
@@ -94,6 +113,38 @@ namespace CubbyFlow
 		result->velocity = VelocityAt(queryPoint);
 	}
 
+	void Collider3::GetClosestPoints(const Surface3Ptr& surface, const ConstArrayAccessor1<Vector3D>& queryPoints, Array1<ColliderQueryResult>* results) const
+	{
+		const size_t n = queryPoints.size();
+		results->Resize(n);
+
+		const auto mesh = std::dynamic_pointer_cast<TriangleMesh3>(surface);
+		if (mesh == nullptr)
+		{
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
+			{
+				GetClosestPoint(surface, queryPoints[i], &(*results)[i]);
+			}, PartitionPolicy{ PartitionMode::Guided });
+
+			return;
+		}
+
+		// Answers all queries with one traversal of the mesh's BVH
+		Array1<Vector3D> points(n);
+		Array1<Vector3D> normals(n);
+		Array1<double> distances(n);
+		mesh->ClosestPointsAndNormals(queryPoints, points.Accessor(), normals.Accessor(), distances.Accessor());
+
+		ParallelFor(ZERO_SIZE, n, [&](size_t i)
+		{
+			ColliderQueryResult& result = (*results)[i];
+			result.distance = distances[i];
+			result.point = points[i];
+			result.normal = normals[i];
+			result.velocity = VelocityAt(queryPoints[i]);
+		});
+	}
+
 	bool Collider3::IsPenetrating(const ColliderQueryResult& colliderPoint, const Vector3D& position, double radius)
 	{
 		// If the new candidate position of the particle is on the other side of
@@ -6,6 +6,7 @@
 > Created Time: 2017/08/12
 > Copyright (c) 2018, Chan-Ho Chris Ohk
 *************************************************************************/
+#include <Core/Array/ArrayUtils.h>
 #include <Core/FDM/FDMLinearSystem2.h>
 #include <Core/Math/MathUtils.h>
 
@@ -59,20 +60,10 @@ namespace CubbyFlow
 	double FDMBLAS2::Dot(const FDMVector2& a, const FDMVector2& b)
 	{
 		Size2 size = a.size();
-		
-		assert(size == b.size());
-
-		double result = 0.0;
 
-		for (size_t j = 0; j < size.y; ++j)
-		{
-			for (size_t i = 0; i < size.x; ++i)
-			{
-				result += a(i, j) * b(i, j);
-			}
-		}
+		assert(size == b.size());
 
-		return result;
+		return DotRange1(a, b, size.x * size.y);
 	}
 
 	void FDMBLAS2::AXPlusY(double a, const FDMVector2& x, const FDMVector2& y, FDMVector2* result)
@@ -132,17 +123,8 @@ namespace CubbyFlow
 	double FDMBLAS2::LInfNorm(const FDMVector2& v)
 	{
 		Size2 size = v.size();
-		double result = 0.0;
-
-		for (size_t j = 0; j < size.y; ++j)
-		{
-			for (size_t i = 0; i < size.x; ++i)
-			{
-				result = AbsMax(result, v(i, j));
-			}
-		}
 
-		return std::fabs(result);
+		return LInfNormRange1(v, size.x * size.y);
 	}
 
 	void FDMCompressedBLAS2::Set(double s, VectorND* result)
@@ -6,13 +6,205 @@
 > Created Time: 2017/08/12
 > Copyright (c) 2018, Chan-Ho Chris Ohk
 *************************************************************************/
+#include <Core/Array/ArrayUtils.h>
 #include <Core/FDM/FDMLinearSystem3.h>
 #include <Core/Math/MathUtils.h>
+#include <Core/Utils/Constants.h>
+#include <Core/Utils/Parallel.h>
 
 #include <cassert>
+#include <functional>
 
 namespace CubbyFlow
 {
+	// The stencil kernels below are shared by the double and single precision
+	// BLAS, and by the matrix-free BLAS. The arithmetic is done in the
+	// precision T of the vectors, while the dot products are accumulated in
+	// double.
+	template <typename T, typename RowType>
+	static T RowProduct(const Array3<RowType>& m, const Array3<T>& v, const Size3& size, size_t i, size_t j, size_t k)
+	{
+		return
+			m(i, j, k).center * v(i, j, k) +
+			((i > 0) ? m(i - 1, j, k).right * v(i - 1, j, k) : T(0)) +
+			((i + 1 < size.x) ? m(i, j, k).right * v(i + 1, j, k) : T(0)) +
+			((j > 0) ? m(i, j - 1, k).up * v(i, j - 1, k) : T(0)) +
+			((j + 1 < size.y) ? m(i, j, k).up * v(i, j + 1, k) : T(0)) +
+			((k > 0) ? m(i, j, k - 1).front * v(i, j, k - 1) : T(0)) +
+			((k + 1 < size.z) ? m(i, j, k).front * v(i, j, k + 1) : T(0));
+	}
+
+	// Reads each neighbor marker once, instead of evaluating the neighbor rows.
+	// The terms are summed in the same order as above, so the result matches
+	// the assembled matrix.
+	static double RowProduct(const FDMMatrixFree3& m, const FDMVector3& v, const Size3& size, size_t i, size_t j, size_t k)
+	{
+		const auto& markers = m.markers;
+		const Vector3D& invHSqr = m.invHSqr;
+
+		if (markers(i, j, k) != FDMMatrixFree3::FLUID)
+		{
+			return v(i, j, k);
+		}
+
+		double center = 0.0;
+		double left = 0.0, right = 0.0, down = 0.0, up = 0.0, back = 0.0, front = 0.0;
+
+		if (i + 1 < size.x && markers(i + 1, j, k) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.x;
+			if (markers(i + 1, j, k) == FDMMatrixFree3::FLUID)
+			{
+				right = -invHSqr.x * v(i + 1, j, k);
+			}
+		}
+
+		if (i > 0 && markers(i - 1, j, k) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.x;
+			if (markers(i - 1, j, k) == FDMMatrixFree3::FLUID)
+			{
+				left = -invHSqr.x * v(i - 1, j, k);
+			}
+		}
+
+		if (j + 1 < size.y && markers(i, j + 1, k) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.y;
+			if (markers(i, j + 1, k) == FDMMatrixFree3::FLUID)
+			{
+				up = -invHSqr.y * v(i, j + 1, k);
+			}
+		}
+
+		if (j > 0 && markers(i, j - 1, k) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.y;
+			if (markers(i, j - 1, k) == FDMMatrixFree3::FLUID)
+			{
+				down = -invHSqr.y * v(i, j - 1, k);
+			}
+		}
+
+		if (k + 1 < size.z && markers(i, j, k + 1) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.z;
+			if (markers(i, j, k + 1) == FDMMatrixFree3::FLUID)
+			{
+				front = -invHSqr.z * v(i, j, k + 1);
+			}
+		}
+
+		if (k > 0 && markers(i, j, k - 1) != FDMMatrixFree3::BOUNDARY)
+		{
+			center += invHSqr.z;
+			if (markers(i, j, k - 1) == FDMMatrixFree3::FLUID)
+			{
+				back = -invHSqr.z * v(i, j, k - 1);
+			}
+		}
+
+		return center * v(i, j, k) + left + right + down + up + back + front;
+	}
+
+	template <typename T, typename MatrixType>
+	static void MVMImpl(const MatrixType& m, const Array3<T>& v, Array3<T>* result)
+	{
+		Size3 size = m.size();
+
+		assert(size == v.size());
+		assert(size == result->size());
+
+		v.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			(*result)(i, j, k) = RowProduct(m, v, size, i, j, k);
+		});
+	}
+
+	template <typename T, typename RowType, typename ResultType>
+	static void ResidualImpl(const Array3<RowType>& a, const Array3<T>& x, const Array3<T>& b, Array3<ResultType>* result)
+	{
+		Size3 size = a.size();
+
+		assert(size == x.size());
+		assert(size == b.size());
+		assert(size == result->size());
+
+		a.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			(*result)(i, j, k) =
+				b(i, j, k) -
+				a(i, j, k).center * x(i, j, k) -
+				((i > 0) ? a(i - 1, j, k).right * x(i - 1, j, k) : T(0)) -
+				((i + 1 < size.x) ? a(i, j, k).right * x(i + 1, j, k) : T(0)) -
+				((j > 0) ? a(i, j - 1, k).up * x(i, j - 1, k) : T(0)) -
+				((j + 1 < size.y) ? a(i, j, k).up * x(i, j + 1, k) : T(0)) -
+				((k > 0) ? a(i, j, k - 1).front * x(i, j, k - 1) : T(0)) -
+				((k + 1 < size.z) ? a(i, j, k).front * x(i, j, k + 1) : T(0));
+		});
+	}
+
+	template <typename T, typename MatrixType>
+	static double MVMDotImpl(const MatrixType& m, const Array3<T>& v, Array3<T>* result)
+	{
+		Size3 size = m.size();
+
+		assert(size == v.size());
+		assert(size == result->size());
+
+		return ParallelDeterministicReduce(ZERO_SIZE, size.z, 0.0, [&](size_t kBegin, size_t kEnd, double init)
+		{
+			for (size_t k = kBegin; k < kEnd; ++k)
+			{
+				for (size_t j = 0; j < size.y; ++j)
+				{
+					for (size_t i = 0; i < size.x; ++i)
+					{
+						const T mv = RowProduct(m, v, size, i, j, k);
+
+						(*result)(i, j, k) = mv;
+						init += static_cast<double>(v(i, j, k) * mv);
+					}
+				}
+			}
+
+			return init;
+		}, std::plus<double>());
+	}
+
+	template <typename T>
+	static double UpdateSolutionAndResidualImpl(
+		double a, const Array3<T>& d, const Array3<T>& q, Array3<T>* x, Array3<T>* r)
+	{
+		Size3 size = d.size();
+
+		assert(size == q.size());
+		assert(size == x->size());
+		assert(size == r->size());
+
+		const T aT = static_cast<T>(a);
+
+		return ParallelDeterministicReduce(ZERO_SIZE, size.z, 0.0, [&](size_t kBegin, size_t kEnd, double init)
+		{
+			for (size_t k = kBegin; k < kEnd; ++k)
+			{
+				for (size_t j = 0; j < size.y; ++j)
+				{
+					for (size_t i = 0; i < size.x; ++i)
+					{
+						(*x)(i, j, k) += aT * d(i, j, k);
+
+						const T rijk = (*r)(i, j, k) - aT * q(i, j, k);
+						(*r)(i, j, k) = rijk;
+						init += static_cast<double>(rijk * rijk);
+					}
+				}
+			}
+
+			return init;
+		}, std::plus<double>());
+	}
+
 	void FDMLinearSystem3::Clear()
 	{
 		A.Clear();
@@ -27,6 +219,19 @@ namespace CubbyFlow
 		b.Resize(size);
 	}
 
+	void FDMMatrixFreeLinearSystem3::Clear()
+	{
+		A.markers = ConstArrayAccessor3<char>();
+		x.Clear();
+		b.Clear();
+	}
+
+	void FDMMatrixFreeLinearSystem3::Resize(const Size3& size)
+	{
+		x.Resize(size);
+		b.Resize(size);
+	}
+
 	void FDMCompressedLinearSystem3::Clear()
 	{
 		A.Clear();
@@ -62,23 +267,131 @@ namespace CubbyFlow
 
 		assert(size == b.size());
 
-		double result = 0.0;
+		return DotRange1(a, b, size.x * size.y * size.z);
+	}
+
+	void FDMBLAS3::AXPlusY(double a, const FDMVector3& x, const FDMVector3& y, FDMVector3* result)
+	{
+		assert(x.size() == y.size());
+		assert(x.size() == result->size());
+
+		x.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			(*result)(i, j, k) = a * x(i, j, k) + y(i, j, k);
+		});
+	}
+
+	void FDMBLAS3::MVM(const FDMMatrix3& m, const FDMVector3& v, FDMVector3* result)
+	{
+		MVMImpl(m, v, result);
+	}
+
+	void FDMBLAS3::Residual(const FDMMatrix3& a, const FDMVector3& x, const FDMVector3& b, FDMVector3* result)
+	{
+		ResidualImpl(a, x, b, result);
+	}
+
+	double FDMBLAS3::L2Norm(const FDMVector3& v)
+	{
+		return std::sqrt(Dot(v, v));
+	}
+
+	double FDMBLAS3::LInfNorm(const FDMVector3& v)
+	{
+		Size3 size = v.size();
+
+		return LInfNormRange1(v, size.x * size.y * size.z);
+	}
 
-		for (size_t k = 0; k < size.z; ++k)
+	double FDMBLAS3::MVMDot(const FDMMatrix3& m, const FDMVector3& v, FDMVector3* result)
+	{
+		return MVMDotImpl(m, v, result);
+	}
+
+	double FDMBLAS3::UpdateSolutionAndResidual(
+		double a, const FDMVector3& d, const FDMVector3& q, FDMVector3* x, FDMVector3* r)
+	{
+		return UpdateSolutionAndResidualImpl(a, d, q, x, r);
+	}
+
+	void FDMBLAS3F::Set(float s, FDMVector3F* result)
+	{
+		result->Set(s);
+	}
+
+	void FDMBLAS3F::Set(const FDMVector3F& v, FDMVector3F* result)
+	{
+		result->Set(v);
+	}
+
+	void FDMBLAS3F::Set(const FDMVector3& v, FDMVector3F* result)
+	{
+		result->Resize(v.size());
+
+		v.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
 		{
-			for (size_t j = 0; j < size.y; ++j)
+			(*result)(i, j, k) = static_cast<float>(v(i, j, k));
+		});
+	}
+
+	void FDMBLAS3F::Set(float s, FDMMatrix3F* result)
+	{
+		FDMMatrixRow3F row;
+		row.center = row.right = row.up = row.front = s;
+		result->Set(row);
+	}
+
+	void FDMBLAS3F::Set(const FDMMatrix3F& m, FDMMatrix3F* result)
+	{
+		result->Set(m);
+	}
+
+	void FDMBLAS3F::Set(const FDMMatrix3& m, FDMMatrix3F* result)
+	{
+		result->Resize(m.size());
+
+		m.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			FDMMatrixRow3F& row = (*result)(i, j, k);
+			row.center = static_cast<float>(m(i, j, k).center);
+			row.right = static_cast<float>(m(i, j, k).right);
+			row.up = static_cast<float>(m(i, j, k).up);
+			row.front = static_cast<float>(m(i, j, k).front);
+		});
+	}
+
+	double FDMBLAS3F::Dot(const FDMVector3F& a, const FDMVector3F& b)
+	{
+		Size3 size = a.size();
+
+		assert(size == b.size());
+
+		return ParallelDeterministicReduce(ZERO_SIZE, size.x * size.y * size.z, 0.0,
+			[&](size_t start, size_t end, double init)
+		{
+			for (size_t i = start; i < end; ++i)
 			{
-				for (size_t i = 0; i < size.x; ++i)
-				{
-					result += a(i, j, k) * b(i, j, k);
-				}
+				init += static_cast<double>(a[i]) * b[i];
 			}
-		}
 
-		return result;
+			return init;
+		}, std::plus<double>());
 	}
 
-	void FDMBLAS3::AXPlusY(double a, const FDMVector3& x, const FDMVector3& y, FDMVector3* result)
+	void FDMBLAS3F::AXPlusY(double a, const FDMVector3F& x, const FDMVector3F& y, FDMVector3F* result)
+	{
+		assert(x.size() == y.size());
+		assert(x.size() == result->size());
+
+		const float aF = static_cast<float>(a);
+
+		x.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			(*result)(i, j, k) = aF * x(i, j, k) + y(i, j, k);
+		});
+	}
+
+	void FDMBLAS3F::AXPlusY(double a, const FDMVector3F& x, const FDMVector3& y, FDMVector3* result)
 	{
 		assert(x.size() == y.size());
 		assert(x.size() == result->size());
@@ -89,27 +402,85 @@ namespace CubbyFlow
 		});
 	}
 
-	void FDMBLAS3::MVM(const FDMMatrix3& m, const FDMVector3& v, FDMVector3* result)
+	void FDMBLAS3F::MVM(const FDMMatrix3F& m, const FDMVector3F& v, FDMVector3F* result)
 	{
-		Size3 size = m.size();
+		MVMImpl(m, v, result);
+	}
 
-		assert(size == v.size());
-		assert(size == result->size());
+	void FDMBLAS3F::Residual(const FDMMatrix3F& a, const FDMVector3F& x, const FDMVector3F& b, FDMVector3F* result)
+	{
+		ResidualImpl(a, x, b, result);
+	}
 
-		m.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+	void FDMBLAS3F::Residual(const FDMMatrix3& a, const FDMVector3& x, const FDMVector3& b, FDMVector3F* result)
+	{
+		ResidualImpl(a, x, b, result);
+	}
+
+	double FDMBLAS3F::L2Norm(const FDMVector3F& v)
+	{
+		return std::sqrt(Dot(v, v));
+	}
+
+	double FDMBLAS3F::LInfNorm(const FDMVector3F& v)
+	{
+		Size3 size = v.size();
+
+		return LInfNormRange1(v, size.x * size.y * size.z);
+	}
+
+	double FDMBLAS3F::MVMDot(const FDMMatrix3F& m, const FDMVector3F& v, FDMVector3F* result)
+	{
+		return MVMDotImpl(m, v, result);
+	}
+
+	double FDMBLAS3F::UpdateSolutionAndResidual(
+		double a, const FDMVector3F& d, const FDMVector3F& q, FDMVector3F* x, FDMVector3F* r)
+	{
+		return UpdateSolutionAndResidualImpl(a, d, q, x, r);
+	}
+
+	void FDMMatrixFreeBLAS3::Set(double s, FDMVector3* result)
+	{
+		result->Set(s);
+	}
+
+	void FDMMatrixFreeBLAS3::Set(const FDMVector3& v, FDMVector3* result)
+	{
+		result->Set(v);
+	}
+
+	void FDMMatrixFreeBLAS3::Set(const FDMMatrixFree3& m, FDMMatrixFree3* result)
+	{
+		*result = m;
+	}
+
+	void FDMMatrixFreeBLAS3::Set(const FDMMatrixFree3& m, FDMMatrix3* result)
+	{
+		result->Resize(m.size());
+
+		result->ParallelForEachIndex([&](size_t i, size_t j, size_t k)
 		{
-			(*result)(i, j, k) =
-				m(i, j, k).center * v(i, j, k) +
-				((i > 0) ? m(i - 1, j, k).right * v(i - 1, j, k) : 0.0) +
-				((i + 1 < size.x) ? m(i, j, k).right * v(i + 1, j, k) : 0.0) +
-				((j > 0) ? m(i, j - 1, k).up * v(i, j - 1, k) : 0.0) +
-				((j + 1 < size.y) ? m(i, j, k).up * v(i, j + 1, k) : 0.0) +
-				((k > 0) ? m(i, j, k - 1).front * v(i, j, k - 1) : 0.0) +
-				((k + 1 < size.z) ? m(i, j, k).front * v(i, j, k + 1) : 0.0);
+			(*result)(i, j, k) = m(i, j, k);
 		});
 	}
 
-	void FDMBLAS3::Residual(const FDMMatrix3& a, const FDMVector3& x, const FDMVector3& b, FDMVector3* result)
+	double FDMMatrixFreeBLAS3::Dot(const FDMVector3& a, const FDMVector3& b)
+	{
+		return FDMBLAS3::Dot(a, b);
+	}
+
+	void FDMMatrixFreeBLAS3::AXPlusY(double a, const FDMVector3& x, const FDMVector3& y, FDMVector3* result)
+	{
+		FDMBLAS3::AXPlusY(a, x, y, result);
+	}
+
+	void FDMMatrixFreeBLAS3::MVM(const FDMMatrixFree3& m, const FDMVector3& v, FDMVector3* result)
+	{
+		MVMImpl(m, v, result);
+	}
+
+	void FDMMatrixFreeBLAS3::Residual(const FDMMatrixFree3& a, const FDMVector3& x, const FDMVector3& b, FDMVector3* result)
 	{
 		Size3 size = a.size();
 
@@ -117,42 +488,31 @@ namespace CubbyFlow
 		assert(size == b.size());
 		assert(size == result->size());
 
-		a.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		x.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
 		{
-			(*result)(i, j, k) =
-				b(i, j, k) -
-				a(i, j, k).center * x(i, j, k) -
-				((i > 0) ? a(i - 1, j, k).right * x(i - 1, j, k) : 0.0) -
-				((i + 1 < size.x) ? a(i, j, k).right * x(i + 1, j, k) : 0.0) -
-				((j > 0) ? a(i, j - 1, k).up * x(i, j - 1, k) : 0.0) -
-				((j + 1 < size.y) ? a(i, j, k).up * x(i, j + 1, k) : 0.0) -
-				((k > 0) ? a(i, j, k - 1).front * x(i, j, k - 1) : 0.0) -
-				((k + 1 < size.z) ? a(i, j, k).front * x(i, j, k + 1) : 0.0);
+			(*result)(i, j, k) = b(i, j, k) - RowProduct(a, x, size, i, j, k);
 		});
 	}
 
-	double FDMBLAS3::L2Norm(const FDMVector3& v)
+	double FDMMatrixFreeBLAS3::L2Norm(const FDMVector3& v)
 	{
-		return std::sqrt(Dot(v, v));
+		return FDMBLAS3::L2Norm(v);
 	}
 
-	double FDMBLAS3::LInfNorm(const FDMVector3& v)
+	double FDMMatrixFreeBLAS3::LInfNorm(const FDMVector3& v)
 	{
-		Size3 size = v.size();
-		double result = 0.0;
+		return FDMBLAS3::LInfNorm(v);
+	}
 
-		for (size_t k = 0; k < size.z; ++k)
-		{
-			for (size_t j = 0; j < size.y; ++j)
-			{
-				for (size_t i = 0; i < size.x; ++i)
-				{
-					result = AbsMax(result, v(i, j, k));
-				}
-			}
-		}
+	double FDMMatrixFreeBLAS3::MVMDot(const FDMMatrixFree3& m, const FDMVector3& v, FDMVector3* result)
+	{
+		return MVMDotImpl(m, v, result);
+	}
 
-		return std::fabs(result);
+	double FDMMatrixFreeBLAS3::UpdateSolutionAndResidual(
+		double a, const FDMVector3& d, const FDMVector3& q, FDMVector3* x, FDMVector3* r)
+	{
+		return UpdateSolutionAndResidualImpl(a, d, q, x, r);
 	}
 
 	void FDMCompressedBLAS3::Set(double s, VectorND* result)
@@ -8,12 +8,33 @@
 *************************************************************************/
 #include <Core/Geometry/TriangleMesh3.h>
 #include <Core/Math/MathUtils.h>
+#include <Core/Utils/Macros.h>
 #include <Core/Utils/Parallel.h>
 
-#include <obj/obj_parser.hpp>
-
+#ifdef CUBBYFLOW_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
 
 namespace CubbyFlow
 {
@@ -29,6 +50,628 @@ namespace CubbyFlow
 		return stream;
 	}
 
+	namespace
+	{
+		//! Read-only view of the whole content of a file, which is mapped to
+		//! the memory instead of being copied.
+		class MappedFile final
+		{
+		public:
+			explicit MappedFile(const std::string& fileName)
+			{
+#ifdef CUBBYFLOW_WINDOWS
+				m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				LARGE_INTEGER size;
+
+				if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+				{
+					return;
+				}
+
+				m_size = static_cast<size_t>(size.QuadPart);
+				if (m_size > 0)
+				{
+					m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					if (m_mapping == nullptr)
+					{
+						return;
+					}
+
+					m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+					if (m_data == nullptr)
+					{
+						return;
+					}
+				}
+#else
+				m_file = open(fileName.c_str(), O_RDONLY);
+				struct stat status;
+
+				if (m_file < 0 || fstat(m_file, &status) != 0)
+				{
+					return;
+				}
+
+				m_size = static_cast<size_t>(status.st_size);
+				if (m_size > 0)
+				{
+					void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+					if (data == MAP_FAILED)
+					{
+						return;
+					}
+
+					m_data = static_cast<const char*>(data);
+				}
+#endif
+				m_isOpen = true;
+			}
+
+			MappedFile(const MappedFile&) = delete;
+
+			~MappedFile()
+			{
+#ifdef CUBBYFLOW_WINDOWS
+				if (m_data != nullptr)
+				{
+					UnmapViewOfFile(m_data);
+				}
+
+				if (m_mapping != nullptr)
+				{
+					CloseHandle(m_mapping);
+				}
+
+				if (m_file != INVALID_HANDLE_VALUE)
+				{
+					CloseHandle(m_file);
+				}
+#else
+				if (m_data != nullptr)
+				{
+					munmap(const_cast<char*>(m_data), m_size);
+				}
+
+				if (m_file >= 0)
+				{
+					close(m_file);
+				}
+#endif
+			}
+
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			bool IsOpen() const
+			{
+				return m_isOpen;
+			}
+
+			const char* begin() const
+			{
+				return m_data;
+			}
+
+			const char* end() const
+			{
+				return m_data + m_size;
+			}
+
+		private:
+#ifdef CUBBYFLOW_WINDOWS
+			HANDLE m_file = INVALID_HANDLE_VALUE;
+			HANDLE m_mapping = nullptr;
+#else
+			int m_file = -1;
+#endif
+			const char* m_data = nullptr;
+			size_t m_size = 0;
+			bool m_isOpen = false;
+		};
+
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		const char* SkipSpaces(const char* p, const char* end)
+		{
+			while (p < end && IsSpace(*p))
+			{
+				++p;
+			}
+
+			return p;
+		}
+
+		const char* SkipToken(const char* p, const char* end)
+		{
+			while (p < end && !IsSpace(*p) && *p != '\n')
+			{
+				++p;
+			}
+
+			return p;
+		}
+
+		const char* NextLine(const char* p, const char* end)
+		{
+			p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+			return (p == nullptr) ? end : p + 1;
+		}
+
+		bool IsLineEnd(const char* p, const char* end)
+		{
+			return p == end || *p == '\n' || *p == '#';
+		}
+
+		bool ParseReal(const char** p, const char* end, double* value)
+		{
+			const char* first = SkipSpaces(*p, end);
+			const char* last = SkipToken(first, end);
+			const size_t length = static_cast<size_t>(last - first);
+
+			// strtod needs a null-terminated string, and the mapped file is not
+			char buffer[64];
+			if (length == 0 || length >= sizeof(buffer))
+			{
+				return false;
+			}
+
+			std::memcpy(buffer, first, length);
+			buffer[length] = '\0';
+
+			char* parsed;
+			*value = std::strtod(buffer, &parsed);
+			*p = last;
+
+			return parsed == buffer + length;
+		}
+
+		bool ParseIndex(const char** p, const char* end, ssize_t* value)
+		{
+			const char* q = *p;
+			const bool isNegative = (q < end && *q == '-');
+
+			if (q < end && (*q == '-' || *q == '+'))
+			{
+				++q;
+			}
+
+			if (q == end || *q < '0' || *q > '9')
+			{
+				return false;
+			}
+
+			ssize_t result = 0;
+			while (q < end && *q >= '0' && *q <= '9')
+			{
+				result = 10 * result + (*q - '0');
+				++q;
+			}
+
+			*value = isNegative ? -result : result;
+			*p = q;
+
+			return true;
+		}
+
+		enum class ObjLine
+		{
+			Point,
+			UV,
+			Normal,
+			Face,
+			Other
+		};
+
+		//! Returns the type of the line at \p p, and moves \p p past its keyword.
+		ObjLine ParseObjKeyword(const char** p, const char* end)
+		{
+			const char* q = SkipSpaces(*p, end);
+			ObjLine type = ObjLine::Other;
+			size_t length = 0;
+
+			if (q < end && *q == 'v')
+			{
+				if (q + 1 < end && IsSpace(q[1]))
+				{
+					type = ObjLine::Point;
+					length = 1;
+				}
+				else if (q + 2 < end && IsSpace(q[2]) && (q[1] == 't' || q[1] == 'n'))
+				{
+					type = (q[1] == 't') ? ObjLine::UV : ObjLine::Normal;
+					length = 2;
+				}
+			}
+			else if (q + 1 < end && *q == 'f' && IsSpace(q[1]))
+			{
+				type = ObjLine::Face;
+				length = 1;
+			}
+
+			*p = q + length;
+			return type;
+		}
+
+		//! Returns the number of vertices of the face at \p p. Whether they
+		//! have UV and normal indices is read from the first vertex.
+		size_t CountObjFaceVertices(const char* p, const char* end, bool* hasUV, bool* hasNormal)
+		{
+			size_t count = 0;
+
+			for (p = SkipSpaces(p, end); !IsLineEnd(p, end); p = SkipSpaces(p, end))
+			{
+				const char* last = SkipToken(p, end);
+
+				if (count == 0)
+				{
+					const char* slash = std::find(p, last, '/');
+					*hasUV = (slash + 1 < last && slash[1] != '/');
+					*hasNormal = (slash != last && std::find(slash + 1, last, '/') != last);
+				}
+
+				p = last;
+				++count;
+			}
+
+			return count;
+		}
+
+		//! Parses the face vertex "p", "p/t", "p//n" or "p/t/n" at \p p. The
+		//! missing indices are set to zero.
+		bool ParseObjFaceVertex(const char** p, const char* end, ssize_t* indices)
+		{
+			indices[0] = indices[1] = indices[2] = 0;
+
+			if (!ParseIndex(p, end, &indices[0]))
+			{
+				return false;
+			}
+
+			if (*p < end && **p == '/')
+			{
+				++*p;
+
+				if (*p < end && **p != '/' && !ParseIndex(p, end, &indices[1]))
+				{
+					return false;
+				}
+
+				if (*p < end && **p == '/')
+				{
+					++*p;
+
+					if (!ParseIndex(p, end, &indices[2]))
+					{
+						return false;
+					}
+				}
+			}
+
+			return *p == end || IsSpace(**p) || **p == '\n';
+		}
+
+		//! Converts the obj \p index into the index of the mesh. Positive
+		//! indices start from 1, and negative ones count back from the
+		//! \p numRead elements read before the face.
+		bool ResolveObjIndex(ssize_t index, size_t numRead, size_t numTotal, size_t base, size_t* result)
+		{
+			const ssize_t resolved = (index > 0) ? index - 1 : static_cast<ssize_t>(numRead) + index;
+
+			if (index == 0 || resolved < 0 || resolved >= static_cast<ssize_t>(numTotal))
+			{
+				return false;
+			}
+
+			*result = base + static_cast<size_t>(resolved);
+			return true;
+		}
+
+		//! Line-aligned part of an obj file, which is parsed by a single thread.
+		struct ObjChunk
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+
+			size_t numPoints = 0;
+			size_t numUVs = 0;
+			size_t numNormals = 0;
+			size_t numTriangles = 0;
+			size_t numTrianglesWithUVs = 0;
+			size_t numTrianglesWithNormals = 0;
+
+			size_t firstPoint = 0;
+			size_t firstUV = 0;
+			size_t firstNormal = 0;
+			size_t firstTriangle = 0;
+
+			bool isValid = true;
+		};
+
+		enum class PlyType
+		{
+			Int8,
+			UInt8,
+			Int16,
+			UInt16,
+			Int32,
+			UInt32,
+			Float32,
+			Float64,
+			Invalid
+		};
+
+		PlyType GetPlyType(const std::string& name)
+		{
+			if (name == "char" || name == "int8")
+			{
+				return PlyType::Int8;
+			}
+			if (name == "uchar" || name == "uint8")
+			{
+				return PlyType::UInt8;
+			}
+			if (name == "short" || name == "int16")
+			{
+				return PlyType::Int16;
+			}
+			if (name == "ushort" || name == "uint16")
+			{
+				return PlyType::UInt16;
+			}
+			if (name == "int" || name == "int32")
+			{
+				return PlyType::Int32;
+			}
+			if (name == "uint" || name == "uint32")
+			{
+				return PlyType::UInt32;
+			}
+			if (name == "float" || name == "float32")
+			{
+				return PlyType::Float32;
+			}
+			if (name == "double" || name == "float64")
+			{
+				return PlyType::Float64;
+			}
+
+			return PlyType::Invalid;
+		}
+
+		size_t GetPlyTypeSize(PlyType type)
+		{
+			switch (type)
+			{
+			case PlyType::Int8:
+			case PlyType::UInt8:
+				return 1;
+			case PlyType::Int16:
+			case PlyType::UInt16:
+				return 2;
+			case PlyType::Int32:
+			case PlyType::UInt32:
+			case PlyType::Float32:
+				return 4;
+			case PlyType::Float64:
+				return 8;
+			default:
+				return 0;
+			}
+		}
+
+		struct PlyProperty
+		{
+			std::string name;
+			PlyType type = PlyType::Invalid;
+			PlyType countType = PlyType::Invalid;
+
+			bool IsList() const
+			{
+				return countType != PlyType::Invalid;
+			}
+		};
+
+		struct PlyElement
+		{
+			std::string name;
+			size_t count = 0;
+			std::vector<PlyProperty> properties;
+
+			//! Beginning of each record, plus the end of the element.
+			std::vector<const char*> records;
+		};
+
+		bool IsLittleEndian()
+		{
+			const uint16_t one = 1;
+			uint8_t firstByte;
+			std::memcpy(&firstByte, &one, 1);
+
+			return firstByte == 1;
+		}
+
+		template <typename T>
+		T ReadPlyBytes(const char* p, bool swapBytes)
+		{
+			char bytes[sizeof(T)];
+			std::memcpy(bytes, p, sizeof(T));
+
+			if (swapBytes)
+			{
+				std::reverse(bytes, bytes + sizeof(T));
+			}
+
+			T value;
+			std::memcpy(&value, bytes, sizeof(T));
+
+			return value;
+		}
+
+		template <typename T>
+		char* WritePlyBytes(char* p, T value, bool swapBytes)
+		{
+			std::memcpy(p, &value, sizeof(T));
+
+			if (swapBytes)
+			{
+				std::reverse(p, p + sizeof(T));
+			}
+
+			return p + sizeof(T);
+		}
+
+		double ReadPlyValue(const char* p, PlyType type, bool swapBytes)
+		{
+			switch (type)
+			{
+			case PlyType::Int8:
+				return ReadPlyBytes<int8_t>(p, swapBytes);
+			case PlyType::UInt8:
+				return ReadPlyBytes<uint8_t>(p, swapBytes);
+			case PlyType::Int16:
+				return ReadPlyBytes<int16_t>(p, swapBytes);
+			case PlyType::UInt16:
+				return ReadPlyBytes<uint16_t>(p, swapBytes);
+			case PlyType::Int32:
+				return ReadPlyBytes<int32_t>(p, swapBytes);
+			case PlyType::UInt32:
+				return ReadPlyBytes<uint32_t>(p, swapBytes);
+			case PlyType::Float32:
+				return ReadPlyBytes<float>(p, swapBytes);
+			case PlyType::Float64:
+				return ReadPlyBytes<double>(p, swapBytes);
+			default:
+				return 0.0;
+			}
+		}
+
+		//! Returns the beginning of the property \p index of \p record.
+		const char* FindPlyProperty(const char* record, const PlyElement& element, size_t index, bool swapBytes)
+		{
+			for (size_t i = 0; i < index; ++i)
+			{
+				const PlyProperty& property = element.properties[i];
+
+				if (property.IsList())
+				{
+					const double count = ReadPlyValue(record, property.countType, swapBytes);
+					record += GetPlyTypeSize(property.countType) + static_cast<size_t>(count) * GetPlyTypeSize(property.type);
+				}
+				else
+				{
+					record += GetPlyTypeSize(property.type);
+				}
+			}
+
+			return record;
+		}
+
+		//! Returns the index of the property with one of the \p names, or the
+		//! number of the properties if there is none.
+		size_t FindPlyProperty(const PlyElement& element, std::initializer_list<const char*> names)
+		{
+			for (size_t i = 0; i < element.properties.size(); ++i)
+			{
+				for (const char* name : names)
+				{
+					if (element.properties[i].name == name)
+					{
+						return i;
+					}
+				}
+			}
+
+			return element.properties.size();
+		}
+
+		//! Parses the header of a binary ply file, and moves \p p to the
+		//! beginning of the data.
+		bool ParsePlyHeader(const char** p, const char* end, bool* isBigEndian, std::vector<PlyElement>* elements)
+		{
+			bool hasFormat = false;
+
+			for (const char* line = *p; line < end;)
+			{
+				const char* next = NextLine(line, end);
+				std::istringstream words(std::string(line, next));
+				std::string keyword;
+				words >> keyword;
+
+				if (line == *p)
+				{
+					if (keyword != "ply")
+					{
+						return false;
+					}
+				}
+				else if (keyword == "format")
+				{
+					std::string format;
+					words >> format;
+
+					if (format != "binary_little_endian" && format != "binary_big_endian")
+					{
+						return false;
+					}
+
+					*isBigEndian = (format == "binary_big_endian");
+					hasFormat = true;
+				}
+				else if (keyword == "element")
+				{
+					PlyElement element;
+					words >> element.name >> element.count;
+
+					if (!words)
+					{
+						return false;
+					}
+
+					elements->push_back(element);
+				}
+				else if (keyword == "property")
+				{
+					PlyProperty property;
+					std::string type;
+					words >> type;
+
+					if (type == "list")
+					{
+						std::string countType;
+						words >> countType >> type;
+						property.countType = GetPlyType(countType);
+
+						if (property.countType == PlyType::Invalid || property.countType == PlyType::Float32 || property.countType == PlyType::Float64)
+						{
+							return false;
+						}
+					}
+
+					property.type = GetPlyType(type);
+					words >> property.name;
+
+					if (!words || property.type == PlyType::Invalid || elements->empty())
+					{
+						return false;
+					}
+
+					elements->back().properties.push_back(property);
+				}
+				else if (keyword == "end_header")
+				{
+					*p = next;
+					return hasFormat;
+				}
+
+				line = next;
+			}
+
+			return false;
+		}
+	}
+
 	TriangleMesh3::TriangleMesh3(const Transform3& transform_, bool isNormalFlipped_) :
 		Surface3(transform_, isNormalFlipped_)
 	{
@@ -150,10 +793,128 @@ namespace CubbyFlow
 		return queryResult.distance;
 	}
 
-	void TriangleMesh3::Clear()
+	void TriangleMesh3::ClosestPoints(
+		const ConstArrayAccessor1<Vector3D>& otherPoints,
+		ArrayAccessor1<Vector3D> results,
+		ExecutionPolicy policy) const
 	{
-		m_points.Clear();
-		m_normals.Clear();
+		Array1<Vector3D> localPoints;
+		Array1<NearestNeighborQueryResult3<size_t>> queryResults;
+		GetNearestTriangles(otherPoints, &localPoints, &queryResults, policy);
+
+		ParallelFor(ZERO_SIZE, otherPoints.size(), [&](size_t i)
+		{
+			const Vector3D pt = Triangle(*queryResults[i].item).ClosestPoint(localPoints[i]);
+			results[i] = transform.ToWorld(pt);
+		}, policy);
+	}
+
+	void TriangleMesh3::ClosestDistances(
+		const ConstArrayAccessor1<Vector3D>& otherPoints,
+		ArrayAccessor1<double> results,
+		ExecutionPolicy policy) const
+	{
+		Array1<Vector3D> localPoints;
+		Array1<NearestNeighborQueryResult3<size_t>> queryResults;
+		GetNearestTriangles(otherPoints, &localPoints, &queryResults, policy);
+
+		ParallelFor(ZERO_SIZE, otherPoints.size(), [&](size_t i)
+		{
+			results[i] = queryResults[i].distance;
+		}, policy);
+	}
+
+	void TriangleMesh3::ClosestNormals(
+		const ConstArrayAccessor1<Vector3D>& otherPoints,
+		ArrayAccessor1<Vector3D> results,
+		ExecutionPolicy policy) const
+	{
+		Array1<Vector3D> localPoints;
+		Array1<NearestNeighborQueryResult3<size_t>> queryResults;
+		GetNearestTriangles(otherPoints, &localPoints, &queryResults, policy);
+
+		ParallelFor(ZERO_SIZE, otherPoints.size(), [&](size_t i)
+		{
+			Vector3D normal = transform.ToWorldDirection(
+				Triangle(*queryResults[i].item).ClosestNormal(localPoints[i]));
+			normal *= (isNormalFlipped) ? -1.0 : 1.0;
+			results[i] = normal;
+		}, policy);
+	}
+
+	void TriangleMesh3::ClosestPointsAndNormals(
+		const ConstArrayAccessor1<Vector3D>& otherPoints,
+		ArrayAccessor1<Vector3D> points,
+		ArrayAccessor1<Vector3D> normals,
+		ArrayAccessor1<double> distances,
+		ExecutionPolicy policy) const
+	{
+		Array1<Vector3D> localPoints;
+		Array1<NearestNeighborQueryResult3<size_t>> queryResults;
+		GetNearestTriangles(otherPoints, &localPoints, &queryResults, policy);
+
+		ParallelFor(ZERO_SIZE, otherPoints.size(), [&](size_t i)
+		{
+			const Triangle3 tri = Triangle(*queryResults[i].item);
+			Vector3D normal = transform.ToWorldDirection(tri.ClosestNormal(localPoints[i]));
+			normal *= (isNormalFlipped) ? -1.0 : 1.0;
+
+			points[i] = transform.ToWorld(tri.ClosestPoint(localPoints[i]));
+			normals[i] = normal;
+			distances[i] = queryResults[i].distance;
+		}, policy);
+	}
+
+	void TriangleMesh3::ClosestIntersections(
+		const ConstArrayAccessor1<Ray3D>& rays,
+		ArrayAccessor1<SurfaceRayIntersection3> results,
+		ExecutionPolicy policy) const
+	{
+		assert(rays.size() == results.size());
+
+		BuildBVH();
+
+		Array1<Ray3D> localRays(rays.size());
+		ParallelFor(ZERO_SIZE, rays.size(), [&](size_t i)
+		{
+			localRays[i] = transform.ToLocal(rays[i]);
+		}, policy);
+
+		const auto testFunc = [this](const size_t& triIdx, const Ray3D& ray)
+		{
+			Triangle3 tri = Triangle(triIdx);
+			SurfaceRayIntersection3 result = tri.ClosestIntersection(ray);
+
+			return result.distance;
+		};
+
+		Array1<ClosestIntersectionQueryResult3<size_t>> queryResults(rays.size());
+		m_bvh.GetClosestIntersections(localRays.ConstAccessor(), testFunc, queryResults.Accessor(), policy);
+
+		ParallelFor(ZERO_SIZE, rays.size(), [&](size_t i)
+		{
+			SurfaceRayIntersection3 result;
+			result.distance = queryResults[i].distance;
+			result.isIntersecting = queryResults[i].item != nullptr;
+
+			if (queryResults[i].item != nullptr)
+			{
+				result.point = localRays[i].PointAt(queryResults[i].distance);
+				result.normal = Triangle(*queryResults[i].item).ClosestNormal(result.point);
+			}
+
+			result.point = transform.ToWorld(result.point);
+			result.normal = transform.ToWorldDirection(result.normal);
+			result.normal *= (isNormalFlipped) ? -1.0 : 1.0;
+
+			results[i] = result;
+		}, policy);
+	}
+
+	void TriangleMesh3::Clear()
+	{
+		m_points.Clear();
+		m_normals.Clear();
 		m_uvs.Clear();
 		m_pointIndices.Clear();
 		m_normalIndices.Clear();
@@ -217,7 +978,7 @@ namespace CubbyFlow
 
 	Vector3D& TriangleMesh3::Point(size_t i)
 	{
-		InvalidateBVH();
+		InvalidateBVHBounds();
 		return m_points[i];
 	}
 
@@ -523,7 +1284,7 @@ namespace CubbyFlow
 			m_points[i] *= factor;
 		});
 
-		InvalidateBVH();
+		InvalidateBVHBounds();
 	}
 
 	void TriangleMesh3::Translate(const Vector3D& t)
@@ -534,7 +1295,7 @@ namespace CubbyFlow
 			m_points[i] += t;
 		});
 
-		InvalidateBVH();
+		InvalidateBVHBounds();
 	}
 
 	void TriangleMesh3::Rotate(const QuaternionD& q)
@@ -551,7 +1312,7 @@ namespace CubbyFlow
 			m_normals[i] = q * m_normals[i];
 		});
 
-		InvalidateBVH();
+		InvalidateBVHBounds();
 	}
 
 	void TriangleMesh3::WriteObj(std::ostream* stream) const
@@ -623,236 +1384,129 @@ namespace CubbyFlow
 
 	bool TriangleMesh3::ReadObj(std::istream* stream)
 	{
-		obj::obj_parser parser(obj::obj_parser::triangulate_faces | obj::obj_parser::translate_negative_indices);
+		std::ostringstream buffer;
+		buffer << stream->rdbuf();
 
-		parser.info_callback([](size_t lineNumber, const std::string& message)
-		{
-			std::cout << lineNumber << " " << message << "\n";
-		});
-		
-		parser.warning_callback([](size_t lineNumber, const std::string& message)
-		{
-			std::cerr << lineNumber << " " << message << "\n";
-		});
-		
-		parser.error_callback([](size_t lineNumber, const std::string& message)
-		{
-			std::cerr << lineNumber << " " << message << "\n";
-		});
+		const std::string text = buffer.str();
+		return ParseObj(text.data(), text.data() + text.size());
+	}
 
-		parser.geometric_vertex_callback([this](obj::float_type x, obj::float_type y, obj::float_type z)
-		{
-			AddPoint({ x, y, z });
-		});
+	bool TriangleMesh3::ReadObj(const std::string& fileName)
+	{
+		const MappedFile file(fileName);
 
-		parser.texture_vertex_callback([this](obj::float_type u, obj::float_type v)
+		if (file.IsOpen())
 		{
-			AddUV({ u, v });
-		});
+			return ParseObj(file.begin(), file.end());
+		}
+
+		return false;
+	}
 
-		parser.vertex_normal_callback([this](obj::float_type nx, obj::float_type ny, obj::float_type nz)
+	void TriangleMesh3::WritePly(std::ostream* stream) const
+	{
+		const size_t numPoints = NumberOfPoints();
+		const size_t numTriangles = NumberOfTriangles();
+
+		// The normals and the UVs have to be indexed the same way as the points
+		const bool hasNormals = HasNormals() && NumberOfNormals() == numPoints &&
+			m_normalIndices.size() == numTriangles && std::equal(m_pointIndices.begin(), m_pointIndices.end(), m_normalIndices.begin());
+		const bool hasUVs = HasUVs() && NumberOfUVs() == numPoints &&
+			m_uvIndices.size() == numTriangles && std::equal(m_pointIndices.begin(), m_pointIndices.end(), m_uvIndices.begin());
+
+		*stream << "ply\n";
+		*stream << "format binary_little_endian 1.0\n";
+		*stream << "element vertex " << numPoints << '\n';
+		*stream << "property double x\nproperty double y\nproperty double z\n";
+
+		if (hasNormals)
 		{
-			AddNormal({ nx, ny, nz });
-		});
+			*stream << "property double nx\nproperty double ny\nproperty double nz\n";
+		}
 
-		parser.face_callbacks(
-			// triangular_face_geometric_vertices_callback_type
-			[this](obj::index_type v0, obj::index_type v1, obj::index_type v2)
+		if (hasUVs)
 		{
-			AddPointTriangle({ v0 - 1, v1 - 1, v2 - 1 });
-		},
-			// triangular_face_geometric_vertices_texture_vertices_callback_type
-			[this](const obj::index_2_tuple_type& v0_vt0,
-				const obj::index_2_tuple_type& v1_vt1,
-				const obj::index_2_tuple_type& v2_vt2)
+			*stream << "property double u\nproperty double v\n";
+		}
+
+		*stream << "element face " << numTriangles << '\n';
+		*stream << "property list uchar int vertex_indices\n";
+		*stream << "end_header\n";
+
+		const bool swapBytes = !IsLittleEndian();
+		const size_t vertexSize = sizeof(double) * (3 + (hasNormals ? 3 : 0) + (hasUVs ? 2 : 0));
+		const size_t faceSize = sizeof(uint8_t) + 3 * sizeof(int32_t);
+		std::vector<char> data(numPoints * vertexSize + numTriangles * faceSize);
+
+		ParallelFor(ZERO_SIZE, numPoints, [&](size_t i)
 		{
-			AddPointUVTriangle(
+			char* p = data.data() + i * vertexSize;
+			const Vector3D& pt = m_points[i];
+			p = WritePlyBytes(p, pt.x, swapBytes);
+			p = WritePlyBytes(p, pt.y, swapBytes);
+			p = WritePlyBytes(p, pt.z, swapBytes);
+
+			if (hasNormals)
 			{
-				std::get<0>(v0_vt0) - 1,
-				std::get<0>(v1_vt1) - 1,
-				std::get<0>(v2_vt2) - 1
-			},
+				const Vector3D& n = m_normals[i];
+				p = WritePlyBytes(p, n.x, swapBytes);
+				p = WritePlyBytes(p, n.y, swapBytes);
+				p = WritePlyBytes(p, n.z, swapBytes);
+			}
+
+			if (hasUVs)
 			{
-				std::get<1>(v0_vt0) - 1,
-				std::get<1>(v1_vt1) - 1,
-				std::get<1>(v2_vt2) - 1
-			});
-		},
-			// triangular_face_geometric_vertices_vertex_normals_callback_type
-			[this](const obj::index_2_tuple_type& v0_vn0,
-				const obj::index_2_tuple_type& v1_vn1,
-				const obj::index_2_tuple_type& v2_vn2)
-		{
-			AddPointNormalTriangle(
-			{
-				std::get<0>(v0_vn0) - 1,
-				std::get<0>(v1_vn1) - 1,
-				std::get<0>(v2_vn2) - 1
-			},
-			{
-				std::get<1>(v0_vn0) - 1,
-				std::get<1>(v1_vn1) - 1,
-				std::get<1>(v2_vn2) - 1
-			});
-		},
-			// triangular_face_geometric_vertices_texture_vertices_vertex_normals...
-			[this](const obj::index_3_tuple_type& v0_vt0_vn0,
-				const obj::index_3_tuple_type& v1_vt1_vn1,
-				const obj::index_3_tuple_type& v2_vt2_vn2)
-		{
-			AddPointUVNormalTriangle(
-			{
-				std::get<0>(v0_vt0_vn0) - 1,
-				std::get<0>(v1_vt1_vn1) - 1,
-				std::get<0>(v2_vt2_vn2) - 1
-			},
-			{
-				std::get<1>(v0_vt0_vn0) - 1,
-				std::get<1>(v1_vt1_vn1) - 1,
-				std::get<1>(v2_vt2_vn2) - 1
-			},
-			{
-				std::get<2>(v0_vt0_vn0) - 1,
-				std::get<2>(v1_vt1_vn1) - 1,
-				std::get<2>(v2_vt2_vn2) - 1
-			});
-		},
-			// quadrilateral_face_geometric_vertices_callback_type
-			[](obj::index_type, obj::index_type, obj::index_type, obj::index_type)
-		{
-			// Do nothing
-		},
-			// quadrilateral_face_geometric_vertices_texture_vertices_callback_type
-			[](const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// quadrilateral_face_geometric_vertices_vertex_normals_callback_type
-			[](const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// quadrilateral_face_geometric_vertices_texture_vertices_vertex_norm...
-			[](const obj::index_3_tuple_type&,
-				const obj::index_3_tuple_type&,
-				const obj::index_3_tuple_type&,
-				const obj::index_3_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_begin_callback_type
-			[](obj::index_type, obj::index_type, obj::index_type)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_vertex_callback_type
-			[](obj::index_type)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_end_callback_type
-			[]()
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_begin_callback_...
-			[](const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_vertex_callback...
-			[](const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_end_callback_type
-			[]()
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_vertex_normals_begin_callback_type
-			[](const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&,
-				const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_vertex_normals_vertex_callback_type
-			[](const obj::index_2_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_vertex_normals_end_callback_type
-			[]()
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_vertex_normals_...
-			[](const obj::index_3_tuple_type&,
-				const obj::index_3_tuple_type&,
-				const obj::index_3_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_vertex_normals_...
-			[](const obj::index_3_tuple_type&)
-		{
-			// Do nothing
-		},
-			// polygonal_face_geometric_vertices_texture_vertices_vertex_normals_...
-			[]()
-		{
-			// Do nothing
+				const Vector2D& uv = m_uvs[i];
+				p = WritePlyBytes(p, uv.x, swapBytes);
+				WritePlyBytes(p, uv.y, swapBytes);
+			}
 		});
 
-		parser.group_name_callback([](const std::string&)
-		{
-			// Do nothing
-		});
-		parser.smoothing_group_callback([](obj::size_type)
+		ParallelFor(ZERO_SIZE, numTriangles, [&](size_t i)
 		{
-			// Do nothing
-		});
-		parser.object_name_callback([](const std::string&)
-		{
-			// Do nothing
-		});
-		parser.material_library_callback([](const std::string&)
-		{
-			// Do nothing
-		});
-		parser.material_name_callback([](const std::string&)
-		{
-			// Do nothing
-		});
-		parser.comment_callback([](const std::string&)
-		{
-			// Do nothing
-		});
+			char* p = data.data() + numPoints * vertexSize + i * faceSize;
+			p = WritePlyBytes(p, static_cast<uint8_t>(3), swapBytes);
 
-		InvalidateBVH();
+			for (size_t j = 0; j < 3; ++j)
+			{
+				p = WritePlyBytes(p, static_cast<int32_t>(m_pointIndices[i][j]), swapBytes);
+			}
+		});
 
-		return parser.parse(*stream);
+		stream->write(data.data(), static_cast<std::streamsize>(data.size()));
 	}
 
-	bool TriangleMesh3::ReadObj(const std::string& fileName)
+	bool TriangleMesh3::WritePly(const std::string& fileName) const
 	{
-		std::ifstream file(fileName.c_str());
+		std::ofstream file(fileName.c_str(), std::ios::binary);
 
 		if (file)
 		{
-			bool result = ReadObj(&file);
+			WritePly(&file);
 			file.close();
 
-			return result;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool TriangleMesh3::ReadPly(std::istream* stream)
+	{
+		std::ostringstream buffer;
+		buffer << stream->rdbuf();
+
+		const std::string data = buffer.str();
+		return ParsePly(data.data(), data.data() + data.size());
+	}
+
+	bool TriangleMesh3::ReadPly(const std::string& fileName)
+	{
+		const MappedFile file(fileName);
+
+		if (file.IsOpen())
+		{
+			return ParsePly(file.begin(), file.end());
 		}
 
 		return false;
@@ -874,24 +1528,561 @@ namespace CubbyFlow
 		m_bvhInvalidated = true;
 	}
 
+	void TriangleMesh3::InvalidateBVHBounds() const
+	{
+		m_bvhBoundsInvalidated = true;
+	}
+
 	void TriangleMesh3::BuildBVH() const
 	{
-		if (m_bvhInvalidated)
+		if (m_bvhInvalidated || m_bvhBoundsInvalidated)
 		{
 			size_t nTris = NumberOfTriangles();
 
-			std::vector<size_t> ids(nTris);
 			std::vector<BoundingBox3D> bounds(nTris);
-			for (size_t i = 0; i < nTris; ++i)
+			ParallelFor(ZERO_SIZE, nTris, [&](size_t i)
+			{
+				const Point3UI& face = m_pointIndices[i];
+				bounds[i] = BoundingBox3D(m_points[face[0]], m_points[face[1]]);
+				bounds[i].Merge(m_points[face[2]]);
+			});
+
+			// Only the points have moved if the triangles are the same, so the
+			// hierarchy is refitted
+			if (m_bvhInvalidated)
+			{
+				std::vector<size_t> ids(nTris);
+				std::iota(ids.begin(), ids.end(), 0);
+
+				m_bvh.Build(ids, bounds);
+			}
+			else
 			{
-				ids[i] = i;
-				bounds[i] = Triangle(i).BoundingBox();
+				m_bvh.Refit(bounds);
 			}
 
-			m_bvh.Build(ids, bounds);
 			m_bvhInvalidated = false;
+			m_bvhBoundsInvalidated = false;
 		}
 	}
+
+	void TriangleMesh3::GetNearestTriangles(
+		const ConstArrayAccessor1<Vector3D>& otherPoints,
+		Array1<Vector3D>* localPoints,
+		Array1<NearestNeighborQueryResult3<size_t>>* queryResults,
+		ExecutionPolicy policy) const
+	{
+		BuildBVH();
+
+		localPoints->Resize(otherPoints.size());
+		queryResults->Resize(otherPoints.size());
+
+		ParallelFor(ZERO_SIZE, otherPoints.size(), [&](size_t i)
+		{
+			(*localPoints)[i] = transform.ToLocal(otherPoints[i]);
+		}, policy);
+
+		const auto distanceFunc = [this](const size_t& triIdx, const Vector3D& pt)
+		{
+			Triangle3 tri = Triangle(triIdx);
+			return tri.ClosestDistance(pt);
+		};
+
+		m_bvh.GetNearestNeighbors(localPoints->ConstAccessor(), distanceFunc, queryResults->Accessor(), policy);
+	}
+
+	bool TriangleMesh3::ParseObj(const char* begin, const char* end)
+	{
+		// Splits the text into line-aligned chunks, a few per thread
+		const size_t size = static_cast<size_t>(end - begin);
+		const size_t chunkSize = std::max(size / (4 * GetMaxNumberOfThreads()) + 1, static_cast<size_t>(1) << 16);
+		std::vector<ObjChunk> chunks;
+
+		for (const char* p = begin; p < end; p = chunks.back().end)
+		{
+			ObjChunk chunk;
+			chunk.begin = p;
+			chunk.end = (static_cast<size_t>(end - p) > chunkSize) ? NextLine(p + chunkSize, end) : end;
+			chunks.push_back(chunk);
+		}
+
+		// Counts the elements of each chunk
+		ParallelFor(ZERO_SIZE, chunks.size(), [&](size_t c)
+		{
+			ObjChunk& chunk = chunks[c];
+
+			for (const char* p = chunk.begin; p < chunk.end; p = NextLine(p, chunk.end))
+			{
+				switch (ParseObjKeyword(&p, chunk.end))
+				{
+				case ObjLine::Point:
+					++chunk.numPoints;
+					break;
+				case ObjLine::UV:
+					++chunk.numUVs;
+					break;
+				case ObjLine::Normal:
+					++chunk.numNormals;
+					break;
+				case ObjLine::Face:
+				{
+					bool hasUV = false;
+					bool hasNormal = false;
+					const size_t numVertices = CountObjFaceVertices(p, chunk.end, &hasUV, &hasNormal);
+
+					if (numVertices < 3)
+					{
+						chunk.isValid = false;
+						break;
+					}
+
+					chunk.numTriangles += numVertices - 2;
+					chunk.numTrianglesWithUVs += hasUV ? numVertices - 2 : 0;
+					chunk.numTrianglesWithNormals += hasNormal ? numVertices - 2 : 0;
+					break;
+				}
+				default:
+					break;
+				}
+			}
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+
+		size_t numPoints = 0;
+		size_t numUVs = 0;
+		size_t numNormals = 0;
+		size_t numTriangles = 0;
+		size_t numTrianglesWithUVs = 0;
+		size_t numTrianglesWithNormals = 0;
+
+		for (ObjChunk& chunk : chunks)
+		{
+			if (!chunk.isValid)
+			{
+				return false;
+			}
+
+			chunk.firstPoint = numPoints;
+			chunk.firstUV = numUVs;
+			chunk.firstNormal = numNormals;
+			chunk.firstTriangle = numTriangles;
+
+			numPoints += chunk.numPoints;
+			numUVs += chunk.numUVs;
+			numNormals += chunk.numNormals;
+			numTriangles += chunk.numTriangles;
+			numTrianglesWithUVs += chunk.numTrianglesWithUVs;
+			numTrianglesWithNormals += chunk.numTrianglesWithNormals;
+		}
+
+		const bool keepUVs = (numTrianglesWithUVs == numTriangles);
+		const bool keepNormals = (numTrianglesWithNormals == numTriangles);
+
+		// Allocates the storage once, then fills it in parallel
+		const size_t pointBase = NumberOfPoints();
+		const size_t uvBase = NumberOfUVs();
+		const size_t normalBase = NumberOfNormals();
+		const size_t triangleBase = NumberOfTriangles();
+		const size_t uvIndexBase = m_uvIndices.size();
+		const size_t normalIndexBase = m_normalIndices.size();
+
+		m_points.Resize(pointBase + numPoints);
+		m_pointIndices.Resize(triangleBase + numTriangles);
+
+		if (keepUVs)
+		{
+			m_uvs.Resize(uvBase + numUVs);
+			m_uvIndices.Resize(uvIndexBase + numTriangles);
+		}
+
+		if (keepNormals)
+		{
+			m_normals.Resize(normalBase + numNormals);
+			m_normalIndices.Resize(normalIndexBase + numTriangles);
+		}
+
+		ParallelFor(ZERO_SIZE, chunks.size(), [&](size_t c)
+		{
+			ObjChunk& chunk = chunks[c];
+			size_t point = chunk.firstPoint;
+			size_t uv = chunk.firstUV;
+			size_t normal = chunk.firstNormal;
+			size_t triangle = chunk.firstTriangle;
+
+			for (const char* p = chunk.begin; p < chunk.end && chunk.isValid; p = NextLine(p, chunk.end))
+			{
+				switch (ParseObjKeyword(&p, chunk.end))
+				{
+				case ObjLine::Point:
+				{
+					Vector3D& pt = m_points[pointBase + point++];
+					chunk.isValid = ParseReal(&p, chunk.end, &pt.x) && ParseReal(&p, chunk.end, &pt.y) && ParseReal(&p, chunk.end, &pt.z);
+					break;
+				}
+				case ObjLine::UV:
+				{
+					Vector2D t;
+					chunk.isValid = ParseReal(&p, chunk.end, &t.x) && ParseReal(&p, chunk.end, &t.y);
+
+					if (keepUVs)
+					{
+						m_uvs[uvBase + uv] = t;
+					}
+
+					++uv;
+					break;
+				}
+				case ObjLine::Normal:
+				{
+					Vector3D n;
+					chunk.isValid = ParseReal(&p, chunk.end, &n.x) && ParseReal(&p, chunk.end, &n.y) && ParseReal(&p, chunk.end, &n.z);
+
+					if (keepNormals)
+					{
+						m_normals[normalBase + normal] = n;
+					}
+
+					++normal;
+					break;
+				}
+				case ObjLine::Face:
+				{
+					// The point, UV and normal indices of the first, previous
+					// and current vertices of the fan
+					size_t vertices[3][3] = {};
+					size_t numVertices = 0;
+
+					for (p = SkipSpaces(p, chunk.end); !IsLineEnd(p, chunk.end) && chunk.isValid; p = SkipSpaces(p, chunk.end))
+					{
+						ssize_t indices[3];
+						size_t* vertex = vertices[std::min(numVertices, static_cast<size_t>(2))];
+
+						chunk.isValid = ParseObjFaceVertex(&p, chunk.end, indices) &&
+							ResolveObjIndex(indices[0], point, numPoints, pointBase, &vertex[0]) &&
+							(!keepUVs || ResolveObjIndex(indices[1], uv, numUVs, uvBase, &vertex[1])) &&
+							(!keepNormals || ResolveObjIndex(indices[2], normal, numNormals, normalBase, &vertex[2]));
+
+						if (chunk.isValid && numVertices >= 2)
+						{
+							const size_t i = triangle++;
+							m_pointIndices[triangleBase + i] = Point3UI(vertices[0][0], vertices[1][0], vertices[2][0]);
+
+							if (keepUVs)
+							{
+								m_uvIndices[uvIndexBase + i] = Point3UI(vertices[0][1], vertices[1][1], vertices[2][1]);
+							}
+
+							if (keepNormals)
+							{
+								m_normalIndices[normalIndexBase + i] = Point3UI(vertices[0][2], vertices[1][2], vertices[2][2]);
+							}
+
+							std::copy(vertices[2], vertices[2] + 3, vertices[1]);
+						}
+
+						++numVertices;
+					}
+
+					break;
+				}
+				default:
+					break;
+				}
+			}
+		}, PartitionPolicy{ PartitionMode::Dynamic });
+
+		const bool isValid = std::all_of(chunks.begin(), chunks.end(), [](const ObjChunk& chunk)
+		{
+			return chunk.isValid;
+		});
+
+		if (!isValid)
+		{
+			m_points.Resize(pointBase);
+			m_pointIndices.Resize(triangleBase);
+
+			if (keepUVs)
+			{
+				m_uvs.Resize(uvBase);
+				m_uvIndices.Resize(uvIndexBase);
+			}
+
+			if (keepNormals)
+			{
+				m_normals.Resize(normalBase);
+				m_normalIndices.Resize(normalIndexBase);
+			}
+		}
+
+		InvalidateBVH();
+
+		return isValid;
+	}
+
+	bool TriangleMesh3::ParsePly(const char* begin, const char* end)
+	{
+		bool isBigEndian = false;
+		std::vector<PlyElement> elements;
+		const char* p = begin;
+
+		if (!ParsePlyHeader(&p, end, &isBigEndian, &elements))
+		{
+			return false;
+		}
+
+		const bool swapBytes = (isBigEndian == IsLittleEndian());
+
+		// Finds the beginning of each record
+		for (PlyElement& element : elements)
+		{
+			const bool hasLists = std::any_of(element.properties.begin(), element.properties.end(), [](const PlyProperty& property)
+			{
+				return property.IsList();
+			});
+
+			size_t stride = 0;
+			for (const PlyProperty& property : element.properties)
+			{
+				stride += property.IsList() ? 0 : GetPlyTypeSize(property.type);
+			}
+
+			if (!hasLists && element.count > static_cast<size_t>(end - p) / std::max(stride, static_cast<size_t>(1)))
+			{
+				return false;
+			}
+
+			element.records.resize(element.count + 1);
+
+			for (size_t i = 0; i < element.count; ++i)
+			{
+				element.records[i] = p;
+
+				if (!hasLists)
+				{
+					p += stride;
+					continue;
+				}
+
+				for (const PlyProperty& property : element.properties)
+				{
+					const size_t typeSize = GetPlyTypeSize(property.type);
+
+					if (property.IsList())
+					{
+						const size_t countSize = GetPlyTypeSize(property.countType);
+						if (static_cast<size_t>(end - p) < countSize)
+						{
+							return false;
+						}
+
+						const size_t count = static_cast<size_t>(ReadPlyValue(p, property.countType, swapBytes));
+						p += countSize;
+
+						if (count > static_cast<size_t>(end - p) / typeSize)
+						{
+							return false;
+						}
+
+						p += count * typeSize;
+					}
+					else
+					{
+						if (static_cast<size_t>(end - p) < typeSize)
+						{
+							return false;
+						}
+
+						p += typeSize;
+					}
+				}
+			}
+
+			element.records[element.count] = p;
+		}
+
+		const auto vertexElement = std::find_if(elements.begin(), elements.end(), [](const PlyElement& element)
+		{
+			return element.name == "vertex";
+		});
+		const auto faceElement = std::find_if(elements.begin(), elements.end(), [](const PlyElement& element)
+		{
+			return element.name == "face";
+		});
+
+		if (vertexElement == elements.end())
+		{
+			return false;
+		}
+
+		const PlyElement& vertices = *vertexElement;
+		const size_t numVertices = vertices.count;
+		const size_t numProperties = vertices.properties.size();
+		const size_t x = FindPlyProperty(vertices, { "x" });
+		const size_t y = FindPlyProperty(vertices, { "y" });
+		const size_t z = FindPlyProperty(vertices, { "z" });
+		const size_t nx = FindPlyProperty(vertices, { "nx" });
+		const size_t ny = FindPlyProperty(vertices, { "ny" });
+		const size_t nz = FindPlyProperty(vertices, { "nz" });
+		const size_t u = FindPlyProperty(vertices, { "u", "s", "texture_u", "texture_s" });
+		const size_t v = FindPlyProperty(vertices, { "v", "t", "texture_v", "texture_t" });
+		const bool hasNormals = (nx < numProperties && ny < numProperties && nz < numProperties);
+		const bool hasUVs = (u < numProperties && v < numProperties);
+
+		if (x == numProperties || y == numProperties || z == numProperties)
+		{
+			return false;
+		}
+
+		for (size_t i : { x, y, z, nx, ny, nz, u, v })
+		{
+			if (i < numProperties && vertices.properties[i].IsList())
+			{
+				return false;
+			}
+		}
+
+		size_t faceIndex = 0;
+		std::vector<size_t> firstTriangles(1, 0);
+
+		if (faceElement != elements.end())
+		{
+			faceIndex = FindPlyProperty(*faceElement, { "vertex_indices", "vertex_index" });
+
+			if (faceIndex == faceElement->properties.size() || !faceElement->properties[faceIndex].IsList())
+			{
+				return false;
+			}
+
+			// Counts the triangles of the fan of each face
+			const PlyProperty& property = faceElement->properties[faceIndex];
+			firstTriangles.resize(faceElement->count + 1);
+
+			for (size_t i = 0; i < faceElement->count; ++i)
+			{
+				const char* indices = FindPlyProperty(faceElement->records[i], *faceElement, faceIndex, swapBytes);
+				const size_t count = static_cast<size_t>(ReadPlyValue(indices, property.countType, swapBytes));
+
+				if (count < 3)
+				{
+					return false;
+				}
+
+				firstTriangles[i + 1] = firstTriangles[i] + count - 2;
+			}
+		}
+
+		const size_t numTriangles = firstTriangles.back();
+		const size_t pointBase = NumberOfPoints();
+		const size_t uvBase = NumberOfUVs();
+		const size_t normalBase = NumberOfNormals();
+		const size_t triangleBase = NumberOfTriangles();
+		const size_t uvIndexBase = m_uvIndices.size();
+		const size_t normalIndexBase = m_normalIndices.size();
+
+		m_points.Resize(pointBase + numVertices);
+		m_pointIndices.Resize(triangleBase + numTriangles);
+
+		if (hasUVs)
+		{
+			m_uvs.Resize(uvBase + numVertices);
+			m_uvIndices.Resize(uvIndexBase + numTriangles);
+		}
+
+		if (hasNormals)
+		{
+			m_normals.Resize(normalBase + numVertices);
+			m_normalIndices.Resize(normalIndexBase + numTriangles);
+		}
+
+		ParallelFor(ZERO_SIZE, numVertices, [&](size_t i)
+		{
+			auto read = [&](size_t index)
+			{
+				const char* value = FindPlyProperty(vertices.records[i], vertices, index, swapBytes);
+				return ReadPlyValue(value, vertices.properties[index].type, swapBytes);
+			};
+
+			m_points[pointBase + i] = Vector3D(read(x), read(y), read(z));
+
+			if (hasNormals)
+			{
+				m_normals[normalBase + i] = Vector3D(read(nx), read(ny), read(nz));
+			}
+
+			if (hasUVs)
+			{
+				m_uvs[uvBase + i] = Vector2D(read(u), read(v));
+			}
+		});
+
+		std::atomic<bool> isValid(true);
+
+		if (faceElement != elements.end())
+		{
+			const PlyProperty& property = faceElement->properties[faceIndex];
+			const size_t countSize = GetPlyTypeSize(property.countType);
+			const size_t typeSize = GetPlyTypeSize(property.type);
+
+			ParallelFor(ZERO_SIZE, faceElement->count, [&](size_t i)
+			{
+				const char* indices = FindPlyProperty(faceElement->records[i], *faceElement, faceIndex, swapBytes) + countSize;
+				const size_t count = firstTriangles[i + 1] - firstTriangles[i] + 2;
+				size_t fan[3] = {};
+
+				for (size_t j = 0; j < count; ++j)
+				{
+					const double index = ReadPlyValue(indices + j * typeSize, property.type, swapBytes);
+
+					if (index < 0.0 || index >= static_cast<double>(numVertices))
+					{
+						isValid = false;
+						return;
+					}
+
+					fan[std::min(j, static_cast<size_t>(2))] = static_cast<size_t>(index);
+
+					if (j >= 2)
+					{
+						const size_t t = firstTriangles[i] + j - 2;
+						m_pointIndices[triangleBase + t] = Point3UI(pointBase + fan[0], pointBase + fan[1], pointBase + fan[2]);
+
+						if (hasUVs)
+						{
+							m_uvIndices[uvIndexBase + t] = Point3UI(uvBase + fan[0], uvBase + fan[1], uvBase + fan[2]);
+						}
+
+						if (hasNormals)
+						{
+							m_normalIndices[normalIndexBase + t] = Point3UI(normalBase + fan[0], normalBase + fan[1], normalBase + fan[2]);
+						}
+
+						fan[1] = fan[2];
+					}
+				}
+			});
+		}
+
+		if (!isValid)
+		{
+			m_points.Resize(pointBase);
+			m_pointIndices.Resize(triangleBase);
+
+			if (hasUVs)
+			{
+				m_uvs.Resize(uvBase);
+				m_uvIndices.Resize(uvIndexBase);
+			}
+
+			if (hasNormals)
+			{
+				m_normals.Resize(normalBase);
+				m_normalIndices.Resize(normalIndexBase);
+			}
+		}
+
+		InvalidateBVH();
+
+		return isValid;
+	}
 	
 	TriangleMesh3::Builder& TriangleMesh3::Builder::WithPoints(const PointArray& points)
 	{
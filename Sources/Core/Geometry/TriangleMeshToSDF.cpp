@@ -38,45 +38,76 @@
 #include <Core/Size/Size3.h>
 #include <Core/Utils/Constants.h>
 #include <Core/Utils/Macros.h>
+#include <Core/Utils/Parallel.h>
 #include <Core/Vector/Vector3.h>
 
 #include <algorithm>
 #include <cassert>
+#include <utility>
+#include <vector>
 
 namespace CubbyFlow
 {
 	static void CheckNeighbor(
-		const TriangleMesh3& mesh,
+		const std::vector<Triangle3>& triangles,
 		const Vector3D& gx,
 		ssize_t i0,	ssize_t j0, ssize_t k0,
 		ssize_t i1, ssize_t j1, ssize_t k1,
 		ScalarGrid3* sdf,
 		Array3<size_t>* closestTri)
 	{
-		if ((*closestTri)(i1, j1, k1) != std::numeric_limits<size_t>::max())
+		const size_t t = (*closestTri)(i1, j1, k1);
+
+		// The distance to the current closest triangle is already in the sdf,
+		// so it is only computed for the triangles of the other points.
+		if (t != std::numeric_limits<size_t>::max() && t != (*closestTri)(i0, j0, k0))
 		{
-			size_t t = (*closestTri)(i1, j1, k1);
-			Triangle3 tri = mesh.Triangle(t);
-			double d = tri.ClosestDistance(gx);
+			double d = triangles[t].ClosestDistance(gx);
 
 			if (d < (*sdf)(i0, j0, k0))
 			{
 				(*sdf)(i0, j0, k0) = d;
-				(*closestTri)(i0, j0, k0) = (*closestTri)(i1, j1, k1);
+				(*closestTri)(i0, j0, k0) = t;
 			}
 		}
 	}
 
-	static void Sweep(
-		const TriangleMesh3& mesh,
+	static void SweepRow(
+		const std::vector<Triangle3>& triangles,
 		int di, int dj, int dk,
+		ssize_t i0, ssize_t i1,
+		ssize_t j, ssize_t k,
 		ScalarGrid3* sdf,
 		Array3<size_t>* closestTri)
 	{
-		Size3 size = sdf->GetDataSize();
 		Vector3D h = sdf->GridSpacing();
 		Vector3D origin = sdf->GetDataOrigin();
 
+		for (ssize_t i = i0; i != i1; i += di)
+		{
+			Vector3D gx({ i, j, k });
+			gx *= h;
+			gx += origin;
+
+			CheckNeighbor(triangles, gx, i, j, k, i - di, j, k, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i, j - dj, k, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i - di, j - dj, k, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i, j, k - dk, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i - di, j, k - dk, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i, j - dj, k - dk, sdf, closestTri);
+			CheckNeighbor(triangles, gx, i, j, k, i - di, j - dj, k - dk, sdf, closestTri);
+		}
+	}
+
+	static void Sweep(
+		const std::vector<Triangle3>& triangles,
+		int di, int dj, int dk,
+		ScalarGrid3* sdf,
+		Array3<size_t>* closestTri,
+		ExecutionPolicy policy)
+	{
+		Size3 size = sdf->GetDataSize();
+
 		ssize_t ni = static_cast<ssize_t>(size.x);
 		ssize_t nj = static_cast<ssize_t>(size.y);
 		ssize_t nk = static_cast<ssize_t>(size.z);
@@ -117,25 +148,38 @@ namespace CubbyFlow
 			k1 = -1;
 		}
 
-		for (ssize_t k = k0; k != k1; k += dk)
+		if (policy == ExecutionPolicy::Serial)
 		{
-			for (ssize_t j = j0; j != j1; j += dj)
+			for (ssize_t k = k0; k != k1; k += dk)
 			{
-				for (ssize_t i = i0; i != i1; i += di)
+				for (ssize_t j = j0; j != j1; j += dj)
 				{
-					Vector3D gx({ i, j, k });
-					gx *= h;
-					gx += origin;
-
-					CheckNeighbor(mesh, gx, i, j, k, i - di, j, k, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i, j - dj, k, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i - di, j - dj, k, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i, j, k - dk, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i - di, j, k - dk, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i, j - dj, k - dk, sdf, closestTri);
-					CheckNeighbor(mesh, gx, i, j, k, i - di, j - dj, k - dk, sdf, closestTri);
+					SweepRow(triangles, di, dj, dk, i0, i1, j, k, sdf, closestTri);
 				}
 			}
+
+			return;
+		}
+
+		// A row only reads the rows one step behind it in y and z, which are on
+		// the previous two wavefronts along j + k, so the rows of a wavefront
+		// are swept in parallel. The result is the same as the serial sweep.
+		const ssize_t numberOfRowsY = std::max(nj - 1, ZERO_SSIZE);
+		const ssize_t numberOfRowsZ = std::max(nk - 1, ZERO_SSIZE);
+		const ssize_t numberOfLevels = numberOfRowsY + numberOfRowsZ - 1;
+
+		for (ssize_t level = 0; level < numberOfLevels; ++level)
+		{
+			const ssize_t kBegin = std::max(level - (numberOfRowsY - 1), ZERO_SSIZE);
+			const ssize_t kEnd = std::min(numberOfRowsZ, level + 1);
+
+			ParallelFor(kBegin, kEnd, [&](ssize_t kk)
+			{
+				const ssize_t j = j0 + dj * (level - kk);
+				const ssize_t k = k0 + dk * kk;
+
+				SweepRow(triangles, di, dj, dk, i0, i1, j, k, sdf, closestTri);
+			});
 		}
 	}
 
@@ -223,7 +267,146 @@ namespace CubbyFlow
 		return true;
 	}
 
-	void TriangleMeshToSDF(const TriangleMesh3& mesh, ScalarGrid3* sdf, const unsigned int exactBand)
+	// Initializes the distances near triangle t and counts its intersections
+	// with the x-rows, in the z-slices [kBegin, kEnd) only.
+	static void InitializeTriangle(
+		const TriangleMesh3& mesh,
+		const Triangle3& tri,
+		size_t t,
+		ssize_t bandwidth,
+		ssize_t kBegin, ssize_t kEnd,
+		ScalarGrid3* sdf,
+		Array3<size_t>* closestTri,
+		Array3<unsigned int>* intersectionCount)
+	{
+		Size3 size = sdf->GetDataSize();
+		Vector3D h = sdf->GridSpacing();
+		Vector3D origin = sdf->GetDataOrigin();
+		auto gridPos = sdf->GetDataPosition();
+
+		ssize_t maxSizeX = static_cast<ssize_t>(size.x);
+		ssize_t maxSizeY = static_cast<ssize_t>(size.y);
+		ssize_t maxSizeZ = static_cast<ssize_t>(size.z);
+
+		Point3UI indices = mesh.PointIndex(t);
+
+		Vector3D pt1 = mesh.Point(indices.x);
+		Vector3D pt2 = mesh.Point(indices.y);
+		Vector3D pt3 = mesh.Point(indices.z);
+
+		// Normalize coordinates
+		Vector3D f1 = (pt1 - origin) / h;
+		Vector3D f2 = (pt2 - origin) / h;
+		Vector3D f3 = (pt3 - origin) / h;
+
+		// Do distances nearby
+		ssize_t i0 = static_cast<ssize_t>(std::min({ f1.x, f2.x, f3.x }));
+		i0 = std::clamp(i0 - bandwidth, ZERO_SSIZE, maxSizeX - 1);
+		ssize_t i1 = static_cast<ssize_t>(std::max({ f1.x, f2.x, f3.x }));
+		i1 = std::clamp(i1 + bandwidth + 1, ZERO_SSIZE, maxSizeX - 1);
+
+		ssize_t j0 = static_cast<ssize_t>(std::min({ f1.y, f2.y, f3.y }));
+		j0 = std::clamp(j0 - bandwidth, ZERO_SSIZE, maxSizeY - 1);
+		ssize_t j1 = static_cast<ssize_t>(std::max({ f1.y, f2.y, f3.y }));
+		j1 = std::clamp(j1 + bandwidth + 1, ZERO_SSIZE, maxSizeY - 1);
+
+		ssize_t k0 = static_cast<ssize_t>(std::min({ f1.z, f2.z, f3.z }));
+		k0 = std::clamp(k0 - bandwidth, ZERO_SSIZE, maxSizeZ - 1);
+		ssize_t k1 = static_cast<ssize_t>(std::max({ f1.z, f2.z, f3.z }));
+		k1 = std::clamp(k1 + bandwidth + 1, ZERO_SSIZE, maxSizeZ - 1);
+
+		for (ssize_t k = std::max(k0, kBegin); k <= std::min(k1, kEnd - 1); ++k)
+		{
+			for (ssize_t j = j0; j <= j1; ++j)
+			{
+				for (ssize_t i = i0; i <= i1; ++i)
+				{
+					Vector3D gx = gridPos(i, j, k);
+					double d = tri.ClosestDistance(gx);
+
+					if (d < (*sdf)(i, j, k))
+					{
+						(*sdf)(i, j, k) = d;
+						(*closestTri)(i, j, k) = t;
+					}
+				}
+			}
+		}
+
+		// Do intersection counts
+		j0 = static_cast<ssize_t>(std::ceil(std::min({ f1.y, f2.y, f3.y })));
+		j0 = std::clamp(j0 - bandwidth, ZERO_SSIZE, maxSizeY - 1);
+		j1 = static_cast<ssize_t>(std::floor(std::max({ f1.y, f2.y, f3.y })));
+		j1 = std::clamp(j1 + bandwidth + 1, ZERO_SSIZE, maxSizeY - 1);
+		k0 = static_cast<ssize_t>(std::ceil(std::min({ f1.z, f2.z, f3.z })));
+		k0 = std::clamp(k0 - bandwidth, ZERO_SSIZE, maxSizeZ - 1);
+		k1 = static_cast<ssize_t>(std::floor(std::max({ f1.z, f2.z, f3.z })));
+		k1 = std::clamp(k1 + bandwidth + 1, ZERO_SSIZE, maxSizeZ - 1);
+
+		for (ssize_t k = std::max(k0, kBegin); k <= std::min(k1, kEnd - 1); ++k)
+		{
+			for (ssize_t j = j0; j <= j1; ++j)
+			{
+				double a, b, c;
+				double jD = static_cast<double>(j);
+				double kD = static_cast<double>(k);
+
+				if (PointInTriangle2D(jD, kD, f1.y, f1.z, f2.y, f2.z, f3.y, f3.z, &a, &b, &c))
+				{
+					// intersection i coordinate
+					double fi = a * f1.x + b * f2.x + c * f3.x;
+
+					// intersection is in (iInterval - 1, iInterval]
+					int iInterval = static_cast<int>(std::ceil(fi));
+					if (iInterval < 0)
+					{
+						// we enlarge the first interval to include everything
+						// to the -x direction
+						++(*intersectionCount)(0, j, k);
+					}
+					else if (iInterval < static_cast<int>(size.x))
+					{
+						++(*intersectionCount)(iInterval, j, k);
+					}
+
+					// we ignore intersections that are beyond the +x side of the grid
+				}
+			}
+		}
+	}
+
+	// Returns the range of the z-slices which InitializeTriangle writes for
+	// triangle t.
+	static std::pair<ssize_t, ssize_t> GetTriangleSlices(
+		const TriangleMesh3& mesh,
+		size_t t,
+		ssize_t bandwidth,
+		const ScalarGrid3& sdf)
+	{
+		const ssize_t maxSizeZ = static_cast<ssize_t>(sdf.GetDataSize().z);
+		const double originZ = sdf.GetDataOrigin().z;
+		const double hZ = sdf.GridSpacing().z;
+
+		const Point3UI indices = mesh.PointIndex(t);
+		const double z1 = (mesh.Point(indices.x).z - originZ) / hZ;
+		const double z2 = (mesh.Point(indices.y).z - originZ) / hZ;
+		const double z3 = (mesh.Point(indices.z).z - originZ) / hZ;
+
+		// The same bounds as the distance loop, which contain the bounds of
+		// the intersection count loop.
+		ssize_t k0 = static_cast<ssize_t>(std::min({ z1, z2, z3 }));
+		k0 = std::clamp(k0 - bandwidth, ZERO_SSIZE, maxSizeZ - 1);
+		ssize_t k1 = static_cast<ssize_t>(std::max({ z1, z2, z3 }));
+		k1 = std::clamp(k1 + bandwidth + 1, ZERO_SSIZE, maxSizeZ - 1);
+
+		return std::make_pair(k0, k1 + 1);
+	}
+
+	void TriangleMeshToSDF(
+		const TriangleMesh3& mesh,
+		ScalarGrid3* sdf,
+		const unsigned int exactBand,
+		ExecutionPolicy policy)
 	{
 		Size3 size = sdf->GetDataSize();
 		if (size.x * size.y * size.z == 0)
@@ -232,131 +415,116 @@ namespace CubbyFlow
 		}
 
 		// Upper bound on distance
-		sdf->Fill(sdf->BoundingBox().DiagonalLength());
-		Vector3D h = sdf->GridSpacing();
-		Vector3D origin = sdf->GetDataOrigin();
+		sdf->Fill(sdf->BoundingBox().DiagonalLength(), policy);
 
 		Array3<size_t> closestTri(size, std::numeric_limits<size_t>::max());
 
 		// Intersection_count(i,j,k) is # of tri intersections in (i-1,i]x{j}x{k}
 		Array3<unsigned int> intersectionCount(size, 0);
 
+		// The triangles are built once since they are looked up for every
+		// point of the band and every step of the sweeps.
+		size_t nTri = mesh.NumberOfTriangles();
+		std::vector<Triangle3> triangles(nTri);
+
+		ParallelFor(ZERO_SIZE, nTri, [&](size_t t)
+		{
+			triangles[t] = mesh.Triangle(t);
+		}, policy);
+
 		// We begin by initializing distances near the mesh, and figuring out
 		// intersection counts
-		auto gridPos = sdf->GetDataPosition();
-
-		size_t nTri = mesh.NumberOfTriangles();
 		ssize_t bandwidth = static_cast<ssize_t>(exactBand);
-		ssize_t maxSizeX = static_cast<ssize_t>(size.x);
-		ssize_t maxSizeY = static_cast<ssize_t>(size.y);
-		ssize_t maxSizeZ = static_cast<ssize_t>(size.z);
 
-		for (size_t t = 0; t < nTri; ++t)
+		if (policy == ExecutionPolicy::Serial)
 		{
-			Point3UI indices = mesh.PointIndex(t);
+			for (size_t t = 0; t < nTri; ++t)
+			{
+				InitializeTriangle(
+					mesh, triangles[t], t, bandwidth,
+					ZERO_SSIZE, static_cast<ssize_t>(size.z),
+					sdf, &closestTri, &intersectionCount);
+			}
+		}
+		else
+		{
+			// The z-slices are split into slabs and the triangles are binned
+			// into the slabs they touch. Each slab visits its triangles in the
+			// serial order and only writes its own slices, so the slabs are
+			// independent and the result is the same as the serial loop.
+			const size_t numberOfSlabs = std::min(size.z, static_cast<size_t>(8 * GetMaxNumberOfThreads()));
+			const size_t slabDepth = (size.z + numberOfSlabs - 1) / numberOfSlabs;
 
-			Triangle3 tri = mesh.Triangle(t);
+			std::vector<std::pair<ssize_t, ssize_t>> triangleSlices(nTri);
 
-			Vector3D pt1 = mesh.Point(indices.x);
-			Vector3D pt2 = mesh.Point(indices.y);
-			Vector3D pt3 = mesh.Point(indices.z);
+			ParallelFor(ZERO_SIZE, nTri, [&](size_t t)
+			{
+				triangleSlices[t] = GetTriangleSlices(mesh, t, bandwidth, *sdf);
+			});
+
+			std::vector<size_t> slabOffsets(numberOfSlabs + 1, 0);
 
-			// Normalize coordinates
-			Vector3D f1 = (pt1 - origin) / h;
-			Vector3D f2 = (pt2 - origin) / h;
-			Vector3D f3 = (pt3 - origin) / h;
+			for (size_t t = 0; t < nTri; ++t)
+			{
+				const size_t slabBegin = static_cast<size_t>(triangleSlices[t].first) / slabDepth;
+				const size_t slabEnd = static_cast<size_t>(triangleSlices[t].second - 1) / slabDepth + 1;
 
-			// Do distances nearby
-			ssize_t i0 = static_cast<ssize_t>(std::min({ f1.x, f2.x, f3.x }));
-			i0 = std::clamp(i0 - bandwidth, ZERO_SSIZE, maxSizeX - 1);
-			ssize_t i1 = static_cast<ssize_t>(std::max({ f1.x, f2.x, f3.x }));
-			i1 = std::clamp(i1 + bandwidth + 1, ZERO_SSIZE, maxSizeX - 1);
+				for (size_t s = slabBegin; s < slabEnd; ++s)
+				{
+					++slabOffsets[s + 1];
+				}
+			}
 
-			ssize_t j0 = static_cast<ssize_t>(std::min({ f1.y, f2.y, f3.y }));
-			j0 = std::clamp(j0 - bandwidth, ZERO_SSIZE, maxSizeY - 1);
-			ssize_t j1 = static_cast<ssize_t>(std::max({ f1.y, f2.y, f3.y }));
-			j1 = std::clamp(j1 + bandwidth + 1, ZERO_SSIZE, maxSizeY - 1);
+			for (size_t s = 0; s < numberOfSlabs; ++s)
+			{
+				slabOffsets[s + 1] += slabOffsets[s];
+			}
 
-			ssize_t k0 = static_cast<ssize_t>(std::min({ f1.z, f2.z, f3.z }));
-			k0 = std::clamp(k0 - bandwidth, ZERO_SSIZE, maxSizeZ - 1);
-			ssize_t k1 = static_cast<ssize_t>(std::max({ f1.z, f2.z, f3.z }));
-			k1 = std::clamp(k1 + bandwidth + 1, ZERO_SSIZE, maxSizeZ - 1);
+			std::vector<size_t> slabTriangles(slabOffsets.back());
+			std::vector<size_t> slabEnds(slabOffsets.begin(), slabOffsets.end() - 1);
 
-			for (ssize_t k = k0; k <= k1; ++k)
+			for (size_t t = 0; t < nTri; ++t)
 			{
-				for (ssize_t j = j0; j <= j1; ++j)
+				const size_t slabBegin = static_cast<size_t>(triangleSlices[t].first) / slabDepth;
+				const size_t slabEnd = static_cast<size_t>(triangleSlices[t].second - 1) / slabDepth + 1;
+
+				for (size_t s = slabBegin; s < slabEnd; ++s)
 				{
-					for (ssize_t i = i0; i <= i1; ++i)
-					{
-						Vector3D gx = gridPos(i, j, k);
-						double d = tri.ClosestDistance(gx);
-
-						if (d < (*sdf)(i, j, k))
-						{
-							(*sdf)(i, j, k) = d;
-							closestTri(i, j, k) = t;
-						}
-					}
+					slabTriangles[slabEnds[s]++] = t;
 				}
 			}
 
-			// Do intersection counts
-			j0 = static_cast<ssize_t>(std::ceil(std::min({ f1.y, f2.y, f3.y })));
-			j0 = std::clamp(j0 - bandwidth, ZERO_SSIZE, maxSizeY - 1);
-			j1 = static_cast<ssize_t>(std::floor(std::max({ f1.y, f2.y, f3.y })));
-			j1 = std::clamp(j1 + bandwidth + 1, ZERO_SSIZE, maxSizeY - 1);
-			k0 = static_cast<ssize_t>(std::ceil(std::min({ f1.z, f2.z, f3.z })));
-			k0 = std::clamp(k0 - bandwidth, ZERO_SSIZE, maxSizeZ - 1);
-			k1 = static_cast<ssize_t>(std::floor(std::max({ f1.z, f2.z, f3.z })));
-			k1 = std::clamp(k1 + bandwidth + 1, ZERO_SSIZE, maxSizeZ - 1);
-
-			for (ssize_t k = k0; k <= k1; ++k)
+			ParallelFor(ZERO_SIZE, numberOfSlabs, [&](size_t s)
 			{
-				for (ssize_t j = j0; j <= j1; ++j)
+				const ssize_t kBegin = static_cast<ssize_t>(s * slabDepth);
+				const ssize_t kEnd = static_cast<ssize_t>(std::min(size.z, (s + 1) * slabDepth));
+
+				for (size_t n = slabOffsets[s]; n < slabOffsets[s + 1]; ++n)
 				{
-					double a, b, c;
-					double jD = static_cast<double>(j);
-					double kD = static_cast<double>(k);
+					const size_t t = slabTriangles[n];
 
-					if (PointInTriangle2D(jD, kD, f1.y, f1.z, f2.y, f2.z, f3.y, f3.z, &a, &b, &c))
-					{
-						// intersection i coordinate
-						double fi = a * f1.x + b * f2.x + c * f3.x;
-
-						// intersection is in (iInterval - 1, iInterval]
-						int iInterval = static_cast<int>(std::ceil(fi));
-						if (iInterval < 0)
-						{
-							// we enlarge the first interval to include everything
-							// to the -x direction
-							++intersectionCount(0, j, k);
-						}
-						else if (iInterval < static_cast<int>(size.x))
-						{
-							++intersectionCount(iInterval, j, k);
-						}
-
-						// we ignore intersections that are beyond the +x side of the grid
-					}
+					InitializeTriangle(
+						mesh, triangles[t], t, bandwidth, kBegin, kEnd,
+						sdf, &closestTri, &intersectionCount);
 				}
-			}
+			}, PartitionPolicy{ PartitionMode::Dynamic });
 		}
 
 		// and now we fill in the rest of the distances with fast sweeping
 		for (unsigned int pass = 0; pass < 2; ++pass)
 		{
-			Sweep(mesh, +1, +1, +1, sdf, &closestTri);
-			Sweep(mesh, -1, -1, -1, sdf, &closestTri);
-			Sweep(mesh, +1, +1, -1, sdf, &closestTri);
-			Sweep(mesh, -1, -1, +1, sdf, &closestTri);
-			Sweep(mesh, +1, -1, +1, sdf, &closestTri);
-			Sweep(mesh, -1, +1, -1, sdf, &closestTri);
-			Sweep(mesh, +1, -1, -1, sdf, &closestTri);
-			Sweep(mesh, -1, +1, +1, sdf, &closestTri);
+			Sweep(triangles, +1, +1, +1, sdf, &closestTri, policy);
+			Sweep(triangles, -1, -1, -1, sdf, &closestTri, policy);
+			Sweep(triangles, +1, +1, -1, sdf, &closestTri, policy);
+			Sweep(triangles, -1, -1, +1, sdf, &closestTri, policy);
+			Sweep(triangles, +1, -1, +1, sdf, &closestTri, policy);
+			Sweep(triangles, -1, +1, -1, sdf, &closestTri, policy);
+			Sweep(triangles, +1, -1, -1, sdf, &closestTri, policy);
+			Sweep(triangles, -1, +1, +1, sdf, &closestTri, policy);
 		}
 
 		// then figure out signs (inside/outside) from intersection counts
-		for (size_t k = 0; k < size.z; ++k)
+		ParallelFor(ZERO_SIZE, size.z, [&](size_t k)
 		{
 			for (size_t j = 0; j < size.y; ++j)
 			{
@@ -374,6 +542,6 @@ namespace CubbyFlow
 					}
 				}
 			}
-		}
+		}, policy);
 	}
-}
+}
\ No newline at end of file
@@ -20,12 +20,17 @@
 //
 // This code is public domain.
 
+#include <Core/Array/Array2.h>
 #include <Core/LevelSet/LevelSetUtils.h>
 #include <Core/MarchingCubes/MarchingCubes.h>
 #include <Core/MarchingCubes/MarchingCubesTable.h>
 #include <Core/MarchingCubes/MarchingSquaresTable.h>
 
+#include <algorithm>
+#include <limits>
+#include <ostream>
 #include <unordered_map>
+#include <utility>
 
 namespace CubbyFlow
 {
@@ -48,8 +53,9 @@ namespace CubbyFlow
 		return false;
 	}
 
+	template <typename GridType>
 	inline Vector3D Grad(
-		const ConstArrayAccessor3<double>& grid,
+		const GridType& grid,
 		ssize_t i, ssize_t j, ssize_t k,
 		const Vector3D& invGridSize)
 	{
@@ -154,14 +160,18 @@ namespace CubbyFlow
 			(2 * i + vertexOffset3D[localVertexID][0]);
 	}
 
+	// getVertexID(key, position, normal) returns the index of the vertex with
+	// the given global vertex or edge ID, and addTriangle(face) stores the
+	// triangle.
+	template <typename VertexIDFunc, typename TriangleFunc>
 	static void SingleSquare(
 		const std::array<double, 4>& data,
 		const std::array<size_t, 8>& vertAndEdgeIds,
 		const Vector3D& normal,
 		const std::array<Vector3D, 4>& corners,
-		MarchingCubeVertexMap* vertexMap,
-		TriangleMesh3* mesh,
-		double isoValue)
+		double isoValue,
+		const VertexIDFunc& getVertexID,
+		const TriangleFunc& addTriangle)
 	{
 		int idxFlags = 0;
 		int idxVertexOfTheEdge[2];
@@ -247,47 +257,25 @@ namespace CubbyFlow
 			for (int j = 0; j < 3; ++j) 
 			{
 				int idxVertex = triangleConnectionTable2D[idxFlags][3 * iterTri + j];
+				const Vector3D& pt = (idxVertex < 4) ? corners[idxVertex] : e[idxVertex - 4];
 
-				MarchingCubeVertexHashKey vKey = vertAndEdgeIds[idxVertex];
-				MarchingCubeVertexID vID;
-				
-				if (QueryVertexID(*vertexMap, vKey, &vID))
-				{
-					face[j] = vID;
-				}
-				else
-				{
-					// if vertex does not exist...
-					face[j] = mesh->NumberOfPoints();
-					mesh->AddNormal(normal);
-					
-					if (idxVertex < 4)
-					{
-						mesh->AddPoint(corners[idxVertex]);
-					}
-					else
-					{
-						mesh->AddPoint(e[idxVertex - 4]);
-					}
-
-					// empty texture coordinate...
-					mesh->AddUV(Vector2D());
-					vertexMap->insert(std::make_pair(vKey, face[j]));
-				}
+				face[j] = getVertexID(vertAndEdgeIds[idxVertex], pt, normal);
 			}
 
-			mesh->AddPointUVNormalTriangle(face, face, face);
+			addTriangle(face);
 		}
 	}
 
+	// getVertexID(edge, position, normal) returns the index of the vertex on
+	// the given local edge, and addTriangle(face) stores the triangle.
+	template <typename VertexIDFunc, typename TriangleFunc>
 	static void SingleCube(
 		const std::array<double, 8>& data,
-		const std::array<size_t, 12>& edgeIDs,
 		const std::array<Vector3D, 8>& normals,
 		const BoundingBox3D& bound,
-		MarchingCubeVertexMap* vertexMap,
-		TriangleMesh3* mesh,
-		double isoValue)
+		double isoValue,
+		const VertexIDFunc& getVertexID,
+		const TriangleFunc& addTriangle)
 	{
 		int idxFlagSize = 0;
 		int idxVertexOfTheEdge[2];
@@ -370,26 +358,405 @@ namespace CubbyFlow
 
 			for (int j = 0; j < 3; ++j)
 			{
-				int k = 3 * iterTri + j;
-				MarchingCubeVertexHashKey vKey = edgeIDs[triangleConnectionTable3D[idxFlagSize][k]];
-				MarchingCubeVertexID vID;
+				int edge = triangleConnectionTable3D[idxFlagSize][3 * iterTri + j];
+				face[j] = getVertexID(edge, e[edge], n[edge]);
+			}
+
+			addTriangle(face);
+		}
+	}
+
+	// Computes the triangles of the cell (i, j, k). The cells which are entirely
+	// inside or outside of the surface are skipped before the gradients are
+	// evaluated.
+	template <typename GridType, typename PositionFunc, typename VertexIDFunc, typename TriangleFunc>
+	static void MarchCell(
+		const GridType& grid,
+		ssize_t i, ssize_t j, ssize_t k,
+		const Vector3D& invGridSize,
+		const PositionFunc& pos,
+		double isoValue,
+		const VertexIDFunc& getVertexID,
+		const TriangleFunc& addTriangle)
+	{
+		std::array<double, 8> data;
+		std::array<Vector3D, 8>  normals;
+		BoundingBox3D bound;
+
+		data[0] = grid(i, j, k);
+		data[1] = grid(i + 1, j, k);
+		data[4] = grid(i, j + 1, k);
+		data[5] = grid(i + 1, j + 1, k);
+		data[3] = grid(i, j, k + 1);
+		data[2] = grid(i + 1, j, k + 1);
+		data[7] = grid(i, j + 1, k + 1);
+		data[6] = grid(i + 1, j + 1, k + 1);
+
+		int numInside = 0;
+		for (int iterVertex = 0; iterVertex < 8; ++iterVertex)
+		{
+			if (data[iterVertex] <= isoValue)
+			{
+				++numInside;
+			}
+		}
+
+		if (numInside == 0 || numInside == 8)
+		{
+			return;
+		}
+
+		normals[0] = Grad(grid, i, j, k, invGridSize);
+		normals[1] = Grad(grid, i + 1, j, k, invGridSize);
+		normals[4] = Grad(grid, i, j + 1, k, invGridSize);
+		normals[5] = Grad(grid, i + 1, j + 1, k, invGridSize);
+		normals[3] = Grad(grid, i, j, k + 1, invGridSize);
+		normals[2] = Grad(grid, i + 1, j, k + 1, invGridSize);
+		normals[7] = Grad(grid, i, j + 1, k + 1, invGridSize);
+		normals[6] = Grad(grid, i + 1, j + 1, k + 1, invGridSize);
+
+		bound.lowerCorner = pos(i, j, k);
+		bound.upperCorner = pos(i + 1, j + 1, k + 1);
+
+		SingleCube(data, normals, bound, isoValue, getVertexID, addTriangle);
+	}
+
+	// Computes the boundary face of the cell (i, j, k) on the wall in the given
+	// direction.
+	template <typename GridType, typename PositionFunc, typename VertexIDFunc, typename TriangleFunc>
+	static void BoundarySquare(
+		const GridType& grid,
+		ssize_t i, ssize_t j, ssize_t k,
+		int direction,
+		const PositionFunc& pos,
+		double isoValue,
+		const VertexIDFunc& getVertexID,
+		const TriangleFunc& addTriangle)
+	{
+		const Size3 dim = grid.size();
+
+		std::array<double, 4> data;
+		std::array<size_t, 8> vertexAndEdgeIDs;
+		std::array<Vector3D, 4> corners;
+		Vector3D normal;
+
+		if (direction == DIRECTION_BACK)
+		{
+			data[0] = grid(i + 1, j, k);
+			data[1] = grid(i, j, k);
+			data[2] = grid(i, j + 1, k);
+			data[3] = grid(i + 1, j + 1, k);
+
+			normal = Vector3D(0, 0, -1);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 1);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 0);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 4);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 5);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 0);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 8);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 4);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 9);
+
+			corners[0] = pos(i + 1, j, k);
+			corners[1] = pos(i, j, k);
+			corners[2] = pos(i, j + 1, k);
+			corners[3] = pos(i + 1, j + 1, k);
+		}
+		else if (direction == DIRECTION_FRONT)
+		{
+			data[0] = grid(i, j, k + 1);
+			data[1] = grid(i + 1, j, k + 1);
+			data[2] = grid(i + 1, j + 1, k + 1);
+			data[3] = grid(i, j + 1, k + 1);
+
+			normal = Vector3D(0, 0, 1);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 3);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 2);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 6);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 2);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 10);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 6);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 11);
+
+			corners[0] = pos(i, j, k + 1);
+			corners[1] = pos(i + 1, j, k + 1);
+			corners[2] = pos(i + 1, j + 1, k + 1);
+			corners[3] = pos(i, j + 1, k + 1);
+		}
+		else if (direction == DIRECTION_LEFT)
+		{
+			data[0] = grid(i, j, k);
+			data[1] = grid(i, j, k + 1);
+			data[2] = grid(i, j + 1, k + 1);
+			data[3] = grid(i, j + 1, k);
+
+			normal = Vector3D(-1, 0, 0);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 0);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 3);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 4);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 3);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 11);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 8);
+
+			corners[0] = pos(i, j, k);
+			corners[1] = pos(i, j, k + 1);
+			corners[2] = pos(i, j + 1, k + 1);
+			corners[3] = pos(i, j + 1, k);
+		}
+		else if (direction == DIRECTION_RIGHT)
+		{
+			data[0] = grid(i + 1, j, k + 1);
+			data[1] = grid(i + 1, j, k);
+			data[2] = grid(i + 1, j + 1, k);
+			data[3] = grid(i + 1, j + 1, k + 1);
+
+			normal = Vector3D(1, 0, 0);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 2);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 1);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 5);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 6);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 1);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 5);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 10);
+
+			corners[0] = pos(i + 1, j, k + 1);
+			corners[1] = pos(i + 1, j, k);
+			corners[2] = pos(i + 1, j + 1, k);
+			corners[3] = pos(i + 1, j + 1, k + 1);
+		}
+		else if (direction == DIRECTION_DOWN)
+		{
+			data[0] = grid(i, j, k);
+			data[1] = grid(i + 1, j, k);
+			data[2] = grid(i + 1, j, k + 1);
+			data[3] = grid(i, j, k + 1);
+
+			normal = Vector3D(0, -1, 0);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 0);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 1);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 2);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 3);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 0);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 1);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 2);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 3);
+
+			corners[0] = pos(i, j, k);
+			corners[1] = pos(i + 1, j, k);
+			corners[2] = pos(i + 1, j, k + 1);
+			corners[3] = pos(i, j, k + 1);
+		}
+		else
+		{
+			data[0] = grid(i + 1, j + 1, k);
+			data[1] = grid(i, j + 1, k);
+			data[2] = grid(i, j + 1, k + 1);
+			data[3] = grid(i + 1, j + 1, k + 1);
+
+			normal = Vector3D(0, 1, 0);
+
+			vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 5);
+			vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 4);
+			vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 6);
+			vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 4);
+			vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 7);
+			vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 6);
+			vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 5);
+
+			corners[0] = pos(i + 1, j + 1, k);
+			corners[1] = pos(i, j + 1, k);
+			corners[2] = pos(i, j + 1, k + 1);
+			corners[3] = pos(i + 1, j + 1, k + 1);
+		}
+
+		SingleSquare(data, vertexAndEdgeIDs, normal, corners, isoValue, getVertexID, addTriangle);
+	}
+
+	// Vertices of a slab of cell layers which are welded through the edge
+	// arrays of the current layer. Only the occupied edges of the bottom and
+	// the top planes are kept to weld the slab to its neighbors, as (edge,
+	// vertex) pairs sorted by edge.
+	struct MarchingCubesSlab
+	{
+		std::vector<Vector3D> points;
+		std::vector<Vector3D> normals;
+		std::vector<Point3UI> triangles;
+		std::vector<std::pair<size_t, size_t>> firstPlaneEdges;
+		std::vector<std::pair<size_t, size_t>> lastPlaneEdges;
+	};
+
+	// Returns the (edge, vertex) pairs of the occupied edges of a plane.
+	static std::vector<std::pair<size_t, size_t>> OccupiedPlaneEdges(const std::vector<size_t>& plane)
+	{
+		std::vector<std::pair<size_t, size_t>> edges;
+
+		for (size_t n = 0; n < plane.size(); ++n)
+		{
+			if (plane[n] != std::numeric_limits<size_t>::max())
+			{
+				edges.emplace_back(n, plane[n]);
+			}
+		}
+
+		return edges;
+	}
+
+	// Location of each local edge of a cell in the edge arrays of its layer.
+	// The plane is 0 for the bottom plane, 1 for the vertical edges and 2 for
+	// the top plane, and the axis is 0 for x-edges and 1 for y-edges.
+	static const int edgeSlot3D[12][4] =
+	{
+		// plane, di, dj, axis
+		{ 0, 0, 0, 0 }, { 1, 1, 0, 0 }, { 2, 0, 0, 0 }, { 1, 0, 0, 0 },
+		{ 0, 0, 1, 0 }, { 1, 1, 1, 0 }, { 2, 0, 1, 0 }, { 1, 0, 1, 0 },
+		{ 0, 0, 0, 1 }, { 0, 1, 0, 1 }, { 2, 1, 0, 1 }, { 2, 0, 0, 1 }
+	};
+
+	static void MarchingCubesParallel(
+		const ConstArrayAccessor3<double>& grid,
+		const Vector3D& gridSize,
+		const Vector3D& origin,
+		TriangleMesh3* mesh,
+		double isoValue)
+	{
+		const Size3 dim = grid.size();
+		const Vector3D invGridSize = 1.0 / gridSize;
+		const size_t planeSize = dim.x * dim.y;
+		const size_t invalid = std::numeric_limits<size_t>::max();
+
+		auto pos = [origin, gridSize](ssize_t i, ssize_t j, ssize_t k)
+		{
+			return origin + gridSize * Vector3D({ i, j, k });
+		};
+
+		if (dim.x < 2 || dim.y < 2 || dim.z < 2)
+		{
+			return;
+		}
+
+		const size_t numLayers = dim.z - 1;
+		const size_t numSlabs = std::min(numLayers, static_cast<size_t>(4 * GetMaxNumberOfThreads()));
+		std::vector<MarchingCubesSlab> slabs(numSlabs);
+
+		ParallelFor(ZERO_SIZE, numSlabs, [&](size_t s)
+		{
+			const size_t kBegin = s * numLayers / numSlabs;
+			const size_t kEnd = (s + 1) * numLayers / numSlabs;
+			MarchingCubesSlab& slab = slabs[s];
+
+			std::vector<size_t> bottom(2 * planeSize, invalid);
+			std::vector<size_t> vertical(planeSize, invalid);
+			std::vector<size_t> top(2 * planeSize, invalid);
+			std::vector<size_t>* planes[3] = { &bottom, &vertical, &top };
+
+			for (size_t k = kBegin; k < kEnd; ++k)
+			{
+				for (size_t j = 0; j + 1 < dim.y; ++j)
+				{
+					for (size_t i = 0; i + 1 < dim.x; ++i)
+					{
+						auto getVertexID = [&](int edge, const Vector3D& pt, const Vector3D& normal)
+						{
+							const int* slot = edgeSlot3D[edge];
+							const size_t index = (i + slot[1]) + dim.x * (j + slot[2]);
+							std::vector<size_t>& plane = *planes[slot[0]];
+							size_t& vID = (slot[0] == 1) ? plane[index] : plane[2 * index + slot[3]];
+
+							if (vID == invalid)
+							{
+								vID = slab.points.size();
+								slab.points.push_back(pt);
+								slab.normals.push_back(SafeNormalize(normal));
+							}
+
+							return vID;
+						};
+
+						auto addTriangle = [&](const Point3UI& face)
+						{
+							slab.triangles.push_back(face);
+						};
+
+						MarchCell(grid, i, j, k, invGridSize, pos, isoValue, getVertexID, addTriangle);
+					}
+				}
 
-				if (QueryVertexID(*vertexMap, vKey, &vID))
+				if (k == kBegin)
 				{
-					face[j] = vID;
+					slab.firstPlaneEdges = OccupiedPlaneEdges(bottom);
 				}
-				else
+
+				std::swap(bottom, top);
+				std::fill(top.begin(), top.end(), invalid);
+				std::fill(vertical.begin(), vertical.end(), invalid);
+			}
+
+			slab.lastPlaneEdges = OccupiedPlaneEdges(bottom);
+		});
+
+		// The vertices are numbered in the order in which the serial version
+		// creates them. The vertices on the bottom plane of a slab which have
+		// been created by the previous slab are mapped to that vertex.
+		std::vector<size_t> prevLocalToGlobal;
+
+		for (size_t s = 0; s < numSlabs; ++s)
+		{
+			const MarchingCubesSlab& slab = slabs[s];
+			std::vector<size_t> localToGlobal(slab.points.size(), invalid);
+
+			if (s > 0)
+			{
+				const auto& prevLastPlaneEdges = slabs[s - 1].lastPlaneEdges;
+				auto prevEdge = prevLastPlaneEdges.begin();
+
+				for (const auto& edge : slab.firstPlaneEdges)
 				{
-					// If vertex does not exist from the map
-					face[j] = mesh->NumberOfPoints();
-					mesh->AddNormal(SafeNormalize(n[triangleConnectionTable3D[idxFlagSize][k]]));
-					mesh->AddPoint(e[triangleConnectionTable3D[idxFlagSize][k]]);
+					while (prevEdge != prevLastPlaneEdges.end() && prevEdge->first < edge.first)
+					{
+						++prevEdge;
+					}
+
+					if (prevEdge != prevLastPlaneEdges.end() && prevEdge->first == edge.first)
+					{
+						localToGlobal[edge.second] = prevLocalToGlobal[prevEdge->second];
+					}
+				}
+			}
+
+			for (size_t v = 0; v < slab.points.size(); ++v)
+			{
+				if (localToGlobal[v] == invalid)
+				{
+					localToGlobal[v] = mesh->NumberOfPoints();
+					mesh->AddNormal(slab.normals[v]);
+					mesh->AddPoint(slab.points[v]);
 					mesh->AddUV(Vector2D());
-					vertexMap->insert(std::make_pair(vKey, face[j]));
 				}
 			}
 
-			mesh->AddPointUVNormalTriangle(face, face, face);
+			for (const Point3UI& localFace : slab.triangles)
+			{
+				const Point3UI face(localToGlobal[localFace.x], localToGlobal[localFace.y], localToGlobal[localFace.z]);
+				mesh->AddPointUVNormalTriangle(face, face, face);
+			}
+
+			prevLocalToGlobal = std::move(localToGlobal);
+
+			// The previous slab has been welded and copied into the mesh
+			if (s > 0)
+			{
+				slabs[s - 1] = MarchingCubesSlab();
+			}
 		}
 	}
 
@@ -399,7 +766,8 @@ namespace CubbyFlow
 		const Vector3D& origin,
 		TriangleMesh3* mesh,
 		double isoValue,
-		int bndFlag)
+		int bndFlag,
+		ExecutionPolicy policy)
 	{
 		MarchingCubeVertexMap vertexMap;
 
@@ -415,48 +783,74 @@ namespace CubbyFlow
 		ssize_t dimY = static_cast<ssize_t>(dim.y);
 		ssize_t dimZ = static_cast<ssize_t>(dim.z);
 
-		for (ssize_t k = 0; k < dimZ - 1; ++k)
+		if (policy == ExecutionPolicy::Parallel)
 		{
-			for (ssize_t j = 0; j < dimY - 1; ++j)
+			MarchingCubesParallel(grid, gridSize, origin, mesh, isoValue);
+		}
+		else
+		{
+			for (ssize_t k = 0; k < dimZ - 1; ++k)
 			{
-				for (ssize_t i = 0; i < dimX - 1; ++i)
+				for (ssize_t j = 0; j < dimY - 1; ++j)
 				{
-					std::array<double, 8> data;
-					std::array<size_t, 12> edgeIDs;
-					std::array<Vector3D, 8>  normals;
-					BoundingBox3D bound;
-
-					data[0] = grid(i, j, k);
-					data[1] = grid(i + 1, j, k);
-					data[4] = grid(i, j + 1, k);
-					data[5] = grid(i + 1, j + 1, k);
-					data[3] = grid(i, j, k + 1);
-					data[2] = grid(i + 1, j, k + 1);
-					data[7] = grid(i, j + 1, k + 1);
-					data[6] = grid(i + 1, j + 1, k + 1);
-
-					normals[0] = Grad(grid, i, j, k, invGridSize);
-					normals[1] = Grad(grid, i + 1, j, k, invGridSize);
-					normals[4] = Grad(grid, i, j + 1, k, invGridSize);
-					normals[5] = Grad(grid, i + 1, j + 1, k, invGridSize);
-					normals[3] = Grad(grid, i, j, k + 1, invGridSize);
-					normals[2] = Grad(grid, i + 1, j, k + 1, invGridSize);
-					normals[7] = Grad(grid, i, j + 1, k + 1, invGridSize);
-					normals[6] = Grad(grid, i + 1, j + 1, k + 1, invGridSize);
-
-					for (int e = 0; e < 12; ++e)
+					for (ssize_t i = 0; i < dimX - 1; ++i)
 					{
-						edgeIDs[e] = GlobalEdgeID(i, j, k, dim, e);
+						auto getVertexID = [&](int edge, const Vector3D& pt, const Vector3D& normal)
+						{
+							MarchingCubeVertexHashKey vKey = GlobalEdgeID(i, j, k, dim, edge);
+							MarchingCubeVertexID vID;
+
+							if (QueryVertexID(vertexMap, vKey, &vID))
+							{
+								return vID;
+							}
+
+							// If vertex does not exist from the map
+							vID = mesh->NumberOfPoints();
+							mesh->AddNormal(SafeNormalize(normal));
+							mesh->AddPoint(pt);
+							mesh->AddUV(Vector2D());
+							vertexMap.insert(std::make_pair(vKey, vID));
+
+							return vID;
+						};
+
+						auto addTriangle = [&](const Point3UI& face)
+						{
+							mesh->AddPointUVNormalTriangle(face, face, face);
+						};
+
+						MarchCell(grid, i, j, k, invGridSize, pos, isoValue, getVertexID, addTriangle);
 					}
-
-					bound.lowerCorner = pos(i, j, k);
-					bound.upperCorner = pos(i + 1, j + 1, k + 1);
-
-					SingleCube(data, edgeIDs, normals, bound, &vertexMap, mesh, isoValue);
 				}
 			}
 		}
 
+		auto getBoundaryVertexID = [&](size_t vKey, const Vector3D& pt, const Vector3D& normal)
+		{
+			MarchingCubeVertexID vID;
+
+			if (QueryVertexID(vertexMap, vKey, &vID))
+			{
+				return vID;
+			}
+
+			// if vertex does not exist...
+			vID = mesh->NumberOfPoints();
+			mesh->AddNormal(normal);
+			mesh->AddPoint(pt);
+			// empty texture coordinate...
+			mesh->AddUV(Vector2D());
+			vertexMap.insert(std::make_pair(vKey, vID));
+
+			return vID;
+		};
+
+		auto addBoundaryTriangle = [&](const Point3UI& face)
+		{
+			mesh->AddPointUVNormalTriangle(face, face, face);
+		};
+
 		// Construct boundaries parallel to x-y plane
 		vertexMap.clear();
 
@@ -466,64 +860,14 @@ namespace CubbyFlow
 			{
 				for (ssize_t i = 0; i < dimX - 1; ++i)
 				{
-					ssize_t k = 0;
-
-					std::array<double, 4> data;
-					std::array<size_t, 8> vertexAndEdgeIDs;
-					std::array<Vector3D, 4> corners;
-					Vector3D normal;
-
-					data[0] = grid(i + 1, j, k);
-					data[1] = grid(i, j, k);
-					data[2] = grid(i, j + 1, k);
-					data[3] = grid(i + 1, j + 1, k);
-
 					if (bndFlag & DIRECTION_BACK)
 					{
-						normal = Vector3D(0, 0, -1);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 1);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 0);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 4);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 5);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 0);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 8);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 4);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 9);
-
-						corners[0] = pos(i + 1, j, k);
-						corners[1] = pos(i, j, k);
-						corners[2] = pos(i, j + 1, k);
-						corners[3] = pos(i + 1, j + 1, k);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						BoundarySquare(grid, i, j, 0, DIRECTION_BACK, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
 					}
 
-					k = dimZ - 2;
-					data[0] = grid(i, j, k + 1);
-					data[1] = grid(i + 1, j, k + 1);
-					data[2] = grid(i + 1, j + 1, k + 1);
-					data[3] = grid(i, j + 1, k + 1);
-
 					if (bndFlag & DIRECTION_FRONT)
 					{
-						normal = Vector3D(0, 0, 1);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 3);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 2);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 6);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 2);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 10);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 6);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 11);
-
-						corners[0] = pos(i, j, k + 1);
-						corners[1] = pos(i + 1, j, k + 1);
-						corners[2] = pos(i + 1, j + 1, k + 1);
-						corners[3] = pos(i, j + 1, k + 1);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						BoundarySquare(grid, i, j, dimZ - 2, DIRECTION_FRONT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
 					}
 				}
 			}
@@ -538,64 +882,14 @@ namespace CubbyFlow
 			{
 				for (ssize_t j = 0; j < dimY - 1; ++j)
 				{
-					ssize_t i = 0;
-
-					std::array<double, 4> data;
-					std::array<size_t, 8> vertexAndEdgeIDs;
-					std::array<Vector3D, 4> corners;
-					Vector3D normal;
-
-					data[0] = grid(i, j, k);
-					data[1] = grid(i, j, k + 1);
-					data[2] = grid(i, j + 1, k + 1);
-					data[3] = grid(i, j + 1, k);
-
 					if (bndFlag & DIRECTION_LEFT)
 					{
-						normal = Vector3D(-1, 0, 0);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 0);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 3);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 4);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 3);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 11);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 8);
-
-						corners[0] = pos(i, j, k);
-						corners[1] = pos(i, j, k + 1);
-						corners[2] = pos(i, j + 1, k + 1);
-						corners[3] = pos(i, j + 1, k);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						BoundarySquare(grid, 0, j, k, DIRECTION_LEFT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
 					}
 
-					i = dimX - 2;
-					data[0] = grid(i + 1, j, k + 1);
-					data[1] = grid(i + 1, j, k);
-					data[2] = grid(i + 1, j + 1, k);
-					data[3] = grid(i + 1, j + 1, k + 1);
-
 					if (bndFlag & DIRECTION_RIGHT)
 					{
-						normal = Vector3D(1, 0, 0);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 2);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 1);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 5);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 6);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 1);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 5);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 10);
-
-						corners[0] = pos(i + 1, j, k + 1);
-						corners[1] = pos(i + 1, j, k);
-						corners[2] = pos(i + 1, j + 1, k);
-						corners[3] = pos(i + 1, j + 1, k + 1);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						BoundarySquare(grid, dimX - 2, j, k, DIRECTION_RIGHT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
 					}
 				}
 			}
@@ -610,67 +904,238 @@ namespace CubbyFlow
 			{
 				for (ssize_t i = 0; i < dimX - 1; ++i)
 				{
-					ssize_t j = 0;
+					if (bndFlag & DIRECTION_DOWN)
+					{
+						BoundarySquare(grid, i, 0, k, DIRECTION_DOWN, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+					}
+
+					if (bndFlag & DIRECTION_UP)
+					{
+						BoundarySquare(grid, i, dimY - 2, k, DIRECTION_UP, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+					}
+				}
+			}
+		}
+	}
 
-					std::array<double, 4> data;
-					std::array<size_t, 8> vertexAndEdgeIDs;
-					std::array<Vector3D, 4> corners;
-					Vector3D normal;
+	// Four consecutive z-slices of the grid which are streamed by the
+	// streaming version. While the cell layer k is processed, the slices from
+	// k - 1 to k + 2 can be accessed, which are needed by the gradients.
+	class MarchingCubesSliceWindow
+	{
+	public:
+		explicit MarchingCubesSliceWindow(const Size3& size) :
+			m_size(size), m_slices(4, Array2<double>(size.x, size.y))
+		{
+			// Do nothing
+		}
 
-					data[0] = grid(i, j, k);
-					data[1] = grid(i + 1, j, k);
-					data[2] = grid(i + 1, j, k + 1);
-					data[3] = grid(i, j, k + 1);
+		Size3 size() const
+		{
+			return m_size;
+		}
 
-					if (bndFlag & DIRECTION_DOWN)
+		double operator()(size_t i, size_t j, size_t k) const
+		{
+			return m_slices[k % 4](i, j);
+		}
+
+		ArrayAccessor2<double> Slice(size_t k)
+		{
+			return m_slices[k % 4].Accessor();
+		}
+
+	private:
+		Size3 m_size;
+		std::vector<Array2<double>> m_slices;
+	};
+
+	void MarchingCubes(
+		const std::function<void(size_t, ArrayAccessor2<double>)>& slice,
+		const Size3& resolution,
+		const Vector3D& gridSize,
+		const Vector3D& origin,
+		const std::function<void(const Vector3D&, const Vector3D&)>& addVertex,
+		const std::function<void(const Point3UI&)>& addTriangle,
+		double isoValue,
+		int bndFlag)
+	{
+		const Size3 dim = resolution;
+		const Vector3D invGridSize = 1.0 / gridSize;
+		const size_t planeSize = dim.x * dim.y;
+		const size_t invalid = std::numeric_limits<size_t>::max();
+
+		auto pos = [origin, gridSize](ssize_t i, ssize_t j, ssize_t k)
+		{
+			return origin + gridSize * Vector3D({ i, j, k });
+		};
+
+		if (dim.x < 2 || dim.y < 2 || dim.z < 2)
+		{
+			return;
+		}
+
+		MarchingCubesSliceWindow window(dim);
+		size_t numVertices = 0;
+
+		// The cube vertices are welded through the edge arrays of the current
+		// layer as in the parallel version.
+		std::vector<size_t> bottom(2 * planeSize, invalid);
+		std::vector<size_t> vertical(planeSize, invalid);
+		std::vector<size_t> top(2 * planeSize, invalid);
+		std::vector<size_t>* planes[3] = { &bottom, &vertical, &top };
+
+		// The boundary vertices of each pair of walls are welded through the
+		// maps of the current and the previous layer.
+		std::array<MarchingCubeVertexMap, 3> boundaryMaps;
+		std::array<MarchingCubeVertexMap, 3> prevBoundaryMaps;
+
+		auto addBoundaryTriangle = [&](const Point3UI& face)
+		{
+			addTriangle(face);
+		};
+
+		slice(0, window.Slice(0));
+		slice(1, window.Slice(1));
+
+		for (size_t k = 0; k + 1 < dim.z; ++k)
+		{
+			if (k + 2 < dim.z)
+			{
+				slice(k + 2, window.Slice(k + 2));
+			}
+
+			for (size_t j = 0; j + 1 < dim.y; ++j)
+			{
+				for (size_t i = 0; i + 1 < dim.x; ++i)
+				{
+					auto getVertexID = [&](int edge, const Vector3D& pt, const Vector3D& normal)
+					{
+						const int* slot = edgeSlot3D[edge];
+						const size_t index = (i + slot[1]) + dim.x * (j + slot[2]);
+						std::vector<size_t>& plane = *planes[slot[0]];
+						size_t& vID = (slot[0] == 1) ? plane[index] : plane[2 * index + slot[3]];
+
+						if (vID == invalid)
+						{
+							vID = numVertices++;
+							addVertex(pt, SafeNormalize(normal));
+						}
+
+						return vID;
+					};
+
+					MarchCell(window, i, j, k, invGridSize, pos, isoValue, getVertexID, addTriangle);
+				}
+			}
+
+			for (size_t wall = 0; wall < 3; ++wall)
+			{
+				MarchingCubeVertexMap& vertexMap = boundaryMaps[wall];
+				const MarchingCubeVertexMap& prevVertexMap = prevBoundaryMaps[wall];
+
+				auto getBoundaryVertexID = [&](size_t vKey, const Vector3D& pt, const Vector3D& normal)
+				{
+					MarchingCubeVertexID vID;
+
+					if (QueryVertexID(vertexMap, vKey, &vID) || QueryVertexID(prevVertexMap, vKey, &vID))
 					{
-						normal = Vector3D(0, -1, 0);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 0);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 1);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 2);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 3);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 0);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 1);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 2);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 3);
-
-						corners[0] = pos(i, j, k);
-						corners[1] = pos(i + 1, j, k);
-						corners[2] = pos(i + 1, j, k + 1);
-						corners[3] = pos(i, j, k + 1);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						return vID;
 					}
 
-					j = dimY - 2;
-					data[0] = grid(i + 1, j + 1, k);
-					data[1] = grid(i, j + 1, k);
-					data[2] = grid(i, j + 1, k + 1);
-					data[3] = grid(i + 1, j + 1, k + 1);
+					vID = numVertices++;
+					addVertex(pt, normal);
+					vertexMap.insert(std::make_pair(vKey, vID));
 
-					if (bndFlag & DIRECTION_UP)
+					return vID;
+				};
+
+				if (wall == 0)
+				{
+					for (size_t j = 0; j + 1 < dim.y; ++j)
+					{
+						for (size_t i = 0; i + 1 < dim.x; ++i)
+						{
+							if ((bndFlag & DIRECTION_BACK) && k == 0)
+							{
+								BoundarySquare(window, i, j, k, DIRECTION_BACK, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+							}
+
+							if ((bndFlag & DIRECTION_FRONT) && k + 2 == dim.z)
+							{
+								BoundarySquare(window, i, j, k, DIRECTION_FRONT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+							}
+						}
+					}
+				}
+				else if (wall == 1)
+				{
+					for (size_t j = 0; j + 1 < dim.y; ++j)
+					{
+						if (bndFlag & DIRECTION_LEFT)
+						{
+							BoundarySquare(window, 0, j, k, DIRECTION_LEFT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+						}
+
+						if (bndFlag & DIRECTION_RIGHT)
+						{
+							BoundarySquare(window, dim.x - 2, j, k, DIRECTION_RIGHT, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+						}
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i + 1 < dim.x; ++i)
 					{
-						normal = Vector3D(0, 1, 0);
-
-						vertexAndEdgeIDs[0] = GlobalVertexID(i, j, k, dim, 5);
-						vertexAndEdgeIDs[1] = GlobalVertexID(i, j, k, dim, 4);
-						vertexAndEdgeIDs[2] = GlobalVertexID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[3] = GlobalVertexID(i, j, k, dim, 6);
-						vertexAndEdgeIDs[4] = GlobalEdgeID(i, j, k, dim, 4);
-						vertexAndEdgeIDs[5] = GlobalEdgeID(i, j, k, dim, 7);
-						vertexAndEdgeIDs[6] = GlobalEdgeID(i, j, k, dim, 6);
-						vertexAndEdgeIDs[7] = GlobalEdgeID(i, j, k, dim, 5);
-
-						corners[0] = pos(i + 1, j + 1, k);
-						corners[1] = pos(i, j + 1, k);
-						corners[2] = pos(i, j + 1, k + 1);
-						corners[3] = pos(i + 1, j + 1, k + 1);
-
-						SingleSquare(data, vertexAndEdgeIDs, normal, corners, &vertexMap, mesh, isoValue);
+						if (bndFlag & DIRECTION_DOWN)
+						{
+							BoundarySquare(window, i, 0, k, DIRECTION_DOWN, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+						}
+
+						if (bndFlag & DIRECTION_UP)
+						{
+							BoundarySquare(window, i, dim.y - 2, k, DIRECTION_UP, pos, isoValue, getBoundaryVertexID, addBoundaryTriangle);
+						}
 					}
 				}
+
+				prevBoundaryMaps[wall] = std::move(vertexMap);
+				vertexMap.clear();
 			}
+
+			std::swap(bottom, top);
+			std::fill(top.begin(), top.end(), invalid);
+			std::fill(vertical.begin(), vertical.end(), invalid);
 		}
 	}
+
+	void MarchingCubes(
+		const std::function<void(size_t, ArrayAccessor2<double>)>& slice,
+		const Size3& resolution,
+		const Vector3D& gridSize,
+		const Vector3D& origin,
+		std::ostream* objStream,
+		double isoValue,
+		int bndFlag)
+	{
+		auto addVertex = [objStream](const Vector3D& pt, const Vector3D& normal)
+		{
+			*objStream << "v " << pt.x << ' ' << pt.y << ' ' << pt.z << '\n';
+			*objStream << "vn " << normal.x << ' ' << normal.y << ' ' << normal.z << '\n';
+		};
+
+		auto addTriangle = [objStream](const Point3UI& face)
+		{
+			*objStream << "f ";
+
+			for (int j = 0; j < 3; ++j)
+			{
+				*objStream << face[j] + 1 << "//" << face[j] + 1 << ' ';
+			}
+
+			*objStream << '\n';
+		};
+
+		MarchingCubes(slice, resolution, gridSize, origin, addVertex, addTriangle, isoValue, bndFlag);
+	}
 }
\ No newline at end of file
@@ -6,8 +6,11 @@
 > Created Time: 2017/04/28
 > Copyright (c) 2018, Chan-Ho Chris Ohk
 *************************************************************************/
+#include <Core/BoundingBox/BoundingBox2.h>
+#include <Core/Math/MathUtils.h>
 #include <Core/Particle/ParticleSystemData2.h>
 #include <Core/Searcher/PointNeighborSearcher2.h>
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
 #include <Core/Searcher/PointParallelHashGridSearcher2.h>
 #include <Core/Utils/Factory.h>
 #include <Core/Utils/FlatbuffersHelper.h>
@@ -22,6 +25,36 @@ namespace CubbyFlow
 {
 	static const size_t DEFAULT_HASH_GRID_RESOLUTION = 64;
 
+	template <typename Searcher>
+	static void BuildNeighborListsFrom(
+		const Searcher& searcher, const ConstArrayAccessor1<Vector2D>& points,
+		double maxSearchRadius, ParticleNeighborLists* neighborLists)
+	{
+		neighborLists->Build(points.size(), [&](size_t i)
+		{
+			size_t count = 0;
+
+			searcher.ForEachNearbyPoint(points[i], maxSearchRadius, [&](size_t j, const Vector2D&)
+			{
+				if (i != j)
+				{
+					++count;
+				}
+			});
+
+			return count;
+		}, [&](size_t i, ParticleNeighborIndex* neighbors)
+		{
+			searcher.ForEachNearbyPoint(points[i], maxSearchRadius, [&](size_t j, const Vector2D&)
+			{
+				if (i != j)
+				{
+					*neighbors++ = static_cast<ParticleNeighborIndex>(j);
+				}
+			});
+		});
+	}
+
 	ParticleSystemData2::ParticleSystemData2() :
 		ParticleSystemData2(0)
 	{
@@ -222,7 +255,7 @@ namespace CubbyFlow
 		m_neighborSearcher = newNeighborSearcher;
 	}
 
-	const std::vector<std::vector<size_t>>& ParticleSystemData2::GetNeighborLists() const
+	const ParticleNeighborLists& ParticleSystemData2::GetNeighborLists() const
 	{
 		return m_neighborLists;
 	}
@@ -248,29 +281,117 @@ namespace CubbyFlow
 	{
 		Timer timer;
 
-		m_neighborLists.resize(GetNumberOfParticles());
+		const ConstArrayAccessor1<Vector2D> points(GetPositions());
+
+		// Resolve the searcher type once to skip the virtual call and
+		// std::function in the inner loop.
+		VisitPointNeighborSearcher(*m_neighborSearcher, [&](const auto& searcher)
+		{
+			BuildNeighborListsFrom(searcher, points, maxSearchRadius, &m_neighborLists);
+		});
+
+		CUBBYFLOW_INFO << "Building neighbor list took: "
+			<< timer.DurationInSeconds()
+			<< " seconds";
+	}
+
+	void ParticleSystemData2::SortParticles(double gridSpacing)
+	{
+		Timer timer;
+
+		const size_t n = GetNumberOfParticles();
+		const ConstArrayAccessor1<Vector2D> positions(GetPositions());
+
+		const BoundingBox2D bound = ParallelReduce(ZERO_SIZE, n, BoundingBox2D(),
+			[&](size_t start, size_t end, BoundingBox2D box)
+		{
+			for (size_t i = start; i < end; ++i)
+			{
+				box.Merge(positions[i]);
+			}
+
+			return box;
+		}, [](const BoundingBox2D& a, const BoundingBox2D& b)
+		{
+			BoundingBox2D box = a;
+			box.Merge(b);
+			return box;
+		});
+
+		const double maxCell = static_cast<double>(std::numeric_limits<uint32_t>::max());
 
-		auto points = GetPositions();
+		std::vector<uint64_t> codes(n);
+		m_sortedIndices.resize(n);
+
+		ParallelFor(ZERO_SIZE, n, [&](size_t i)
+		{
+			const Vector2D cell = (positions[i] - bound.lowerCorner) / gridSpacing;
+			codes[i] = MortonCode(
+				static_cast<uint32_t>(Clamp(cell.x, 0.0, maxCell)),
+				static_cast<uint32_t>(Clamp(cell.y, 0.0, maxCell)));
+			m_sortedIndices[i] = i;
+		});
+
+		// Ties are broken by the old index to keep the order deterministic
+		ParallelSort(m_sortedIndices.begin(), m_sortedIndices.end(), [&](size_t a, size_t b)
+		{
+			return codes[a] < codes[b] || (codes[a] == codes[b] && a < b);
+		});
 
-		for (size_t i = 0; i < GetNumberOfParticles(); ++i)
+		for (auto& attr : m_scalarDataList)
 		{
-			Vector2D origin = points[i];
-			m_neighborLists[i].clear();
+			ScalarData sorted(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
+			{
+				sorted[i] = attr[m_sortedIndices[i]];
+			});
+			attr.Swap(sorted);
+		}
 
-			m_neighborSearcher->ForEachNearbyPoint(origin, maxSearchRadius, [&](size_t j, const Vector2D&)
+		for (auto& attr : m_vectorDataList)
+		{
+			VectorData sorted(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
 			{
-				if (i != j)
+				sorted[i] = attr[m_sortedIndices[i]];
+			});
+			attr.Swap(sorted);
+		}
+
+		// Remap the neighbor lists if they are up to date
+		if (m_neighborLists.size() == n)
+		{
+			std::vector<size_t> newIndices(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
+			{
+				newIndices[m_sortedIndices[i]] = i;
+			});
+
+			const ParticleNeighborLists oldNeighborLists = m_neighborLists;
+			m_neighborLists.Build(n, [&](size_t i)
+			{
+				return oldNeighborLists[m_sortedIndices[i]].size();
+			}, [&](size_t i, ParticleNeighborIndex* neighbors)
+			{
+				for (size_t j : oldNeighborLists[m_sortedIndices[i]])
 				{
-					m_neighborLists[i].push_back(j);
+					*neighbors++ = static_cast<ParticleNeighborIndex>(newIndices[j]);
 				}
 			});
 		}
 
-		CUBBYFLOW_INFO << "Building neighbor list took: "
+		m_neighborSearcher->Build(GetPositions());
+
+		CUBBYFLOW_INFO << "Sorting particles took: "
 			<< timer.DurationInSeconds()
 			<< " seconds";
 	}
 
+	const std::vector<size_t>& ParticleSystemData2::GetSortedIndices() const
+	{
+		return m_sortedIndices;
+	}
+
 	void ParticleSystemData2::Serialize(std::vector<uint8_t>* buffer) const
 	{
 		flatbuffers::FlatBufferBuilder builder(1024);
@@ -314,6 +435,7 @@ namespace CubbyFlow
 
 		m_neighborSearcher = other.m_neighborSearcher->Clone();
 		m_neighborLists = other.m_neighborLists;
+		m_sortedIndices = other.m_sortedIndices;
 	}
 
 	ParticleSystemData2& ParticleSystemData2::operator=(const ParticleSystemData2& other)
@@ -364,8 +486,9 @@ namespace CubbyFlow
 
 		// Copy neighbor lists
 		std::vector<flatbuffers::Offset<fbs::ParticleNeighborList2>> neighborLists;
-		for (const auto& neighbors : m_neighborLists)
+		for (size_t i = 0; i < m_neighborLists.size(); ++i)
 		{
+			const auto neighbors = m_neighborLists[i];
 			std::vector<uint64_t> neighbors64(neighbors.begin(), neighbors.end());
 			flatbuffers::Offset<fbs::ParticleNeighborList2> fbsNeighborList
 				= fbs::CreateParticleNeighborList2(*builder,
@@ -442,20 +565,17 @@ namespace CubbyFlow
 
 		// Copy neighbor list
 		auto fbsNeighborLists = fbsParticleSystemData->neighborLists();
-		m_neighborLists.resize(fbsNeighborLists->size());
-		
+		m_neighborLists.Clear();
+
 		for (uint32_t i = 0; i < fbsNeighborLists->size(); ++i)
 		{
 			auto fbsNeighborList = fbsNeighborLists->Get(i);
-			m_neighborLists[i].resize(fbsNeighborList->data()->size());
-			std::transform(
-				fbsNeighborList->data()->begin(),
-				fbsNeighborList->data()->end(),
-				m_neighborLists[i].begin(),
-				[](uint64_t val)
+			for (uint64_t val : *fbsNeighborList->data())
 			{
-				return static_cast<size_t>(val);
-			});
+				m_neighborLists.AddNeighbor(static_cast<size_t>(val));
+			}
+
+			m_neighborLists.EndList();
 		}
 	}
 }
\ No newline at end of file
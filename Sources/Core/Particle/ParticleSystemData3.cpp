@@ -6,8 +6,11 @@
 > Created Time: 2017/05/09
 > Copyright (c) 2018, Chan-Ho Chris Ohk
 *************************************************************************/
+#include <Core/BoundingBox/BoundingBox3.h>
+#include <Core/Math/MathUtils.h>
 #include <Core/Particle/ParticleSystemData3.h>
 #include <Core/Searcher/PointNeighborSearcher3.h>
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
 #include <Core/Searcher/PointParallelHashGridSearcher3.h>
 #include <Core/Utils/Factory.h>
 #include <Core/Utils/FlatbuffersHelper.h>
@@ -18,9 +21,92 @@
 
 #include <Flatbuffers/generated/ParticleSystemData3_generated.h>
 
+#include <typeinfo>
+
 namespace CubbyFlow
 {
 	static const size_t DEFAULT_HASH_GRID_RESOLUTION = 64;
+	static const double DEFAULT_HASH_GRID_MAX_CHURN_RATIO = 0.1;
+
+	template <typename Searcher>
+	static void BuildNeighborListsFrom(
+		const Searcher& searcher, const ConstArrayAccessor1<Vector3D>& points,
+		double maxSearchRadius, ParticleNeighborLists* neighborLists)
+	{
+		neighborLists->Build(points.size(), [&](size_t i)
+		{
+			size_t count = 0;
+
+			searcher.ForEachNearbyPoint(points[i], maxSearchRadius, [&](size_t j, const Vector3D&)
+			{
+				if (i != j)
+				{
+					++count;
+				}
+			});
+
+			return count;
+		}, [&](size_t i, ParticleNeighborIndex* neighbors)
+		{
+			searcher.ForEachNearbyPoint(points[i], maxSearchRadius, [&](size_t j, const Vector3D&)
+			{
+				if (i != j)
+				{
+					*neighbors++ = static_cast<ParticleNeighborIndex>(j);
+				}
+			});
+		});
+	}
+
+	// The hash grid searchers answer all the queries in one batched pass,
+	// which visits the buckets once per group of nearby particles instead of
+	// querying each particle twice.
+	template <typename Searcher>
+	static void BuildNeighborListsFromBatch(
+		const Searcher& searcher, const ConstArrayAccessor1<Vector3D>& points,
+		double maxSearchRadius, ParticleNeighborLists* neighborLists)
+	{
+		std::vector<size_t> offsets, indices;
+		searcher.FindNearbyPoints(points, maxSearchRadius, &offsets, &indices);
+
+		neighborLists->Build(points.size(), [&](size_t i)
+		{
+			size_t count = 0;
+
+			for (size_t jj = offsets[i]; jj < offsets[i + 1]; ++jj)
+			{
+				if (i != indices[jj])
+				{
+					++count;
+				}
+			}
+
+			return count;
+		}, [&](size_t i, ParticleNeighborIndex* neighbors)
+		{
+			for (size_t jj = offsets[i]; jj < offsets[i + 1]; ++jj)
+			{
+				if (i != indices[jj])
+				{
+					*neighbors++ = static_cast<ParticleNeighborIndex>(indices[jj]);
+				}
+			}
+		});
+	}
+
+	static void BuildNeighborListsFrom(
+		const PointHashGridSearcher3& searcher, const ConstArrayAccessor1<Vector3D>& points,
+		double maxSearchRadius, ParticleNeighborLists* neighborLists)
+	{
+		BuildNeighborListsFromBatch(searcher, points, maxSearchRadius, neighborLists);
+	}
+
+	static void BuildNeighborListsFrom(
+		const PointParallelHashGridSearcher3& searcher, const ConstArrayAccessor1<Vector3D>& points,
+		double maxSearchRadius, ParticleNeighborLists* neighborLists)
+	{
+		BuildNeighborListsFromBatch(searcher, points, maxSearchRadius, neighborLists);
+	}
 
 	ParticleSystemData3::ParticleSystemData3() :
 		ParticleSystemData3(0)
@@ -226,7 +312,7 @@ namespace CubbyFlow
 		m_neighborSearcher = newNeighborSearcher;
 	}
 
-	const std::vector<std::vector<size_t>>& ParticleSystemData3::GetNeighborLists() const
+	const ParticleNeighborLists& ParticleSystemData3::GetNeighborLists() const
 	{
 		return m_neighborLists;
 	}
@@ -235,47 +321,150 @@ namespace CubbyFlow
 	{
 		Timer timer;
 
-		// Use PointParallelHashGridSearcher3 by default
-		m_neighborSearcher = std::make_shared<PointParallelHashGridSearcher3>(
-			DEFAULT_HASH_GRID_RESOLUTION,
-			DEFAULT_HASH_GRID_RESOLUTION,
-			DEFAULT_HASH_GRID_RESOLUTION,
-			2.0 * maxSearchRadius);
+		// Use PointParallelHashGridSearcher3 by default. The grid of the
+		// previous step is kept, so that only the particles which changed
+		// bucket have to be moved. Any other searcher, or a grid with other
+		// parameters (e.g. set with SetNeighborSearcher), is replaced.
+		const Size3 resolution(DEFAULT_HASH_GRID_RESOLUTION, DEFAULT_HASH_GRID_RESOLUTION, DEFAULT_HASH_GRID_RESOLUTION);
+		auto hashGridSearcher = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(m_neighborSearcher);
+		if (hashGridSearcher == nullptr ||
+			typeid(*hashGridSearcher) != typeid(PointParallelHashGridSearcher3) ||
+			hashGridSearcher->GetGridSpacing() != 2.0 * maxSearchRadius ||
+			hashGridSearcher->GetResolution() != resolution ||
+			hashGridSearcher->GetMaxChurnRatio() != DEFAULT_HASH_GRID_MAX_CHURN_RATIO)
+		{
+			hashGridSearcher = std::make_shared<PointParallelHashGridSearcher3>(resolution, 2.0 * maxSearchRadius);
+			hashGridSearcher->SetMaxChurnRatio(DEFAULT_HASH_GRID_MAX_CHURN_RATIO);
 
-		m_neighborSearcher->Build(GetPositions());
+			m_neighborSearcher = hashGridSearcher;
+		}
+
+		hashGridSearcher->Build(GetPositions());
 
 		CUBBYFLOW_INFO << "Building neighbor searcher took: "
 			<< timer.DurationInSeconds()
-			<< " seconds";
+			<< " seconds (full builds vs. incremental updates: "
+			<< hashGridSearcher->GetNumberOfFullBuilds() << " / "
+			<< hashGridSearcher->GetNumberOfIncrementalUpdates() << ")";
 	}
 
 	void ParticleSystemData3::BuildNeighborLists(double maxSearchRadius)
 	{
 		Timer timer;
 
-		m_neighborLists.resize(GetNumberOfParticles());
+		const ConstArrayAccessor1<Vector3D> points(GetPositions());
 
-		auto points = GetPositions();
+		// Resolve the searcher type once to skip the virtual call and
+		// std::function in the inner loop.
+		VisitPointNeighborSearcher(*m_neighborSearcher, [&](const auto& searcher)
+		{
+			BuildNeighborListsFrom(searcher, points, maxSearchRadius, &m_neighborLists);
+		});
+
+		CUBBYFLOW_INFO << "Building neighbor list took: "
+			<< timer.DurationInSeconds()
+			<< " seconds";
+	}
+
+	void ParticleSystemData3::SortParticles(double gridSpacing)
+	{
+		Timer timer;
+
+		const size_t n = GetNumberOfParticles();
+		const ConstArrayAccessor1<Vector3D> positions(GetPositions());
+
+		const BoundingBox3D bound = ParallelReduce(ZERO_SIZE, n, BoundingBox3D(),
+			[&](size_t start, size_t end, BoundingBox3D box)
+		{
+			for (size_t i = start; i < end; ++i)
+			{
+				box.Merge(positions[i]);
+			}
 
-		for (size_t i = 0; i < GetNumberOfParticles(); ++i)
+			return box;
+		}, [](const BoundingBox3D& a, const BoundingBox3D& b)
 		{
-			Vector3D origin = points[i];
-			m_neighborLists[i].clear();
+			BoundingBox3D box = a;
+			box.Merge(b);
+			return box;
+		});
+
+		// Morton codes hold 21 bits per axis in 3-D
+		const double maxCell = static_cast<double>((1u << 21) - 1);
 
-			m_neighborSearcher->ForEachNearbyPoint(origin, maxSearchRadius, [&](size_t j, const Vector3D&)
+		std::vector<uint64_t> codes(n);
+		m_sortedIndices.resize(n);
+
+		ParallelFor(ZERO_SIZE, n, [&](size_t i)
+		{
+			const Vector3D cell = (positions[i] - bound.lowerCorner) / gridSpacing;
+			codes[i] = MortonCode(
+				static_cast<uint32_t>(Clamp(cell.x, 0.0, maxCell)),
+				static_cast<uint32_t>(Clamp(cell.y, 0.0, maxCell)),
+				static_cast<uint32_t>(Clamp(cell.z, 0.0, maxCell)));
+			m_sortedIndices[i] = i;
+		});
+
+		// Ties are broken by the old index to keep the order deterministic
+		ParallelSort(m_sortedIndices.begin(), m_sortedIndices.end(), [&](size_t a, size_t b)
+		{
+			return codes[a] < codes[b] || (codes[a] == codes[b] && a < b);
+		});
+
+		for (auto& attr : m_scalarDataList)
+		{
+			ScalarData sorted(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
 			{
-				if (i != j)
+				sorted[i] = attr[m_sortedIndices[i]];
+			});
+			attr.Swap(sorted);
+		}
+
+		for (auto& attr : m_vectorDataList)
+		{
+			VectorData sorted(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
+			{
+				sorted[i] = attr[m_sortedIndices[i]];
+			});
+			attr.Swap(sorted);
+		}
+
+		// Remap the neighbor lists if they are up to date
+		if (m_neighborLists.size() == n)
+		{
+			std::vector<size_t> newIndices(n);
+			ParallelFor(ZERO_SIZE, n, [&](size_t i)
+			{
+				newIndices[m_sortedIndices[i]] = i;
+			});
+
+			const ParticleNeighborLists oldNeighborLists = m_neighborLists;
+			m_neighborLists.Build(n, [&](size_t i)
+			{
+				return oldNeighborLists[m_sortedIndices[i]].size();
+			}, [&](size_t i, ParticleNeighborIndex* neighbors)
+			{
+				for (size_t j : oldNeighborLists[m_sortedIndices[i]])
 				{
-					m_neighborLists[i].push_back(j);
+					*neighbors++ = static_cast<ParticleNeighborIndex>(newIndices[j]);
 				}
 			});
 		}
 
-		CUBBYFLOW_INFO << "Building neighbor list took: "
+		m_neighborSearcher->Build(GetPositions());
+
+		CUBBYFLOW_INFO << "Sorting particles took: "
 			<< timer.DurationInSeconds()
 			<< " seconds";
 	}
 
+	const std::vector<size_t>& ParticleSystemData3::GetSortedIndices() const
+	{
+		return m_sortedIndices;
+	}
+
 	void ParticleSystemData3::Serialize(std::vector<uint8_t>* buffer) const
 	{
 		flatbuffers::FlatBufferBuilder builder(1024);
@@ -319,6 +508,7 @@ namespace CubbyFlow
 
 		m_neighborSearcher = other.m_neighborSearcher->Clone();
 		m_neighborLists = other.m_neighborLists;
+		m_sortedIndices = other.m_sortedIndices;
 	}
 
 	ParticleSystemData3& ParticleSystemData3::operator=(const ParticleSystemData3& other)
@@ -369,8 +559,9 @@ namespace CubbyFlow
 
 		// Copy neighbor lists
 		std::vector<flatbuffers::Offset<fbs::ParticleNeighborList3>> neighborLists;
-		for (const auto& neighbors : m_neighborLists)
+		for (size_t i = 0; i < m_neighborLists.size(); ++i)
 		{
+			const auto neighbors = m_neighborLists[i];
 			std::vector<uint64_t> neighbors64(neighbors.begin(), neighbors.end());
 			flatbuffers::Offset<fbs::ParticleNeighborList3> fbsNeighborList
 				= fbs::CreateParticleNeighborList3( *builder,
@@ -447,20 +638,17 @@ namespace CubbyFlow
 
 		// Copy neighbor list
 		auto fbsNeighborLists = fbsParticleSystemData->neighborLists();
-		m_neighborLists.resize(fbsNeighborLists->size());
+		m_neighborLists.Clear();
 
 		for (uint32_t i = 0; i < fbsNeighborLists->size(); ++i)
 		{
 			auto fbsNeighborList = fbsNeighborLists->Get(i);
-			m_neighborLists[i].resize(fbsNeighborList->data()->size());
-			std::transform(
-				fbsNeighborList->data()->begin(),
-				fbsNeighborList->data()->end(),
-				m_neighborLists[i].begin(),
-				[](uint64_t val)
+			for (uint64_t val : *fbsNeighborList->data())
 			{
-				return static_cast<size_t>(val);
-			});
+				m_neighborLists.AddNeighbor(static_cast<size_t>(val));
+			}
+
+			m_neighborLists.EndList();
 		}
 	}
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <Core/PointGenerator/TrianglePointGenerator.h>
 #include <Core/SPH/SPHStdKernel2.h>
 #include <Core/SPH/SPHSystemData2.h>
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
 
 #include <Flatbuffers/generated/SPHSystemData2_generated.h>
 
@@ -79,10 +80,25 @@ namespace CubbyFlow
 		auto d = GetDensities();
 		const double m = GetMass();
 
-		ParallelFor(ZERO_SIZE, GetNumberOfParticles(), [&](size_t i)
+		SPHStdKernel2 kernel(m_kernelRadius);
+
+		// Same as SumOfKernelNearby, with the searcher type resolved once so
+		// the kernel sum is inlined into the neighbor query.
+		VisitPointNeighborSearcher(*GetNeighborSearcher(), [&](const auto& searcher)
 		{
-			double sum = SumOfKernelNearby(p[i]);
-			d[i] = m * sum;
+			ParallelFor(ZERO_SIZE, GetNumberOfParticles(), [&](size_t i)
+			{
+				const Vector2D origin = p[i];
+				double sum = 0.0;
+
+				searcher.ForEachNearbyPoint(origin, m_kernelRadius,
+					[&](size_t, const Vector2D& neighborPosition)
+				{
+					sum += kernel(origin.DistanceTo(neighborPosition));
+				});
+
+				d[i] = m * sum;
+			});
 		});
 	}
 
@@ -59,31 +59,7 @@ namespace CubbyFlow
 		double radius,
 		const ForEachNearbyPointFunc& callback) const
 	{
-		if (m_buckets.empty())
-		{
-			return;
-		}
-
-		size_t nearByKeys[4];
-		GetNearbyKeys(origin, nearByKeys);
-
-		const double queryRadiusSquared = radius * radius;
-
-		for (size_t i = 0; i < 4; ++i)
-		{
-			const auto& bucket = m_buckets[nearByKeys[i]];
-			size_t numberOfPointsInBucket = bucket.size();
-
-			for (size_t j = 0; j < numberOfPointsInBucket; ++j)
-			{
-				size_t pointIndex = bucket[j];
-				double rSquared = (m_points[pointIndex] - origin).LengthSquared();
-				if (rSquared <= queryRadiusSquared)
-				{
-					callback(pointIndex, m_points[pointIndex]);
-				}
-			}
-		}
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 	}
 
 	bool PointHashGridSearcher2::HasNearbyPoint(const Vector2D& origin, double radius) const
@@ -11,6 +11,8 @@
 
 #include <Flatbuffers/generated/PointHashGridSearcher3_generated.h>
 
+#include <algorithm>
+
 namespace CubbyFlow
 {
 	PointHashGridSearcher3::PointHashGridSearcher3(const Size3& resolution, double gridSpacing) :
@@ -60,31 +62,21 @@ namespace CubbyFlow
 		double radius,
 		const ForEachNearbyPointFunc& callback) const
 	{
-		if (m_buckets.empty())
-		{
-			return;
-		}
-
-		size_t nearByKeys[8];
-		GetNearbyKeys(origin, nearByKeys);
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
+	}
 
-		const double queryRadiusSquared = radius * radius;
+	void PointHashGridSearcher3::FindNearbyPoints(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		std::vector<size_t>* offsets, std::vector<size_t>* indices) const
+	{
+		std::vector<size_t> queryOrder, groupStarts;
+		Internal::GroupHashGridQueries(*this, m_gridSpacing, origins, &queryOrder, &groupStarts);
 
-		for (size_t i = 0; i < 8; ++i)
+		Internal::CollectNearbyPointsOfGroups(origins.size(), queryOrder, groupStarts,
+			[&](size_t begin, size_t end, const auto& callback)
 		{
-			const auto& bucket = m_buckets[nearByKeys[i]];
-			size_t numberOfPointsInBucket = bucket.size();
-
-			for (size_t j = 0; j < numberOfPointsInBucket; ++j)
-			{
-				size_t pointIndex = bucket[j];
-				double rSquared = (m_points[pointIndex] - origin).LengthSquared();
-				if (rSquared <= queryRadiusSquared)
-				{
-					callback(pointIndex, m_points[pointIndex]);
-				}
-			}
-		}
+			ForEachNearbyPointInGroup(origins, radius, queryOrder, begin, end, callback);
+		}, offsets, indices);
 	}
 
 	bool PointHashGridSearcher3::HasNearbyPoint(const Vector3D&  origin, double radius) const
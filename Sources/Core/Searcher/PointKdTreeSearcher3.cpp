@@ -36,7 +36,7 @@ namespace CubbyFlow
 		const Vector3D& origin, double radius,
 		const ForEachNearbyPointFunc& callback) const
 	{
-		m_tree.ForEachNearbyPoint(origin, radius, callback);
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 	}
 
 	bool PointKdTreeSearcher3::HasNearbyPoint(const Vector3D& origin, double radius) const
@@ -66,21 +66,17 @@ namespace CubbyFlow
 		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
 		{
 			m_sortedIndices[i] = i;
-			m_points[i] = points[i];
 			tempKeys[i] = GetHashKeyFromPosition(points[i]);
 		});
 
 		// Sort indices based on hash key
-		ParallelSort(m_sortedIndices.begin(), m_sortedIndices.end(), [&tempKeys](size_t indexA, size_t indexB)
-		{
-			return tempKeys[indexA] < tempKeys[indexB];
-		});
+		ParallelRadixSort(tempKeys.begin(), tempKeys.end(), m_sortedIndices.begin());
 
 		// Re-order point and key arrays
 		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
 		{
 			m_points[i] = points[m_sortedIndices[i]];
-			m_keys[i] = tempKeys[m_sortedIndices[i]];
+			m_keys[i] = tempKeys[i];
 		});
 
 		// Now m_points and m_keys are sorted by points' hash key values.
@@ -129,33 +125,7 @@ namespace CubbyFlow
 
 	void PointParallelHashGridSearcher2::ForEachNearbyPoint(const Vector2D& origin, double radius, const ForEachNearbyPointFunc& callback) const
 	{
-		size_t nearbyKeys[4];
-		GetNearbyKeys(origin, nearbyKeys);
-
-		const double queryRadiusSquared = radius * radius;
-
-		for (int i = 0; i < 4; ++i)
-		{
-			size_t nearbyKey = nearbyKeys[i];
-			size_t start = m_startIndexTable[nearbyKey];
-			size_t end = m_endIndexTable[nearbyKey];
-
-			// Empty bucket -- continue to next bucket
-			if (start == std::numeric_limits<size_t>::max())
-			{
-				continue;
-			}
-
-			for (size_t j = start; j < end; ++j)
-			{
-				Vector2D direction = m_points[j] - origin;
-				double distanceSquared = direction.LengthSquared();
-				if (distanceSquared <= queryRadiusSquared)
-				{
-					callback(m_sortedIndices[j], m_points[j]);
-				}
-			}
-		}
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 	}
 
 	bool PointParallelHashGridSearcher2::HasNearbyPoint(const Vector2D& origin, double radius) const
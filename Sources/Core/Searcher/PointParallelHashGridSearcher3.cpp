@@ -15,6 +15,8 @@
 
 #include <flatbuffers/flatbuffers.h>
 
+#include <algorithm>
+
 namespace CubbyFlow
 {
 	PointParallelHashGridSearcher3::PointParallelHashGridSearcher3(const Size3& resolution, double gridSpacing) :
@@ -41,72 +43,20 @@ namespace CubbyFlow
 
 	void PointParallelHashGridSearcher3::Build(const ConstArrayAccessor1<Vector3D>& points)
 	{
-		m_points.clear();
-		m_keys.clear();
-		m_startIndexTable.clear();
-		m_endIndexTable.clear();
-		m_sortedIndices.clear();
-
-		// Allocate memory chunks
-		size_t numberOfPoints = points.size();
-		std::vector<size_t> tempKeys(numberOfPoints);
-		m_startIndexTable.resize(m_resolution.x * m_resolution.y * m_resolution.z);
-		m_endIndexTable.resize(m_resolution.x * m_resolution.y * m_resolution.z);
-		ParallelFill(m_startIndexTable.begin(), m_startIndexTable.end(), std::numeric_limits<size_t>::max());
-		ParallelFill(m_endIndexTable.begin(), m_endIndexTable.end(), std::numeric_limits<size_t>::max());
-		m_keys.resize(numberOfPoints);
-		m_sortedIndices.resize(numberOfPoints);
-		m_points.resize(numberOfPoints);
-
-		if (numberOfPoints == 0)
+		if (UpdateIncrementally(points))
 		{
-			return;
+			++m_numberOfIncrementalUpdates;
 		}
-
-		// Initialize indices array and generate hash key for each point
-		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
-		{
-			m_sortedIndices[i] = i;
-			m_points[i] = points[i];
-			tempKeys[i] = GetHashKeyFromPosition(points[i]);
-		});
-
-		// Sort indices based on hash key
-		ParallelSort(m_sortedIndices.begin(), m_sortedIndices.end(), [&tempKeys](size_t indexA, size_t indexB)
-		{
-			return tempKeys[indexA] < tempKeys[indexB];
-		});
-
-		// Re-order point and key arrays
-		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		else
 		{
-			m_points[i] = points[m_sortedIndices[i]];
-			m_keys[i] = tempKeys[m_sortedIndices[i]];
-		});
-
-		// Now m_points and m_keys are sorted by points' hash key values.
-		// Let's fill in start/end index table with m_keys.
-
-		// Assume that m_keys array looks like:
-		// [5|8|8|10|10|10]
-		// Then m_startIndexTable and m_endIndexTable should be like:
-		// [.....|0|...|1|..|3|..]
-		// [.....|1|...|3|..|6|..]
-		//       ^5    ^8   ^10
-		// So that m_endIndexTable[i] - m_startIndexTable[i] is the number points
-		// in i-th table bucket.
-
-		m_startIndexTable[m_keys[0]] = 0;
-		m_endIndexTable[m_keys[numberOfPoints - 1]] = numberOfPoints;
+			BuildFull(points);
+			++m_numberOfFullBuilds;
+		}
 
-		ParallelFor(static_cast<size_t>(1), numberOfPoints, [&](size_t i)
+		if (points.size() == 0)
 		{
-			if (m_keys[i] > m_keys[i - 1])
-			{
-				m_startIndexTable[m_keys[i]] = i;
-				m_endIndexTable[m_keys[i - 1]] = i;
-			}
-		});
+			return;
+		}
 
 		size_t sumNumberOfPointsPerBucket = 0;
 		size_t maxNumberOfPointsPerBucket = 0;
@@ -128,35 +78,56 @@ namespace CubbyFlow
 		CUBBYFLOW_INFO << "Max number of points per bucket: " << maxNumberOfPointsPerBucket;
 	}
 
-	void PointParallelHashGridSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const ForEachNearbyPointFunc& callback) const
+	void PointParallelHashGridSearcher3::SetMaxChurnRatio(double ratio)
 	{
-		size_t nearbyKeys[8];
-		GetNearbyKeys(origin, nearbyKeys);
+		m_maxChurnRatio = std::max(ratio, 0.0);
+	}
 
-		const double queryRadiusSquared = radius * radius;
+	double PointParallelHashGridSearcher3::GetMaxChurnRatio() const
+	{
+		return m_maxChurnRatio;
+	}
 
-		for (int i = 0; i < 8; ++i)
-		{
-			size_t nearbyKey = nearbyKeys[i];
-			size_t start = m_startIndexTable[nearbyKey];
-			size_t end = m_endIndexTable[nearbyKey];
+	double PointParallelHashGridSearcher3::GetGridSpacing() const
+	{
+		return m_gridSpacing;
+	}
 
-			// Empty bucket -- continue to next bucket
-			if (start == std::numeric_limits<size_t>::max())
-			{
-				continue;
-			}
+	Size3 PointParallelHashGridSearcher3::GetResolution() const
+	{
+		return Size3(
+			static_cast<size_t>(m_resolution.x),
+			static_cast<size_t>(m_resolution.y),
+			static_cast<size_t>(m_resolution.z));
+	}
 
-			for (size_t j = start; j < end; ++j)
-			{
-				Vector3D direction = m_points[j] - origin;
-				double distanceSquared = direction.LengthSquared();
-				if (distanceSquared <= queryRadiusSquared)
-				{
-					callback(m_sortedIndices[j], m_points[j]);
-				}
-			}
-		}
+	size_t PointParallelHashGridSearcher3::GetNumberOfFullBuilds() const
+	{
+		return m_numberOfFullBuilds;
+	}
+
+	size_t PointParallelHashGridSearcher3::GetNumberOfIncrementalUpdates() const
+	{
+		return m_numberOfIncrementalUpdates;
+	}
+
+	void PointParallelHashGridSearcher3::ForEachNearbyPoint(const Vector3D& origin, double radius, const ForEachNearbyPointFunc& callback) const
+	{
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
+	}
+
+	void PointParallelHashGridSearcher3::FindNearbyPoints(
+		const ConstArrayAccessor1<Vector3D>& origins, double radius,
+		std::vector<size_t>* offsets, std::vector<size_t>* indices) const
+	{
+		std::vector<size_t> queryOrder, groupStarts;
+		Internal::GroupHashGridQueries(*this, m_gridSpacing, origins, &queryOrder, &groupStarts);
+
+		Internal::CollectNearbyPointsOfGroups(origins.size(), queryOrder, groupStarts,
+			[&](size_t begin, size_t end, const auto& callback)
+		{
+			ForEachNearbyPointInGroup(origins, radius, queryOrder, begin, end, callback);
+		}, offsets, indices);
 	}
 
 	bool PointParallelHashGridSearcher3::HasNearbyPoint(const Vector3D& origin, double radius) const
@@ -223,6 +194,224 @@ namespace CubbyFlow
 		return bucketIndex;
 	}
 
+	void PointParallelHashGridSearcher3::BuildFull(const ConstArrayAccessor1<Vector3D>& points)
+	{
+		m_points.clear();
+		m_keys.clear();
+		m_startIndexTable.clear();
+		m_endIndexTable.clear();
+		m_sortedIndices.clear();
+
+		// Allocate memory chunks
+		size_t numberOfPoints = points.size();
+		std::vector<size_t> tempKeys(numberOfPoints);
+		m_startIndexTable.resize(m_resolution.x * m_resolution.y * m_resolution.z);
+		m_endIndexTable.resize(m_resolution.x * m_resolution.y * m_resolution.z);
+		ParallelFill(m_startIndexTable.begin(), m_startIndexTable.end(), std::numeric_limits<size_t>::max());
+		ParallelFill(m_endIndexTable.begin(), m_endIndexTable.end(), std::numeric_limits<size_t>::max());
+		m_keys.resize(numberOfPoints);
+		m_sortedIndices.resize(numberOfPoints);
+		m_points.resize(numberOfPoints);
+
+		if (numberOfPoints == 0)
+		{
+			return;
+		}
+
+		// Initialize indices array and generate hash key for each point
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			m_sortedIndices[i] = i;
+			tempKeys[i] = GetHashKeyFromPosition(points[i]);
+		});
+
+		// Sort indices based on hash key
+		ParallelRadixSort(tempKeys.begin(), tempKeys.end(), m_sortedIndices.begin());
+
+		// Re-order point and key arrays
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			m_points[i] = points[m_sortedIndices[i]];
+			m_keys[i] = tempKeys[i];
+		});
+
+		// Now m_points and m_keys are sorted by points' hash key values.
+		// Let's fill in start/end index table with m_keys.
+
+		// Assume that m_keys array looks like:
+		// [5|8|8|10|10|10]
+		// Then m_startIndexTable and m_endIndexTable should be like:
+		// [.....|0|...|1|..|3|..]
+		// [.....|1|...|3|..|6|..]
+		//       ^5    ^8   ^10
+		// So that m_endIndexTable[i] - m_startIndexTable[i] is the number points
+		// in i-th table bucket.
+
+		m_startIndexTable[m_keys[0]] = 0;
+		m_endIndexTable[m_keys[numberOfPoints - 1]] = numberOfPoints;
+
+		ParallelFor(static_cast<size_t>(1), numberOfPoints, [&](size_t i)
+		{
+			if (m_keys[i] > m_keys[i - 1])
+			{
+				m_startIndexTable[m_keys[i]] = i;
+				m_endIndexTable[m_keys[i - 1]] = i;
+			}
+		});
+	}
+
+	bool PointParallelHashGridSearcher3::UpdateIncrementally(const ConstArrayAccessor1<Vector3D>& points)
+	{
+		const size_t numberOfPoints = points.size();
+
+		if (m_maxChurnRatio <= 0.0 || numberOfPoints == 0 || numberOfPoints != m_keys.size())
+		{
+			return false;
+		}
+
+		// New key of each point, in the current sorted order. The points are
+		// hashed in their own order and only the keys are gathered, which
+		// keeps the random reads small.
+		std::vector<size_t> pointKeys(numberOfPoints);
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			pointKeys[i] = GetHashKeyFromPosition(points[i]);
+		});
+
+		std::vector<size_t> newKeys(numberOfPoints);
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			newKeys[i] = pointKeys[m_sortedIndices[i]];
+		});
+
+		// Count the points which changed bucket per chunk of the sorted
+		// arrays. The exclusive scan of the counts gives where each chunk
+		// writes its moved and its stayed points.
+		const size_t numberOfChunks = std::min(numberOfPoints, static_cast<size_t>(8 * GetMaxNumberOfThreads()));
+		const auto GetChunkBegin = [&](size_t c)
+		{
+			return c * numberOfPoints / numberOfChunks;
+		};
+
+		std::vector<size_t> movedOffsets(numberOfChunks + 1, 0);
+		ParallelFor(ZERO_SIZE, numberOfChunks, [&](size_t c)
+		{
+			for (size_t i = GetChunkBegin(c); i < GetChunkBegin(c + 1); ++i)
+			{
+				if (newKeys[i] != m_keys[i])
+				{
+					++movedOffsets[c + 1];
+				}
+			}
+		});
+
+		for (size_t c = 0; c < numberOfChunks; ++c)
+		{
+			movedOffsets[c + 1] += movedOffsets[c];
+		}
+
+		const size_t numberOfMovedPoints = movedOffsets[numberOfChunks];
+		if (numberOfMovedPoints > static_cast<size_t>(m_maxChurnRatio * numberOfPoints))
+		{
+			return false;
+		}
+
+		const size_t numberOfStayedPoints = numberOfPoints - numberOfMovedPoints;
+		std::vector<size_t> movedKeys(numberOfMovedPoints), movedIndices(numberOfMovedPoints);
+		std::vector<size_t> stayedKeys(numberOfStayedPoints), stayedIndices(numberOfStayedPoints);
+
+		ParallelFor(ZERO_SIZE, numberOfChunks, [&](size_t c)
+		{
+			size_t moved = movedOffsets[c];
+			size_t stayed = GetChunkBegin(c) - movedOffsets[c];
+
+			for (size_t i = GetChunkBegin(c); i < GetChunkBegin(c + 1); ++i)
+			{
+				if (newKeys[i] != m_keys[i])
+				{
+					movedKeys[moved] = newKeys[i];
+					movedIndices[moved++] = m_sortedIndices[i];
+				}
+				else
+				{
+					stayedKeys[stayed] = newKeys[i];
+					stayedIndices[stayed++] = m_sortedIndices[i];
+				}
+			}
+		});
+
+		// The buckets the points left may become empty, so the table entries
+		// of the current buckets are cleared, each by the first point of its
+		// bucket. Every non-empty bucket is rewritten below.
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			if (i == 0 || m_keys[i] != m_keys[i - 1])
+			{
+				m_startIndexTable[m_keys[i]] = std::numeric_limits<size_t>::max();
+				m_endIndexTable[m_keys[i]] = std::numeric_limits<size_t>::max();
+			}
+		});
+
+		ParallelRadixSort(movedKeys.begin(), movedKeys.end(), movedIndices.begin());
+
+		// Merge the moved points back into the points which stayed, which are
+		// still sorted by key. The stayed points are split into chunks, and
+		// each chunk takes the moved points with keys from its first key up to
+		// the first key of the next chunk. Equal keys keep the stayed points
+		// first, so every chunk knows its output range and merges alone.
+		const size_t numberOfMergeChunks = std::max(ONE_SIZE, std::min(numberOfStayedPoints, numberOfChunks));
+		const auto GetStayedBegin = [&](size_t c)
+		{
+			return c * numberOfStayedPoints / numberOfMergeChunks;
+		};
+
+		std::vector<size_t> movedBegins(numberOfMergeChunks + 1, 0);
+		movedBegins[numberOfMergeChunks] = numberOfMovedPoints;
+		ParallelFor(ONE_SIZE, numberOfMergeChunks, [&](size_t c)
+		{
+			movedBegins[c] = static_cast<size_t>(std::lower_bound(
+				movedKeys.begin(), movedKeys.end(), stayedKeys[GetStayedBegin(c)]) - movedKeys.begin());
+		});
+
+		ParallelFor(ZERO_SIZE, numberOfMergeChunks, [&](size_t c)
+		{
+			size_t stayed = GetStayedBegin(c);
+			size_t moved = movedBegins[c];
+			const size_t stayedEnd = GetStayedBegin(c + 1);
+			const size_t movedEnd = movedBegins[c + 1];
+
+			for (size_t dest = stayed + moved; stayed < stayedEnd || moved < movedEnd; ++dest)
+			{
+				if (moved == movedEnd || (stayed < stayedEnd && stayedKeys[stayed] <= movedKeys[moved]))
+				{
+					m_keys[dest] = stayedKeys[stayed];
+					m_sortedIndices[dest] = stayedIndices[stayed++];
+				}
+				else
+				{
+					m_keys[dest] = movedKeys[moved];
+					m_sortedIndices[dest] = movedIndices[moved++];
+				}
+			}
+		});
+
+		ParallelFor(ZERO_SIZE, numberOfPoints, [&](size_t i)
+		{
+			m_points[i] = points[m_sortedIndices[i]];
+
+			if (i == 0 || m_keys[i] != m_keys[i - 1])
+			{
+				m_startIndexTable[m_keys[i]] = i;
+			}
+			if (i == numberOfPoints - 1 || m_keys[i] != m_keys[i + 1])
+			{
+				m_endIndexTable[m_keys[i]] = i + 1;
+			}
+		});
+
+		return true;
+	}
+
 	size_t PointParallelHashGridSearcher3::GetHashKeyFromPosition(const Vector3D& position) const
 	{
 		Point3I bucketIndex = GetBucketIndex(position);
@@ -337,6 +526,9 @@ namespace CubbyFlow
 		m_startIndexTable = other.m_startIndexTable;
 		m_endIndexTable = other.m_endIndexTable;
 		m_sortedIndices = other.m_sortedIndices;
+		m_maxChurnRatio = other.m_maxChurnRatio;
+		m_numberOfFullBuilds = other.m_numberOfFullBuilds;
+		m_numberOfIncrementalUpdates = other.m_numberOfIncrementalUpdates;
 	}
 
 	void PointParallelHashGridSearcher3::Serialize(std::vector<uint8_t>* buffer) const
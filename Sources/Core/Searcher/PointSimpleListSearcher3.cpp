@@ -34,17 +34,7 @@ namespace CubbyFlow
 		double radius,
 		const ForEachNearbyPointFunc& callback) const
 	{
-		double radiusSquared = radius * radius;
-
-		for (size_t i = 0; i < m_points.size(); ++i)
-		{
-			Vector3D r = m_points[i] - origin;
-			double distanceSquared = r.Dot(r);
-			if (distanceSquared <= radiusSquared)
-			{
-				callback(i, m_points[i]);
-			}
-		}
+		ForEachNearbyPoint<ForEachNearbyPointFunc>(origin, radius, callback);
 	}
 
 	bool PointSimpleListSearcher3::HasNearbyPoint(const Vector3D& origin, double radius) const
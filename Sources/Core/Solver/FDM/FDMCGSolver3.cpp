@@ -8,6 +8,7 @@
 *************************************************************************/
 #include <Core/Math/CG.h>
 #include <Core/Solver/FDM/FDMCGSolver3.h>
+#include <Core/Solver/FDM/FDMIterativeRefinement3.h>
 
 namespace CubbyFlow
 {
@@ -22,6 +23,11 @@ namespace CubbyFlow
 
 	bool FDMCGSolver3::Solve(FDMLinearSystem3* system)
 	{
+		if (m_precision != FDMPrecision::Double)
+		{
+			return SolveSinglePrecision(system);
+		}
+
 		FDMMatrix3& matrix = system->A;
 		FDMVector3& solution = system->x;
 		FDMVector3& rhs = system->b;
@@ -29,6 +35,7 @@ namespace CubbyFlow
 		assert(matrix.size() == rhs.size());
 		assert(matrix.size() == solution.size());
 
+		ClearSinglePrecisionVectors();
 		ClearCompressedVectors();
 
 		const Size3 size = matrix.size();
@@ -56,6 +63,7 @@ namespace CubbyFlow
 		VectorND& rhs = system->b;
 
 		ClearUncompressedVectors();
+		ClearSinglePrecisionVectors();
 
 		const size_t size = solution.size();
 		m_rComp.Resize(size);
@@ -75,6 +83,36 @@ namespace CubbyFlow
 		return (m_lastResidual <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
 	}
 
+	bool FDMCGSolver3::SolveMatrixFree(FDMMatrixFreeLinearSystem3* system)
+	{
+		FDMMatrixFree3& matrix = system->A;
+		FDMVector3& solution = system->x;
+		FDMVector3& rhs = system->b;
+
+		assert(matrix.size() == rhs.size());
+		assert(matrix.size() == solution.size());
+
+		ClearSinglePrecisionVectors();
+		ClearCompressedVectors();
+
+		const Size3 size = matrix.size();
+		m_r.Resize(size);
+		m_d.Resize(size);
+		m_q.Resize(size);
+		m_s.Resize(size);
+
+		system->x.Set(0.0);
+		m_r.Set(0.0);
+		m_d.Set(0.0);
+		m_q.Set(0.0);
+		m_s.Set(0.0);
+
+		CG<FDMMatrixFreeBLAS3>(matrix, rhs, m_maxNumberOfIterations, m_tolerance, &solution,
+			&m_r, &m_d, &m_q, &m_s, &m_lastNumberOfIterations, &m_lastResidual);
+
+		return (m_lastResidual <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
+	}
+
 	unsigned int FDMCGSolver3::GetMaxNumberOfIterations() const
 	{
 		return m_maxNumberOfIterations;
@@ -95,6 +133,49 @@ namespace CubbyFlow
 		return m_lastResidual;
 	}
 
+	void FDMCGSolver3::SetPrecision(FDMPrecision precision)
+	{
+		m_precision = precision;
+	}
+
+	FDMPrecision FDMCGSolver3::GetPrecision() const
+	{
+		return m_precision;
+	}
+
+	bool FDMCGSolver3::SolveSinglePrecision(FDMLinearSystem3* system)
+	{
+		FDMMatrix3& matrix = system->A;
+		FDMVector3& solution = system->x;
+		FDMVector3& rhs = system->b;
+
+		assert(matrix.size() == rhs.size());
+		assert(matrix.size() == solution.size());
+
+		ClearUncompressedVectors();
+		ClearCompressedVectors();
+
+		const Size3 size = matrix.size();
+		FDMBLAS3F::Set(matrix, &m_AF);
+		m_xF.Resize(size);
+		m_bF.Resize(size);
+		m_rF.Resize(size);
+		m_dF.Resize(size);
+		m_qF.Resize(size);
+		m_sF.Resize(size);
+
+		FDMIterativeRefinement3(matrix, rhs, m_precision, m_maxNumberOfIterations, m_tolerance,
+			[&](unsigned int maxNumberOfIterations, double tolerance, unsigned int* numberOfIterations)
+		{
+			double residualNorm = 0.0;
+
+			CG<FDMBLAS3F>(m_AF, m_bF, maxNumberOfIterations, tolerance,
+				&m_xF, &m_rF, &m_dF, &m_qF, &m_sF, numberOfIterations, &residualNorm);
+		}, &m_bF, &m_xF, &solution, &m_lastNumberOfIterations, &m_lastResidual);
+
+		return (m_lastResidual <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
+	}
+
 	void FDMCGSolver3::ClearUncompressedVectors()
 	{
 		m_r.Clear();
@@ -103,6 +184,17 @@ namespace CubbyFlow
 		m_s.Clear();
 	}
 
+	void FDMCGSolver3::ClearSinglePrecisionVectors()
+	{
+		m_AF.Clear();
+		m_xF.Clear();
+		m_bF.Clear();
+		m_rF.Clear();
+		m_dF.Clear();
+		m_qF.Clear();
+		m_sF.Clear();
+	}
+
 	void FDMCGSolver3::ClearCompressedVectors()
 	{
 		m_rComp.Clear();
@@ -10,9 +10,106 @@
 #include <Core/Math/CG.h>
 #include <Core/Solver/FDM/FDMICCGSolver2.h>
 #include <Core/Utils/Logging.h>
+#include <Core/Utils/Parallel.h>
+
+#include <algorithm>
 
 namespace CubbyFlow
 {
+	// Min and max number of cells in the tiles of the wavefront sweeps
+	static const size_t MIN_WAVEFRONT_TILE_SIZE = 8;
+	static const size_t MAX_WAVEFRONT_TILE_SIZE = 256;
+	// Max number of consecutive rows visited in order by one task of the
+	// level-scheduled compressed sweeps
+	static const size_t LEVEL_SEGMENT_SIZE = 32;
+
+	// Splits the x-rows of cells into tiles and visits the tiles wavefront by
+	// wavefront along (tile index + j). The cells of a tile are visited in
+	// order, and the lower (upper) neighboring tiles are on the previous (next)
+	// wavefront, so the tiles of a wavefront are independent in the triangular
+	// sweeps. The tiles are sized to give each thread a few tiles per row, so
+	// narrow grids are not swept by a single task.
+	template <typename Function>
+	static void ForEachIndexInWavefronts(const Size2& size, bool isReversed, const Function& function)
+	{
+		if (size.x == 0 || size.y == 0)
+		{
+			return;
+		}
+
+		const unsigned int numThreadsHint = GetMaxNumberOfThreads();
+		const size_t numThreads = (numThreadsHint == 0u) ? 8u : numThreadsHint;
+		const size_t tileSize = std::clamp(size.x / (4 * numThreads), MIN_WAVEFRONT_TILE_SIZE, MAX_WAVEFRONT_TILE_SIZE);
+		const size_t numberOfTiles = (size.x + tileSize - 1) / tileSize;
+		const size_t numberOfLevels = numberOfTiles + size.y - 1;
+
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			const size_t level = isReversed ? numberOfLevels - 1 - l : l;
+			const size_t jBegin = (level > numberOfTiles - 1) ? level - (numberOfTiles - 1) : 0;
+			const size_t jEnd = std::min(size.y, level + 1);
+
+			ParallelFor(jBegin, jEnd, [&](size_t j)
+			{
+				const size_t iBegin = (level - j) * tileSize;
+				const size_t iEnd = std::min(size.x, iBegin + tileSize);
+
+				if (isReversed)
+				{
+					for (size_t i = iEnd; i-- > iBegin;)
+					{
+						function(i, j);
+					}
+				}
+				else
+				{
+					for (size_t i = iBegin; i < iEnd; ++i)
+					{
+						function(i, j);
+					}
+				}
+			});
+		}
+	}
+
+	// Visits the segments of rows level by level, and the rows of a segment
+	// in order. A segment only depends on the lower (upper) segments of the
+	// previous (next) levels.
+	template <typename Function>
+	static void ForEachRowInLevels(
+		const std::vector<size_t>& segmentBegins, const std::vector<size_t>& levelOffsets,
+		const std::vector<size_t>& levelSegments, bool isReversed, const Function& function)
+	{
+		const size_t numberOfLevels = levelOffsets.size() - 1;
+
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			const size_t level = isReversed ? numberOfLevels - 1 - l : l;
+
+			ParallelFor(levelOffsets[level], levelOffsets[level + 1], [&](size_t s)
+			{
+				const size_t segment = levelSegments[s];
+				const size_t rowBegin = segmentBegins[segment];
+				const size_t rowEnd = segmentBegins[segment + 1];
+
+				if (isReversed)
+				{
+					for (size_t i = rowEnd; i-- > rowBegin;)
+					{
+						function(i);
+					}
+				}
+				else
+				{
+					for (size_t i = rowBegin; i < rowEnd; ++i)
+					{
+						function(i);
+					}
+				}
+			});
+		}
+	}
+
 	void FDMICCGSolver2::Preconditioner::Build(const FDMMatrix2& matrix)
 	{
 		const Size2 size = matrix.size();
@@ -21,7 +118,7 @@ namespace CubbyFlow
 		d.Resize(size, 0.0);
 		y.Resize(size, 0.0);
 
-		matrix.ForEachIndex([&](size_t i, size_t j)
+		const auto factorize = [&](size_t i, size_t j)
 		{
 			double denom =
 				matrix(i, j).center -
@@ -36,7 +133,16 @@ namespace CubbyFlow
 			{
 				d(i, j) = 0.0;
 			}
-		});
+		};
+
+		if (isParallel)
+		{
+			ForEachIndexInWavefronts(size, false, factorize);
+		}
+		else
+		{
+			matrix.ForEachIndex(factorize);
+		}
 	}
 
 	void FDMICCGSolver2::Preconditioner::Solve(const FDMVector2& b, FDMVector2* x)
@@ -45,24 +151,38 @@ namespace CubbyFlow
 		const ssize_t sx = static_cast<ssize_t>(size.x);
 		const ssize_t sy = static_cast<ssize_t>(size.y);
 
-		b.ForEachIndex([&](size_t i, size_t j)
+		const auto forwardSubstitute = [&](size_t i, size_t j)
 		{
 			y(i, j) =
 				(b(i, j) -
 				((i > 0) ? A(i - 1, j).right * y(i - 1, j) : 0.0) -
 				((j > 0) ? A(i, j - 1).up    * y(i, j - 1) : 0.0)) *
 				d(i, j);
-		});
+		};
+
+		const auto backSubstitute = [&](size_t i, size_t j)
+		{
+			(*x)(i, j) =
+				(y(i, j) -
+				((i + 1 < size.x) ? A(i, j).right * (*x)(i + 1, j) : 0.0) -
+				((j + 1 < size.y) ? A(i, j).up    * (*x)(i, j + 1) : 0.0)) *
+				d(i, j);
+		};
+
+		if (isParallel)
+		{
+			ForEachIndexInWavefronts(size, false, forwardSubstitute);
+			ForEachIndexInWavefronts(size, true, backSubstitute);
+			return;
+		}
+
+		b.ForEachIndex(forwardSubstitute);
 
 		for (ssize_t j = sy - 1; j >= 0; --j)
 		{
 			for (ssize_t i = sx - 1; i >= 0; --i)
 			{
-				(*x)(i, j) =
-					(y(i, j) -
-					((i + 1 < sx) ? A(i, j).right * (*x)(i + 1, j) : 0.0) -
-					((j + 1 < sy) ? A(i, j).up    * (*x)(i, j + 1) : 0.0)) *
-					d(i, j);
+				backSubstitute(i, j);
 			}
 		}
 	}
@@ -79,7 +199,7 @@ namespace CubbyFlow
 		const auto ci = A->ColumnIndicesBegin();
 		const auto nnz = A->NonZeroBegin();
 
-		d.ForEachIndex([&](size_t i)
+		const auto factorize = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -107,7 +227,90 @@ namespace CubbyFlow
 			{
 				d[i] = 0.0;
 			}
-		});
+		};
+
+		if (!isParallel)
+		{
+			segmentBegins.clear();
+			levelOffsets.clear();
+			levelSegments.clear();
+
+			d.ForEachIndex(factorize);
+			return;
+		}
+
+		const auto isCoupledWithPreviousRow = [&](size_t i)
+		{
+			for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj)
+			{
+				if (ci[jj] + 1 == i)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		};
+
+		// The rows are split into segments of consecutive rows where each row
+		// couples with the previous one; for the FDM matrices these are runs
+		// of cells along x within one grid row. The i - 1 coupling thus stays
+		// inside a segment, and the level of a segment is one more than the
+		// max level of the lower segments it depends on, which gives
+		// wavefronts over the grid rows instead of chaining each segment to
+		// the previous one. Since the matrix is symmetric, the upper segments
+		// of a segment are on the higher levels.
+		std::vector<size_t> rowLevels(size, 0);
+		std::vector<size_t> segmentLevels;
+		size_t numberOfLevels = 0;
+
+		segmentBegins.clear();
+		for (size_t rowBegin = 0; rowBegin < size;)
+		{
+			size_t rowEnd = rowBegin + 1;
+			while (rowEnd < size && rowEnd - rowBegin < LEVEL_SEGMENT_SIZE && isCoupledWithPreviousRow(rowEnd))
+			{
+				++rowEnd;
+			}
+
+			size_t level = 0;
+			for (size_t jj = rp[rowBegin]; jj < rp[rowEnd]; ++jj)
+			{
+				if (ci[jj] < rowBegin)
+				{
+					level = std::max(level, rowLevels[ci[jj]] + 1);
+				}
+			}
+
+			std::fill(rowLevels.begin() + rowBegin, rowLevels.begin() + rowEnd, level);
+			segmentBegins.push_back(rowBegin);
+			segmentLevels.push_back(level);
+			numberOfLevels = std::max(numberOfLevels, level + 1);
+
+			rowBegin = rowEnd;
+		}
+		segmentBegins.push_back(size);
+
+		const size_t numberOfSegments = segmentLevels.size();
+
+		levelOffsets.assign(numberOfLevels + 1, 0);
+		for (size_t level : segmentLevels)
+		{
+			++levelOffsets[level + 1];
+		}
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			levelOffsets[l + 1] += levelOffsets[l];
+		}
+
+		levelSegments.resize(numberOfSegments);
+		std::vector<size_t> cursors(levelOffsets.begin(), levelOffsets.end() - 1);
+		for (size_t s = 0; s < numberOfSegments; ++s)
+		{
+			levelSegments[cursors[segmentLevels[s]]++] = s;
+		}
+
+		ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, false, factorize);
 	}
 
 	void FDMICCGSolver2::PreconditionerCompressed::Solve(const VectorND& b, VectorND* x)
@@ -118,7 +321,7 @@ namespace CubbyFlow
 		const auto ci = A->ColumnIndicesBegin();
 		const auto nnz = A->NonZeroBegin();
 
-		b.ForEachIndex([&](size_t i)
+		const auto forwardSubstitute = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -135,9 +338,9 @@ namespace CubbyFlow
 			}
 
 			y[i] = sum * d[i];
-		});
+		};
 
-		for (ssize_t i = size - 1; i >= 0; --i)
+		const auto backSubstitute = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -145,7 +348,7 @@ namespace CubbyFlow
 			double sum = y[i];
 			for (size_t jj = rowBegin; jj < rowEnd; ++jj)
 			{
-				const ssize_t j = static_cast<ssize_t>(ci[jj]);
+				size_t j = ci[jj];
 
 				if (j > i)
 				{
@@ -154,6 +357,20 @@ namespace CubbyFlow
 			}
 
 			(*x)[i] = sum * d[i];
+		};
+
+		if (isParallel)
+		{
+			ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, false, forwardSubstitute);
+			ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, true, backSubstitute);
+			return;
+		}
+
+		b.ForEachIndex(forwardSubstitute);
+
+		for (ssize_t i = size - 1; i >= 0; --i)
+		{
+			backSubstitute(i);
 		}
 	}
 
@@ -189,6 +406,7 @@ namespace CubbyFlow
 		m_q.Set(0.0);
 		m_s.Set(0.0);
 
+		m_precond.isParallel = m_isUsingParallelPreconditioner;
 		m_precond.Build(matrix);
 		
 		PCG<FDMBLAS2, Preconditioner>(matrix, rhs, m_maxNumberOfIterations, m_tolerance, &m_precond, &solution,
@@ -220,6 +438,7 @@ namespace CubbyFlow
 		m_qComp.Set(0.0);
 		m_sComp.Set(0.0);
 
+		m_precondComp.isParallel = m_isUsingParallelPreconditioner;
 		m_precondComp.Build(matrix);
 
 		PCG<FDMCompressedBLAS2, PreconditionerCompressed>(
@@ -252,6 +471,16 @@ namespace CubbyFlow
 		return m_lastResidualNorm;
 	}
 
+	void FDMICCGSolver2::SetIsUsingParallelPreconditioner(bool isUsing)
+	{
+		m_isUsingParallelPreconditioner = isUsing;
+	}
+
+	bool FDMICCGSolver2::GetIsUsingParallelPreconditioner() const
+	{
+		return m_isUsingParallelPreconditioner;
+	}
+
 	void FDMICCGSolver2::ClearUncompressedVectors()
 	{
 		m_r.Clear();
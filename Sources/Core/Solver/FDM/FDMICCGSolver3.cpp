@@ -9,53 +9,172 @@
 *************************************************************************/
 #include <Core/Math/CG.h>
 #include <Core/Solver/FDM/FDMICCGSolver3.h>
+#include <Core/Solver/FDM/FDMIterativeRefinement3.h>
 #include <Core/Utils/Logging.h>
+#include <Core/Utils/Parallel.h>
+
+#include <algorithm>
 
 namespace CubbyFlow
 {
-	void FDMICCGSolver3::Preconditioner::Build(const FDMMatrix3& matrix)
+	// Max number of consecutive rows visited in order by one task of the
+	// level-scheduled compressed sweeps. The j + k wavefronts already expose
+	// the parallelism, so the segments usually span whole grid rows.
+	static const size_t LEVEL_SEGMENT_SIZE = 256;
+
+	// Visits the x-rows of cells wavefront by wavefront along j + k. The cells
+	// of a row are visited in order, and the lower (upper) neighbors of a row
+	// in y and z are on the previous (next) wavefront, so the rows of a
+	// wavefront are independent in the triangular sweeps.
+	template <typename Function>
+	static void ForEachIndexInWavefronts(const Size3& size, bool isReversed, const Function& function)
+	{
+		if (size.x == 0 || size.y == 0 || size.z == 0)
+		{
+			return;
+		}
+
+		const size_t numberOfLevels = size.y + size.z - 1;
+
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			const size_t level = isReversed ? numberOfLevels - 1 - l : l;
+			const size_t kBegin = (level > size.y - 1) ? level - (size.y - 1) : 0;
+			const size_t kEnd = std::min(size.z, level + 1);
+
+			ParallelFor(kBegin, kEnd, [&](size_t k)
+			{
+				const size_t j = level - k;
+
+				if (isReversed)
+				{
+					for (size_t i = size.x; i-- > 0;)
+					{
+						function(i, j, k);
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < size.x; ++i)
+					{
+						function(i, j, k);
+					}
+				}
+			});
+		}
+	}
+
+	// Visits the segments of rows level by level, and the rows of a segment
+	// in order. A segment only depends on the lower (upper) segments of the
+	// previous (next) levels.
+	template <typename Function>
+	static void ForEachRowInLevels(
+		const std::vector<size_t>& segmentBegins, const std::vector<size_t>& levelOffsets,
+		const std::vector<size_t>& levelSegments, bool isReversed, const Function& function)
+	{
+		const size_t numberOfLevels = levelOffsets.size() - 1;
+
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			const size_t level = isReversed ? numberOfLevels - 1 - l : l;
+
+			ParallelFor(levelOffsets[level], levelOffsets[level + 1], [&](size_t s)
+			{
+				const size_t segment = levelSegments[s];
+				const size_t rowBegin = segmentBegins[segment];
+				const size_t rowEnd = segmentBegins[segment + 1];
+
+				if (isReversed)
+				{
+					for (size_t i = rowEnd; i-- > rowBegin;)
+					{
+						function(i);
+					}
+				}
+				else
+				{
+					for (size_t i = rowBegin; i < rowEnd; ++i)
+					{
+						function(i);
+					}
+				}
+			});
+		}
+	}
+
+	template <typename T, typename MatrixType>
+	void FDMICCGSolver3::Preconditioner<T, MatrixType>::Build(const MatrixType& matrix)
 	{
 		const Size3 size = matrix.size();
-		A = matrix.ConstAccessor();
+		A = matrix;
 
-		d.Resize(size, 0.0);
-		y.Resize(size, 0.0);
+		d.Resize(size, T(0));
+		y.Resize(size, T(0));
 
-		matrix.ForEachIndex([&](size_t i, size_t j, size_t k)
+		const auto factorize = [&](size_t i, size_t j, size_t k)
 		{
-			double denom =
+			T denom =
 				matrix(i, j, k).center -
-				((i > 0) ? Square(matrix(i - 1, j, k).right) * d(i - 1, j, k) : 0.0) -
-				((j > 0) ? Square(matrix(i, j - 1, k).up)    * d(i, j - 1, k) : 0.0) -
-				((k > 0) ? Square(matrix(i, j, k - 1).front) * d(i, j, k - 1) : 0.0);
+				((i > 0) ? Square(matrix(i - 1, j, k).right) * d(i - 1, j, k) : T(0)) -
+				((j > 0) ? Square(matrix(i, j - 1, k).up)    * d(i, j - 1, k) : T(0)) -
+				((k > 0) ? Square(matrix(i, j, k - 1).front) * d(i, j, k - 1) : T(0));
 
-			if (std::fabs(denom) > 0.0)
+			if (std::fabs(denom) > T(0))
 			{
-				d(i, j, k) = 1.0 / denom;
+				d(i, j, k) = T(1) / denom;
 			}
 			else
 			{
-				d(i, j, k) = 0.0;
+				d(i, j, k) = T(0);
 			}
-		});
+		};
+
+		if (isParallel)
+		{
+			ForEachIndexInWavefronts(size, false, factorize);
+		}
+		else
+		{
+			d.ForEachIndex(factorize);
+		}
 	}
 
-	void FDMICCGSolver3::Preconditioner::Solve(const FDMVector3& b, FDMVector3* x)
+	template <typename T, typename MatrixType>
+	void FDMICCGSolver3::Preconditioner<T, MatrixType>::Solve(const Array3<T>& b, Array3<T>* x)
 	{
 		const Size3 size = b.size();
 		const ssize_t sx = static_cast<ssize_t>(size.x);
 		const ssize_t sy = static_cast<ssize_t>(size.y);
 		const ssize_t sz = static_cast<ssize_t>(size.z);
 
-		b.ForEachIndex([&](size_t i, size_t j, size_t k)
+		const auto forwardSubstitute = [&](size_t i, size_t j, size_t k)
 		{
 			y(i, j, k) =
 				(b(i, j, k) -
-				((i > 0) ? A(i - 1, j, k).right * y(i - 1, j, k) : 0.0) -
-				((j > 0) ? A(i, j - 1, k).up    * y(i, j - 1, k) : 0.0) -
-				((k > 0) ? A(i, j, k - 1).front * y(i, j, k - 1) : 0.0)) *
+				((i > 0) ? A(i - 1, j, k).right * y(i - 1, j, k) : T(0)) -
+				((j > 0) ? A(i, j - 1, k).up    * y(i, j - 1, k) : T(0)) -
+				((k > 0) ? A(i, j, k - 1).front * y(i, j, k - 1) : T(0))) *
+				d(i, j, k);
+		};
+
+		const auto backSubstitute = [&](size_t i, size_t j, size_t k)
+		{
+			(*x)(i, j, k) =
+				(y(i, j, k) -
+				((i + 1 < size.x) ? A(i, j, k).right * (*x)(i + 1, j, k) : T(0)) -
+				((j + 1 < size.y) ? A(i, j, k).up    * (*x)(i, j + 1, k) : T(0)) -
+				((k + 1 < size.z) ? A(i, j, k).front * (*x)(i, j, k + 1) : T(0))) *
 				d(i, j, k);
-		});
+		};
+
+		if (isParallel)
+		{
+			ForEachIndexInWavefronts(size, false, forwardSubstitute);
+			ForEachIndexInWavefronts(size, true, backSubstitute);
+			return;
+		}
+
+		b.ForEachIndex(forwardSubstitute);
 
 		for (ssize_t k = sz - 1; k >= 0; --k)
 		{
@@ -63,12 +182,7 @@ namespace CubbyFlow
 			{
 				for (ssize_t i = sx - 1; i >= 0; --i)
 				{
-					(*x)(i, j, k) =
-						(y(i, j, k) -
-						((i + 1 < sx) ? A(i, j, k).right * (*x)(i + 1, j, k) : 0.0) -
-						((j + 1 < sy) ? A(i, j, k).up    * (*x)(i, j + 1, k) : 0.0) -
-						((k + 1 < sz) ? A(i, j, k).front * (*x)(i, j, k + 1) : 0.0)) *
-						d(i, j, k);
+					backSubstitute(i, j, k);
 				}
 			}
 		}
@@ -86,7 +200,7 @@ namespace CubbyFlow
 		const auto ci = A->ColumnIndicesBegin();
 		const auto nnz = A->NonZeroBegin();
 
-		d.ForEachIndex([&](size_t i)
+		const auto factorize = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -114,7 +228,90 @@ namespace CubbyFlow
 			{
 				d[i] = 0.0;
 			}
-		});
+		};
+
+		if (!isParallel)
+		{
+			segmentBegins.clear();
+			levelOffsets.clear();
+			levelSegments.clear();
+
+			d.ForEachIndex(factorize);
+			return;
+		}
+
+		const auto isCoupledWithPreviousRow = [&](size_t i)
+		{
+			for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj)
+			{
+				if (ci[jj] + 1 == i)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		};
+
+		// The rows are split into segments of consecutive rows where each row
+		// couples with the previous one; for the FDM matrices these are runs
+		// of cells along x within one grid row. The i - 1 coupling thus stays
+		// inside a segment, and the level of a segment is one more than the
+		// max level of the lower segments it depends on, which gives
+		// wavefronts over the grid rows instead of chaining each segment to
+		// the previous one. Since the matrix is symmetric, the upper segments
+		// of a segment are on the higher levels.
+		std::vector<size_t> rowLevels(size, 0);
+		std::vector<size_t> segmentLevels;
+		size_t numberOfLevels = 0;
+
+		segmentBegins.clear();
+		for (size_t rowBegin = 0; rowBegin < size;)
+		{
+			size_t rowEnd = rowBegin + 1;
+			while (rowEnd < size && rowEnd - rowBegin < LEVEL_SEGMENT_SIZE && isCoupledWithPreviousRow(rowEnd))
+			{
+				++rowEnd;
+			}
+
+			size_t level = 0;
+			for (size_t jj = rp[rowBegin]; jj < rp[rowEnd]; ++jj)
+			{
+				if (ci[jj] < rowBegin)
+				{
+					level = std::max(level, rowLevels[ci[jj]] + 1);
+				}
+			}
+
+			std::fill(rowLevels.begin() + rowBegin, rowLevels.begin() + rowEnd, level);
+			segmentBegins.push_back(rowBegin);
+			segmentLevels.push_back(level);
+			numberOfLevels = std::max(numberOfLevels, level + 1);
+
+			rowBegin = rowEnd;
+		}
+		segmentBegins.push_back(size);
+
+		const size_t numberOfSegments = segmentLevels.size();
+
+		levelOffsets.assign(numberOfLevels + 1, 0);
+		for (size_t level : segmentLevels)
+		{
+			++levelOffsets[level + 1];
+		}
+		for (size_t l = 0; l < numberOfLevels; ++l)
+		{
+			levelOffsets[l + 1] += levelOffsets[l];
+		}
+
+		levelSegments.resize(numberOfSegments);
+		std::vector<size_t> cursors(levelOffsets.begin(), levelOffsets.end() - 1);
+		for (size_t s = 0; s < numberOfSegments; ++s)
+		{
+			levelSegments[cursors[segmentLevels[s]]++] = s;
+		}
+
+		ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, false, factorize);
 	}
 
 	void FDMICCGSolver3::PreconditionerCompressed::Solve(const VectorND& b, VectorND* x)
@@ -125,7 +322,7 @@ namespace CubbyFlow
 		const auto ci = A->ColumnIndicesBegin();
 		const auto nnz = A->NonZeroBegin();
 
-		b.ForEachIndex([&](size_t i)
+		const auto forwardSubstitute = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -142,9 +339,9 @@ namespace CubbyFlow
 			}
 
 			y[i] = sum * d[i];
-		});
+		};
 
-		for (ssize_t i = size - 1; i >= 0; --i)
+		const auto backSubstitute = [&](size_t i)
 		{
 			const size_t rowBegin = rp[i];
 			const size_t rowEnd = rp[i + 1];
@@ -152,7 +349,7 @@ namespace CubbyFlow
 			double sum = y[i];
 			for (size_t jj = rowBegin; jj < rowEnd; ++jj)
 			{
-				const ssize_t j = static_cast<ssize_t>(ci[jj]);
+				size_t j = ci[jj];
 
 				if (j > i)
 				{
@@ -161,6 +358,20 @@ namespace CubbyFlow
 			}
 
 			(*x)[i] = sum * d[i];
+		};
+
+		if (isParallel)
+		{
+			ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, false, forwardSubstitute);
+			ForEachRowInLevels(segmentBegins, levelOffsets, levelSegments, true, backSubstitute);
+			return;
+		}
+
+		b.ForEachIndex(forwardSubstitute);
+
+		for (ssize_t i = size - 1; i >= 0; --i)
+		{
+			backSubstitute(i);
 		}
 	}
 
@@ -175,10 +386,16 @@ namespace CubbyFlow
 
 	bool FDMICCGSolver3::Solve(FDMLinearSystem3* system)
 	{
+		if (m_precision != FDMPrecision::Double)
+		{
+			return SolveSinglePrecision(system);
+		}
+
 		FDMMatrix3& matrix = system->A;
 		FDMVector3& solution = system->x;
 		FDMVector3& rhs = system->b;
 
+		ClearSinglePrecisionVectors();
 		ClearCompressedVectors();
 
 		assert(matrix.size() == rhs.size());
@@ -196,9 +413,10 @@ namespace CubbyFlow
 		m_q.Set(0.0);
 		m_s.Set(0.0);
 
-		m_precond.Build(matrix);
+		m_precond.isParallel = m_isUsingParallelPreconditioner;
+		m_precond.Build(matrix.ConstAccessor());
 
-		PCG<FDMBLAS3, Preconditioner>(matrix, rhs, m_maxNumberOfIterations, m_tolerance, &m_precond, &solution,
+		PCG<FDMBLAS3, Preconditioner<double, ConstArrayAccessor3<FDMMatrixRow3>>>(matrix, rhs, m_maxNumberOfIterations, m_tolerance, &m_precond, &solution,
 			&m_r, &m_d, &m_q, &m_s, &m_lastNumberOfIterations, &m_lastResidualNorm);
 
 		CUBBYFLOW_INFO << "Residual norm after solving ICCG: " << m_lastResidualNorm
@@ -214,6 +432,7 @@ namespace CubbyFlow
 		VectorND& rhs = system->b;
 
 		ClearUncompressedVectors();
+		ClearSinglePrecisionVectors();
 
 		const size_t size = solution.size();
 		m_rComp.Resize(size);
@@ -227,6 +446,7 @@ namespace CubbyFlow
 		m_qComp.Set(0.0);
 		m_sComp.Set(0.0);
 
+		m_precondComp.isParallel = m_isUsingParallelPreconditioner;
 		m_precondComp.Build(matrix);
 
 		PCG<FDMCompressedBLAS3, PreconditionerCompressed>(
@@ -239,6 +459,43 @@ namespace CubbyFlow
 		return (m_lastResidualNorm <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
 	}
 
+	bool FDMICCGSolver3::SolveMatrixFree(FDMMatrixFreeLinearSystem3* system)
+	{
+		FDMMatrixFree3& matrix = system->A;
+		FDMVector3& solution = system->x;
+		FDMVector3& rhs = system->b;
+
+		ClearSinglePrecisionVectors();
+		ClearCompressedVectors();
+
+		assert(matrix.size() == rhs.size());
+		assert(matrix.size() == solution.size());
+
+		const Size3 size = matrix.size();
+		m_r.Resize(size);
+		m_d.Resize(size);
+		m_q.Resize(size);
+		m_s.Resize(size);
+
+		system->x.Set(0.0);
+		m_r.Set(0.0);
+		m_d.Set(0.0);
+		m_q.Set(0.0);
+		m_s.Set(0.0);
+
+		m_precondMatrixFree.isParallel = m_isUsingParallelPreconditioner;
+		m_precondMatrixFree.Build(matrix);
+
+		PCG<FDMMatrixFreeBLAS3, Preconditioner<double, FDMMatrixFree3>>(
+			matrix, rhs, m_maxNumberOfIterations, m_tolerance, &m_precondMatrixFree, &solution,
+			&m_r, &m_d, &m_q, &m_s, &m_lastNumberOfIterations, &m_lastResidualNorm);
+
+		CUBBYFLOW_INFO << "Residual norm after solving ICCG: " << m_lastResidualNorm
+			<< " Number of ICCG iterations: " << m_lastNumberOfIterations;
+
+		return (m_lastResidualNorm <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
+	}
+
 	unsigned int FDMICCGSolver3::GetMaxNumberOfIterations() const
 	{
 		return m_maxNumberOfIterations;
@@ -259,6 +516,66 @@ namespace CubbyFlow
 		return m_lastResidualNorm;
 	}
 
+	void FDMICCGSolver3::SetIsUsingParallelPreconditioner(bool isUsing)
+	{
+		m_isUsingParallelPreconditioner = isUsing;
+	}
+
+	bool FDMICCGSolver3::GetIsUsingParallelPreconditioner() const
+	{
+		return m_isUsingParallelPreconditioner;
+	}
+
+	void FDMICCGSolver3::SetPrecision(FDMPrecision precision)
+	{
+		m_precision = precision;
+	}
+
+	FDMPrecision FDMICCGSolver3::GetPrecision() const
+	{
+		return m_precision;
+	}
+
+	bool FDMICCGSolver3::SolveSinglePrecision(FDMLinearSystem3* system)
+	{
+		FDMMatrix3& matrix = system->A;
+		FDMVector3& solution = system->x;
+		FDMVector3& rhs = system->b;
+
+		assert(matrix.size() == rhs.size());
+		assert(matrix.size() == solution.size());
+
+		ClearUncompressedVectors();
+		ClearCompressedVectors();
+
+		const Size3 size = matrix.size();
+		FDMBLAS3F::Set(matrix, &m_AF);
+		m_xF.Resize(size);
+		m_bF.Resize(size);
+		m_rF.Resize(size);
+		m_dF.Resize(size);
+		m_qF.Resize(size);
+		m_sF.Resize(size);
+
+		m_precondF.isParallel = m_isUsingParallelPreconditioner;
+		m_precondF.Build(m_AF.ConstAccessor());
+
+		FDMIterativeRefinement3(matrix, rhs, m_precision, m_maxNumberOfIterations, m_tolerance,
+			[&](unsigned int maxNumberOfIterations, double tolerance, unsigned int* numberOfIterations)
+		{
+			double residualNorm = 0.0;
+
+			PCG<FDMBLAS3F, Preconditioner<float, ConstArrayAccessor3<FDMMatrixRow3F>>>(
+				m_AF, m_bF, maxNumberOfIterations, tolerance, &m_precondF,
+				&m_xF, &m_rF, &m_dF, &m_qF, &m_sF, numberOfIterations, &residualNorm);
+		}, &m_bF, &m_xF, &solution, &m_lastNumberOfIterations, &m_lastResidualNorm);
+
+		CUBBYFLOW_INFO << "Residual norm after solving ICCG: " << m_lastResidualNorm
+			<< " Number of ICCG iterations: " << m_lastNumberOfIterations;
+
+		return (m_lastResidualNorm <= m_tolerance) || (m_lastNumberOfIterations < m_maxNumberOfIterations);
+	}
+
 	void FDMICCGSolver3::ClearUncompressedVectors()
 	{
 		m_r.Clear();
@@ -267,6 +584,20 @@ namespace CubbyFlow
 		m_s.Clear();
 	}
 
+	void FDMICCGSolver3::ClearSinglePrecisionVectors()
+	{
+		m_AF.Clear();
+		m_xF.Clear();
+		m_bF.Clear();
+		m_rF.Clear();
+		m_dF.Clear();
+		m_qF.Clear();
+		m_sF.Clear();
+		m_precondF.d.Clear();
+		m_precondF.y.Clear();
+		m_precondF.A = ConstArrayAccessor3<FDMMatrixRow3F>();
+	}
+
 	void FDMICCGSolver3::ClearCompressedVectors()
 	{
 		m_r.Clear();
@@ -13,9 +13,11 @@
 
 namespace CubbyFlow
 {
-	const char FLUID = 0;
-	const char AIR = 1;
-	const char BOUNDARY = 2;
+	// The markers are defined once by the matrix-free operator, which
+	// derives the system rows from them.
+	const char FLUID = FDMMatrixFree3::FLUID;
+	const char AIR = FDMMatrixFree3::AIR;
+	const char BOUNDARY = FDMMatrixFree3::BOUNDARY;
 
 	const double DEFAULT_TOLERANCE = 1e-6;
 
@@ -91,6 +93,23 @@ namespace CubbyFlow
 			});
 		}
 
+		void BuildSingleSystem(FDMMatrixFree3* A, FDMVector3* b,
+			const Array3<char>& markers,
+			const FaceCenteredGrid3& input)
+		{
+			const Vector3D invH = 1.0 / input.GridSpacing();
+
+			// The rows are derived from the markers by FDMMatrixFree3, which
+			// uses the same marker values as this solver.
+			A->markers = markers.ConstAccessor();
+			A->invHSqr = invH * invH;
+
+			b->ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+			{
+				(*b)(i, j, k) = (markers(i, j, k) == FLUID) ? input.DivergenceAtCellCenter(i, j, k) : 0.0;
+			});
+		}
+
 		void BuildSingleSystem(MatrixCSRD* A, VectorND* x, VectorND* b,
 			const Array3<char>& markers,
 			const FaceCenteredGrid3& input)
@@ -242,12 +261,24 @@ namespace CubbyFlow
 				if (useCompressed)
 				{
 					m_system.Clear();
+					m_matrixFreeSystem.Clear();
 					m_systemSolver->SolveCompressed(&m_compSystem);
 					DecompressSolution();
 				}
+				else if (m_isUsingMatrixFree)
+				{
+					m_system.Clear();
+					m_compSystem.Clear();
+					m_systemSolver->SolveMatrixFree(&m_matrixFreeSystem);
+
+					// Moves the solution so that the pressure is found at the
+					// same place for all the systems
+					m_system.x.Swap(m_matrixFreeSystem.x);
+				}
 				else
 				{
 					m_compSystem.Clear();
+					m_matrixFreeSystem.Clear();
 					m_systemSolver->Solve(&m_system);
 				}
 			}
@@ -286,6 +317,7 @@ namespace CubbyFlow
 			// In case of mg system, use multi-level structure.
 			m_system.Clear();
 			m_compSystem.Clear();
+			m_matrixFreeSystem.Clear();
 		}
 	}
 
@@ -299,6 +331,16 @@ namespace CubbyFlow
 		return m_mgSystem.x.levels.front();
 	}
 
+	void GridSinglePhasePressureSolver3::SetIsUsingMatrixFree(bool isUsing)
+	{
+		m_isUsingMatrixFree = isUsing;
+	}
+
+	bool GridSinglePhasePressureSolver3::GetIsUsingMatrixFree() const
+	{
+		return m_isUsingMatrixFree;
+	}
+
 	void GridSinglePhasePressureSolver3::BuildMarkers(
 		const Size3& size,
 		const std::function<Vector3D(size_t, size_t, size_t)>& pos,
@@ -422,7 +464,11 @@ namespace CubbyFlow
 
 		if (m_mgSystemSolver == nullptr)
 		{
-			if (!useCompressed)
+			if (!useCompressed && m_isUsingMatrixFree)
+			{
+				m_matrixFreeSystem.Resize(size);
+			}
+			else if (!useCompressed)
 			{
 				m_system.Resize(size);
 			}
@@ -446,6 +492,10 @@ namespace CubbyFlow
 			{
 				BuildSingleSystem(&m_compSystem.A, &m_compSystem.x, &m_compSystem.b, m_markers[0], *finer);
 			}
+			else if (m_isUsingMatrixFree)
+			{
+				BuildSingleSystem(&m_matrixFreeSystem.A, &m_matrixFreeSystem.b, m_markers[0], *finer);
+			}
 			else
 			{
 				BuildSingleSystem(&m_system.A, &m_system.b, m_markers[0], *finer);
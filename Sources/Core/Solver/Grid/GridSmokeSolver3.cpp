@@ -11,6 +11,9 @@
 
 namespace CubbyFlow
 {
+	// Size of the blocks of cells scanned for smoke in the buoyancy step
+	static const size_t BUOYANCY_BLOCK_SIZE = 8;
+
 	GridSmokeSolver3::GridSmokeSolver3() :
 		GridSmokeSolver3({ 1, 1, 1 }, { 1, 1, 1 }, { 0, 0, 0 })
 	{
@@ -183,6 +186,76 @@ namespace CubbyFlow
 
 			tAmb /= static_cast<double>(temp->Resolution().x * temp->Resolution().y * temp->Resolution().z);
 
+			// Smoke usually fills a small part of the domain, so the cells are
+			// scanned in blocks to find the ones holding smoke. The faces which
+			// only sample the cells of empty blocks get the ambient buoyancy
+			// without sampling.
+			const Size3 res = temp->Resolution();
+			const Size3 blockGridSize(
+				(res.x + BUOYANCY_BLOCK_SIZE - 1) / BUOYANCY_BLOCK_SIZE,
+				(res.y + BUOYANCY_BLOCK_SIZE - 1) / BUOYANCY_BLOCK_SIZE,
+				(res.z + BUOYANCY_BLOCK_SIZE - 1) / BUOYANCY_BLOCK_SIZE);
+			const auto denData = den->GetConstDataAccessor();
+			const auto tempData = temp->GetConstDataAccessor();
+
+			Array3<char> hasSmoke(blockGridSize, 0);
+			hasSmoke.ParallelForEachIndex([&](size_t bi, size_t bj, size_t bk)
+			{
+				const size_t iEnd = std::min(res.x, (bi + 1) * BUOYANCY_BLOCK_SIZE);
+				const size_t jEnd = std::min(res.y, (bj + 1) * BUOYANCY_BLOCK_SIZE);
+				const size_t kEnd = std::min(res.z, (bk + 1) * BUOYANCY_BLOCK_SIZE);
+
+				for (size_t k = bk * BUOYANCY_BLOCK_SIZE; k < kEnd; ++k)
+				{
+					for (size_t j = bj * BUOYANCY_BLOCK_SIZE; j < jEnd; ++j)
+					{
+						for (size_t i = bi * BUOYANCY_BLOCK_SIZE; i < iEnd; ++i)
+						{
+							if (denData(i, j, k) != 0.0 || tempData(i, j, k) != 0.0)
+							{
+								hasSmoke(bi, bj, bk) = 1;
+								return;
+							}
+						}
+					}
+				}
+			});
+
+			// A face samples the cells within one cell from its index, so the
+			// neighbors of the blocks holding smoke are marked as well.
+			Array3<char> isNearSmoke(blockGridSize, 0);
+			isNearSmoke.ParallelForEachIndex([&](size_t bi, size_t bj, size_t bk)
+			{
+				for (size_t nk = (bk > 0 ? bk - 1 : 0); nk <= std::min(bk + 1, blockGridSize.z - 1); ++nk)
+				{
+					for (size_t nj = (bj > 0 ? bj - 1 : 0); nj <= std::min(bj + 1, blockGridSize.y - 1); ++nj)
+					{
+						for (size_t ni = (bi > 0 ? bi - 1 : 0); ni <= std::min(bi + 1, blockGridSize.x - 1); ++ni)
+						{
+							if (hasSmoke(ni, nj, nk))
+							{
+								isNearSmoke(bi, bj, bk) = 1;
+								return;
+							}
+						}
+					}
+				}
+			});
+
+			const auto buoyancy = [&](size_t i, size_t j, size_t k, const Vector3D& pt)
+			{
+				if (!isNearSmoke(
+					std::min(i, res.x - 1) / BUOYANCY_BLOCK_SIZE,
+					std::min(j, res.y - 1) / BUOYANCY_BLOCK_SIZE,
+					std::min(k, res.z - 1) / BUOYANCY_BLOCK_SIZE))
+				{
+					return -m_buoyancyTemperatureFactor * tAmb;
+				}
+
+				return m_buoyancySmokeDensityFactor * den->Sample(pt) +
+					m_buoyancyTemperatureFactor * (temp->Sample(pt) - tAmb);
+			};
+
 			auto u = vel->GetUAccessor();
 			auto v = vel->GetVAccessor();
 			auto w = vel->GetWAccessor();
@@ -194,10 +267,7 @@ namespace CubbyFlow
 			{
 				vel->ParallelForEachUIndex([&](size_t i, size_t j, size_t k)
 				{
-					Vector3D pt = uPos(i, j, k);
-					double fBuoy =
-						m_buoyancySmokeDensityFactor * den->Sample(pt) +
-						m_buoyancyTemperatureFactor * (temp->Sample(pt) - tAmb);
+					double fBuoy = buoyancy(i, j, k, uPos(i, j, k));
 					u(i, j, k) += timeIntervalInSeconds * fBuoy * up.x;
 				});
 			}
@@ -206,10 +276,7 @@ namespace CubbyFlow
 			{
 				vel->ParallelForEachVIndex([&](size_t i, size_t j, size_t k)
 				{
-					Vector3D pt = vPos(i, j, k);
-					double fBuoy =
-						m_buoyancySmokeDensityFactor * den->Sample(pt) +
-						m_buoyancyTemperatureFactor * (temp->Sample(pt) - tAmb);
+					double fBuoy = buoyancy(i, j, k, vPos(i, j, k));
 					v(i, j, k) += timeIntervalInSeconds * fBuoy * up.y;
 				});
 			}
@@ -218,10 +285,7 @@ namespace CubbyFlow
 			{
 				vel->ParallelForEachWIndex([&](size_t i, size_t j, size_t k)
 				{
-					Vector3D pt = wPos(i, j, k);
-					double fBuoy =
-						m_buoyancySmokeDensityFactor * den->Sample(pt) +
-						m_buoyancyTemperatureFactor * (temp->Sample(pt) - tAmb);
+					double fBuoy = buoyancy(i, j, k, wPos(i, j, k));
 					w(i, j, k) += timeIntervalInSeconds * fBuoy * up.z;
 				});
 			}
@@ -67,39 +67,72 @@ namespace CubbyFlow
             flow->GridSpacing(),
             flow->GetVOrigin());
 
-        for (size_t i = 0; i < numberOfParticles; ++i)
+        auto uPosClamped = [&](size_t i)
+        {
+            auto pos = positions[i];
+            pos.y = std::clamp(pos.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
+            return pos;
+        };
+        auto vPosClamped = [&](size_t i)
+        {
+            auto pos = positions[i];
+            pos.x = std::clamp(pos.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
+            return pos;
+        };
+
+        // Particles are bucketed by the y-index of their stencil, which only
+        // spans two rows, so the scatter is race-free and deterministic.
+        ParallelScatter(numberOfParticles, u.size().y, [&](size_t i)
         {
             std::array<Point2UI, 4> indices;
             std::array<double, 4> weights;
 
-            auto uPosClamped = positions[i];
-            uPosClamped.y = std::clamp(uPosClamped.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
-            uSampler.GetCoordinatesAndWeights(uPosClamped, &indices, &weights);
+            uSampler.GetCoordinatesAndWeights(uPosClamped(i), &indices, &weights);
+            return indices[0].y;
+        }, [&](size_t i)
+        {
+            std::array<Point2UI, 4> indices;
+            std::array<double, 4> weights;
+
+            const auto pos = uPosClamped(i);
+            uSampler.GetCoordinatesAndWeights(pos, &indices, &weights);
 
             for (int j = 0; j < 4; ++j)
             {
                 Vector2D gridPos = uPos(indices[j].x, indices[j].y);
-                double apicTerm = m_cX[i].Dot(gridPos - uPosClamped);
+                double apicTerm = m_cX[i].Dot(gridPos - pos);
 
                 u(indices[j]) += weights[j] * (velocities[i].x + apicTerm);
                 uWeight(indices[j]) += weights[j];
                 m_uMarkers(indices[j]) = 1;
             }
+        });
 
-            auto vPosClamped = positions[i];
-            vPosClamped.x = std::clamp(vPosClamped.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
-            vSampler.GetCoordinatesAndWeights(vPosClamped, &indices, &weights);
+        ParallelScatter(numberOfParticles, v.size().y, [&](size_t i)
+        {
+            std::array<Point2UI, 4> indices;
+            std::array<double, 4> weights;
+
+            vSampler.GetCoordinatesAndWeights(vPosClamped(i), &indices, &weights);
+            return indices[0].y;
+        }, [&](size_t i)
+        {
+            std::array<Point2UI, 4> indices;
+            std::array<double, 4> weights;
+
+            const auto pos = vPosClamped(i);
+            vSampler.GetCoordinatesAndWeights(pos, &indices, &weights);
 
             for (int j = 0; j < 4; ++j)
             {
                 Vector2D gridPos = vPos(indices[j].x, indices[j].y);
-                double apicTerm = m_cY[i].Dot(gridPos - vPosClamped);
+                double apicTerm = m_cY[i].Dot(gridPos - pos);
 
                 v(indices[j]) += weights[j] * (velocities[i].y + apicTerm);
                 vWeight(indices[j]) += weights[j];
                 m_vMarkers(indices[j]) = 1;
             }
-        }
+        });
 
         uWeight.ParallelForEachIndex([&](size_t i, size_t j)
         {
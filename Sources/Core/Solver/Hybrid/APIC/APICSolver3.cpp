@@ -77,56 +77,107 @@ namespace CubbyFlow
             flow->GridSpacing(),
             flow->GetWOrigin());
 
-        for (size_t i = 0; i < numberOfParticles; ++i)
+        auto uPosClamped = [&](size_t i)
+        {
+            auto pos = positions[i];
+            pos.y = std::clamp(pos.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
+            pos.z = std::clamp(pos.z, bbox.lowerCorner.z + hh.z, bbox.upperCorner.z - hh.z);
+            return pos;
+        };
+        auto vPosClamped = [&](size_t i)
+        {
+            auto pos = positions[i];
+            pos.x = std::clamp(pos.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
+            pos.z = std::clamp(pos.z, bbox.lowerCorner.z + hh.z, bbox.upperCorner.z - hh.z);
+            return pos;
+        };
+        auto wPosClamped = [&](size_t i)
+        {
+            auto pos = positions[i];
+            pos.x = std::clamp(pos.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
+            pos.y = std::clamp(pos.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
+            return pos;
+        };
+
+        // Particles are bucketed by the z-index of their stencil, which only
+        // spans two z-layers, so the scatter is race-free and deterministic.
+        ParallelScatter(numberOfParticles, u.size().z, [&](size_t i)
         {
             std::array<Point3UI, 8> indices;
             std::array<double, 8> weights;
 
-            auto uPosClamped = positions[i];
-            uPosClamped.y = std::clamp(uPosClamped.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
-            uPosClamped.z = std::clamp(uPosClamped.z, bbox.lowerCorner.z + hh.z, bbox.upperCorner.z - hh.z);
-            uSampler.GetCoordinatesAndWeights(uPosClamped, &indices, &weights);
-            
+            uSampler.GetCoordinatesAndWeights(uPosClamped(i), &indices, &weights);
+            return indices[0].z;
+        }, [&](size_t i)
+        {
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+
+            const auto pos = uPosClamped(i);
+            uSampler.GetCoordinatesAndWeights(pos, &indices, &weights);
+
             for (int j = 0; j < 8; ++j)
             {
                 Vector3D gridPos = uPos(indices[j].x, indices[j].y, indices[j].z);
-                double apicTerm = m_cX[i].Dot(gridPos - uPosClamped);
-                
+                double apicTerm = m_cX[i].Dot(gridPos - pos);
+
                 u(indices[j]) += weights[j] * (velocities[i].x + apicTerm);
                 uWeight(indices[j]) += weights[j];
                 m_uMarkers(indices[j]) = 1;
             }
+        });
+
+        ParallelScatter(numberOfParticles, v.size().z, [&](size_t i)
+        {
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+
+            vSampler.GetCoordinatesAndWeights(vPosClamped(i), &indices, &weights);
+            return indices[0].z;
+        }, [&](size_t i)
+        {
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+
+            const auto pos = vPosClamped(i);
+            vSampler.GetCoordinatesAndWeights(pos, &indices, &weights);
 
-            auto vPosClamped = positions[i];
-            vPosClamped.x = std::clamp(vPosClamped.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
-            vPosClamped.z = std::clamp(vPosClamped.z, bbox.lowerCorner.z + hh.z, bbox.upperCorner.z - hh.z);
-            vSampler.GetCoordinatesAndWeights(vPosClamped, &indices, &weights);
-            
             for (int j = 0; j < 8; ++j)
             {
                 Vector3D gridPos = vPos(indices[j].x, indices[j].y, indices[j].z);
-                double apicTerm = m_cY[i].Dot(gridPos - vPosClamped);
-                
+                double apicTerm = m_cY[i].Dot(gridPos - pos);
+
                 v(indices[j]) += weights[j] * (velocities[i].y + apicTerm);
                 vWeight(indices[j]) += weights[j];
                 m_vMarkers(indices[j]) = 1;
             }
+        });
+
+        ParallelScatter(numberOfParticles, w.size().z, [&](size_t i)
+        {
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+
+            wSampler.GetCoordinatesAndWeights(wPosClamped(i), &indices, &weights);
+            return indices[0].z;
+        }, [&](size_t i)
+        {
+            std::array<Point3UI, 8> indices;
+            std::array<double, 8> weights;
+
+            const auto pos = wPosClamped(i);
+            wSampler.GetCoordinatesAndWeights(pos, &indices, &weights);
 
-            auto wPosClamped = positions[i];
-            wPosClamped.x = std::clamp(wPosClamped.x, bbox.lowerCorner.x + hh.x, bbox.upperCorner.x - hh.x);
-            wPosClamped.y = std::clamp(wPosClamped.y, bbox.lowerCorner.y + hh.y, bbox.upperCorner.y - hh.y);
-            wSampler.GetCoordinatesAndWeights(wPosClamped, &indices, &weights);
-            
             for (int j = 0; j < 8; ++j)
             {
                 Vector3D gridPos = wPos(indices[j].x, indices[j].y, indices[j].z);
-                double apicTerm = m_cZ[i].Dot(gridPos - wPosClamped);
+                double apicTerm = m_cZ[i].Dot(gridPos - pos);
 
                 w(indices[j]) += weights[j] * (velocities[i].z + apicTerm);
                 wWeight(indices[j]) += weights[j];
                 m_wMarkers(indices[j]) = 1;
             }
-        }
+        });
 
         uWeight.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
         {
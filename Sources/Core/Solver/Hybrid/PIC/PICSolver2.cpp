@@ -8,6 +8,7 @@
 *************************************************************************/
 #include <Core/Array/ArrayUtils.h>
 #include <Core/Grid/CellCenteredScalarGrid2.h>
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
 #include <Core/Solver/Hybrid/PIC/PICSolver2.h>
 #include <Core/Utils/Logging.h>
 #include <Core/Utils/Timer.h>
@@ -147,7 +148,17 @@ namespace CubbyFlow
 			flow->GetVConstAccessor(),
 			flow->GridSpacing(),
 			flow->GetVOrigin());
-		for (size_t i = 0; i < numberOfParticles; ++i)
+
+		// Particles are bucketed by the y-index of their stencil, which only
+		// spans two rows, so the scatter is race-free and deterministic.
+		ParallelScatter(numberOfParticles, u.size().y, [&](size_t i)
+		{
+			std::array<Point2UI, 4> indices;
+			std::array<double, 4> weights;
+
+			uSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			return indices[0].y;
+		}, [&](size_t i)
 		{
 			std::array<Point2UI, 4> indices;
 			std::array<double, 4> weights;
@@ -159,6 +170,19 @@ namespace CubbyFlow
 				uWeight(indices[j]) += weights[j];
 				m_uMarkers(indices[j]) = 1;
 			}
+		});
+
+		ParallelScatter(numberOfParticles, v.size().y, [&](size_t i)
+		{
+			std::array<Point2UI, 4> indices;
+			std::array<double, 4> weights;
+
+			vSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			return indices[0].y;
+		}, [&](size_t i)
+		{
+			std::array<Point2UI, 4> indices;
+			std::array<double, 4> weights;
 
 			vSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
 			for (int j = 0; j < 4; ++j)
@@ -167,7 +191,7 @@ namespace CubbyFlow
 				vWeight(indices[j]) += weights[j];
 				m_vMarkers(indices[j]) = 1;
 			}
-		}
+		});
 
 		uWeight.ParallelForEachIndex([&](size_t i, size_t j)
 		{
@@ -259,7 +283,7 @@ namespace CubbyFlow
 			ParallelFor(ZERO_SIZE, numberOfParticles, [&](size_t i)
 			{
 				col->ResolveCollision(0.0, 0.0, &positions[i], &velocities[i]);
-			});
+			}, PartitionPolicy{ PartitionMode::Guided });
 		}
 	}
 
@@ -283,16 +307,25 @@ namespace CubbyFlow
 
 		m_particles->BuildNeighborSearcher(2 * radius);
 		auto searcher = m_particles->GetNeighborSearcher();
-		sdf->ParallelForEachDataPointIndex([&](size_t i, size_t j)
+		Size2 sdfSize = sdf->GetDataSize();
+
+		// Resolve the searcher type once so the queries below are inlined.
+		VisitPointNeighborSearcher(*searcher, [&](const auto& neighborSearcher)
 		{
-			Vector2D pt = sdfPos(i, j);
-			double minDist = 2.0 * radius;
-			
-			searcher->ForEachNearbyPoint(pt, 2.0 * radius, [&](size_t, const Vector2D& x)
+			// The cost per cell depends on the number of nearby particles, so
+			// rows are handed out on demand.
+			ParallelFor(ZERO_SIZE, sdfSize.x, ZERO_SIZE, sdfSize.y,
+				[&](size_t i, size_t j)
 			{
-				minDist = std::min(minDist, pt.DistanceTo(x));
-			});
-			(*sdf)(i, j) = minDist - radius;
+				Vector2D pt = sdfPos(i, j);
+				double minDist = 2.0 * radius;
+			
+				neighborSearcher.ForEachNearbyPoint(pt, 2.0 * radius, [&](size_t, const Vector2D& x)
+				{
+					minDist = std::min(minDist, pt.DistanceTo(x));
+				});
+				(*sdf)(i, j) = minDist - radius;
+			}, PartitionPolicy{ PartitionMode::Dynamic });
 		});
 
 		ExtrapolateIntoCollider(sdf.get());
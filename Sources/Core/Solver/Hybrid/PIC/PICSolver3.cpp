@@ -8,6 +8,7 @@
 *************************************************************************/
 #include <Core/Array/ArrayUtils.h>
 #include <Core/Grid/CellCenteredScalarGrid3.h>
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
 #include <Core/Solver/Hybrid/PIC/PICSolver3.h>
 #include <Core/Utils/Logging.h>
 #include <Core/Utils/Timer.h>
@@ -158,7 +159,17 @@ namespace CubbyFlow
 			flow->GetWConstAccessor(),
 			flow->GridSpacing(),
 			flow->GetWOrigin());
-		for (size_t i = 0; i < numberOfParticles; ++i)
+
+		// Particles are bucketed by the z-index of their stencil, which only
+		// spans two z-layers, so the scatter is race-free and deterministic.
+		ParallelScatter(numberOfParticles, u.size().z, [&](size_t i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
+
+			uSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			return indices[0].z;
+		}, [&](size_t i)
 		{
 			std::array<Point3UI, 8> indices;
 			std::array<double, 8> weights;
@@ -170,6 +181,19 @@ namespace CubbyFlow
 				uWeight(indices[j]) += weights[j];
 				m_uMarkers(indices[j]) = 1;
 			}
+		});
+
+		ParallelScatter(numberOfParticles, v.size().z, [&](size_t i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
+
+			vSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			return indices[0].z;
+		}, [&](size_t i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
 
 			vSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
 			for (int j = 0; j < 8; ++j)
@@ -178,6 +202,19 @@ namespace CubbyFlow
 				vWeight(indices[j]) += weights[j];
 				m_vMarkers(indices[j]) = 1;
 			}
+		});
+
+		ParallelScatter(numberOfParticles, w.size().z, [&](size_t i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
+
+			wSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			return indices[0].z;
+		}, [&](size_t i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
 
 			wSampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
 			for (int j = 0; j < 8; ++j)
@@ -186,7 +223,7 @@ namespace CubbyFlow
 				wWeight(indices[j]) += weights[j];
 				m_wMarkers(indices[j]) = 1;
 			}
-		}
+		});
 
 		uWeight.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
 		{
@@ -292,10 +329,7 @@ namespace CubbyFlow
 		Collider3Ptr col = GetCollider();
 		if (col != nullptr)
 		{
-			ParallelFor(ZERO_SIZE, numberOfParticles, [&](size_t i)
-			{
-				col->ResolveCollision(0.0, 0.0, &positions[i], &velocities[i]);
-			});
+			col->ResolveCollisions(0.0, 0.0, positions, velocities);
 		}
 	}
 
@@ -322,16 +356,25 @@ namespace CubbyFlow
 
 		m_particles->BuildNeighborSearcher(2 * radius);
 		auto searcher = m_particles->GetNeighborSearcher();
-		sdf->ParallelForEachDataPointIndex([&](size_t i, size_t j, size_t k)
-		{
-			Vector3D pt = sdfPos(i, j, k);
-			double minDist = sdfBandRadius;
+		Size3 sdfSize = sdf->GetDataSize();
 
-			searcher->ForEachNearbyPoint(pt, sdfBandRadius, [&](size_t, const Vector3D& x)
+		// Resolve the searcher type once so the queries below are inlined.
+		VisitPointNeighborSearcher(*searcher, [&](const auto& neighborSearcher)
+		{
+			// The cost per cell depends on the number of nearby particles, so
+			// slices are handed out on demand.
+			ParallelFor(ZERO_SIZE, sdfSize.x, ZERO_SIZE, sdfSize.y, ZERO_SIZE, sdfSize.z,
+				[&](size_t i, size_t j, size_t k)
 			{
-				minDist = std::min(minDist, pt.DistanceTo(x));
-			});
-			(*sdf)(i, j, k) = minDist - radius;
+				Vector3D pt = sdfPos(i, j, k);
+				double minDist = sdfBandRadius;
+
+				neighborSearcher.ForEachNearbyPoint(pt, sdfBandRadius, [&](size_t, const Vector3D& x)
+				{
+					minDist = std::min(minDist, pt.DistanceTo(x));
+				});
+				(*sdf)(i, j, k) = minDist - radius;
+			}, PartitionPolicy{ PartitionMode::Dynamic });
 		});
 
 		ExtrapolateIntoCollider(sdf.get());
@@ -0,0 +1,694 @@
+/*************************************************************************
+> File Name: FastSweepingLevelSetSolver3.cpp
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Three-dimensional parallel fast sweeping method implementation.
+> Created Time: 2018/06/18
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#include <Core/FDM/FDMUtils.h>
+#include <Core/LevelSet/LevelSetUtils.h>
+#include <Core/Solver/LevelSet/FastSweepingLevelSetSolver3.h>
+#include <Core/Utils/Logging.h>
+#include <Core/Utils/Parallel.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace CubbyFlow
+{
+	static const double UNKNOWN_DISTANCE = std::numeric_limits<double>::max();
+
+	// The grid is swept in blocks of BLOCK_SIZE^3 cells. The blocks far from
+	// the surface are skipped.
+	static const size_t BLOCK_SIZE = 8;
+
+	// Returns the blocks which contain a cell satisfying the predicate.
+	template <typename Predicate>
+	static Array3<char> MarkBlocks(const Size3& size, const Predicate& predicate)
+	{
+		Array3<char> blocks(
+			(size.x + BLOCK_SIZE - 1) / BLOCK_SIZE,
+			(size.y + BLOCK_SIZE - 1) / BLOCK_SIZE,
+			(size.z + BLOCK_SIZE - 1) / BLOCK_SIZE, 0);
+
+		blocks.ParallelForEachIndex([&](size_t bi, size_t bj, size_t bk)
+		{
+			for (size_t k = bk * BLOCK_SIZE; k < std::min((bk + 1) * BLOCK_SIZE, size.z); ++k)
+			{
+				for (size_t j = bj * BLOCK_SIZE; j < std::min((bj + 1) * BLOCK_SIZE, size.y); ++j)
+				{
+					for (size_t i = bi * BLOCK_SIZE; i < std::min((bi + 1) * BLOCK_SIZE, size.x); ++i)
+					{
+						if (predicate(i, j, k))
+						{
+							blocks(bi, bj, bk) = 1;
+							return;
+						}
+					}
+				}
+			}
+		});
+
+		return blocks;
+	}
+
+	// Marks the blocks within radius blocks of a marked block along each axis.
+	static void DilateBlocks(size_t radius, Array3<char>* blocks)
+	{
+		const Size3 size = blocks->size();
+		Array3<char> temp(size);
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const size_t n = size[axis];
+
+			temp.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+			{
+				const size_t idx[3] = { i, j, k };
+				const size_t begin = idx[axis] > radius ? idx[axis] - radius : 0;
+				const size_t end = std::min(idx[axis] + radius + 1, n);
+
+				size_t neighbor[3] = { i, j, k };
+				char marked = 0;
+
+				for (neighbor[axis] = begin; neighbor[axis] < end && !marked; ++neighbor[axis])
+				{
+					marked = (*blocks)(neighbor[0], neighbor[1], neighbor[2]);
+				}
+
+				temp(i, j, k) = marked;
+			});
+
+			blocks->Swap(temp);
+		}
+	}
+
+	// Sweeps the marked blocks in the eight diagonal directions and calls
+	// update(i, j, k) for each cell in the upwind order of each direction. A
+	// block only shares faces with the blocks on the previous and the next
+	// block planes I + J + K = const, so the blocks on the same plane are
+	// updated in parallel, and the result does not depend on the number of
+	// threads. Returns true if any call of update returned true.
+	template <typename Function>
+	static bool FastSweep(const Size3& size, const Array3<char>& activeBlocks, const Function& update)
+	{
+		const Size3 numberOfBlocks = activeBlocks.size();
+
+		std::vector<Point3UI> blocks;
+		activeBlocks.ForEachIndex([&](size_t bi, size_t bj, size_t bk)
+		{
+			if (activeBlocks(bi, bj, bk))
+			{
+				blocks.emplace_back(bi, bj, bk);
+			}
+		});
+
+		if (blocks.empty())
+		{
+			return false;
+		}
+
+		const size_t numberOfPlanes = numberOfBlocks.x + numberOfBlocks.y + numberOfBlocks.z - 2;
+
+		std::vector<size_t> planeOffsets(numberOfPlanes + 1);
+		std::vector<size_t> order(blocks.size());
+
+		// One flag per block, so the blocks never write to the same flag.
+		std::vector<char> changed(blocks.size(), 0);
+
+		for (int dir = 0; dir < 8; ++dir)
+		{
+			const bool flipX = (dir & 1) != 0;
+			const bool flipY = (dir & 2) != 0;
+			const bool flipZ = (dir & 4) != 0;
+
+			auto planeOf = [&](const Point3UI& block)
+			{
+				return (flipX ? numberOfBlocks.x - 1 - block.x : block.x) +
+					(flipY ? numberOfBlocks.y - 1 - block.y : block.y) +
+					(flipZ ? numberOfBlocks.z - 1 - block.z : block.z);
+			};
+
+			// Sorts the blocks by plane
+			std::fill(planeOffsets.begin(), planeOffsets.end(), 0);
+
+			for (const Point3UI& block : blocks)
+			{
+				++planeOffsets[planeOf(block) + 1];
+			}
+
+			for (size_t plane = 0; plane < numberOfPlanes; ++plane)
+			{
+				planeOffsets[plane + 1] += planeOffsets[plane];
+			}
+
+			std::vector<size_t> cursor(planeOffsets.begin(), planeOffsets.end() - 1);
+
+			for (size_t b = 0; b < blocks.size(); ++b)
+			{
+				order[cursor[planeOf(blocks[b])]++] = b;
+			}
+
+			for (size_t plane = 0; plane < numberOfPlanes; ++plane)
+			{
+				ParallelFor(planeOffsets[plane], planeOffsets[plane + 1], [&](size_t n)
+				{
+					const size_t b = order[n];
+					const Point3UI& block = blocks[b];
+
+					const size_t iBegin = block.x * BLOCK_SIZE;
+					const size_t jBegin = block.y * BLOCK_SIZE;
+					const size_t kBegin = block.z * BLOCK_SIZE;
+					const size_t iEnd = std::min(iBegin + BLOCK_SIZE, size.x);
+					const size_t jEnd = std::min(jBegin + BLOCK_SIZE, size.y);
+					const size_t kEnd = std::min(kBegin + BLOCK_SIZE, size.z);
+
+					bool isChanged = false;
+
+					for (size_t kk = kBegin; kk < kEnd; ++kk)
+					{
+						const size_t k = flipZ ? kBegin + kEnd - 1 - kk : kk;
+
+						for (size_t jj = jBegin; jj < jEnd; ++jj)
+						{
+							const size_t j = flipY ? jBegin + jEnd - 1 - jj : jj;
+
+							for (size_t ii = iBegin; ii < iEnd; ++ii)
+							{
+								const size_t i = flipX ? iBegin + iEnd - 1 - ii : ii;
+
+								isChanged |= update(i, j, k);
+							}
+						}
+					}
+
+					if (isChanged)
+					{
+						changed[b] = 1;
+					}
+				});
+			}
+		}
+
+		return std::find(changed.begin(), changed.end(), 1) != changed.end();
+	}
+
+	// Solves the first-order upwind discretization of |grad(phi)| = 1 with the
+	// smallest neighbor value of each axis.
+	static double SolveEikonal(
+		double phiX, double phiY, double phiZ,
+		const Vector3D& gridSpacing)
+	{
+		double phi[3] = { phiX, phiY, phiZ };
+		double h[3] = { gridSpacing.x, gridSpacing.y, gridSpacing.z };
+
+		// Sorts the neighbors in ascending order
+		auto sortPair = [&](int p, int q)
+		{
+			if (phi[q] < phi[p])
+			{
+				std::swap(phi[p], phi[q]);
+				std::swap(h[p], h[q]);
+			}
+		};
+
+		sortPair(0, 1);
+		sortPair(1, 2);
+		sortPair(0, 1);
+
+		double solution = phi[0] + h[0];
+
+		double a = 0.0;
+		double b = 0.0;
+		double c = -1.0;
+
+		for (int n = 0; n < 3; ++n)
+		{
+			// The larger neighbors are not upwind of the solution.
+			if (phi[n] == UNKNOWN_DISTANCE || solution <= phi[n])
+			{
+				break;
+			}
+
+			const double invHSqr = 1.0 / Square(h[n]);
+
+			a += invHSqr;
+			b += phi[n] * invHSqr;
+			c += Square(phi[n]) * invHSqr;
+
+			const double det = b * b - a * c;
+
+			if (det > 0.0)
+			{
+				solution = (b + std::sqrt(det)) / a;
+			}
+		}
+
+		return solution;
+	}
+
+	FastSweepingLevelSetSolver3::FastSweepingLevelSetSolver3()
+	{
+		// Do nothing
+	}
+
+	void FastSweepingLevelSetSolver3::Reinitialize(
+		const ScalarGrid3& inputSDF,
+		double maxDistance,
+		ScalarGrid3* outputSDF)
+	{
+		if (!inputSDF.HasSameShape(*outputSDF))
+		{
+			throw std::invalid_argument("inputSDF and outputSDF have not same shape.");
+		}
+
+		const Size3 size = inputSDF.GetDataSize();
+		const Vector3D gridSpacing = inputSDF.GridSpacing();
+
+		auto input = inputSDF.GetConstDataAccessor();
+		auto output = outputSDF->GetDataAccessor();
+
+		// Unsigned distance to the surface. The cells next to the surface are
+		// solved geometrically and frozen, so both sides are swept at once.
+		Array3<double> distance(size, UNKNOWN_DISTANCE);
+		Array3<char> frozen(size, 0);
+
+		distance.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			const double phi = input(i, j, k);
+			const bool isInside = IsInsideSDF(phi);
+
+			auto distanceToSurface = [&](double phiNeighbor, double h, double* dist)
+			{
+				if (IsInsideSDF(phiNeighbor) != isInside)
+				{
+					*dist = std::min(*dist, h * std::abs(phi) / (std::abs(phi) + std::abs(phiNeighbor)));
+				}
+			};
+
+			double distX = UNKNOWN_DISTANCE;
+			double distY = UNKNOWN_DISTANCE;
+			double distZ = UNKNOWN_DISTANCE;
+
+			if (i > 0)
+			{
+				distanceToSurface(input(i - 1, j, k), gridSpacing.x, &distX);
+			}
+			if (i + 1 < size.x)
+			{
+				distanceToSurface(input(i + 1, j, k), gridSpacing.x, &distX);
+			}
+			if (j > 0)
+			{
+				distanceToSurface(input(i, j - 1, k), gridSpacing.y, &distY);
+			}
+			if (j + 1 < size.y)
+			{
+				distanceToSurface(input(i, j + 1, k), gridSpacing.y, &distY);
+			}
+			if (k > 0)
+			{
+				distanceToSurface(input(i, j, k - 1), gridSpacing.z, &distZ);
+			}
+			if (k + 1 < size.z)
+			{
+				distanceToSurface(input(i, j, k + 1), gridSpacing.z, &distZ);
+			}
+
+			if (distX == UNKNOWN_DISTANCE && distY == UNKNOWN_DISTANCE && distZ == UNKNOWN_DISTANCE)
+			{
+				return;
+			}
+
+			if (distX == 0.0 || distY == 0.0 || distZ == 0.0)
+			{
+				distance(i, j, k) = 0.0;
+			}
+			else
+			{
+				double denomSqr = 0.0;
+
+				for (double dist : { distX, distY, distZ })
+				{
+					if (dist != UNKNOWN_DISTANCE)
+					{
+						denomSqr += 1.0 / Square(dist);
+					}
+				}
+
+				distance(i, j, k) = 1.0 / std::sqrt(denomSqr);
+			}
+
+			frozen(i, j, k) = 1;
+		});
+
+		// The sweeps stop when no cell decreases by more than the tolerance.
+		// The first-order discretization error is O(h), so the last tiny
+		// corrections, which take one more pass to detect, are not needed.
+		const double tolerance = 1e-6 * gridSpacing.Min();
+
+		// The sweeps read the arrays through raw pointers, so the compiler
+		// does not reload the array sizes after each write.
+		const char* frozenData = frozen.data();
+		double* distanceData = distance.data();
+		const size_t strideY = size.x;
+		const size_t strideZ = size.x * size.y;
+
+		auto update = [=](size_t i, size_t j, size_t k)
+		{
+			const size_t idx = i + strideY * j + strideZ * k;
+
+			if (frozenData[idx])
+			{
+				return false;
+			}
+
+			const double phiX = std::min(
+				i > 0 ? distanceData[idx - 1] : UNKNOWN_DISTANCE,
+				i + 1 < size.x ? distanceData[idx + 1] : UNKNOWN_DISTANCE);
+			const double phiY = std::min(
+				j > 0 ? distanceData[idx - strideY] : UNKNOWN_DISTANCE,
+				j + 1 < size.y ? distanceData[idx + strideY] : UNKNOWN_DISTANCE);
+			const double phiZ = std::min(
+				k > 0 ? distanceData[idx - strideZ] : UNKNOWN_DISTANCE,
+				k + 1 < size.z ? distanceData[idx + strideZ] : UNKNOWN_DISTANCE);
+
+			// The cells farther than maxDistance are not written to the output,
+			// and they never become upwind of the cells within maxDistance.
+			if (phiX >= maxDistance && phiY >= maxDistance && phiZ >= maxDistance)
+			{
+				return false;
+			}
+
+			const double solution = SolveEikonal(phiX, phiY, phiZ, gridSpacing);
+			const double oldDistance = distanceData[idx];
+
+			if (solution < oldDistance)
+			{
+				distanceData[idx] = solution;
+			}
+
+			return solution < oldDistance - tolerance;
+		};
+
+		// A cell n cells away from the surface along each axis is at least
+		// n * h / sqrt(3) away in the discrete solution, so the blocks beyond
+		// that range from the surface never reach maxDistance.
+		Array3<char> activeBlocks = MarkBlocks(size, [&](size_t i, size_t j, size_t k)
+		{
+			return frozen(i, j, k) != 0;
+		});
+
+		const double maxCells = std::ceil(std::sqrt(3.0) * maxDistance / gridSpacing.Min()) + 1.0;
+		const size_t maxBlocks = activeBlocks.size().x + activeBlocks.size().y + activeBlocks.size().z;
+		const size_t radius = maxCells < static_cast<double>(maxBlocks * BLOCK_SIZE) ?
+			static_cast<size_t>(maxCells) / BLOCK_SIZE + 1 : maxBlocks;
+
+		DilateBlocks(radius, &activeBlocks);
+
+		unsigned int iteration = 0;
+
+		while (iteration < m_maxNumberOfIterations && FastSweep(size, activeBlocks, update))
+		{
+			++iteration;
+		}
+
+		CUBBYFLOW_INFO << "Reinitialized with " << iteration << " sweep passes";
+
+		distance.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			const double phi = input(i, j, k);
+
+			if (distance(i, j, k) <= maxDistance)
+			{
+				output(i, j, k) = IsInsideSDF(phi) ? -distance(i, j, k) : distance(i, j, k);
+			}
+			else
+			{
+				output(i, j, k) = phi;
+			}
+		});
+	}
+
+	void FastSweepingLevelSetSolver3::Extrapolate(
+		const ScalarGrid3& input,
+		const ScalarField3& sdf,
+		double maxDistance,
+		ScalarGrid3* output)
+	{
+		if (!input.HasSameShape(*output))
+		{
+			throw std::invalid_argument("input and output have not same shape.");
+		}
+
+		Array3<double> sdfGrid(input.GetDataSize());
+		auto pos = input.GetDataPosition();
+		sdfGrid.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			sdfGrid(i, j, k) = sdf.Sample(pos(i, j, k));
+		});
+
+		Extrapolate(
+			input.GetConstDataAccessor(),
+			sdfGrid.ConstAccessor(),
+			input.GridSpacing(),
+			maxDistance,
+			output->GetDataAccessor());
+	}
+
+	void FastSweepingLevelSetSolver3::Extrapolate(
+		const CollocatedVectorGrid3& input,
+		const ScalarField3& sdf,
+		double maxDistance,
+		CollocatedVectorGrid3* output)
+	{
+		if (!input.HasSameShape(*output))
+		{
+			throw std::invalid_argument("input and output have not same shape.");
+		}
+
+		Array3<double> sdfGrid(input.GetDataSize());
+		auto pos = input.GetDataPosition();
+		sdfGrid.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			sdfGrid(i, j, k) = sdf.Sample(pos(i, j, k));
+		});
+
+		const Vector3D gridSpacing = input.GridSpacing();
+
+		Array3<double> u(input.GetDataSize());
+		Array3<double> u0(input.GetDataSize());
+		Array3<double> v(input.GetDataSize());
+		Array3<double> v0(input.GetDataSize());
+		Array3<double> w(input.GetDataSize());
+		Array3<double> w0(input.GetDataSize());
+
+		input.ParallelForEachDataPointIndex([&](size_t i, size_t j, size_t k)
+		{
+			u(i, j, k) = input(i, j, k).x;
+			v(i, j, k) = input(i, j, k).y;
+			w(i, j, k) = input(i, j, k).z;
+		});
+
+		Extrapolate(u, sdfGrid.ConstAccessor(), gridSpacing, maxDistance, u0);
+		Extrapolate(v, sdfGrid.ConstAccessor(), gridSpacing, maxDistance, v0);
+		Extrapolate(w, sdfGrid.ConstAccessor(), gridSpacing, maxDistance, w0);
+
+		output->ParallelForEachDataPointIndex([&](size_t i, size_t j, size_t k)
+		{
+			(*output)(i, j, k).x = u0(i, j, k);
+			(*output)(i, j, k).y = v0(i, j, k);
+			(*output)(i, j, k).z = w0(i, j, k);
+		});
+	}
+
+	void FastSweepingLevelSetSolver3::Extrapolate(
+		const FaceCenteredGrid3& input,
+		const ScalarField3& sdf,
+		double maxDistance,
+		FaceCenteredGrid3* output)
+	{
+		if (!input.HasSameShape(*output))
+		{
+			throw std::invalid_argument("inputSDF and outputSDF have not same shape.");
+		}
+
+		const Vector3D gridSpacing = input.GridSpacing();
+
+		auto u = input.GetUConstAccessor();
+		auto uPos = input.GetUPosition();
+		Array3<double> sdfAtU(u.size());
+		input.ParallelForEachUIndex([&](size_t i, size_t j, size_t k)
+		{
+			sdfAtU(i, j, k) = sdf.Sample(uPos(i, j, k));
+		});
+
+		Extrapolate(u, sdfAtU, gridSpacing, maxDistance, output->GetUAccessor());
+
+		auto v = input.GetVConstAccessor();
+		auto vPos = input.GetVPosition();
+		Array3<double> sdfAtV(v.size());
+		input.ParallelForEachVIndex([&](size_t i, size_t j, size_t k)
+		{
+			sdfAtV(i, j, k) = sdf.Sample(vPos(i, j, k));
+		});
+
+		Extrapolate(v, sdfAtV, gridSpacing, maxDistance, output->GetVAccessor());
+
+		auto w = input.GetWConstAccessor();
+		auto wPos = input.GetWPosition();
+		Array3<double> sdfAtW(w.size());
+		input.ParallelForEachWIndex([&](size_t i, size_t j, size_t k)
+		{
+			sdfAtW(i, j, k) = sdf.Sample(wPos(i, j, k));
+		});
+
+		Extrapolate(w, sdfAtW, gridSpacing, maxDistance, output->GetWAccessor());
+	}
+
+	unsigned int FastSweepingLevelSetSolver3::GetMaxNumberOfIterations() const
+	{
+		return m_maxNumberOfIterations;
+	}
+
+	void FastSweepingLevelSetSolver3::SetMaxNumberOfIterations(unsigned int n)
+	{
+		m_maxNumberOfIterations = n;
+	}
+
+	void FastSweepingLevelSetSolver3::Extrapolate(
+		const ConstArrayAccessor3<double>& input,
+		const ConstArrayAccessor3<double>& sdf,
+		const Vector3D& gridSpacing,
+		double maxDistance,
+		ArrayAccessor3<double> output)
+	{
+		const Size3 size = input.size();
+		const Vector3D invGridSpacing = 1.0 / gridSpacing;
+
+		// The cells inside the surface are known. A cell outside is known once
+		// it has been computed from its known upwind neighbors.
+		Array3<char> known(size, 0);
+		known.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			if (IsInsideSDF(sdf(i, j, k)))
+			{
+				known(i, j, k) = 1;
+			}
+			output(i, j, k) = input(i, j, k);
+		});
+
+		// Same weights as FMMLevelSetSolver3, with the neighbors of the smaller
+		// SDF value as the upwind neighbors.
+		auto update = [&](size_t i, size_t j, size_t k)
+		{
+			const double phi = sdf(i, j, k);
+
+			if (IsInsideSDF(phi) || phi > maxDistance)
+			{
+				return false;
+			}
+
+			Vector3D grad;
+			bool hasGradient = false;
+
+			double sum = 0.0;
+			double count = 0.0;
+
+			auto weightOf = [&](double w)
+			{
+				// If gradient is zero, then just assign 1 to weight
+				return w < std::numeric_limits<double>::epsilon() ? 1.0 : w;
+			};
+
+			auto isUpwind = [&](size_t ni, size_t nj, size_t nk)
+			{
+				if (!known(ni, nj, nk) || sdf(ni, nj, nk) >= phi)
+				{
+					return false;
+				}
+
+				if (!hasGradient)
+				{
+					grad = Gradient3(sdf, gridSpacing, i, j, k).Normalized();
+					hasGradient = true;
+				}
+
+				return true;
+			};
+
+			if (i > 0 && isUpwind(i - 1, j, k))
+			{
+				const double weight = weightOf(std::max(grad.x, 0.0) * invGridSpacing.x);
+				sum += weight * output(i - 1, j, k);
+				count += weight;
+			}
+
+			if (i + 1 < size.x && isUpwind(i + 1, j, k))
+			{
+				const double weight = weightOf(-std::min(grad.x, 0.0) * invGridSpacing.x);
+				sum += weight * output(i + 1, j, k);
+				count += weight;
+			}
+
+			if (j > 0 && isUpwind(i, j - 1, k))
+			{
+				const double weight = weightOf(std::max(grad.y, 0.0) * invGridSpacing.y);
+				sum += weight * output(i, j - 1, k);
+				count += weight;
+			}
+
+			if (j + 1 < size.y && isUpwind(i, j + 1, k))
+			{
+				const double weight = weightOf(-std::min(grad.y, 0.0) * invGridSpacing.y);
+				sum += weight * output(i, j + 1, k);
+				count += weight;
+			}
+
+			if (k > 0 && isUpwind(i, j, k - 1))
+			{
+				const double weight = weightOf(std::max(grad.z, 0.0) * invGridSpacing.z);
+				sum += weight * output(i, j, k - 1);
+				count += weight;
+			}
+
+			if (k + 1 < size.z && isUpwind(i, j, k + 1))
+			{
+				const double weight = weightOf(-std::min(grad.z, 0.0) * invGridSpacing.z);
+				sum += weight * output(i, j, k + 1);
+				count += weight;
+			}
+
+			if (count <= 0.0)
+			{
+				return false;
+			}
+
+			const double value = sum / count;
+
+			if (known(i, j, k) && output(i, j, k) == value)
+			{
+				return false;
+			}
+
+			output(i, j, k) = value;
+			known(i, j, k) = 1;
+
+			return true;
+		};
+
+		const Array3<char> activeBlocks = MarkBlocks(size, [&](size_t i, size_t j, size_t k)
+		{
+			return !IsInsideSDF(sdf(i, j, k)) && sdf(i, j, k) <= maxDistance;
+		});
+
+		unsigned int iteration = 0;
+
+		while (iteration < m_maxNumberOfIterations && FastSweep(size, activeBlocks, update))
+		{
+			++iteration;
+		}
+	}
+}
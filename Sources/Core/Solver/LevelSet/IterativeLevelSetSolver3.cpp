@@ -43,39 +43,46 @@ namespace CubbyFlow
 
 		CopyRange3(inputSDF.GetConstDataAccessor(), size.x, size.y, size.z, &outputAcc);
 
-		Array3<double> temp(size);
-		ArrayAccessor3<double> tempAcc = temp.Accessor();
-
 		CUBBYFLOW_INFO << "Reinitializing with pseudoTimeStep: " << dtau
 			<< " numberOfIterations: " << numberOfIterations;
 
+		if (m_isUsingNarrowBand)
+		{
+			const double bandWidth = maxDistance + NarrowBandMargin(gridSpacing);
+
+			std::vector<Point3UI> band;
+			BuildNarrowBand(inputSDF.GetConstDataAccessor(), -bandWidth, bandWidth, &band);
+
+			CUBBYFLOW_INFO << "Number of cells in the narrow band: " << band.size();
+
+			std::vector<double> values(band.size());
+
+			for (unsigned int n = 0; n < numberOfIterations; ++n)
+			{
+				ParallelFor(ZERO_SIZE, band.size(), [&](size_t b)
+				{
+					const Point3UI& cell = band[b];
+					values[b] = ReinitializeStep(outputAcc, gridSpacing, dtau, cell.x, cell.y, cell.z);
+				});
+
+				ParallelFor(ZERO_SIZE, band.size(), [&](size_t b)
+				{
+					const Point3UI& cell = band[b];
+					outputAcc(cell.x, cell.y, cell.z) = values[b];
+				});
+			}
+
+			return;
+		}
+
+		Array3<double> temp(size);
+		ArrayAccessor3<double> tempAcc = temp.Accessor();
+
 		for (unsigned int n = 0; n < numberOfIterations; ++n)
 		{
 			inputSDF.ParallelForEachDataPointIndex([&](size_t i, size_t j, size_t k)
 			{
-				double s = Sign(outputAcc, gridSpacing, i, j, k);
-
-				std::array<double, 2> dx, dy, dz;
-
-				GetDerivatives(outputAcc, gridSpacing, i, j, k, &dx, &dy, &dz);
-
-				// Explicit Euler step
-				double val = outputAcc(i, j, k) -
-					dtau * std::max(s, 0.0) *
-					(std::sqrt(Square(std::max(dx[0], 0.0)) +
-						Square(std::min(dx[1], 0.0)) +
-						Square(std::max(dy[0], 0.0)) +
-						Square(std::min(dy[1], 0.0)) +
-						Square(std::max(dz[0], 0.0)) +
-						Square(std::min(dz[1], 0.0))) - 1.0) -
-					dtau * std::min(s, 0.0) *
-					(std::sqrt(Square(std::min(dx[0], 0.0)) +
-						Square(std::max(dx[1], 0.0)) +
-						Square(std::min(dy[0], 0.0)) +
-						Square(std::max(dy[1], 0.0)) +
-						Square(std::min(dz[0], 0.0)) +
-						Square(std::max(dz[1], 0.0))) - 1.0);
-				tempAcc(i, j, k) = val;
+				tempAcc(i, j, k) = ReinitializeStep(outputAcc, gridSpacing, dtau, i, j, k);
 			});
 
 			std::swap(tempAcc, outputAcc);
@@ -217,6 +224,33 @@ namespace CubbyFlow
 
 		CopyRange3(input, size.x, size.y, size.z, &outputAcc);
 
+		if (m_isUsingNarrowBand)
+		{
+			// The cells inside the surface keep their values, so the band only
+			// covers the outside.
+			std::vector<Point3UI> band;
+			BuildNarrowBand(sdf, 0.0, maxDistance + NarrowBandMargin(gridSpacing), &band);
+
+			std::vector<double> values(band.size());
+
+			for (unsigned int n = 0; n < numberOfIterations; ++n)
+			{
+				ParallelFor(ZERO_SIZE, band.size(), [&](size_t b)
+				{
+					const Point3UI& cell = band[b];
+					values[b] = ExtrapolateStep(outputAcc, sdf, gridSpacing, dtau, cell.x, cell.y, cell.z);
+				});
+
+				ParallelFor(ZERO_SIZE, band.size(), [&](size_t b)
+				{
+					const Point3UI& cell = band[b];
+					outputAcc(cell.x, cell.y, cell.z) = values[b];
+				});
+			}
+
+			return;
+		}
+
 		Array3<double> temp(size);
 		ArrayAccessor3<double> tempAcc = temp.Accessor();
 
@@ -227,18 +261,7 @@ namespace CubbyFlow
 			{
 				if (sdf(i, j, k) >= 0)
 				{
-					std::array<double, 2> dx, dy, dz;
-					Vector3D grad = Gradient3(sdf, gridSpacing, i, j, k);
-
-					GetDerivatives(outputAcc, gridSpacing, i, j, k, &dx, &dy, &dz);
-
-					tempAcc(i, j, k) = outputAcc(i, j, k) - 
-						dtau * (std::max(grad.x, 0.0) * dx[0] +
-							std::min(grad.x, 0.0) * dx[1] +
-							std::max(grad.y, 0.0) * dy[0] +
-							std::min(grad.y, 0.0) * dy[1] +
-							std::max(grad.z, 0.0) * dz[0] +
-							std::min(grad.z, 0.0) * dz[1]);
+					tempAcc(i, j, k) = ExtrapolateStep(outputAcc, sdf, gridSpacing, dtau, i, j, k);
 				}
 				else
 				{
@@ -262,6 +285,130 @@ namespace CubbyFlow
 		m_maxCFL = std::max(newMaxCFL, 0.0);
 	}
 
+	bool IterativeLevelSetSolver3::GetIsUsingNarrowBand() const
+	{
+		return m_isUsingNarrowBand;
+	}
+
+	void IterativeLevelSetSolver3::SetIsUsingNarrowBand(bool isUsing)
+	{
+		m_isUsingNarrowBand = isUsing;
+	}
+
+	double IterativeLevelSetSolver3::ReinitializeStep(
+		const ConstArrayAccessor3<double>& sdf,
+		const Vector3D& gridSpacing,
+		double dtau,
+		size_t i, size_t j, size_t k) const
+	{
+		double s = Sign(sdf, gridSpacing, i, j, k);
+
+		std::array<double, 2> dx, dy, dz;
+
+		GetDerivatives(sdf, gridSpacing, i, j, k, &dx, &dy, &dz);
+
+		// Explicit Euler step
+		return sdf(i, j, k) -
+			dtau * std::max(s, 0.0) *
+			(std::sqrt(Square(std::max(dx[0], 0.0)) +
+				Square(std::min(dx[1], 0.0)) +
+				Square(std::max(dy[0], 0.0)) +
+				Square(std::min(dy[1], 0.0)) +
+				Square(std::max(dz[0], 0.0)) +
+				Square(std::min(dz[1], 0.0))) - 1.0) -
+			dtau * std::min(s, 0.0) *
+			(std::sqrt(Square(std::min(dx[0], 0.0)) +
+				Square(std::max(dx[1], 0.0)) +
+				Square(std::min(dy[0], 0.0)) +
+				Square(std::max(dy[1], 0.0)) +
+				Square(std::min(dz[0], 0.0)) +
+				Square(std::max(dz[1], 0.0))) - 1.0);
+	}
+
+	double IterativeLevelSetSolver3::ExtrapolateStep(
+		const ConstArrayAccessor3<double>& input,
+		const ConstArrayAccessor3<double>& sdf,
+		const Vector3D& gridSpacing,
+		double dtau,
+		size_t i, size_t j, size_t k) const
+	{
+		std::array<double, 2> dx, dy, dz;
+		Vector3D grad = Gradient3(sdf, gridSpacing, i, j, k);
+
+		GetDerivatives(input, gridSpacing, i, j, k, &dx, &dy, &dz);
+
+		return input(i, j, k) -
+			dtau * (std::max(grad.x, 0.0) * dx[0] +
+				std::min(grad.x, 0.0) * dx[1] +
+				std::max(grad.y, 0.0) * dy[0] +
+				std::min(grad.y, 0.0) * dy[1] +
+				std::max(grad.z, 0.0) * dz[0] +
+				std::min(grad.z, 0.0) * dz[1]);
+	}
+
+	void IterativeLevelSetSolver3::BuildNarrowBand(
+		const ConstArrayAccessor3<double>& sdf,
+		double lower, double upper,
+		std::vector<Point3UI>* band)
+	{
+		const Size3 size = sdf.size();
+
+		// Counts the cells of each z-slice, then fills the slices in parallel
+		// at their offsets, so the band is sorted like the grid.
+		std::vector<size_t> offsets(size.z + 1, 0);
+
+		ParallelFor(ZERO_SIZE, size.z, [&](size_t k)
+		{
+			size_t count = 0;
+
+			for (size_t j = 0; j < size.y; ++j)
+			{
+				for (size_t i = 0; i < size.x; ++i)
+				{
+					const double phi = sdf(i, j, k);
+
+					if (phi >= lower && phi <= upper)
+					{
+						++count;
+					}
+				}
+			}
+
+			offsets[k + 1] = count;
+		});
+
+		for (size_t k = 0; k < size.z; ++k)
+		{
+			offsets[k + 1] += offsets[k];
+		}
+
+		band->resize(offsets[size.z]);
+
+		ParallelFor(ZERO_SIZE, size.z, [&](size_t k)
+		{
+			size_t b = offsets[k];
+
+			for (size_t j = 0; j < size.y; ++j)
+			{
+				for (size_t i = 0; i < size.x; ++i)
+				{
+					const double phi = sdf(i, j, k);
+
+					if (phi >= lower && phi <= upper)
+					{
+						(*band)[b++] = Point3UI(i, j, k);
+					}
+				}
+			}
+		});
+	}
+
+	double IterativeLevelSetSolver3::NarrowBandMargin(const Vector3D& gridSpacing)
+	{
+		// The widest derivative stencil (third-order ENO) reaches three cells.
+		return 3.0 * std::max({ gridSpacing.x, gridSpacing.y, gridSpacing.z });
+	}
+
 	unsigned int IterativeLevelSetSolver3::DistanceToNumberOfIterations(double distance, double dtau)
 	{
 		return static_cast<unsigned int>(std::ceil(distance / dtau));
@@ -31,6 +31,7 @@ namespace CubbyFlow
 		auto grids = GetGridSystemData();
 		m_signedDistanceFieldId = grids->AddAdvectableScalarData(std::make_shared<CellCenteredScalarGrid3::Builder>(), std::numeric_limits<double>::max());
 		m_levelSetSolver = std::make_shared<ENOLevelSetSolver3>();
+		m_velocityExtrapolator = std::make_shared<FMMLevelSetSolver3>();
 	}
 
 	LevelSetLiquidSolver3::~LevelSetLiquidSolver3()
@@ -53,6 +54,16 @@ namespace CubbyFlow
 		m_levelSetSolver = newSolver;
 	}
 
+	LevelSetSolver3Ptr LevelSetLiquidSolver3::GetVelocityExtrapolator() const
+	{
+		return m_velocityExtrapolator;
+	}
+
+	void LevelSetLiquidSolver3::SetVelocityExtrapolator(const LevelSetSolver3Ptr& newExtrapolator)
+	{
+		m_velocityExtrapolator = newExtrapolator;
+	}
+
 	void LevelSetLiquidSolver3::SetMinReinitializeDistance(double distance)
 	{
 		m_minReinitializeDistance = distance;
@@ -211,8 +222,10 @@ namespace CubbyFlow
 
 		CUBBYFLOW_INFO << "Max velocity extrapolation distance: " << maxDist;
 
-		FMMLevelSetSolver3 fmmSolver;
-		fmmSolver.Extrapolate(*vel, *sdf, maxDist, vel.get());
+		if (m_velocityExtrapolator != nullptr)
+		{
+			m_velocityExtrapolator->Extrapolate(*vel, *sdf, maxDist, vel.get());
+		}
 
 		ApplyBoundaryCondition();
 	}
@@ -102,6 +102,17 @@ namespace CubbyFlow
 		m_wind = newWind;
 	}
 
+	size_t ParticleSystemSolver2::GetParticleSortingInterval() const
+	{
+		return m_particleSortingInterval;
+	}
+
+	void ParticleSystemSolver2::SetParticleSortingInterval(size_t newInterval)
+	{
+		m_particleSortingInterval = newInterval;
+		m_numberOfStepsSinceSorting = 0;
+	}
+
 	void ParticleSystemSolver2::OnInitialize()
 	{
 		// When initializing the solver, update the collider and emitter state as
@@ -164,6 +175,14 @@ namespace CubbyFlow
 		CUBBYFLOW_INFO << "Update emitter took "
 			<< timer.DurationInSeconds() << " seconds";
 
+		// Sort particles in memory every few steps
+		if (m_particleSortingInterval > 0 &&
+			++m_numberOfStepsSinceSorting >= m_particleSortingInterval)
+		{
+			m_particleSystemData->SortParticles(2.0 * m_particleSystemData->GetRadius());
+			m_numberOfStepsSinceSorting = 0;
+		}
+
 		// Allocate buffers
 		size_t n = m_particleSystemData->GetNumberOfParticles();
 		m_newPositions.Resize(n);
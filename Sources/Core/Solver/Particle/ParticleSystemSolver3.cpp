@@ -102,6 +102,17 @@ namespace CubbyFlow
 		m_wind = newWind;
 	}
 
+	size_t ParticleSystemSolver3::GetParticleSortingInterval() const
+	{
+		return m_particleSortingInterval;
+	}
+
+	void ParticleSystemSolver3::SetParticleSortingInterval(size_t newInterval)
+	{
+		m_particleSortingInterval = newInterval;
+		m_numberOfStepsSinceSorting = 0;
+	}
+
 	void ParticleSystemSolver3::OnInitialize()
 	{
 		// When initializing the solver, update the collider and emitter state as
@@ -164,6 +175,14 @@ namespace CubbyFlow
 		CUBBYFLOW_INFO << "Update emitter took "
 			<< timer.DurationInSeconds() << " seconds";
 
+		// Sort particles in memory every few steps
+		if (m_particleSortingInterval > 0 &&
+			++m_numberOfStepsSinceSorting >= m_particleSortingInterval)
+		{
+			m_particleSystemData->SortParticles(2.0 * m_particleSystemData->GetRadius());
+			m_numberOfStepsSinceSorting = 0;
+		}
+
 		// Allocate buffers
 		size_t n = m_particleSystemData->GetNumberOfParticles();
 		m_newPositions.Resize(n);
@@ -212,14 +231,11 @@ namespace CubbyFlow
 			size_t numberOfParticles = m_particleSystemData->GetNumberOfParticles();
 			const double radius = m_particleSystemData->GetRadius();
 
-			ParallelFor(ZERO_SIZE, numberOfParticles, [&](size_t i)
-			{
-				m_collider->ResolveCollision(
-					radius,
-					m_restitutionCoefficient,
-					&newPositions[i],
-					&newVelocities[i]);
-			});
+			m_collider->ResolveCollisions(
+				radius,
+				m_restitutionCoefficient,
+				ArrayAccessor1<Vector3D>(numberOfParticles, newPositions.data()),
+				ArrayAccessor1<Vector3D>(numberOfParticles, newVelocities.data()));
 		}
 	}
 
@@ -32,6 +32,12 @@ namespace CubbyFlow
 
 	void SurfaceSet3::UpdateQueryEngine()
 	{
+		for (const auto& surface : m_surfaces)
+		{
+			surface->UpdateQueryEngine();
+		}
+
+		m_bvhBoundsInvalidated = true;
 		BuildBVH();
 	}
 
@@ -151,7 +157,7 @@ namespace CubbyFlow
 
 	void SurfaceSet3::BuildBVH() const
 	{
-		if (m_bvhInvalidated)
+		if (m_bvhInvalidated || m_bvhBoundsInvalidated)
 		{
 			std::vector<BoundingBox3D> bounds(m_surfaces.size());
 			for (size_t i = 0; i < m_surfaces.size(); ++i)
@@ -159,8 +165,17 @@ namespace CubbyFlow
 				bounds[i] = m_surfaces[i]->BoundingBox();
 			}
 
-			m_bvh.Build(m_surfaces, bounds);
+			if (m_bvhInvalidated)
+			{
+				m_bvh.Build(m_surfaces, bounds);
+			}
+			else
+			{
+				m_bvh.Refit(bounds);
+			}
+
 			m_bvhInvalidated = false;
+			m_bvhBoundsInvalidated = false;
 		}
 	}
 
@@ -13,6 +13,8 @@
 #include <tbb/task_scheduler_init.h>
 #elif defined(CUBBYFLOW_TASKING_OPENMP)
 #include <omp.h>
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+#include <Core/Utils/ThreadPool.h>
 #endif
 
 #include <memory>
@@ -38,7 +40,11 @@ namespace CubbyFlow
 		}
 #elif defined(CUBBYFLOW_TASKING_OPENMP)
 		omp_set_num_threads(numThreads);
+#elif defined(CUBBYFLOW_TASKING_CPP11THREAD)
+		// Throws before changing anything if the pool is busy.
+		ThreadPool::GetInstance().Resize(std::max(numThreads, 1u));
 #endif
+
 		MAX_NUMBER_OF_THREADS = std::max(numThreads, 1u);
 	}
 
@@ -0,0 +1,294 @@
+/*************************************************************************
+> File Name: ThreadPool.cpp
+> Project Name: CubbyFlow
+> Author: Chan-Ho Chris Ohk
+> Purpose: Persistent work-stealing thread pool for CubbyFlow.
+> Created Time: 2018/06/04
+> Copyright (c) 2018, Chan-Ho Chris Ohk
+*************************************************************************/
+#include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace CubbyFlow
+{
+	// The pool and the queue owned by the current thread if it is a worker.
+	static thread_local const ThreadPool* s_currentPool = nullptr;
+	static thread_local size_t s_currentQueue = 0;
+
+	// Number of tasks the current thread is executing (nested included).
+	static thread_local size_t s_taskDepth = 0;
+
+	ThreadPool::ThreadPool(unsigned int numThreads)
+	{
+		Start(numThreads);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		Stop();
+	}
+
+	unsigned int ThreadPool::NumberOfThreads() const
+	{
+		return m_numThreads;
+	}
+
+	void ThreadPool::Resize(unsigned int numThreads)
+	{
+		if (std::max(numThreads, 1u) == m_numThreads)
+		{
+			return;
+		}
+
+		if (s_currentPool == this || s_taskDepth > 0)
+		{
+			throw std::logic_error("ThreadPool cannot be resized from inside a task.");
+		}
+
+		if (m_numRunningBatches.load() > 0)
+		{
+			throw std::logic_error("ThreadPool cannot be resized while running tasks.");
+		}
+
+		Stop();
+		Start(numThreads);
+	}
+
+	void ThreadPool::Run(size_t numTasks, const TaskFunc& func)
+	{
+		if (numTasks == 0)
+		{
+			return;
+		}
+
+		// Nothing to distribute; run on the calling thread.
+		if (m_workers.empty() || numTasks == 1)
+		{
+			++s_taskDepth;
+
+			try
+			{
+				for (size_t i = 0; i < numTasks; ++i)
+				{
+					func(i);
+				}
+			}
+			catch (...)
+			{
+				--s_taskDepth;
+				throw;
+			}
+
+			--s_taskDepth;
+			return;
+		}
+
+		TaskGroup group;
+		group.func = &func;
+		group.numRemaining = numTasks;
+
+		const bool isWorker = (s_currentPool == this);
+		const size_t numQueues = m_queues.size();
+
+		++m_numRunningBatches;
+
+		// Keep the first task for the calling thread and queue the others.
+		m_numQueuedTasks += numTasks - 1;
+
+		const size_t firstQueue = m_nextQueue++;
+		for (size_t i = 1; i < numTasks; ++i)
+		{
+			WorkQueue& queue = *m_queues[(firstQueue + i) % numQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(Task{ &group, i });
+		}
+
+		{
+			// Makes sure no worker is between checking its wake-up condition
+			// and going to sleep while we notify.
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCondition.notify_all();
+
+		Execute(Task{ &group, 0 });
+
+		// Help the workers until the whole batch is done.
+		while (group.numRemaining.load(std::memory_order_acquire) > 0)
+		{
+			Task task;
+			if ((isWorker && PopTask(s_currentQueue, &task)) ||
+				StealTask(isWorker ? s_currentQueue : numQueues, &task))
+			{
+				Execute(task);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		--m_numRunningBatches;
+
+		// Every task of the batch has finished, so nobody else touches the
+		// group any more.
+		if (group.exception)
+		{
+			std::rethrow_exception(group.exception);
+		}
+	}
+
+	ThreadPool& ThreadPool::GetInstance()
+	{
+		static ThreadPool pool(GetMaxNumberOfThreads());
+		return pool;
+	}
+
+	void ThreadPool::Start(unsigned int numThreads)
+	{
+		// Follows the same rule as the parallel functions when the number of
+		// hardware threads is unknown.
+		m_numThreads = (numThreads == 0u) ? 8u : numThreads;
+		m_isStopping = false;
+
+		// The calling thread of Run() always takes part, so one thread less.
+		const size_t numWorkers = m_numThreads - 1;
+
+		m_queues.clear();
+		for (size_t i = 0; i < numWorkers; ++i)
+		{
+			m_queues.emplace_back(std::make_unique<WorkQueue>());
+		}
+
+		m_workers.reserve(numWorkers);
+		for (size_t i = 0; i < numWorkers; ++i)
+		{
+			m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+		}
+	}
+
+	void ThreadPool::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_isStopping = true;
+		}
+		m_sleepCondition.notify_all();
+
+		for (std::thread& worker : m_workers)
+		{
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+
+		m_workers.clear();
+		m_queues.clear();
+	}
+
+	void ThreadPool::WorkerLoop(size_t queueIndex)
+	{
+		s_currentPool = this;
+		s_currentQueue = queueIndex;
+
+		while (true)
+		{
+			Task task;
+			if (PopTask(queueIndex, &task) || StealTask(queueIndex, &task))
+			{
+				Execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepCondition.wait(lock, [this]()
+			{
+				return m_isStopping || m_numQueuedTasks.load() > 0;
+			});
+
+			if (m_isStopping && m_numQueuedTasks.load() == 0)
+			{
+				break;
+			}
+		}
+
+		s_currentPool = nullptr;
+	}
+
+	bool ThreadPool::PopTask(size_t queueIndex, Task* task)
+	{
+		WorkQueue& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.tasks.empty())
+		{
+			return false;
+		}
+
+		// Owner takes the most recently pushed task for better locality.
+		*task = queue.tasks.back();
+		queue.tasks.pop_back();
+		--m_numQueuedTasks;
+
+		return true;
+	}
+
+	bool ThreadPool::StealTask(size_t queueIndex, Task* task)
+	{
+		const size_t numQueues = m_queues.size();
+
+		for (size_t i = 1; i <= numQueues; ++i)
+		{
+			const size_t victim = (queueIndex + i) % numQueues;
+			if (victim == queueIndex)
+			{
+				continue;
+			}
+
+			WorkQueue& queue = *m_queues[victim];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (!queue.tasks.empty())
+			{
+				// Thieves take the oldest task from the other end.
+				*task = queue.tasks.front();
+				queue.tasks.pop_front();
+				--m_numQueuedTasks;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::Execute(const Task& task)
+	{
+		TaskGroup* group = task.group;
+
+		++s_taskDepth;
+
+		try
+		{
+			(*group->func)(task.index);
+		}
+		catch (...)
+		{
+			// Keep the first exception; Run() rethrows it after the batch.
+			std::lock_guard<std::mutex> lock(group->exceptionMutex);
+			if (!group->exception)
+			{
+				group->exception = std::current_exception();
+			}
+		}
+
+		--s_taskDepth;
+
+		// The group lives on the stack of the submitting thread, so it must
+		// not be touched after the last decrement.
+		group->numRemaining.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,87 @@
+#include "MemPerfTestsUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <Core/Particle/ParticleSystemData3.h>
+
+#include <random>
+
+using namespace CubbyFlow;
+
+TEST(ParticleSystemData3, NeighborListsMemory)
+{
+    const size_t n = 64;
+    const double spacing = 1.0 / n;
+
+    std::mt19937 rng{ 0 };
+    std::uniform_real_distribution<> d{ -0.25 * spacing, 0.25 * spacing };
+
+    Array1<Vector3D> positions;
+    for (size_t k = 0; k < n; ++k)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                positions.Append(Vector3D(
+                    (i + 0.5) * spacing + d(rng),
+                    (j + 0.5) * spacing + d(rng),
+                    (k + 0.5) * spacing + d(rng)));
+            }
+        }
+    }
+
+    ParticleSystemData3 particles;
+    particles.AddParticles(positions);
+    particles.BuildNeighborSearcher(2.0 * spacing);
+
+    const size_t mem0 = GetCurrentRSS();
+
+    particles.BuildNeighborLists(2.0 * spacing);
+
+    const size_t mem1 = GetCurrentRSS();
+
+    const auto msg1 = MakeReadableByteSize(mem1 - mem0);
+
+    CUBBYFLOW_PRINT_INFO("Neighbor list build (%d-bit CSR) mem. usage: %f %s.\n",
+        static_cast<int>(8 * sizeof(ParticleNeighborIndex)),
+        msg1.first,
+        msg1.second.c_str());
+
+    // RSS cannot tell the layouts apart once freed blocks get reused, so the
+    // footprint of each layout is also computed from its allocations.
+    const auto& neighborLists = particles.GetNeighborLists();
+    const NeighborLists<uint32_t> compactLists(neighborLists.ToNestedLists());
+    const auto nestedLists = neighborLists.ToNestedLists();
+
+    size_t nestedBytes = nestedLists.capacity() * sizeof(std::vector<size_t>);
+    for (const auto& list : nestedLists)
+    {
+        nestedBytes += list.capacity() * sizeof(size_t);
+    }
+
+    const auto CSRBytes = [](const auto& lists)
+    {
+        return lists.Offsets().capacity() * sizeof(size_t)
+            + lists.Indices().capacity() * sizeof(lists.Indices()[0]);
+    };
+
+    const auto msg2 = MakeReadableByteSize(nestedBytes);
+    const auto msg3 = MakeReadableByteSize(CSRBytes(neighborLists));
+    const auto msg4 = MakeReadableByteSize(CSRBytes(compactLists));
+
+    CUBBYFLOW_PRINT_INFO("Nested vector neighbor lists footprint: %f %s in %zu allocations.\n",
+        msg2.first,
+        msg2.second.c_str(),
+        nestedLists.size() + 1);
+    CUBBYFLOW_PRINT_INFO("CSR (%d-bit) neighbor lists footprint: %f %s in 2 allocations.\n",
+        static_cast<int>(8 * sizeof(ParticleNeighborIndex)),
+        msg3.first,
+        msg3.second.c_str());
+    CUBBYFLOW_PRINT_INFO("CSR (32-bit) neighbor lists footprint: %f %s in 2 allocations.\n",
+        msg4.first,
+        msg4.second.c_str());
+
+    EXPECT_EQ(neighborLists.size(), nestedLists.size());
+    EXPECT_EQ(neighborLists.NumberOfNeighbors(), compactLists.NumberOfNeighbors());
+}
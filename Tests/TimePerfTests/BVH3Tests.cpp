@@ -5,6 +5,7 @@
 #include <Core/Geometry/Triangle3.h>
 #include <Core/Geometry/TriangleMesh3.h>
 #include <Core/Ray/Ray3.h>
+#include <Core/Utils/Parallel.h>
 #include <Core/Vector/Vector3.h>
 
 #include <fstream>
@@ -23,6 +24,8 @@ public:
     std::uniform_real_distribution<> dist{ 0.0, 1.0 };
     TriangleMesh3 triMesh;
     CubbyFlow::BVH3<Triangle3> queryEngine;
+    std::vector<Triangle3> triangles;
+    std::vector<BoundingBox3D> bounds;
 
     void SetUp(const ::benchmark::State&)
     {
@@ -34,8 +37,8 @@ public:
             file.close();
         }
 
-        std::vector<Triangle3> triangles;
-        std::vector<BoundingBox3D> bounds;
+        triangles.clear();
+        bounds.clear();
         for (size_t i = 0; i < triMesh.NumberOfTriangles(); ++i)
         {
             auto tri = triMesh.Triangle(i);
@@ -60,14 +63,66 @@ public:
     {
         return tri.Intersects(ray);
     }
+
+    static double ClosestIntersectionFunc(const Triangle3& tri, const Ray3D& ray)
+    {
+        return tri.ClosestIntersection(ray).distance;
+    }
 };
 
+BENCHMARK_DEFINE_F(BVH3, Build)(benchmark::State& state)
+{
+    const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+    CubbyFlow::SetMaxNumberOfThreads(static_cast<unsigned int>(state.range(0)));
+
+    while (state.KeepRunning())
+    {
+        queryEngine.Build(triangles, bounds);
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+
+    CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(BVH3, Build)
+->Unit(benchmark::kMillisecond)
+->UseRealTime()
+->Arg(1)
+->Arg(4)
+->Arg(8);
+
+BENCHMARK_DEFINE_F(BVH3, Refit)(benchmark::State& state)
+{
+    std::vector<BoundingBox3D> movedBounds = bounds;
+    size_t frame = 0;
+
+    while (state.KeepRunning())
+    {
+        // Alternates between two rigidly moved poses
+        const Vector3D offset = (++frame % 2 == 0) ? Vector3D(0.1, 0.0, 0.0) : Vector3D(-0.1, 0.0, 0.0);
+        for (auto& bound : movedBounds)
+        {
+            bound.lowerCorner += offset;
+            bound.upperCorner += offset;
+        }
+
+        queryEngine.Refit(movedBounds);
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK_REGISTER_F(BVH3, Refit)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_DEFINE_F(BVH3, Nearest)(benchmark::State& state)
 {
     while (state.KeepRunning())
     {
         benchmark::DoNotOptimize(queryEngine.GetNearestNeighbor(MakeVec(), DistanceFunc));
     }
+
+    state.SetItemsProcessed(state.iterations());
 }
 
 BENCHMARK_REGISTER_F(BVH3, Nearest);
@@ -78,6 +133,41 @@ BENCHMARK_DEFINE_F(BVH3, RayIntersects)(benchmark::State& state)
     {
         benchmark::DoNotOptimize(queryEngine.IsIntersects(Ray3D(MakeVec(), MakeVec().Normalized()), IntersectsFunc));
     }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BVH3, RayIntersects);
+
+BENCHMARK_DEFINE_F(BVH3, RayClosestIntersection)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(queryEngine.GetClosestIntersection(Ray3D(MakeVec(), MakeVec().Normalized()), ClosestIntersectionFunc));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BVH3, RayClosestIntersection);
+
+BENCHMARK_DEFINE_F(BVH3, BoxIntersects)(benchmark::State& state)
+{
+    const auto overlapsFunc = [](const Triangle3& tri, const BoundingBox3D& box)
+    {
+        return tri.BoundingBox().Overlaps(box);
+    };
+
+    while (state.KeepRunning())
+    {
+        const Vector3D center = MakeVec();
+        BoundingBox3D box(center, center);
+        box.Expand(0.01);
+
+        benchmark::DoNotOptimize(queryEngine.IsIntersects(box, overlapsFunc));
+    }
+
+    state.SetItemsProcessed(state.iterations());
 }
 
-BENCHMARK_REGISTER_F(BVH3, RayIntersects);
\ No newline at end of file
+BENCHMARK_REGISTER_F(BVH3, BoxIntersects);
@@ -3,7 +3,11 @@
 #include <Core/Array/Array3.h>
 #include <Core/FDM/FDMLinearSystem2.h>
 #include <Core/FDM/FDMLinearSystem3.h>
+#include <Core/Math/CG.h>
 #include <Core/Size/Size3.h>
+#include <Core/Solver/FDM/FDMCGSolver3.h>
+#include <Core/Solver/FDM/FDMICCGSolver3.h>
+#include <Core/Utils/Parallel.h>
 
 #include <random>
 
@@ -13,6 +17,9 @@ using CubbyFlow::FDMVector2;
 using CubbyFlow::FDMMatrix3;
 using CubbyFlow::FDMVector3;
 using CubbyFlow::FDMCompressedLinearSystem3;
+using CubbyFlow::FDMLinearSystem3;
+using CubbyFlow::FDMMatrixFree3;
+using CubbyFlow::FDMMatrixFreeLinearSystem3;
 using CubbyFlow::Size3;
 
 class FDMBLAS2 : public ::benchmark::Fixture
@@ -200,4 +207,324 @@ BENCHMARK_DEFINE_F(FDMCompressedBLAS3, MVM)(benchmark::State& state)
     }
 }
 
-BENCHMARK_REGISTER_F(FDMCompressedBLAS3, MVM)->Arg(1 << 4)->Arg(1 << 6)->Arg(1 << 8);
\ No newline at end of file
+BENCHMARK_REGISTER_F(FDMCompressedBLAS3, MVM)->Arg(1 << 4)->Arg(1 << 6)->Arg(1 << 8);
+
+class FDMICCGSolver3 : public ::benchmark::Fixture
+{
+public:
+    FDMLinearSystem3 system;
+    FDMCompressedLinearSystem3 compressedSystem;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto dim = static_cast<size_t>(state.range(0));
+        const Size3 size(dim, dim, dim);
+
+        // Same Poisson problem as FDMCompressedBLAS3::BuildSystem
+        system.Clear();
+        system.Resize(size);
+
+        system.A.ForEachIndex([&](size_t i, size_t j, size_t k)
+        {
+            auto& row = system.A(i, j, k);
+            double& bijk = system.b(i, j, k);
+
+            if (i > 0)
+            {
+                row.center += 1.0;
+            }
+            if (i < size.x - 1)
+            {
+                row.center += 1.0;
+                row.right -= 1.0;
+            }
+
+            if (j > 0)
+            {
+                row.center += 1.0;
+            }
+            else
+            {
+                bijk += 1.0;
+            }
+
+            if (j < size.y - 1)
+            {
+                row.center += 1.0;
+                row.up -= 1.0;
+            }
+            else
+            {
+                bijk -= 1.0;
+            }
+
+            if (k > 0)
+            {
+                row.center += 1.0;
+            }
+            else
+            {
+                bijk += 1.0;
+            }
+
+            if (k < size.z - 1)
+            {
+                row.center += 1.0;
+                row.front -= 1.0;
+            }
+            else
+            {
+                bijk -= 1.0;
+            }
+        });
+
+        FDMCompressedBLAS3::BuildSystem(&compressedSystem, size);
+    }
+};
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, Solve)(benchmark::State& state)
+{
+    CubbyFlow::FDMICCGSolver3 solver(100, 1e-6);
+    solver.SetIsUsingParallelPreconditioner(state.range(1) != 0);
+
+    while (state.KeepRunning())
+    {
+        solver.Solve(&system);
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+}
+
+BENCHMARK_REGISTER_F(FDMICCGSolver3, Solve)
+->Args({ 1 << 5, 0 })
+->Args({ 1 << 5, 1 })
+->Args({ 1 << 7, 0 })
+->Args({ 1 << 7, 1 });
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, SolveCompressed)(benchmark::State& state)
+{
+    const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+    CubbyFlow::SetMaxNumberOfThreads(static_cast<unsigned int>(state.range(2)));
+
+    CubbyFlow::FDMICCGSolver3 solver(100, 1e-6);
+    solver.SetIsUsingParallelPreconditioner(state.range(1) != 0);
+
+    while (state.KeepRunning())
+    {
+        solver.SolveCompressed(&compressedSystem);
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+
+    CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(FDMICCGSolver3, SolveCompressed)
+->UseRealTime()
+->Args({ 1 << 5, 0, 1 })
+->Args({ 1 << 5, 1, 1 })
+->Args({ 1 << 5, 1, 4 })
+->Args({ 1 << 7, 0, 1 })
+->Args({ 1 << 7, 1, 1 })
+->Args({ 1 << 7, 1, 4 })
+->Args({ 1 << 7, 1, 8 });
+
+namespace
+{
+    // FDMBLAS3 without the fused kernels, to run the unfused PCG path
+    struct UnfusedFDMBLAS3 : CubbyFlow::FDMBLAS3
+    {
+        static void MVMDot() = delete;
+    };
+
+    template <typename BLASType>
+    void RunCG(FDMLinearSystem3* system, benchmark::State& state)
+    {
+        const Size3 size = system->x.size();
+        FDMVector3 r(size), d(size), q(size), s(size);
+        unsigned int numberOfIterations = 0;
+        double residualNorm = 0.0;
+
+        while (state.KeepRunning())
+        {
+            system->x.Set(0.0);
+
+            CubbyFlow::CG<BLASType>(system->A, system->b, 100, 1e-6, &system->x,
+                &r, &d, &q, &s, &numberOfIterations, &residualNorm);
+        }
+
+        state.counters["iterations"] = numberOfIterations;
+    }
+}
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, CGUnfused)(benchmark::State& state)
+{
+    RunCG<UnfusedFDMBLAS3>(&system, state);
+}
+
+BENCHMARK_REGISTER_F(FDMICCGSolver3, CGUnfused)->Arg(1 << 5)->Arg(1 << 7);
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, CGFused)(benchmark::State& state)
+{
+    RunCG<CubbyFlow::FDMBLAS3>(&system, state);
+}
+
+BENCHMARK_REGISTER_F(FDMICCGSolver3, CGFused)->Arg(1 << 5)->Arg(1 << 7);
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, SolvePrecision)(benchmark::State& state)
+{
+    CubbyFlow::FDMICCGSolver3 solver(100, 1e-6);
+    solver.SetPrecision(static_cast<CubbyFlow::FDMPrecision>(state.range(1)));
+
+    while (state.KeepRunning())
+    {
+        solver.Solve(&system);
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+    state.counters["residual"] = solver.GetLastResidual();
+}
+
+// Double, Single and Mixed precision
+BENCHMARK_REGISTER_F(FDMICCGSolver3, SolvePrecision)
+->Args({ 1 << 7, 0 })
+->Args({ 1 << 7, 1 })
+->Args({ 1 << 7, 2 });
+
+BENCHMARK_DEFINE_F(FDMICCGSolver3, CGSolvePrecision)(benchmark::State& state)
+{
+    CubbyFlow::FDMCGSolver3 solver(300, 1e-6);
+    solver.SetPrecision(static_cast<CubbyFlow::FDMPrecision>(state.range(1)));
+
+    while (state.KeepRunning())
+    {
+        solver.Solve(&system);
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+    state.counters["residual"] = solver.GetLastResidual();
+}
+
+// Double, Single and Mixed precision
+BENCHMARK_REGISTER_F(FDMICCGSolver3, CGSolvePrecision)
+->Args({ 1 << 7, 0 })
+->Args({ 1 << 7, 1 })
+->Args({ 1 << 7, 2 });
+
+class FDMMatrixFreeBLAS3 : public ::benchmark::Fixture
+{
+public:
+    Array3<char> markers;
+    FDMMatrixFreeLinearSystem3 system;
+    FDMLinearSystem3 assembledSystem;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto dim = static_cast<size_t>(state.range(0));
+        const Size3 size(dim, dim, dim);
+
+        // Liquid pool filling the lower 3/4 of a box with solid walls
+        markers.Resize(size);
+        markers.ForEachIndex([&](size_t i, size_t j, size_t k)
+        {
+            if (i == 0 || i + 1 == dim || j == 0 || k == 0 || k + 1 == dim)
+            {
+                markers(i, j, k) = FDMMatrixFree3::BOUNDARY;
+            }
+            else if (4 * j >= 3 * dim)
+            {
+                markers(i, j, k) = FDMMatrixFree3::AIR;
+            }
+            else
+            {
+                markers(i, j, k) = FDMMatrixFree3::FLUID;
+            }
+        });
+
+        system.Resize(size);
+        system.A.markers = markers.ConstAccessor();
+        system.A.invHSqr = CubbyFlow::Vector3D(1.0, 1.0, 1.0) * static_cast<double>(dim * dim);
+
+        std::mt19937 rng;
+        std::uniform_real_distribution<> d(-1.0, 1.0);
+
+        system.b.ForEachIndex([&](size_t i, size_t j, size_t k)
+        {
+            system.b(i, j, k) = (markers(i, j, k) == FDMMatrixFree3::FLUID) ? d(rng) : 0.0;
+        });
+
+        CubbyFlow::FDMMatrixFreeBLAS3::Set(system.A, &assembledSystem.A);
+        assembledSystem.x = system.x;
+        assembledSystem.b = system.b;
+    }
+};
+
+BENCHMARK_DEFINE_F(FDMMatrixFreeBLAS3, MVM)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::FDMMatrixFreeBLAS3::MVM(system.A, system.b, &system.x);
+    }
+}
+
+BENCHMARK_REGISTER_F(FDMMatrixFreeBLAS3, MVM)->Arg(1 << 6)->Arg(1 << 8);
+
+BENCHMARK_DEFINE_F(FDMMatrixFreeBLAS3, MVMAssembled)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::FDMBLAS3::MVM(assembledSystem.A, assembledSystem.b, &assembledSystem.x);
+    }
+}
+
+BENCHMARK_REGISTER_F(FDMMatrixFreeBLAS3, MVMAssembled)->Arg(1 << 6)->Arg(1 << 8);
+
+BENCHMARK_DEFINE_F(FDMMatrixFreeBLAS3, SolveICCG)(benchmark::State& state)
+{
+    CubbyFlow::FDMICCGSolver3 solver(100, 1e-6);
+    const bool isMatrixFree = (state.range(1) != 0);
+
+    while (state.KeepRunning())
+    {
+        if (isMatrixFree)
+        {
+            solver.SolveMatrixFree(&system);
+        }
+        else
+        {
+            solver.Solve(&assembledSystem);
+        }
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+}
+
+// Assembled and matrix-free systems
+BENCHMARK_REGISTER_F(FDMMatrixFreeBLAS3, SolveICCG)
+->Args({ 1 << 7, 0 })
+->Args({ 1 << 7, 1 });
+
+BENCHMARK_DEFINE_F(FDMMatrixFreeBLAS3, SolveCG)(benchmark::State& state)
+{
+    CubbyFlow::FDMCGSolver3 solver(100, 1e-6);
+    const bool isMatrixFree = (state.range(1) != 0);
+
+    while (state.KeepRunning())
+    {
+        if (isMatrixFree)
+        {
+            solver.SolveMatrixFree(&system);
+        }
+        else
+        {
+            solver.Solve(&assembledSystem);
+        }
+    }
+
+    state.counters["iterations"] = solver.GetLastNumberOfIterations();
+}
+
+// Assembled and matrix-free systems
+BENCHMARK_REGISTER_F(FDMMatrixFreeBLAS3, SolveCG)
+->Args({ 1 << 7, 0 })
+->Args({ 1 << 7, 1 });
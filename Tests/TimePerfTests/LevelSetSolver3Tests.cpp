@@ -0,0 +1,134 @@
+#include "benchmark/benchmark.h"
+
+#include <Core/Grid/CellCenteredScalarGrid3.h>
+#include <Core/Solver/LevelSet/FMMLevelSetSolver3.h>
+#include <Core/Solver/LevelSet/FastSweepingLevelSetSolver3.h>
+#include <Core/Solver/LevelSet/UpwindLevelSetSolver3.h>
+#include <Core/Vector/Vector3.h>
+
+using CubbyFlow::Vector3D;
+using CubbyFlow::CellCenteredScalarGrid3;
+
+class LevelSetSolver3 : public ::benchmark::Fixture
+{
+public:
+    CellCenteredScalarGrid3 sdf;
+    CellCenteredScalarGrid3 field;
+    CellCenteredScalarGrid3 output;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto n = static_cast<size_t>(state.range(0));
+        const Vector3D center(0.5 * n, 0.5 * n, 0.5 * n);
+
+        sdf.Resize(n, n, n);
+        sdf.Fill([&](const Vector3D& x)
+        {
+            return (x - center).Length() - 0.25 * n;
+        });
+
+        field.Resize(n, n, n);
+        field.Fill([&](const Vector3D& x)
+        {
+            return (x - center).Length() <= 0.25 * n ? x.y : 0.0;
+        });
+
+        output.Resize(n, n, n);
+    }
+};
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, Reinitialize)(benchmark::State& state)
+{
+    CubbyFlow::UpwindLevelSetSolver3 solver;
+    solver.SetIsUsingNarrowBand(state.range(1) == 1);
+
+    while (state.KeepRunning())
+    {
+        solver.Reinitialize(sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, Reinitialize)
+->Args({ 64, 0 })
+->Args({ 64, 1 })
+->Args({ 128, 0 })
+->Args({ 128, 1 })
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, Extrapolate)(benchmark::State& state)
+{
+    CubbyFlow::UpwindLevelSetSolver3 solver;
+    solver.SetIsUsingNarrowBand(state.range(1) == 1);
+
+    while (state.KeepRunning())
+    {
+        solver.Extrapolate(field, sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, Extrapolate)
+->Args({ 64, 0 })
+->Args({ 64, 1 })
+->Args({ 128, 0 })
+->Args({ 128, 1 })
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, ReinitializeFMM)(benchmark::State& state)
+{
+    CubbyFlow::FMMLevelSetSolver3 solver;
+
+    while (state.KeepRunning())
+    {
+        solver.Reinitialize(sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, ReinitializeFMM)
+->Arg(64)
+->Arg(128)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, ReinitializeFastSweeping)(benchmark::State& state)
+{
+    CubbyFlow::FastSweepingLevelSetSolver3 solver;
+
+    while (state.KeepRunning())
+    {
+        solver.Reinitialize(sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, ReinitializeFastSweeping)
+->Arg(64)
+->Arg(128)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, ExtrapolateFMM)(benchmark::State& state)
+{
+    CubbyFlow::FMMLevelSetSolver3 solver;
+
+    while (state.KeepRunning())
+    {
+        solver.Extrapolate(field, sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, ExtrapolateFMM)
+->Arg(64)
+->Arg(128)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(LevelSetSolver3, ExtrapolateFastSweeping)(benchmark::State& state)
+{
+    CubbyFlow::FastSweepingLevelSetSolver3 solver;
+
+    while (state.KeepRunning())
+    {
+        solver.Extrapolate(field, sdf, 5.0, &output);
+    }
+}
+
+BENCHMARK_REGISTER_F(LevelSetSolver3, ExtrapolateFastSweeping)
+->Arg(64)
+->Arg(128)
+->Unit(benchmark::kMillisecond);
@@ -0,0 +1,59 @@
+#include "benchmark/benchmark.h"
+
+#include <Core/Array/Array3.h>
+#include <Core/MarchingCubes/MarchingCubes.h>
+#include <Core/Vector/Vector3.h>
+
+#include <cmath>
+
+using CubbyFlow::Array3;
+using CubbyFlow::Vector3D;
+
+class MarchingCubes : public ::benchmark::Fixture
+{
+public:
+    Array3<double> grid;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto n = static_cast<size_t>(state.range(0));
+        const Vector3D center(0.5 * n, 0.5 * n, 0.5 * n);
+
+        grid.Resize(n, n, n);
+        grid.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+        {
+            const Vector3D x(i, j, k);
+            grid(i, j, k) = (x - center).Length() - 0.3 * n + 0.02 * n * std::sin(0.2 * x.x) * std::sin(0.2 * x.y);
+        });
+    }
+};
+
+BENCHMARK_DEFINE_F(MarchingCubes, Serial)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMesh3 mesh;
+        CubbyFlow::MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(), &mesh, 0.0, CubbyFlow::DIRECTION_ALL, CubbyFlow::ExecutionPolicy::Serial);
+    }
+}
+
+BENCHMARK_REGISTER_F(MarchingCubes, Serial)
+->Arg(64)
+->Arg(128)
+->Arg(256)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(MarchingCubes, Parallel)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMesh3 mesh;
+        CubbyFlow::MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(), &mesh, 0.0, CubbyFlow::DIRECTION_ALL, CubbyFlow::ExecutionPolicy::Parallel);
+    }
+}
+
+BENCHMARK_REGISTER_F(MarchingCubes, Parallel)
+->Arg(64)
+->Arg(128)
+->Arg(256)
+->Unit(benchmark::kMillisecond);
@@ -0,0 +1,112 @@
+#include "benchmark/benchmark.h"
+
+#include <Core/Solver/Hybrid/APIC/APICSolver3.h>
+#include <Core/Solver/Hybrid/PIC/PICSolver3.h>
+#include <Core/Utils/Parallel.h>
+
+#include <random>
+
+using CubbyFlow::Array1;
+using CubbyFlow::Vector3D;
+
+namespace
+{
+	template <typename Solver>
+	class P2GSolver : public Solver
+	{
+	public:
+		using Solver::Solver;
+		using Solver::TransferFromParticlesToGrids;
+	};
+
+	template <typename Solver>
+	void AddRandomParticles(Solver* solver, size_t numberOfParticles)
+	{
+		std::mt19937 rng{ 0 };
+		std::uniform_real_distribution<> d{ 0.0, 1.0 };
+
+		Array1<Vector3D> positions(numberOfParticles);
+		Array1<Vector3D> velocities(numberOfParticles);
+		for (size_t i = 0; i < numberOfParticles; ++i)
+		{
+			positions[i] = Vector3D(d(rng), d(rng), d(rng));
+			velocities[i] = Vector3D(d(rng), d(rng), d(rng));
+		}
+
+		solver->GetParticleSystemData()->AddParticles(positions, velocities);
+	}
+}
+
+class PICSolver3 : public ::benchmark::Fixture
+{
+protected:
+	std::unique_ptr<P2GSolver<CubbyFlow::PICSolver3>> pic;
+	std::unique_ptr<P2GSolver<CubbyFlow::APICSolver3>> apic;
+	unsigned int numThreads = 1;
+
+	void SetUp(const ::benchmark::State& state)
+	{
+		// Eight particles per cell on a 64^3 grid
+		const size_t resolution = 64;
+		const double h = 1.0 / resolution;
+		numThreads = static_cast<unsigned int>(state.range(0));
+
+		pic = std::make_unique<P2GSolver<CubbyFlow::PICSolver3>>(
+			CubbyFlow::Size3(resolution, resolution, resolution),
+			Vector3D(h, h, h), Vector3D());
+		apic = std::make_unique<P2GSolver<CubbyFlow::APICSolver3>>(
+			CubbyFlow::Size3(resolution, resolution, resolution),
+			Vector3D(h, h, h), Vector3D());
+
+		AddRandomParticles(pic.get(), 8 * resolution * resolution * resolution);
+		AddRandomParticles(apic.get(), 8 * resolution * resolution * resolution);
+	}
+
+	void TearDown(const ::benchmark::State&)
+	{
+		pic.reset();
+		apic.reset();
+	}
+};
+
+BENCHMARK_DEFINE_F(PICSolver3, TransferFromParticlesToGrids)(benchmark::State& state)
+{
+	const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+	CubbyFlow::SetMaxNumberOfThreads(numThreads);
+
+	while (state.KeepRunning())
+	{
+		pic->TransferFromParticlesToGrids();
+	}
+
+	CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(PICSolver3, TransferFromParticlesToGrids)
+->Unit(benchmark::kMillisecond)
+->UseRealTime()
+->Arg(1)
+->Arg(2)
+->Arg(4)
+->Arg(8);
+
+BENCHMARK_DEFINE_F(PICSolver3, APICTransferFromParticlesToGrids)(benchmark::State& state)
+{
+	const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+	CubbyFlow::SetMaxNumberOfThreads(numThreads);
+
+	while (state.KeepRunning())
+	{
+		apic->TransferFromParticlesToGrids();
+	}
+
+	CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(PICSolver3, APICTransferFromParticlesToGrids)
+->Unit(benchmark::kMillisecond)
+->UseRealTime()
+->Arg(1)
+->Arg(2)
+->Arg(4)
+->Arg(8);
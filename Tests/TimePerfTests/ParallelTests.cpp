@@ -3,7 +3,42 @@
 #include <Core/Utils/Constants.h>
 #include <Core/Utils/Parallel.h>
 
+#include <numeric>
 #include <random>
+#include <thread>
+
+namespace
+{
+	// The pre-thread pool implementation of ParallelFor which spawns and joins
+	// a new set of threads on every call; kept as the comparison baseline.
+	template <typename Function>
+	void ParallelForPerCallSpawn(size_t beginIndex, size_t endIndex,
+		unsigned int numThreads, const Function& function)
+	{
+		size_t slice = std::max(
+			(endIndex - beginIndex + numThreads - 1) / numThreads, size_t(1));
+
+		std::vector<std::thread> pool;
+		pool.reserve(numThreads);
+
+		for (size_t i1 = beginIndex; i1 < endIndex; i1 += slice)
+		{
+			const size_t i2 = std::min(i1 + slice, endIndex);
+			pool.emplace_back([&function, i1, i2]()
+			{
+				for (size_t i = i1; i < i2; ++i)
+				{
+					function(i);
+				}
+			});
+		}
+
+		for (std::thread& t : pool)
+		{
+			t.join();
+		}
+	}
+}
 
 class Parallel : public ::benchmark::Fixture
 {
@@ -89,4 +124,148 @@ BENCHMARK_REGISTER_F(Parallel, ParallelRangeFor)
 ->Args({ 1 << 24, 1 })
 ->Args({ 1 << 24, 2 })
 ->Args({ 1 << 24, 4 })
-->Args({ 1 << 24, 8 });
\ No newline at end of file
+->Args({ 1 << 24, 8 });
+
+BENCHMARK_DEFINE_F(Parallel, ParallelForPerCallSpawn)(benchmark::State& state)
+{
+	while (state.KeepRunning())
+	{
+		ParallelForPerCallSpawn(CubbyFlow::ZERO_SIZE, n, numThreads, [this](size_t i) {
+			c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
+		});
+	}
+}
+
+BENCHMARK_REGISTER_F(Parallel, ParallelForPerCallSpawn)
+->UseRealTime()
+->Args({ 1 << 8, 1 })
+->Args({ 1 << 8, 2 })
+->Args({ 1 << 8, 4 })
+->Args({ 1 << 8, 8 })
+->Args({ 1 << 16, 1 })
+->Args({ 1 << 16, 2 })
+->Args({ 1 << 16, 4 })
+->Args({ 1 << 16, 8 })
+->Args({ 1 << 24, 1 })
+->Args({ 1 << 24, 2 })
+->Args({ 1 << 24, 4 })
+->Args({ 1 << 24, 8 });
+
+BENCHMARK_DEFINE_F(Parallel, ParallelReduce)(benchmark::State& state)
+{
+	const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+	CubbyFlow::SetMaxNumberOfThreads(numThreads);
+
+	while (state.KeepRunning())
+	{
+		double sum = CubbyFlow::ParallelReduce(CubbyFlow::ZERO_SIZE, n, 0.0,
+			[this](size_t iBegin, size_t iEnd, double init)
+		{
+			double result = init;
+
+			for (size_t i = iBegin; i < iEnd; ++i)
+			{
+				result += a[i] * b[i];
+			}
+
+			return result;
+		}, std::plus<double>());
+
+		benchmark::DoNotOptimize(sum);
+	}
+
+	CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(Parallel, ParallelReduce)
+->UseRealTime()
+->Args({ 1 << 8, 1 })
+->Args({ 1 << 8, 2 })
+->Args({ 1 << 8, 4 })
+->Args({ 1 << 8, 8 })
+->Args({ 1 << 16, 1 })
+->Args({ 1 << 16, 2 })
+->Args({ 1 << 16, 4 })
+->Args({ 1 << 16, 8 })
+->Args({ 1 << 24, 1 })
+->Args({ 1 << 24, 2 })
+->Args({ 1 << 24, 4 })
+->Args({ 1 << 24, 8 });
+
+class ParallelSortKeys : public ::benchmark::Fixture
+{
+public:
+	std::vector<size_t> keys, indices;
+	size_t n = 0;
+	unsigned int numThreads = 1;
+
+	void SetUp(const ::benchmark::State& state)
+	{
+		n = static_cast<size_t>(state.range(0));
+		numThreads = static_cast<unsigned int>(state.range(1));
+
+		// Hash keys of a 64^3 grid, as in PointParallelHashGridSearcher3
+		std::mt19937 rng{ 0 };
+		std::uniform_int_distribution<size_t> d{ 0, 64 * 64 * 64 - 1 };
+
+		keys.resize(n);
+		indices.resize(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			keys[i] = d(rng);
+		}
+	}
+};
+
+BENCHMARK_DEFINE_F(ParallelSortKeys, IndirectCompare)(benchmark::State& state)
+{
+	const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+	CubbyFlow::SetMaxNumberOfThreads(numThreads);
+
+	while (state.KeepRunning())
+	{
+		std::iota(indices.begin(), indices.end(), CubbyFlow::ZERO_SIZE);
+
+		CubbyFlow::ParallelSort(indices.begin(), indices.end(), [this](size_t a, size_t b)
+		{
+			return keys[a] < keys[b];
+		});
+
+		benchmark::DoNotOptimize(indices.data());
+	}
+
+	CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(ParallelSortKeys, IndirectCompare)
+->UseRealTime()
+->Args({ 1 << 16, 1 })
+->Args({ 1 << 16, 8 })
+->Args({ 1 << 20, 1 })
+->Args({ 1 << 20, 8 });
+
+BENCHMARK_DEFINE_F(ParallelSortKeys, RadixSort)(benchmark::State& state)
+{
+	const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+	CubbyFlow::SetMaxNumberOfThreads(numThreads);
+
+	std::vector<size_t> sortedKeys(n);
+	while (state.KeepRunning())
+	{
+		sortedKeys = keys;
+		std::iota(indices.begin(), indices.end(), CubbyFlow::ZERO_SIZE);
+
+		CubbyFlow::ParallelRadixSort(sortedKeys.begin(), sortedKeys.end(), indices.begin());
+
+		benchmark::DoNotOptimize(indices.data());
+	}
+
+	CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(ParallelSortKeys, RadixSort)
+->UseRealTime()
+->Args({ 1 << 16, 1 })
+->Args({ 1 << 16, 8 })
+->Args({ 1 << 20, 1 })
+->Args({ 1 << 20, 8 });
@@ -0,0 +1,60 @@
+#include "benchmark/benchmark.h"
+
+#include <Core/Particle/ParticleSystemData3.h>
+#include <Core/Utils/Parallel.h>
+
+#include <random>
+
+using CubbyFlow::Array1;
+using CubbyFlow::Vector3D;
+
+class ParticleSystemData3 : public ::benchmark::Fixture
+{
+protected:
+    std::unique_ptr<CubbyFlow::ParticleSystemData3> particles;
+    const double radius = 1.0 / 64.0;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        std::mt19937 rng{ 0 };
+        std::uniform_real_distribution<> dist{ 0.0, 1.0 };
+
+        const size_t N = static_cast<size_t>(state.range(0));
+
+        Array1<Vector3D> points(N);
+        for (size_t i = 0; i < N; ++i)
+        {
+            points[i] = Vector3D(dist(rng), dist(rng), dist(rng));
+        }
+
+        particles = std::make_unique<CubbyFlow::ParticleSystemData3>();
+        particles->AddParticles(points);
+        particles->BuildNeighborSearcher(radius);
+    }
+
+    void TearDown(const ::benchmark::State&)
+    {
+        particles.reset();
+    }
+};
+
+BENCHMARK_DEFINE_F(ParticleSystemData3, BuildNeighborLists)(benchmark::State& state)
+{
+    const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+    CubbyFlow::SetMaxNumberOfThreads(static_cast<unsigned int>(state.range(1)));
+
+    while (state.KeepRunning())
+    {
+        particles->BuildNeighborLists(radius);
+    }
+
+    CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(ParticleSystemData3, BuildNeighborLists)
+->Unit(benchmark::kMillisecond)
+->UseRealTime()
+->Args({ 1 << 16, 1 })
+->Args({ 1 << 16, 8 })
+->Args({ 1 << 20, 1 })
+->Args({ 1 << 20, 8 });
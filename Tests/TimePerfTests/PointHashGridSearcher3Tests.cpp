@@ -61,9 +61,37 @@ BENCHMARK_DEFINE_F(PointHashGridSearcher3, ForEachNearbyPoints)(benchmark::State
             ++cnt;
         });
     }
+
+    benchmark::DoNotOptimize(cnt);
 }
 
 BENCHMARK_REGISTER_F(PointHashGridSearcher3, ForEachNearbyPoints)
 ->Arg(1 << 5)
 ->Arg(1 << 10)
-->Arg(1 << 20);
\ No newline at end of file
+->Arg(1 << 20);
+
+BENCHMARK_DEFINE_F(PointHashGridSearcher3, ForEachNearbyPointsVirtual)(benchmark::State& state)
+{
+    CubbyFlow::PointHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+    grid.Build(points);
+
+    // Same queries through the base class and std::function.
+    const CubbyFlow::PointNeighborSearcher3& searcher = grid;
+
+    size_t cnt = 0;
+    while (state.KeepRunning())
+    {
+        searcher.ForEachNearbyPoint(MakeVec(), 1.0 / 64.0,
+            [&](size_t, const Vector3D&)
+        {
+            ++cnt;
+        });
+    }
+
+    benchmark::DoNotOptimize(cnt);
+}
+
+BENCHMARK_REGISTER_F(PointHashGridSearcher3, ForEachNearbyPointsVirtual)
+->Arg(1 << 5)
+->Arg(1 << 10)
+->Arg(1 << 20);
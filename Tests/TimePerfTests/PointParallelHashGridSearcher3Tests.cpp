@@ -2,6 +2,7 @@
 
 #include <Core/Array/Array1.h>
 #include <Core/Searcher/PointParallelHashGridSearcher3.h>
+#include <Core/Utils/Parallel.h>
 #include <Core/Vector/Vector3.h>
 
 #include <random>
@@ -66,4 +67,85 @@ BENCHMARK_DEFINE_F(PointParallelHashGridSearcher3, ForEachNearbyPoints)(benchmar
 BENCHMARK_REGISTER_F(PointParallelHashGridSearcher3, ForEachNearbyPoints)
 ->Arg(1 << 5)
 ->Arg(1 << 10)
-->Arg(1 << 20);
\ No newline at end of file
+->Arg(1 << 20);
+
+BENCHMARK_DEFINE_F(PointParallelHashGridSearcher3, FindNearbyPointsPerPoint)(benchmark::State& state)
+{
+    CubbyFlow::PointParallelHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+    grid.Build(points);
+
+    std::vector<size_t> offsets(points.size() + 1), indices;
+    while (state.KeepRunning())
+    {
+        indices.clear();
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            grid.ForEachNearbyPoint(points[i], 1.0 / 64.0,
+                [&](size_t j, const Vector3D&)
+            {
+                indices.push_back(j);
+            });
+            offsets[i + 1] = indices.size();
+        }
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(PointParallelHashGridSearcher3, FindNearbyPointsPerPoint)
+->Arg(1 << 16)
+->Arg(1 << 20);
+
+BENCHMARK_DEFINE_F(PointParallelHashGridSearcher3, FindNearbyPointsBatched)(benchmark::State& state)
+{
+    CubbyFlow::PointParallelHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+    grid.Build(points);
+
+    std::vector<size_t> offsets, indices;
+    while (state.KeepRunning())
+    {
+        grid.FindNearbyPoints(points, 1.0 / 64.0, &offsets, &indices);
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(PointParallelHashGridSearcher3, FindNearbyPointsBatched)
+->Arg(1 << 16)
+->Arg(1 << 20);
+
+BENCHMARK_DEFINE_F(PointParallelHashGridSearcher3, BuildIncremental)(benchmark::State& state)
+{
+    const unsigned int oldNumThreads = CubbyFlow::GetMaxNumberOfThreads();
+    CubbyFlow::SetMaxNumberOfThreads(static_cast<unsigned int>(state.range(2)));
+
+    // Particles moving by a small fraction of the grid spacing per step
+    std::uniform_real_distribution<> jitter{ -0.05 / 64.0, 0.05 / 64.0 };
+    Array1<Vector3D> steps[2] = { points, points };
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        steps[1][i] += Vector3D(jitter(rng), jitter(rng), jitter(rng));
+    }
+
+    CubbyFlow::PointParallelHashGridSearcher3 grid(64, 64, 64, 1.0 / 64.0);
+    grid.SetMaxChurnRatio(static_cast<double>(state.range(1)) / 100.0);
+    grid.Build(steps[0]);
+
+    size_t step = 1;
+    while (state.KeepRunning())
+    {
+        grid.Build(steps[step]);
+        step = 1 - step;
+    }
+
+    CubbyFlow::SetMaxNumberOfThreads(oldNumThreads);
+}
+
+BENCHMARK_REGISTER_F(PointParallelHashGridSearcher3, BuildIncremental)
+->UseRealTime()
+->Args({ 1 << 16, 0, 1 })
+->Args({ 1 << 16, 10, 1 })
+->Args({ 1 << 20, 0, 1 })
+->Args({ 1 << 20, 10, 1 })
+->Args({ 1 << 20, 0, 4 })
+->Args({ 1 << 20, 10, 4 })
+->Args({ 1 << 20, 0, 8 })
+->Args({ 1 << 20, 10, 8 });
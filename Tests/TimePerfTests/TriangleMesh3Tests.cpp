@@ -1,8 +1,11 @@
 #include "benchmark/benchmark.h"
 
+#include <Core/Array/Array3.h>
 #include <Core/Geometry/TriangleMesh3.h>
+#include <Core/MarchingCubes/MarchingCubes.h>
 #include <Core/Vector/Vector3.h>
 
+#include <cstdio>
 #include <fstream>
 #include <random>
 
@@ -40,4 +43,70 @@ BENCHMARK_DEFINE_F(TriangleMesh3, ClosestPoint)(benchmark::State& state)
     }
 }
 
-BENCHMARK_REGISTER_F(TriangleMesh3, ClosestPoint);
\ No newline at end of file
+BENCHMARK_REGISTER_F(TriangleMesh3, ClosestPoint);
+
+class TriangleMesh3IO : public ::benchmark::Fixture
+{
+protected:
+    CubbyFlow::TriangleMesh3 triMesh;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto n = static_cast<size_t>(state.range(0));
+        const Vector3D center(0.5 * n, 0.5 * n, 0.5 * n);
+
+        CubbyFlow::Array3<double> grid(n, n, n);
+        grid.ParallelForEachIndex([&](size_t i, size_t j, size_t k)
+        {
+            grid(i, j, k) = (Vector3D(i, j, k) - center).Length() - 0.4 * n;
+        });
+
+        triMesh = CubbyFlow::TriangleMesh3();
+        CubbyFlow::MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(), &triMesh, 0.0, CubbyFlow::DIRECTION_NONE);
+
+        std::ofstream file("TriangleMesh3IO.obj");
+        file.precision(17);
+        triMesh.WriteObj(&file);
+        file.close();
+
+        triMesh.WritePly("TriangleMesh3IO.ply");
+    }
+
+    void TearDown(const ::benchmark::State&)
+    {
+        std::remove("TriangleMesh3IO.obj");
+        std::remove("TriangleMesh3IO.ply");
+    }
+};
+
+BENCHMARK_DEFINE_F(TriangleMesh3IO, ReadObj)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMesh3 mesh;
+        benchmark::DoNotOptimize(mesh.ReadObj(std::string("TriangleMesh3IO.obj")));
+    }
+
+    state.SetItemsProcessed(state.iterations() * triMesh.NumberOfTriangles());
+}
+
+BENCHMARK_REGISTER_F(TriangleMesh3IO, ReadObj)
+->Arg(128)
+->Arg(256)
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(TriangleMesh3IO, ReadPly)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMesh3 mesh;
+        benchmark::DoNotOptimize(mesh.ReadPly(std::string("TriangleMesh3IO.ply")));
+    }
+
+    state.SetItemsProcessed(state.iterations() * triMesh.NumberOfTriangles());
+}
+
+BENCHMARK_REGISTER_F(TriangleMesh3IO, ReadPly)
+->Arg(128)
+->Arg(256)
+->Unit(benchmark::kMillisecond);
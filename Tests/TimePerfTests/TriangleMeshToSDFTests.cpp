@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+
+#include <Core/Geometry/TriangleMesh3.h>
+#include <Core/Geometry/TriangleMeshToSDF.h>
+#include <Core/Grid/VertexCenteredScalarGrid3.h>
+#include <Core/Vector/Vector3.h>
+
+#include <cmath>
+#include <fstream>
+#include <string>
+
+using CubbyFlow::Vector3D;
+
+class TriangleMeshToSDF : public ::benchmark::Fixture
+{
+public:
+    CubbyFlow::TriangleMesh3 triMesh;
+    CubbyFlow::VertexCenteredScalarGrid3 grid;
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        const std::string fileName = (state.range(0) == 0) ? "bunny.obj" : "dragon.obj";
+        std::ifstream file(RESOURCES_DIR + fileName);
+
+        triMesh = CubbyFlow::TriangleMesh3();
+
+        if (file)
+        {
+            triMesh.ReadObj(&file);
+            file.close();
+        }
+
+        // The same grid as Obj2Sdf, which has a margin of 20% around the mesh.
+        const auto n = static_cast<size_t>(state.range(1));
+        CubbyFlow::BoundingBox3D box(Vector3D(), Vector3D(1, 1, 1));
+
+        if (triMesh.NumberOfTriangles() > 0)
+        {
+            box = triMesh.BoundingBox();
+        }
+
+        const Vector3D scale(box.GetWidth(), box.GetHeight(), box.GetDepth());
+        box.lowerCorner -= 0.2 * scale;
+        box.upperCorner += 0.2 * scale;
+
+        const double dx = box.GetWidth() / n;
+        const auto ny = static_cast<size_t>(std::ceil(box.GetHeight() / dx));
+        const auto nz = static_cast<size_t>(std::ceil(box.GetDepth() / dx));
+
+        grid.Resize(n, ny, nz, dx, dx, dx, box.lowerCorner.x, box.lowerCorner.y, box.lowerCorner.z);
+    }
+};
+
+BENCHMARK_DEFINE_F(TriangleMeshToSDF, Serial)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMeshToSDF(triMesh, &grid, 1, CubbyFlow::ExecutionPolicy::Serial);
+    }
+}
+
+BENCHMARK_REGISTER_F(TriangleMeshToSDF, Serial)
+->Args({ 0, 64 })
+->Args({ 0, 128 })
+->Args({ 1, 64 })
+->Args({ 1, 128 })
+->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(TriangleMeshToSDF, Parallel)(benchmark::State& state)
+{
+    while (state.KeepRunning())
+    {
+        CubbyFlow::TriangleMeshToSDF(triMesh, &grid, 1, CubbyFlow::ExecutionPolicy::Parallel);
+    }
+}
+
+BENCHMARK_REGISTER_F(TriangleMeshToSDF, Parallel)
+->Args({ 0, 64 })
+->Args({ 0, 128 })
+->Args({ 0, 256 })
+->Args({ 1, 64 })
+->Args({ 1, 128 })
+->Args({ 1, 256 })
+->Unit(benchmark::kMillisecond);
@@ -2,6 +2,8 @@
 
 #include <Core/Solver/Hybrid/APIC/APICSolver3.h>
 
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(APICSolver3, UpdateEmpty)
@@ -12,4 +14,59 @@ TEST(APICSolver3, UpdateEmpty)
     {
         solver.Update(frame);
     }
+}
+
+namespace
+{
+    class APICSolver3P2G : public APICSolver3
+    {
+    public:
+        using APICSolver3::APICSolver3;
+        using APICSolver3::TransferFromParticlesToGrids;
+    };
+}
+
+TEST(APICSolver3, TransferFromParticlesToGridsIsDeterministic)
+{
+    APICSolver3P2G solver({ 16, 16, 16 }, { 1.0 / 16.0, 1.0 / 16.0, 1.0 / 16.0 }, { 0, 0, 0 });
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> positions(5000);
+    Array1<Vector3D> velocities(5000);
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        positions[i] = Vector3D(d(rng), d(rng), d(rng));
+        velocities[i] = Vector3D(d(rng), d(rng), d(rng)) - Vector3D(0.5, 0.5, 0.5);
+    }
+    solver.GetParticleSystemData()->AddParticles(positions, velocities);
+
+    const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+    SetMaxNumberOfThreads(1);
+    solver.TransferFromParticlesToGrids();
+    FaceCenteredGrid3 expected(*solver.GetGridSystemData()->GetVelocity());
+
+    for (unsigned int numThreads : { 2u, 3u, 8u })
+    {
+        SetMaxNumberOfThreads(numThreads);
+        solver.TransferFromParticlesToGrids();
+
+        auto vel = solver.GetGridSystemData()->GetVelocity();
+        vel->ForEachUIndex([&](size_t i, size_t j, size_t k)
+        {
+            EXPECT_EQ(expected.GetU(i, j, k), vel->GetU(i, j, k));
+        });
+        vel->ForEachVIndex([&](size_t i, size_t j, size_t k)
+        {
+            EXPECT_EQ(expected.GetV(i, j, k), vel->GetV(i, j, k));
+        });
+        vel->ForEachWIndex([&](size_t i, size_t j, size_t k)
+        {
+            EXPECT_EQ(expected.GetW(i, j, k), vel->GetW(i, j, k));
+        });
+    }
+
+    SetMaxNumberOfThreads(oldNumThreads);
 }
\ No newline at end of file
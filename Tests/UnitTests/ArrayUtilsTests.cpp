@@ -108,6 +108,33 @@ TEST(ArrayUtils, CopyRange3)
 	}
 }
 
+TEST(ArrayUtils, Norms)
+{
+	Array3<double> array0(7, 5, 3);
+	Array3<double> array1(7, 5, 3);
+
+	double dot = 0.0;
+	double lInf = 0.0;
+
+	array0.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		array0(i, j, k) = std::sin(0.3 * i + 0.7 * j - 1.1 * k);
+		array1(i, j, k) = static_cast<double>(i + j) - 2.0 * k;
+
+		dot += array0(i, j, k) * array1(i, j, k);
+		lInf = std::max(lInf, std::fabs(array1(i, j, k)));
+	});
+
+	EXPECT_NEAR(dot, DotRange1(array0, array1, 105), 1e-12);
+	EXPECT_NEAR(std::sqrt(DotRange1(array1, array1, 105)), L2NormRange1(array1, 105), 1e-12);
+	EXPECT_EQ(lInf, LInfNormRange1(array1, 105));
+	EXPECT_EQ(0.0, DotRange1(array0, array1, 0));
+
+	Array1<float> array2({ -3.0f, 1.0f, 2.5f });
+	EXPECT_FLOAT_EQ(3.0f, LInfNormRange1(array2, 3));
+	EXPECT_FLOAT_EQ(std::sqrt(16.25f), L2NormRange1(array2, 3));
+}
+
 TEST(ArrayUtils, ExtrapolateToRegion2)
 {
 	Array2<double> data(10, 12, 0.0);
@@ -1,8 +1,12 @@
 #include "pch.h"
 #include "UnitTestsUtils.h"
 
+#include <Core/Array/Array1.h>
 #include <Core/Geometry/BVH3.h>
 
+#include <algorithm>
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(BVH3, Constructors)
@@ -256,4 +260,303 @@ TEST(BVH3, ForEachOverlappingItems)
 	});
 
 	EXPECT_EQ(numOverlaps, measured);
-}
\ No newline at end of file
+}
+
+TEST(BVH3, LargeBuild)
+{
+	// Enough items for the subtrees to be built by several tasks
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<> dist(0.0, 1.0);
+
+	std::vector<BoundingBox3D> items(5000);
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const Vector3D c(dist(rng), dist(rng), 0.1 * dist(rng));
+		items[i] = BoundingBox3D(c, c);
+		items[i].Expand(0.02 * dist(rng));
+	}
+
+	BVH3<BoundingBox3D> bvh;
+	bvh.Build(items, items);
+
+	BoundingBox3D expectedBound;
+	for (const auto& item : items)
+	{
+		expectedBound.Merge(item);
+	}
+
+	EXPECT_EQ(expectedBound.lowerCorner, bvh.GetBoundingBox().lowerCorner);
+	EXPECT_EQ(expectedBound.upperCorner, bvh.GetBoundingBox().upperCorner);
+
+	auto distanceFunc = [](const BoundingBox3D& a, const Vector3D& pt)
+	{
+		return a.Clamp(pt).DistanceTo(pt);
+	};
+
+	auto overlapsFunc = [](const BoundingBox3D& a, const BoundingBox3D& box)
+	{
+		return a.Overlaps(box);
+	};
+
+	auto intersectsFunc = [](const BoundingBox3D& a, const Ray3D& ray)
+	{
+		auto bboxResult = a.ClosestIntersection(ray);
+		return bboxResult.isIntersecting ? bboxResult.near : std::numeric_limits<double>::max();
+	};
+
+	for (size_t n = 0; n < 100; ++n)
+	{
+		const Vector3D pt(1.2 * dist(rng) - 0.1, 1.2 * dist(rng) - 0.1, 0.5 * dist(rng) - 0.2);
+
+		double bestDist = std::numeric_limits<double>::max();
+		for (const auto& item : items)
+		{
+			bestDist = std::min(bestDist, distanceFunc(item, pt));
+		}
+
+		EXPECT_EQ(bestDist, bvh.GetNearestNeighbor(pt, distanceFunc).distance);
+
+		BoundingBox3D box(pt, pt);
+		box.Expand(0.05);
+
+		size_t numOverlaps = 0;
+		for (const auto& item : items)
+		{
+			numOverlaps += overlapsFunc(item, box);
+		}
+
+		size_t measured = 0;
+		bvh.ForEachIntersectingItem(box, overlapsFunc, [&](const BoundingBox3D&)
+		{
+			++measured;
+		});
+
+		EXPECT_EQ(numOverlaps, measured);
+
+		const Ray3D ray(pt, Vector3D(dist(rng) - 0.5, dist(rng) - 0.5, dist(rng) - 0.5).Normalized());
+
+		double bestRayDist = std::numeric_limits<double>::max();
+		for (const auto& item : items)
+		{
+			bestRayDist = std::min(bestRayDist, intersectsFunc(item, ray));
+		}
+
+		EXPECT_EQ(bestRayDist, bvh.GetClosestIntersection(ray, intersectsFunc).distance);
+	}
+
+	// Batched queries
+	Array1<Vector3D> points(1000);
+	Array1<Ray3D> rays(points.size());
+	for (size_t n = 0; n < points.size(); ++n)
+	{
+		points[n] = Vector3D(1.2 * dist(rng) - 0.1, 1.2 * dist(rng) - 0.1, 0.5 * dist(rng) - 0.2);
+		rays[n] = Ray3D(points[n], Vector3D(dist(rng) - 0.5, dist(rng) - 0.5, dist(rng) - 0.5).Normalized());
+	}
+
+	Array1<NearestNeighborQueryResult3<BoundingBox3D>> nearest(points.size());
+	bvh.GetNearestNeighbors(points.ConstAccessor(), distanceFunc, nearest.Accessor());
+
+	Array1<ClosestIntersectionQueryResult3<BoundingBox3D>> intersections(rays.size());
+	bvh.GetClosestIntersections(rays.ConstAccessor(), intersectsFunc, intersections.Accessor());
+
+	for (size_t n = 0; n < points.size(); ++n)
+	{
+		const auto expected = bvh.GetNearestNeighbor(points[n], distanceFunc);
+		EXPECT_EQ(expected.distance, nearest[n].distance);
+		EXPECT_EQ(nearest[n].distance, distanceFunc(*nearest[n].item, points[n]));
+
+		const auto expectedIntersection = bvh.GetClosestIntersection(rays[n], intersectsFunc);
+		EXPECT_EQ(expectedIntersection.distance, intersections[n].distance);
+		EXPECT_EQ(expectedIntersection.item, intersections[n].item);
+	}
+}
+
+TEST(BVH3, BuildDoesNotDependOnThreadCount)
+{
+	// Enough items for the top nodes to be split in chunks, with duplicates
+	// which tie in the median splits
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<> dist(0.0, 1.0);
+
+	std::vector<size_t> items(100000);
+	std::vector<BoundingBox3D> bounds(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		items[i] = i;
+
+		if (i % 8 == 7)
+		{
+			bounds[i] = bounds[i - 1];
+			continue;
+		}
+
+		const Vector3D c(dist(rng), dist(rng), dist(rng));
+		bounds[i] = BoundingBox3D(c, c);
+		bounds[i].Expand(0.001 * dist(rng));
+	}
+
+	// The items in the order of the leaves
+	const auto GetLeafOrder = [&](unsigned int numThreads)
+	{
+		const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+		SetMaxNumberOfThreads(numThreads);
+
+		BVH3<size_t> bvh;
+		bvh.Build(items, bounds);
+
+		SetMaxNumberOfThreads(oldNumThreads);
+
+		std::vector<size_t> order;
+		bvh.ForEachIntersectingItem(bvh.GetBoundingBox(), [](size_t, const BoundingBox3D&)
+		{
+			return true;
+		}, [&](size_t item)
+		{
+			order.push_back(item);
+		});
+
+		return order;
+	};
+
+	const std::vector<size_t> serialOrder = GetLeafOrder(1);
+	EXPECT_EQ(items.size(), serialOrder.size());
+	EXPECT_EQ(serialOrder, GetLeafOrder(3));
+	EXPECT_EQ(serialOrder, GetLeafOrder(8));
+}
+
+TEST(BVH3, Rebuild)
+{
+	std::vector<Vector3D> points(300, Vector3D(0.5, 0.5, 0.5));
+	std::vector<BoundingBox3D> bounds(points.size(), BoundingBox3D(points[0], points[0]));
+
+	// Every item at the same point
+	BVH3<Vector3D> bvh;
+	bvh.Build(points, bounds);
+
+	auto distanceFunc = [](const Vector3D& a, const Vector3D& b)
+	{
+		return a.DistanceTo(b);
+	};
+
+	EXPECT_DOUBLE_EQ(std::sqrt(0.75), bvh.GetNearestNeighbor(Vector3D(1, 1, 1), distanceFunc).distance);
+
+	points.resize(2);
+	points[1] = Vector3D(2, 3, 4);
+	bounds.resize(2);
+	bounds[1] = BoundingBox3D(points[1], points[1]);
+	bvh.Build(points, bounds);
+
+	EXPECT_EQ(2u, bvh.GetNumberOfItems());
+	EXPECT_EQ(Vector3D(0.5, 0.5, 0.5), bvh.GetBoundingBox().lowerCorner);
+	EXPECT_EQ(Vector3D(2, 3, 4), bvh.GetBoundingBox().upperCorner);
+	EXPECT_EQ(&bvh.GetItem(1), bvh.GetNearestNeighbor(Vector3D(2, 3, 3), distanceFunc).item);
+}
+
+TEST(BVH3, Refit)
+{
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<> dist(0.0, 1.0);
+
+	std::vector<size_t> items(5000);
+	std::vector<BoundingBox3D> bounds(items.size());
+	std::vector<Vector3D> centers(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		items[i] = i;
+		centers[i] = Vector3D(dist(rng), dist(rng), dist(rng));
+	}
+
+	const auto updateBounds = [&]()
+	{
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			bounds[i] = BoundingBox3D(centers[i], centers[i]);
+			bounds[i].Expand(0.01);
+		}
+	};
+
+	const auto expectValidQueries = [&](BVH3<size_t>& bvh)
+	{
+		BoundingBox3D expectedBound;
+		for (const auto& bound : bounds)
+		{
+			expectedBound.Merge(bound);
+		}
+
+		EXPECT_EQ(expectedBound.lowerCorner, bvh.GetBoundingBox().lowerCorner);
+		EXPECT_EQ(expectedBound.upperCorner, bvh.GetBoundingBox().upperCorner);
+
+		auto distanceFunc = [&](size_t i, const Vector3D& pt)
+		{
+			return bounds[i].Clamp(pt).DistanceTo(pt);
+		};
+
+		for (size_t n = 0; n < 50; ++n)
+		{
+			const Vector3D pt = expectedBound.lowerCorner +
+				Vector3D(dist(rng), dist(rng), dist(rng)) * (expectedBound.upperCorner - expectedBound.lowerCorner);
+
+			double bestDist = std::numeric_limits<double>::max();
+			for (size_t i : items)
+			{
+				bestDist = std::min(bestDist, distanceFunc(i, pt));
+			}
+
+			EXPECT_EQ(bestDist, bvh.GetNearestNeighbor(pt, distanceFunc).distance);
+
+			BoundingBox3D box(pt, pt);
+			box.Expand(0.05);
+
+			size_t numOverlaps = 0;
+			for (size_t i : items)
+			{
+				numOverlaps += bounds[i].Overlaps(box);
+			}
+
+			size_t measured = 0;
+			bvh.ForEachIntersectingItem(box, [&](size_t i, const BoundingBox3D& b)
+			{
+				return bounds[i].Overlaps(b);
+			}, [&](size_t)
+			{
+				++measured;
+			});
+
+			EXPECT_EQ(numOverlaps, measured);
+		}
+	};
+
+	updateBounds();
+	BVH3<size_t> bvh;
+	bvh.Build(items, bounds);
+
+	// Rigid motion keeps the quality of the hierarchy
+	for (auto& center : centers)
+	{
+		center = Vector3D(3.0 * center.z - 1.0, center.x + 2.0, center.y);
+	}
+	updateBounds();
+
+	EXPECT_TRUE(bvh.Refit(bounds));
+	expectValidQueries(bvh);
+
+	// So does a small deformation
+	for (auto& center : centers)
+	{
+		center += 0.01 * Vector3D(dist(rng), dist(rng), dist(rng));
+	}
+	updateBounds();
+
+	EXPECT_TRUE(bvh.Refit(bounds));
+	expectValidQueries(bvh);
+
+	// Shuffling the items degrades it, so the hierarchy is rebuilt
+	std::shuffle(centers.begin(), centers.end(), rng);
+	updateBounds();
+
+	EXPECT_FALSE(bvh.Refit(bounds));
+	expectValidQueries(bvh);
+
+	EXPECT_TRUE(bvh.Refit(bounds));
+	expectValidQueries(bvh);
+}
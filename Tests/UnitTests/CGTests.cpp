@@ -1,11 +1,22 @@
 #include "pch.h"
 
+#include <FDMLinearSystemSolverTestHelper3.h>
+
 #include <Core/Math/CG.h>
 #include <Core/Matrix/Matrix2x2.h>
 #include <Core/Vector/Vector2.h>
 
 using namespace CubbyFlow;
 
+namespace
+{
+	// FDMBLAS3 without the fused kernels, to run the unfused PCG path
+	struct UnfusedFDMBLAS3 : FDMBLAS3
+	{
+		static void MVMDot() = delete;
+	};
+}
+
 TEST(CG, Solve)
 {
 	// Solve:
@@ -124,4 +135,53 @@ TEST(PCG, Solve)
 		EXPECT_LE(lastResidualNorm, std::numeric_limits<double>::epsilon());
 		EXPECT_LE(lastNumIter, 2u);
 	}
-}
\ No newline at end of file
+}
+
+TEST(PCG, FusedFDMKernels)
+{
+	FDMLinearSystem3 system;
+	FDMLinearSystemSolverTestHelper3::BuildTestLinearSystem(&system, { 12, 7, 9 });
+
+	const Size3 size = system.x.size();
+	FDMVector3 d(size), q(size), q2(size), x(size), r(size), x2(size), r2(size);
+	d.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		d(i, j, k) = std::sin(0.3 * i + 0.7 * j + 1.1 * k);
+		x(i, j, k) = x2(i, j, k) = std::cos(0.5 * i - 0.2 * j + 0.3 * k);
+		r(i, j, k) = r2(i, j, k) = 0.1 * i - 0.05 * j + 0.02 * k;
+	});
+
+	const double dq = FDMBLAS3::MVMDot(system.A, d, &q);
+	FDMBLAS3::MVM(system.A, d, &q2);
+	EXPECT_NEAR(FDMBLAS3::Dot(d, q2), dq, 1e-9);
+
+	const double rr = FDMBLAS3::UpdateSolutionAndResidual(0.25, d, q, &x, &r);
+	FDMBLAS3::AXPlusY(0.25, d, x2, &x2);
+	FDMBLAS3::AXPlusY(-0.25, q, r2, &r2);
+	EXPECT_NEAR(FDMBLAS3::Dot(r2, r2), rr, 1e-9);
+
+	d.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_EQ(q2(i, j, k), q(i, j, k));
+		EXPECT_DOUBLE_EQ(x2(i, j, k), x(i, j, k));
+		EXPECT_DOUBLE_EQ(r2(i, j, k), r(i, j, k));
+	});
+
+	// The fused and unfused CG converge the same way
+	FDMLinearSystem3 system2 = system;
+	FDMVector3 rv(size), dv(size), qv(size), sv(size);
+	unsigned int numberOfIterations, numberOfIterations2;
+	double residualNorm, residualNorm2;
+
+	CG<FDMBLAS3>(system.A, system.b, 100, 1e-9, &system.x,
+		&rv, &dv, &qv, &sv, &numberOfIterations, &residualNorm);
+	CG<UnfusedFDMBLAS3>(system2.A, system2.b, 100, 1e-9, &system2.x,
+		&rv, &dv, &qv, &sv, &numberOfIterations2, &residualNorm2);
+
+	EXPECT_NEAR(static_cast<double>(numberOfIterations2), static_cast<double>(numberOfIterations), 1.0);
+	EXPECT_GT(1e-9, residualNorm);
+	system.x.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_NEAR(system2.x(i, j, k), system.x(i, j, k), 1e-7);
+	});
+}
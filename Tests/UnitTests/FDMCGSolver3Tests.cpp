@@ -26,4 +26,61 @@ TEST(FDMCGSolver3, SolveCompressed)
     solver.SolveCompressed(&system);
 
     EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
-}
\ No newline at end of file
+}
+
+TEST(FDMCGSolver3, SolveMatrixFree)
+{
+    FDMMatrixFreeLinearSystem3 system;
+    Array3<char> markers;
+    FDMLinearSystemSolverTestHelper3::BuildTestMatrixFreeLinearSystem(&system, &markers, { 7, 6, 5 });
+
+    FDMLinearSystem3 assembled;
+    FDMMatrixFreeBLAS3::Set(system.A, &assembled.A);
+    assembled.x = system.x;
+    assembled.b = system.b;
+
+    FDMCGSolver3 solver(200, 1e-9);
+    EXPECT_TRUE(solver.SolveMatrixFree(&system));
+    EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
+    const unsigned int numberOfIterations = solver.GetLastNumberOfIterations();
+
+    // The matrix-free rows are the assembled rows, so CG takes the same steps
+    EXPECT_TRUE(solver.Solve(&assembled));
+    EXPECT_EQ(numberOfIterations, solver.GetLastNumberOfIterations());
+
+    system.x.ForEachIndex([&](size_t i, size_t j, size_t k)
+    {
+        EXPECT_NEAR(assembled.x(i, j, k), system.x(i, j, k), 1e-12);
+    });
+}
+
+TEST(FDMCGSolver3, SolvePrecision)
+{
+    FDMLinearSystem3 system, singleSystem, mixedSystem;
+    FDMLinearSystemSolverTestHelper3::BuildTestLinearSystem(&system, { 16, 9, 12 });
+    singleSystem = system;
+    mixedSystem = system;
+
+    FDMCGSolver3 solver(200, 1e-9);
+    EXPECT_EQ(FDMPrecision::Double, solver.GetPrecision());
+    EXPECT_TRUE(solver.Solve(&system));
+
+    // Single precision stalls above the tolerance, but stays close
+    FDMCGSolver3 singleSolver(200, 1e-9);
+    singleSolver.SetPrecision(FDMPrecision::Single);
+    EXPECT_EQ(FDMPrecision::Single, singleSolver.GetPrecision());
+    singleSolver.Solve(&singleSystem);
+    EXPECT_GT(1e-3, singleSolver.GetLastResidual());
+
+    // Iterative refinement recovers the double precision accuracy
+    FDMCGSolver3 mixedSolver(200, 1e-9);
+    mixedSolver.SetPrecision(FDMPrecision::Mixed);
+    EXPECT_TRUE(mixedSolver.Solve(&mixedSystem));
+    EXPECT_GE(mixedSolver.GetTolerance(), mixedSolver.GetLastResidual());
+
+    system.x.ForEachIndex([&](size_t i, size_t j, size_t k)
+    {
+        EXPECT_NEAR(system.x(i, j, k), singleSystem.x(i, j, k), 1e-3);
+        EXPECT_NEAR(system.x(i, j, k), mixedSystem.x(i, j, k), 1e-6);
+    });
+}
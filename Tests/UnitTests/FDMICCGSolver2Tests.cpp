@@ -33,4 +33,48 @@ TEST(FDMICCGSolver2, SolveCompressed)
 
     FDMICCGSolver2 solver(200, 1e-4);
     EXPECT_TRUE(solver.Solve(&system));
-}
\ No newline at end of file
+}
+TEST(FDMICCGSolver2, ParallelPreconditioner)
+{
+    FDMLinearSystem2 system, parallelSystem;
+    FDMLinearSystemSolverTestHelper2::BuildTestLinearSystem(&system, { 300, 17 });
+    parallelSystem = system;
+
+    FDMICCGSolver2 solver(100, 1e-9);
+    solver.Solve(&system);
+
+    FDMICCGSolver2 parallelSolver(100, 1e-9);
+    EXPECT_FALSE(parallelSolver.GetIsUsingParallelPreconditioner());
+    parallelSolver.SetIsUsingParallelPreconditioner(true);
+    EXPECT_TRUE(parallelSolver.GetIsUsingParallelPreconditioner());
+    parallelSolver.Solve(&parallelSystem);
+
+    // Level scheduling does not change the preconditioner
+    EXPECT_EQ(solver.GetLastNumberOfIterations(), parallelSolver.GetLastNumberOfIterations());
+    EXPECT_EQ(solver.GetLastResidual(), parallelSolver.GetLastResidual());
+    system.x.ForEachIndex([&](auto... indices)
+    {
+        EXPECT_EQ(system.x(indices...), parallelSystem.x(indices...));
+    });
+}
+
+TEST(FDMICCGSolver2, ParallelPreconditionerCompressed)
+{
+    FDMCompressedLinearSystem2 system, parallelSystem;
+    FDMLinearSystemSolverTestHelper2::BuildTestCompressedLinearSystem(&system, { 32, 17 });
+    parallelSystem = system;
+
+    FDMICCGSolver2 solver(100, 1e-9);
+    solver.SolveCompressed(&system);
+
+    FDMICCGSolver2 parallelSolver(100, 1e-9);
+    parallelSolver.SetIsUsingParallelPreconditioner(true);
+    parallelSolver.SolveCompressed(&parallelSystem);
+
+    EXPECT_EQ(solver.GetLastNumberOfIterations(), parallelSolver.GetLastNumberOfIterations());
+    EXPECT_EQ(solver.GetLastResidual(), parallelSolver.GetLastResidual());
+    for (size_t i = 0; i < system.x.size(); ++i)
+    {
+        EXPECT_EQ(system.x[i], parallelSystem.x[i]);
+    }
+}
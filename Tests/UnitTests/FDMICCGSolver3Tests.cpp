@@ -37,4 +37,106 @@ TEST(FDMICCGSolver3, SolveCompressed)
     solver.SolveCompressed(&system);
 
     EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
-}
\ No newline at end of file
+}
+TEST(FDMICCGSolver3, ParallelPreconditioner)
+{
+    FDMLinearSystem3 system, parallelSystem;
+    FDMLinearSystemSolverTestHelper3::BuildTestLinearSystem(&system, { 16, 9, 12 });
+    parallelSystem = system;
+
+    FDMICCGSolver3 solver(100, 1e-9);
+    solver.Solve(&system);
+
+    FDMICCGSolver3 parallelSolver(100, 1e-9);
+    EXPECT_FALSE(parallelSolver.GetIsUsingParallelPreconditioner());
+    parallelSolver.SetIsUsingParallelPreconditioner(true);
+    EXPECT_TRUE(parallelSolver.GetIsUsingParallelPreconditioner());
+    parallelSolver.Solve(&parallelSystem);
+
+    // Level scheduling does not change the preconditioner
+    EXPECT_EQ(solver.GetLastNumberOfIterations(), parallelSolver.GetLastNumberOfIterations());
+    EXPECT_EQ(solver.GetLastResidual(), parallelSolver.GetLastResidual());
+    system.x.ForEachIndex([&](auto... indices)
+    {
+        EXPECT_EQ(system.x(indices...), parallelSystem.x(indices...));
+    });
+}
+
+TEST(FDMICCGSolver3, ParallelPreconditionerCompressed)
+{
+    FDMCompressedLinearSystem3 system, parallelSystem;
+    FDMLinearSystemSolverTestHelper3::BuildTestCompressedLinearSystem(&system, { 16, 9, 12 });
+    parallelSystem = system;
+
+    FDMICCGSolver3 solver(100, 1e-9);
+    solver.SolveCompressed(&system);
+
+    FDMICCGSolver3 parallelSolver(100, 1e-9);
+    parallelSolver.SetIsUsingParallelPreconditioner(true);
+    parallelSolver.SolveCompressed(&parallelSystem);
+
+    EXPECT_EQ(solver.GetLastNumberOfIterations(), parallelSolver.GetLastNumberOfIterations());
+    EXPECT_EQ(solver.GetLastResidual(), parallelSolver.GetLastResidual());
+    for (size_t i = 0; i < system.x.size(); ++i)
+    {
+        EXPECT_EQ(system.x[i], parallelSystem.x[i]);
+    }
+}
+
+TEST(FDMICCGSolver3, SolveMatrixFree)
+{
+    FDMMatrixFreeLinearSystem3 system;
+    Array3<char> markers;
+    FDMLinearSystemSolverTestHelper3::BuildTestMatrixFreeLinearSystem(&system, &markers, { 7, 6, 5 });
+
+    FDMLinearSystem3 assembled;
+    FDMMatrixFreeBLAS3::Set(system.A, &assembled.A);
+    assembled.x = system.x;
+    assembled.b = system.b;
+
+    FDMICCGSolver3 solver(100, 1e-9);
+    solver.SetIsUsingParallelPreconditioner(true);
+    EXPECT_TRUE(solver.SolveMatrixFree(&system));
+    EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
+    const unsigned int numberOfIterations = solver.GetLastNumberOfIterations();
+
+    // The preconditioner is built from the same rows as the assembled one
+    EXPECT_TRUE(solver.Solve(&assembled));
+    EXPECT_EQ(numberOfIterations, solver.GetLastNumberOfIterations());
+
+    system.x.ForEachIndex([&](size_t i, size_t j, size_t k)
+    {
+        EXPECT_NEAR(assembled.x(i, j, k), system.x(i, j, k), 1e-12);
+    });
+}
+
+TEST(FDMICCGSolver3, SolvePrecision)
+{
+    FDMLinearSystem3 system, singleSystem, mixedSystem;
+    FDMLinearSystemSolverTestHelper3::BuildTestLinearSystem(&system, { 16, 9, 12 });
+    singleSystem = system;
+    mixedSystem = system;
+
+    FDMICCGSolver3 solver(200, 1e-9);
+    EXPECT_EQ(FDMPrecision::Double, solver.GetPrecision());
+    EXPECT_TRUE(solver.Solve(&system));
+
+    // Single precision stalls above the tolerance, but stays close
+    FDMICCGSolver3 singleSolver(200, 1e-9);
+    singleSolver.SetPrecision(FDMPrecision::Single);
+    EXPECT_EQ(FDMPrecision::Single, singleSolver.GetPrecision());
+    singleSolver.Solve(&singleSystem);
+    EXPECT_GT(1e-3, singleSolver.GetLastResidual());
+
+    // Iterative refinement recovers the double precision accuracy
+    FDMICCGSolver3 mixedSolver(200, 1e-9);
+    mixedSolver.SetPrecision(FDMPrecision::Mixed);
+    EXPECT_TRUE(mixedSolver.Solve(&mixedSystem));
+    EXPECT_GE(mixedSolver.GetTolerance(), mixedSolver.GetLastResidual());
+
+    system.x.ForEachIndex([&](size_t i, size_t j, size_t k)
+    {
+        EXPECT_NEAR(system.x(i, j, k), singleSystem.x(i, j, k), 1e-3);
+        EXPECT_NEAR(system.x(i, j, k), mixedSystem.x(i, j, k), 1e-6);
+    });
+}
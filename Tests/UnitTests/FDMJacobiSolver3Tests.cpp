@@ -26,4 +26,19 @@ TEST(FDMJacobiSolver3, SolveCompressed)
     solver.SolveCompressed(&system);
 
     EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
-}
\ No newline at end of file
+}
+
+TEST(FDMJacobiSolver3, SolveMatrixFree)
+{
+    FDMMatrixFreeLinearSystem3 system;
+    Array3<char> markers;
+    FDMLinearSystemSolverTestHelper3::BuildTestMatrixFreeLinearSystem(&system, &markers, { 3, 3, 3 });
+
+    // The default implementation assembles the matrix and solves it
+    FDMJacobiSolver3 solver(1000, 10, 1e-9);
+    solver.SolveMatrixFree(&system);
+
+    EXPECT_GT(solver.GetTolerance(), solver.GetLastResidual());
+    EXPECT_EQ(Size3(3, 3, 3), system.x.size());
+    EXPECT_EQ(Size3(3, 3, 3), system.b.size());
+}
@@ -141,6 +141,43 @@ namespace CubbyFlow
 
             system->x.Resize(system->b.size(), 0.0);
         }
+
+        static void BuildTestMatrixFreeLinearSystem(FDMMatrixFreeLinearSystem3* system, Array3<char>* markers, const Size3& size)
+        {
+            // Air on the top layer and a boundary on every other column of the left wall
+            markers->Resize(size);
+            markers->ForEachIndex([&](size_t i, size_t j, size_t k)
+            {
+                if (j + 1 == size.y)
+                {
+                    (*markers)(i, j, k) = FDMMatrixFree3::AIR;
+                }
+                else if (i == 0 && k % 2 == 0)
+                {
+                    (*markers)(i, j, k) = FDMMatrixFree3::BOUNDARY;
+                }
+                else
+                {
+                    (*markers)(i, j, k) = FDMMatrixFree3::FLUID;
+                }
+            });
+
+            system->Resize(size);
+            system->A.markers = markers->ConstAccessor();
+            system->A.invHSqr = Vector3D(1.0, 4.0, 0.25);
+
+            system->b.ForEachIndex([&](size_t i, size_t j, size_t k)
+            {
+                if ((*markers)(i, j, k) == FDMMatrixFree3::FLUID)
+                {
+                    system->b(i, j, k) = static_cast<double>((i + 2 * j + 3 * k) % 5) - 2.0;
+                }
+                else
+                {
+                    system->b(i, j, k) = 0.0;
+                }
+            });
+        }
     };
 }
 
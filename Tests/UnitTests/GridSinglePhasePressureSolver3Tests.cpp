@@ -422,4 +422,58 @@ TEST(GridSinglePhasePressureSolver3, SolveFreeSurfaceWithBoundary)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST(GridSinglePhasePressureSolver3, SolveFreeSurfaceWithBoundaryMatrixFree)
+{
+	FaceCenteredGrid3 vel(8, 8, 8);
+	CellCenteredScalarGrid3 fluidSDF(8, 8, 8);
+	CellCenteredScalarGrid3 boundarySDF(8, 8, 8);
+
+	vel.Fill([](const Vector3D& x)
+	{
+		return Vector3D(std::sin(x.y), std::cos(x.z + x.x), x.x * x.y);
+	});
+
+	// Wall on the right side, liquid surface in the middle
+	boundarySDF.Fill([&](const Vector3D& x)
+	{
+		return -x.x + 6.0;
+	});
+	fluidSDF.Fill([&](const Vector3D& x)
+	{
+		return x.y - 5.0;
+	});
+
+	FaceCenteredGrid3 vel2(vel);
+
+	GridSinglePhasePressureSolver3 solver;
+	solver.Solve(vel, 1.0, &vel, boundarySDF, ConstantVectorField3({ 0, 0, 0 }), fluidSDF);
+
+	GridSinglePhasePressureSolver3 matrixFreeSolver;
+	EXPECT_FALSE(matrixFreeSolver.GetIsUsingMatrixFree());
+	matrixFreeSolver.SetIsUsingMatrixFree(true);
+	EXPECT_TRUE(matrixFreeSolver.GetIsUsingMatrixFree());
+	matrixFreeSolver.Solve(vel2, 1.0, &vel2, boundarySDF, ConstantVectorField3({ 0, 0, 0 }), fluidSDF);
+
+	const auto& pressure = solver.GetPressure();
+	const auto& pressure2 = matrixFreeSolver.GetPressure();
+	EXPECT_EQ(pressure.size(), pressure2.size());
+	pressure.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_NEAR(pressure(i, j, k), pressure2(i, j, k), 1e-9);
+	});
+
+	vel.ForEachUIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_NEAR(vel.GetU(i, j, k), vel2.GetU(i, j, k), 1e-9);
+	});
+	vel.ForEachVIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_NEAR(vel.GetV(i, j, k), vel2.GetV(i, j, k), 1e-9);
+	});
+	vel.ForEachWIndex([&](size_t i, size_t j, size_t k)
+	{
+		EXPECT_NEAR(vel.GetW(i, j, k), vel2.GetW(i, j, k), 1e-9);
+	});
+}
@@ -4,6 +4,8 @@
 #include <Core/Geometry/Sphere3.h>
 #include <Core/Size/Size2.h>
 #include <Core/Size/Size3.h>
+#include <Core/Solver/LevelSet/FMMLevelSetSolver3.h>
+#include <Core/Solver/LevelSet/FastSweepingLevelSetSolver3.h>
 #include <Core/Solver/LevelSet/LevelSetLiquidSolver2.h>
 #include <Core/Solver/LevelSet/LevelSetLiquidSolver3.h>
 #include <Core/Surface/ImplicitSurface2.h>
@@ -67,4 +69,29 @@ TEST(LevelSetLiquidSolver3, ComputeVolume)
 	const double ans = 4.0 / 3.0 * Cubic(radius) * PI_DOUBLE;
 
 	EXPECT_NEAR(ans, volume, 0.001);
-}
\ No newline at end of file
+}
+
+TEST(LevelSetLiquidSolver3, VelocityExtrapolator)
+{
+	LevelSetLiquidSolver3 solver;
+	EXPECT_NE(nullptr, std::dynamic_pointer_cast<FMMLevelSetSolver3>(solver.GetVelocityExtrapolator()));
+
+	auto extrapolator = std::make_shared<FastSweepingLevelSetSolver3>();
+	solver.SetVelocityExtrapolator(extrapolator);
+	EXPECT_EQ(extrapolator, solver.GetVelocityExtrapolator());
+
+	auto data = solver.GetGridSystemData();
+	double dx = 1.0 / 16.0;
+	data->Resize(Size3(16, 16, 16), Vector3D(dx, dx, dx), Vector3D());
+
+	auto sdf = solver.GetSignedDistanceField();
+	sdf->Fill([&](const Vector3D& x)
+	{
+		return x.y - 0.5;
+	});
+
+	for (Frame frame(0, 1.0 / 60.0); frame.index < 2; ++frame)
+	{
+		solver.Update(frame);
+	}
+}
@@ -4,6 +4,7 @@
 #include <Core/Grid/CellCenteredScalarGrid3.h>
 #include <Core/Solver/LevelSet/ENOLevelSetSolver2.h>
 #include <Core/Solver/LevelSet/ENOLevelSetSolver3.h>
+#include <Core/Solver/LevelSet/FastSweepingLevelSetSolver3.h>
 #include <Core/Solver/LevelSet/FMMLevelSetSolver2.h>
 #include <Core/Solver/LevelSet/FMMLevelSetSolver3.h>
 #include <Core/Solver/LevelSet/UpwindLevelSetSolver2.h>
@@ -107,6 +108,80 @@ TEST(UpwindLevelSetSolver3, Extrapolate)
 	}
 }
 
+TEST(UpwindLevelSetSolver3, ReinitializeNarrowBand)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), dense(40, 30, 50), band(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return 1.2 * ((x - Vector3D(20, 20, 20)).Length() - 8.0);
+	});
+
+	UpwindLevelSetSolver3 solver;
+	solver.Reinitialize(sdf, 5.0, &dense);
+
+	EXPECT_FALSE(solver.GetIsUsingNarrowBand());
+	solver.SetIsUsingNarrowBand(true);
+	EXPECT_TRUE(solver.GetIsUsingNarrowBand());
+	solver.Reinitialize(sdf, 5.0, &band);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				if (std::fabs(dense(i, j, k)) < 5.0)
+				{
+					EXPECT_NEAR(dense(i, j, k), band(i, j, k), 1e-2)
+						<< i << ", " << j << ", " << k;
+				}
+				else if (std::fabs(sdf(i, j, k)) > 5.0 + 3.0)
+				{
+					EXPECT_DOUBLE_EQ(sdf(i, j, k), band(i, j, k))
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
+TEST(UpwindLevelSetSolver3, ExtrapolateNarrowBand)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), dense(40, 30, 50), band(40, 30, 50);
+	CellCenteredScalarGrid3 field(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() - 8.0;
+	});
+	field.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() <= 8.0 ? x.x + 2.0 * x.y - x.z : 0.0;
+	});
+
+	UpwindLevelSetSolver3 solver;
+	solver.Extrapolate(field, sdf, 5.0, &dense);
+
+	solver.SetIsUsingNarrowBand(true);
+	solver.Extrapolate(field, sdf, 5.0, &band);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				if (sdf(i, j, k) < 5.0)
+				{
+					EXPECT_NEAR(dense(i, j, k), band(i, j, k), 1e-3)
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
 TEST(ENOLevelSetSolver2, Reinitialize)
 {
 	CellCenteredScalarGrid2 sdf(40, 30), temp(40, 30);
@@ -203,6 +278,80 @@ TEST(ENOLevelSetSolver3, Extrapolate)
 	}
 }
 
+TEST(ENOLevelSetSolver3, ReinitializeNarrowBand)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), dense(40, 30, 50), band(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return 1.2 * ((x - Vector3D(20, 20, 20)).Length() - 8.0);
+	});
+
+	ENOLevelSetSolver3 solver;
+	solver.Reinitialize(sdf, 5.0, &dense);
+
+	EXPECT_FALSE(solver.GetIsUsingNarrowBand());
+	solver.SetIsUsingNarrowBand(true);
+	EXPECT_TRUE(solver.GetIsUsingNarrowBand());
+	solver.Reinitialize(sdf, 5.0, &band);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				if (std::fabs(dense(i, j, k)) < 5.0)
+				{
+					EXPECT_NEAR(dense(i, j, k), band(i, j, k), 1e-2)
+						<< i << ", " << j << ", " << k;
+				}
+				else if (std::fabs(sdf(i, j, k)) > 5.0 + 3.0)
+				{
+					EXPECT_DOUBLE_EQ(sdf(i, j, k), band(i, j, k))
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
+TEST(ENOLevelSetSolver3, ExtrapolateNarrowBand)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), dense(40, 30, 50), band(40, 30, 50);
+	CellCenteredScalarGrid3 field(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() - 8.0;
+	});
+	field.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() <= 8.0 ? x.x + 2.0 * x.y - x.z : 0.0;
+	});
+
+	ENOLevelSetSolver3 solver;
+	solver.Extrapolate(field, sdf, 5.0, &dense);
+
+	solver.SetIsUsingNarrowBand(true);
+	solver.Extrapolate(field, sdf, 5.0, &band);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				if (sdf(i, j, k) < 5.0)
+				{
+					EXPECT_NEAR(dense(i, j, k), band(i, j, k), 1e-3)
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
 TEST(FMMLevelSetSolver2, Reinitialize)
 {
 	CellCenteredScalarGrid2 sdf(40, 30), temp(40, 30);
@@ -297,4 +446,129 @@ TEST(FMMLevelSetSolver3, Extrapolate)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+TEST(FastSweepingLevelSetSolver3, Reinitialize)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() - 8.0;
+	});
+
+	FastSweepingLevelSetSolver3 solver;
+	solver.Reinitialize(sdf, 5.0, &temp);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				EXPECT_NEAR(sdf(i, j, k), temp(i, j, k), 0.9)
+					<< i << ", " << j << ", " << k;
+
+				if (std::fabs(sdf(i, j, k)) < 4.0)
+				{
+					EXPECT_NEAR(sdf(i, j, k), temp(i, j, k), 0.4)
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
+TEST(FastSweepingLevelSetSolver3, ReinitializeDistorted)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return 3.0 * ((x - Vector3D(20, 20, 20)).Length() - 8.0);
+	});
+
+	FastSweepingLevelSetSolver3 solver;
+	solver.Reinitialize(sdf, 5.0, &temp);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				const double expected = sdf(i, j, k) / 3.0;
+
+				if (std::fabs(expected) < 4.0)
+				{
+					EXPECT_NEAR(expected, temp(i, j, k), 0.9)
+						<< i << ", " << j << ", " << k;
+				}
+				else if (std::fabs(expected) > 6.0)
+				{
+					EXPECT_DOUBLE_EQ(sdf(i, j, k), temp(i, j, k))
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
+
+TEST(FastSweepingLevelSetSolver3, Extrapolate)
+{
+	CellCenteredScalarGrid3 sdf(40, 30, 50), temp(40, 30, 50), fmm(40, 30, 50);
+	CellCenteredScalarGrid3 field(40, 30, 50);
+
+	sdf.Fill([](const Vector3D& x)
+	{
+		return (x - Vector3D(20, 20, 20)).Length() - 8.0;
+	});
+	field.Fill(5.0);
+
+	FastSweepingLevelSetSolver3 solver;
+	solver.Extrapolate(field, sdf, 5.0, &temp);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				EXPECT_DOUBLE_EQ(5.0, temp(i, j, k))
+					<< i << ", " << j << ", " << k;
+			}
+		}
+	}
+
+	// The center is off the grid, so that no two neighbors have the same
+	// SDF value and the upwind order matches the one of FMM.
+	const Vector3D center(20.31, 19.73, 20.12);
+
+	sdf.Fill([&](const Vector3D& x)
+	{
+		return (x - center).Length() - 8.0;
+	});
+	field.Fill([&](const Vector3D& x)
+	{
+		return (x - center).Length() <= 8.0 ? x.x + 2.0 * x.y - x.z : 0.0;
+	});
+
+	solver.Extrapolate(field, sdf, 5.0, &temp);
+
+	FMMLevelSetSolver3 fmmSolver;
+	fmmSolver.Extrapolate(field, sdf, 5.0, &fmm);
+
+	for (size_t k = 0; k < 50; ++k)
+	{
+		for (size_t j = 0; j < 30; ++j)
+		{
+			for (size_t i = 0; i < 40; ++i)
+			{
+				if (sdf(i, j, k) < 5.0)
+				{
+					EXPECT_NEAR(fmm(i, j, k), temp(i, j, k), 1e-6)
+						<< i << ", " << j << ", " << k;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include <Core/Array/Array3.h>
+#include <Core/MarchingCubes/MarchingCubes.h>
+
+#include <sstream>
+
+using namespace CubbyFlow;
+
+namespace
+{
+	void ExpectSameMesh(const TriangleMesh3& expected, const TriangleMesh3& actual)
+	{
+		ASSERT_EQ(expected.NumberOfPoints(), actual.NumberOfPoints());
+		ASSERT_EQ(expected.NumberOfNormals(), actual.NumberOfNormals());
+		ASSERT_EQ(expected.NumberOfUVs(), actual.NumberOfUVs());
+		ASSERT_EQ(expected.NumberOfTriangles(), actual.NumberOfTriangles());
+
+		for (size_t i = 0; i < expected.NumberOfPoints(); ++i)
+		{
+			EXPECT_EQ(expected.Point(i), actual.Point(i));
+			EXPECT_EQ(expected.Normal(i), actual.Normal(i));
+		}
+
+		for (size_t i = 0; i < expected.NumberOfTriangles(); ++i)
+		{
+			EXPECT_EQ(expected.PointIndex(i), actual.PointIndex(i));
+			EXPECT_EQ(expected.NormalIndex(i), actual.NormalIndex(i));
+			EXPECT_EQ(expected.UVIndex(i), actual.UVIndex(i));
+		}
+	}
+}
+
+TEST(MarchingCubes, ParallelMatchesSerial)
+{
+	Array3<double> grid(23, 31, 37);
+	grid.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		const Vector3D x(0.1 * i, 0.1 * j, 0.1 * k);
+		grid(i, j, k) = (x - Vector3D(1.1, 1.4, 1.7)).Length() - 0.9 + 0.1 * std::sin(7.0 * x.x) * std::cos(5.0 * x.z);
+	});
+
+	for (int bndFlag : { DIRECTION_NONE, DIRECTION_ALL })
+	{
+		TriangleMesh3 serialMesh;
+		MarchingCubes(grid, Vector3D(0.1, 0.1, 0.1), Vector3D(), &serialMesh, 0.0, bndFlag, ExecutionPolicy::Serial);
+
+		TriangleMesh3 parallelMesh;
+		MarchingCubes(grid, Vector3D(0.1, 0.1, 0.1), Vector3D(), &parallelMesh, 0.0, bndFlag, ExecutionPolicy::Parallel);
+
+		EXPECT_LT(0u, serialMesh.NumberOfTriangles());
+		ExpectSameMesh(serialMesh, parallelMesh);
+	}
+}
+
+TEST(MarchingCubes, ParallelAppendsToMesh)
+{
+	// The surface crosses the whole domain, so the boundary faces are
+	// extracted too.
+	Array3<double> grid(16, 12, 40);
+	grid.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		grid(i, j, k) = static_cast<double>(j) - 5.5 + 2.0 * std::sin(0.3 * i + 0.2 * k);
+	});
+
+	TriangleMesh3 serialMesh;
+	serialMesh.AddPoint(Vector3D(1, 2, 3));
+	serialMesh.AddNormal(Vector3D(0, 0, 1));
+	serialMesh.AddUV(Vector2D());
+	TriangleMesh3 parallelMesh(serialMesh);
+
+	MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(-1, 0, 2), &serialMesh, 0.0, DIRECTION_ALL, ExecutionPolicy::Serial);
+	MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(-1, 0, 2), &parallelMesh, 0.0, DIRECTION_ALL, ExecutionPolicy::Parallel);
+
+	EXPECT_LT(1u, serialMesh.NumberOfPoints());
+	ExpectSameMesh(serialMesh, parallelMesh);
+}
+
+TEST(MarchingCubes, Streaming)
+{
+	Array3<double> grid(19, 26, 33);
+	grid.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		const Vector3D x(0.1 * i, 0.1 * j, 0.1 * k);
+		grid(i, j, k) = (x - Vector3D(0.9, 1.3, 1.6)).Length() - 1.0 + 0.1 * std::sin(6.0 * x.y);
+	});
+
+	size_t lastSlice = 0;
+	auto slice = [&](size_t k, ArrayAccessor2<double> data)
+	{
+		EXPECT_EQ(lastSlice, k);
+		lastSlice = k + 1;
+
+		data.ForEachIndex([&](size_t i, size_t j)
+		{
+			data(i, j) = grid(i, j, k);
+		});
+	};
+
+	for (int bndFlag : { DIRECTION_NONE, DIRECTION_ALL })
+	{
+		TriangleMesh3 mesh;
+		MarchingCubes(grid, Vector3D(0.1, 0.1, 0.1), Vector3D(), &mesh, 0.0, bndFlag);
+
+		TriangleMesh3 streamedMesh;
+		lastSlice = 0;
+		MarchingCubes(slice, grid.size(), Vector3D(0.1, 0.1, 0.1), Vector3D(),
+			[&](const Vector3D& pt, const Vector3D& normal)
+		{
+			streamedMesh.AddPoint(pt);
+			streamedMesh.AddNormal(normal);
+			streamedMesh.AddUV(Vector2D());
+		},
+			[&](const Point3UI& face)
+		{
+			for (size_t j = 0; j < 3; ++j)
+			{
+				EXPECT_LT(face[j], streamedMesh.NumberOfPoints());
+			}
+			streamedMesh.AddPointUVNormalTriangle(face, face, face);
+		}, 0.0, bndFlag);
+		EXPECT_EQ(grid.Depth(), lastSlice);
+
+		if (bndFlag == DIRECTION_NONE)
+		{
+			ExpectSameMesh(mesh, streamedMesh);
+		}
+		else
+		{
+			EXPECT_EQ(mesh.NumberOfPoints(), streamedMesh.NumberOfPoints());
+			EXPECT_EQ(mesh.NumberOfTriangles(), streamedMesh.NumberOfTriangles());
+			EXPECT_NEAR(mesh.Area(), streamedMesh.Area(), 1e-9);
+		}
+	}
+}
+
+TEST(MarchingCubes, StreamingObj)
+{
+	Array3<double> grid(12, 10, 14);
+	grid.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		grid(i, j, k) = (Vector3D(i, j, k) - Vector3D(5.2, 4.7, 6.1)).Length() - 3.5;
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(grid, Vector3D(1, 1, 1), Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+
+	std::stringstream stream;
+	stream.precision(17);
+	MarchingCubes([&](size_t k, ArrayAccessor2<double> data)
+	{
+		data.ForEachIndex([&](size_t i, size_t j)
+		{
+			data(i, j) = grid(i, j, k);
+		});
+	}, grid.size(), Vector3D(1, 1, 1), Vector3D(), &stream, 0.0, DIRECTION_NONE);
+
+	TriangleMesh3 streamedMesh;
+	EXPECT_TRUE(streamedMesh.ReadObj(&stream));
+
+	ASSERT_EQ(mesh.NumberOfPoints(), streamedMesh.NumberOfPoints());
+	ASSERT_EQ(mesh.NumberOfTriangles(), streamedMesh.NumberOfTriangles());
+
+	for (size_t i = 0; i < mesh.NumberOfPoints(); ++i)
+	{
+		EXPECT_EQ(mesh.Point(i), streamedMesh.Point(i));
+	}
+
+	for (size_t i = 0; i < mesh.NumberOfTriangles(); ++i)
+	{
+		EXPECT_EQ(mesh.PointIndex(i), streamedMesh.PointIndex(i));
+	}
+}
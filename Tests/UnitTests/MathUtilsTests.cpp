@@ -165,4 +165,20 @@ TEST(MathUtils, MonotonicCatmullRom)
 			EXPECT_FLOAT_EQ(c, result);
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST(MathUtils, MortonCode)
+{
+	EXPECT_EQ(0u, MortonCode(0u, 0u));
+	EXPECT_EQ(1u, MortonCode(1u, 0u));
+	EXPECT_EQ(2u, MortonCode(0u, 1u));
+	EXPECT_EQ(15u, MortonCode(3u, 3u));
+	EXPECT_EQ(0xFFFFFFFFFFFFFFFFull, MortonCode(0xFFFFFFFFu, 0xFFFFFFFFu));
+
+	EXPECT_EQ(0u, MortonCode(0u, 0u, 0u));
+	EXPECT_EQ(1u, MortonCode(1u, 0u, 0u));
+	EXPECT_EQ(2u, MortonCode(0u, 1u, 0u));
+	EXPECT_EQ(4u, MortonCode(0u, 0u, 1u));
+	EXPECT_EQ(56u, MortonCode(2u, 2u, 2u));
+	EXPECT_EQ(0x7FFFFFFFFFFFFFFFull, MortonCode(0x1FFFFFu, 0x1FFFFFu, 0x1FFFFFu));
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+
+#include <Core/Particle/NeighborLists.h>
+
+using namespace CubbyFlow;
+
+TEST(NeighborLists, Constructors)
+{
+	NeighborLists<size_t> lists;
+	EXPECT_EQ(0u, lists.size());
+	EXPECT_TRUE(lists.empty());
+	EXPECT_EQ(0u, lists.NumberOfNeighbors());
+
+	NeighborLists<uint32_t> lists2({ { 1, 2 }, {}, { 0, 3, 4 } });
+	EXPECT_EQ(3u, lists2.size());
+	EXPECT_EQ(5u, lists2.NumberOfNeighbors());
+	EXPECT_EQ(2u, lists2[0].size());
+	EXPECT_EQ(0u, lists2[1].size());
+	EXPECT_EQ(3u, lists2[2].size());
+	EXPECT_EQ(4u, lists2[2][2]);
+}
+
+TEST(NeighborLists, AddNeighbor)
+{
+	NeighborLists<uint32_t> lists;
+	lists.AddNeighbor(5);
+	lists.AddNeighbor(7);
+	lists.EndList();
+	lists.EndList();
+	lists.AddNeighbor(1);
+	lists.EndList();
+
+	EXPECT_EQ(3u, lists.size());
+
+	const std::vector<size_t> offsets = { 0, 2, 2, 3 };
+	EXPECT_EQ(offsets, lists.Offsets());
+
+	size_t sum = 0;
+	for (size_t j : lists[0])
+	{
+		sum += j;
+	}
+	EXPECT_EQ(12u, sum);
+
+	lists.Clear();
+	EXPECT_TRUE(lists.empty());
+	EXPECT_EQ(0u, lists.NumberOfNeighbors());
+}
+
+TEST(NeighborLists, ToNestedLists)
+{
+	const std::vector<std::vector<size_t>> nested = { { 3 }, { 0, 2 }, {}, { 1 } };
+
+	NeighborLists<size_t> lists(nested);
+	EXPECT_EQ(nested, lists.ToNestedLists());
+
+	NeighborLists<uint32_t> lists2;
+	lists2.Set(nested);
+	EXPECT_EQ(nested, lists2.ToNestedLists());
+}
+
+TEST(NeighborLists, Build)
+{
+	const std::vector<std::vector<size_t>> nested = { { 3 }, { 0, 2 }, {}, { 1, 4, 0 }, { 2 } };
+
+	NeighborLists<uint32_t> lists;
+	lists.Build(nested.size(), [&](size_t i)
+	{
+		return nested[i].size();
+	}, [&](size_t i, uint32_t* neighbors)
+	{
+		for (size_t j : nested[i])
+		{
+			*neighbors++ = static_cast<uint32_t>(j);
+		}
+	});
+
+	const std::vector<size_t> offsets = { 0, 1, 3, 3, 6, 7 };
+	EXPECT_EQ(offsets, lists.Offsets());
+	EXPECT_EQ(nested, lists.ToNestedLists());
+}
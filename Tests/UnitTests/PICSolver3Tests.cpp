@@ -1,7 +1,10 @@
 #include "pch.h"
 
+#include <Core/Array/ArraySamplers3.h>
 #include <Core/Solver/Hybrid/PIC/PICSolver3.h>
 
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(PICSolver3, UpdateEmpty)
@@ -12,4 +15,116 @@ TEST(PICSolver3, UpdateEmpty)
 	{
 		solver.Update(frame);
 	}
+}
+
+namespace
+{
+	class PICSolver3P2G : public PICSolver3
+	{
+	public:
+		using PICSolver3::PICSolver3;
+		using PICSolver3::TransferFromParticlesToGrids;
+	};
+}
+
+TEST(PICSolver3, TransferFromParticlesToGridsIsDeterministic)
+{
+	PICSolver3P2G solver({ 16, 16, 16 }, { 1.0 / 16.0, 1.0 / 16.0, 1.0 / 16.0 }, { 0, 0, 0 });
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<> d(0.0, 1.0);
+
+	Array1<Vector3D> positions(5000);
+	Array1<Vector3D> velocities(5000);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = Vector3D(d(rng), d(rng), d(rng));
+		velocities[i] = Vector3D(d(rng), d(rng), d(rng)) - Vector3D(0.5, 0.5, 0.5);
+	}
+	solver.GetParticleSystemData()->AddParticles(positions, velocities);
+
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+	SetMaxNumberOfThreads(1);
+	solver.TransferFromParticlesToGrids();
+	FaceCenteredGrid3 expected(*solver.GetGridSystemData()->GetVelocity());
+
+	for (unsigned int numThreads : { 2u, 3u, 8u })
+	{
+		SetMaxNumberOfThreads(numThreads);
+		solver.TransferFromParticlesToGrids();
+
+		auto vel = solver.GetGridSystemData()->GetVelocity();
+		vel->ForEachUIndex([&](size_t i, size_t j, size_t k)
+		{
+			EXPECT_EQ(expected.GetU(i, j, k), vel->GetU(i, j, k));
+		});
+		vel->ForEachVIndex([&](size_t i, size_t j, size_t k)
+		{
+			EXPECT_EQ(expected.GetV(i, j, k), vel->GetV(i, j, k));
+		});
+		vel->ForEachWIndex([&](size_t i, size_t j, size_t k)
+		{
+			EXPECT_EQ(expected.GetW(i, j, k), vel->GetW(i, j, k));
+		});
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(PICSolver3, TransferFromParticlesToGridsMatchesSerialReference)
+{
+	PICSolver3P2G solver({ 16, 16, 16 }, { 1.0 / 16.0, 1.0 / 16.0, 1.0 / 16.0 }, { 0, 0, 0 });
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<> d(0.0, 1.0);
+
+	Array1<Vector3D> positions(5000);
+	Array1<Vector3D> velocities(5000);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = Vector3D(d(rng), d(rng), d(rng));
+		velocities[i] = Vector3D(d(rng), d(rng), d(rng)) - Vector3D(0.5, 0.5, 0.5);
+	}
+	solver.GetParticleSystemData()->AddParticles(positions, velocities);
+
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+	SetMaxNumberOfThreads(8);
+	solver.TransferFromParticlesToGrids();
+	SetMaxNumberOfThreads(oldNumThreads);
+
+	auto vel = solver.GetGridSystemData()->GetVelocity();
+
+	// Plain serial weighted average, one face component at a time
+	auto checkComponent = [&](const ConstArrayAccessor3<double>& actual,
+		const Vector3D& origin, size_t axis)
+	{
+		LinearArraySampler3<double, double> sampler(actual, vel->GridSpacing(), origin);
+		Array3<double> sum(actual.size());
+		Array3<double> weightSum(actual.size());
+
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			std::array<Point3UI, 8> indices;
+			std::array<double, 8> weights;
+
+			sampler.GetCoordinatesAndWeights(positions[i], &indices, &weights);
+			for (int j = 0; j < 8; ++j)
+			{
+				sum(indices[j]) += velocities[i][axis] * weights[j];
+				weightSum(indices[j]) += weights[j];
+			}
+		}
+
+		sum.ForEachIndex([&](size_t i, size_t j, size_t k)
+		{
+			const double expected = weightSum(i, j, k) > 0.0
+				? sum(i, j, k) / weightSum(i, j, k) : 0.0;
+			EXPECT_NEAR(expected, actual(i, j, k), 1e-12);
+		});
+	};
+
+	checkComponent(vel->GetUConstAccessor(), vel->GetUOrigin(), 0);
+	checkComponent(vel->GetVConstAccessor(), vel->GetVOrigin(), 1);
+	checkComponent(vel->GetWConstAccessor(), vel->GetWOrigin(), 2);
 }
\ No newline at end of file
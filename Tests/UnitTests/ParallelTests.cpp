@@ -3,9 +3,11 @@
 #include <Core/Array/Array2.h>
 #include <Core/Array/Array3.h>
 #include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
 
 #include <numeric>
 #include <random>
+#include <stdexcept>
 
 using namespace CubbyFlow;
 
@@ -234,6 +236,66 @@ TEST(Parallel, Sort)
 	}
 }
 
+TEST(Parallel, RadixSort)
+{
+	const size_t N = 5000;
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<size_t> smallKeys(0, 300);
+	std::uniform_int_distribution<size_t> largeKeys;
+
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+	for (auto* dist : { &smallKeys, &largeKeys })
+	{
+		std::vector<size_t> keys(N);
+		for (size_t i = 0; i < N; ++i)
+		{
+			keys[i] = (*dist)(rng);
+		}
+
+		// Stable: equal keys keep their value order
+		std::vector<std::pair<size_t, size_t>> expected(N);
+		for (size_t i = 0; i < N; ++i)
+		{
+			expected[i] = std::make_pair(keys[i], i);
+		}
+		std::sort(expected.begin(), expected.end());
+
+		for (unsigned int numThreads : { 1u, 3u, 8u })
+		{
+			SetMaxNumberOfThreads(numThreads);
+
+			std::vector<size_t> sortedKeys = keys;
+			std::vector<size_t> values(N);
+			std::iota(values.begin(), values.end(), ZERO_SIZE);
+
+			ParallelRadixSort(sortedKeys.begin(), sortedKeys.end(), values.begin());
+
+			for (size_t i = 0; i < N; ++i)
+			{
+				EXPECT_EQ(expected[i].first, sortedKeys[i]);
+				EXPECT_EQ(expected[i].second, values[i]);
+			}
+		}
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+
+	std::vector<uint32_t> keys = { 7, 3, 0xffffffff, 3, 0 };
+	std::vector<double> values = { 0.0, 1.0, 2.0, 3.0, 4.0 };
+
+	ParallelRadixSort(keys.begin(), keys.end(), values.begin(), ExecutionPolicy::Serial);
+
+	EXPECT_EQ(std::vector<uint32_t>({ 0, 3, 3, 7, 0xffffffff }), keys);
+	EXPECT_EQ(std::vector<double>({ 4.0, 1.0, 3.0, 0.0, 2.0 }), values);
+
+	std::vector<uint32_t> emptyKeys;
+	std::vector<double> emptyValues;
+	ParallelRadixSort(emptyKeys.begin(), emptyKeys.end(), emptyValues.begin());
+	EXPECT_TRUE(emptyKeys.empty());
+}
+
 TEST(Parallel, Reduce)
 {
 	size_t N = std::max(20u, (3 * NUM_CORES) / 2);
@@ -262,4 +324,370 @@ TEST(Parallel, Reduce)
 
 	int expected = std::accumulate(a.begin(), a.end(), 0);
 	EXPECT_EQ(expected, sum);
-}
\ No newline at end of file
+}
+
+TEST(Parallel, DeterministicReduce)
+{
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+	std::vector<double> a(10007);
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<> d(-1e6, 1e6);
+
+	for (double& v : a)
+	{
+		v = d(rng);
+	}
+
+	const auto sumRange = [&](size_t start, size_t end, double init)
+	{
+		double result = init;
+
+		for (size_t i = start; i < end; ++i)
+		{
+			result += a[i];
+		}
+
+		return result;
+	};
+
+	const double expected = ParallelDeterministicReduce(ZERO_SIZE, a.size(), 0.0,
+		sumRange, std::plus<double>(), ExecutionPolicy::Serial);
+
+	EXPECT_NEAR(std::accumulate(a.begin(), a.end(), 0.0), expected, 1e-4);
+
+	// Bitwise identical for any number of threads
+	for (unsigned int numThreads : { 1u, 2u, 3u, 7u, oldNumThreads })
+	{
+		SetMaxNumberOfThreads(numThreads);
+
+		const double sum = ParallelDeterministicReduce(ZERO_SIZE, a.size(), 0.0,
+			sumRange, std::plus<double>());
+
+		EXPECT_EQ(expected, sum);
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+
+	EXPECT_EQ(3.0, ParallelDeterministicReduce(ZERO_SIZE, ZERO_SIZE, 3.0,
+		sumRange, std::plus<double>()));
+	EXPECT_EQ(a[5], ParallelDeterministicReduce(size_t(5), size_t(6), 0.0,
+		sumRange, std::plus<double>()));
+}
+
+TEST(Parallel, NestedFor)
+{
+	size_t N = std::max(20u, (3 * NUM_CORES) / 2);
+	Array2<size_t> a(N, N);
+
+	ParallelFor(ZERO_SIZE, N, [&](size_t j)
+	{
+		ParallelFor(ZERO_SIZE, N, [&](size_t i)
+		{
+			a(i, j) = i + j * N;
+		});
+	});
+
+	for (size_t j = 0; j < N; ++j)
+	{
+		for (size_t i = 0; i < N; ++i)
+		{
+			EXPECT_EQ(i + j * N, a(i, j));
+		}
+	}
+}
+
+TEST(Parallel, SetMaxNumberOfThreads)
+{
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+	std::vector<int> a(1000);
+	std::iota(a.begin(), a.end(), 0);
+	int expected = std::accumulate(a.begin(), a.end(), 0);
+
+	for (unsigned int numThreads : { 1u, 2u, 3u, 7u, oldNumThreads })
+	{
+		SetMaxNumberOfThreads(numThreads);
+		EXPECT_EQ(std::max(numThreads, 1u), GetMaxNumberOfThreads());
+
+		int sum = ParallelReduce(ZERO_SIZE, a.size(), 0,
+			[&](size_t start, size_t end, int init)
+		{
+			int result = init;
+
+			for (size_t i = start; i < end; ++i)
+			{
+				result += a[i];
+			}
+
+			return result;
+		}, std::plus<int>());
+
+		EXPECT_EQ(expected, sum);
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, ThreadPoolException)
+{
+	ThreadPool pool(4);
+
+	for (size_t throwingTask : { 0u, 1u, 63u })
+	{
+		std::vector<int> visits(64, 0);
+
+		EXPECT_THROW(pool.Run(visits.size(), [&](size_t i)
+		{
+			++visits[i];
+
+			if (i == throwingTask)
+			{
+				throw std::runtime_error("task failed");
+			}
+		}), std::runtime_error);
+
+		// The other tasks of the batch still ran to completion.
+		for (int visit : visits)
+		{
+			EXPECT_EQ(1, visit);
+		}
+	}
+
+	// The pool stays usable after a failed batch.
+	std::atomic<size_t> count{ 0 };
+	pool.Run(100, [&](size_t)
+	{
+		++count;
+	});
+	EXPECT_EQ(100u, count.load());
+}
+
+TEST(Parallel, ThreadPoolResizeFromTask)
+{
+	ThreadPool pool(4);
+
+	EXPECT_THROW(pool.Run(8, [&](size_t)
+	{
+		pool.Resize(2);
+	}), std::logic_error);
+	EXPECT_EQ(4u, pool.NumberOfThreads());
+
+	pool.Resize(2);
+	EXPECT_EQ(2u, pool.NumberOfThreads());
+}
+
+TEST(Parallel, PartitionedFor)
+{
+	size_t N = std::max(1000u, (3 * NUM_CORES) / 2);
+
+	for (PartitionMode mode : { PartitionMode::Static, PartitionMode::Dynamic, PartitionMode::Guided })
+	{
+		for (size_t grainSize : { 0u, 1u, 7u, 64u, 5000u })
+		{
+			std::vector<int> visits(N, 0);
+
+			ParallelFor(ZERO_SIZE, N, [&](size_t i)
+			{
+				++visits[i];
+			}, PartitionPolicy{ mode, grainSize });
+
+			for (size_t i = 0; i < N; ++i)
+			{
+				EXPECT_EQ(1, visits[i]) << i;
+			}
+		}
+	}
+}
+
+TEST(Parallel, PartitionedRangeFor)
+{
+	size_t N = std::max(1000u, (3 * NUM_CORES) / 2);
+
+	for (PartitionMode mode : { PartitionMode::Static, PartitionMode::Dynamic, PartitionMode::Guided })
+	{
+		for (size_t grainSize : { 0u, 1u, 7u, 64u, 5000u })
+		{
+			std::vector<int> visits(N, 0);
+
+			ParallelRangeFor(ZERO_SIZE, N, [&](size_t iBegin, size_t iEnd)
+			{
+				EXPECT_LT(iBegin, iEnd);
+				if (grainSize > 0)
+				{
+#if defined(CUBBYFLOW_TASKING_CPP11THREAD)
+					// Guided chunks only shrink down to the grain size
+					if (mode == PartitionMode::Guided)
+					{
+						if (iEnd < N)
+						{
+							EXPECT_LE(grainSize, iEnd - iBegin);
+						}
+					}
+					else
+					{
+						EXPECT_GE(grainSize, iEnd - iBegin);
+					}
+#else
+					EXPECT_GE(grainSize, iEnd - iBegin);
+#endif
+				}
+
+				for (size_t i = iBegin; i < iEnd; ++i)
+				{
+					++visits[i];
+				}
+			}, PartitionPolicy{ mode, grainSize });
+
+			for (size_t i = 0; i < N; ++i)
+			{
+				EXPECT_EQ(1, visits[i]) << i;
+			}
+		}
+	}
+}
+
+TEST(Parallel, PartitionedFor3D)
+{
+	size_t nX = std::max(20u, (3 * NUM_CORES) / 2);
+	size_t nY = std::max(30u, (3 * NUM_CORES) / 2);
+	size_t nZ = std::max(30u, (3 * NUM_CORES) / 2);
+	Array3<int> a(nX, nY, nZ, 0);
+
+	ParallelFor(
+		ZERO_SIZE, a.Width(),
+		ZERO_SIZE, a.Height(),
+		ZERO_SIZE, a.Depth(),
+		[&](size_t i, size_t j, size_t k)
+	{
+		++a(i, j, k);
+	}, PartitionPolicy{ PartitionMode::Dynamic, 2 });
+
+	a.ForEach([](int val)
+	{
+		EXPECT_EQ(1, val);
+	});
+}
+
+TEST(Parallel, Scatter)
+{
+	const size_t numItems = 10000;
+	const size_t numSlabs = 37;
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<> d(0.0, 1.0);
+	std::uniform_int_distribution<size_t> s(0, numSlabs - 1);
+
+	std::vector<size_t> slabs(numItems);
+	std::vector<double> values(numItems);
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		slabs[i] = s(rng);
+		values[i] = d(rng);
+	}
+
+	auto scatter = [&](ExecutionPolicy policy)
+	{
+		std::vector<double> result(numSlabs + 1, 0.0);
+
+		ParallelScatter(numItems, numSlabs, [&](size_t i)
+		{
+			return slabs[i];
+		}, [&](size_t i)
+		{
+			result[slabs[i]] += values[i];
+			result[slabs[i] + 1] += 0.5 * values[i];
+		}, policy);
+
+		return result;
+	};
+
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+	const std::vector<double> expected = scatter(ExecutionPolicy::Serial);
+
+	for (unsigned int numThreads : { 1u, 2u, 3u, 8u })
+	{
+		SetMaxNumberOfThreads(numThreads);
+
+		// Bit-identical regardless of the number of threads
+		const std::vector<double> result = scatter(ExecutionPolicy::Parallel);
+		for (size_t i = 0; i <= numSlabs; ++i)
+		{
+			EXPECT_EQ(expected[i], result[i]);
+		}
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+}
+
+TEST(Parallel, ScatterMatchesReference)
+{
+	const size_t numItems = 10000;
+	const size_t numSlabs = 37;
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<size_t> s(0, numSlabs - 1);
+	std::uniform_int_distribution<int> d(-100, 100);
+
+	std::vector<size_t> slabs(numItems);
+	std::vector<int> values(numItems);
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		slabs[i] = s(rng);
+		values[i] = d(rng);
+	}
+
+	// Plain serial loop; integer sums do not depend on the visiting order
+	std::vector<int> expected(numSlabs + 1, 0);
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		expected[slabs[i]] += values[i];
+		expected[slabs[i] + 1] += 2 * values[i];
+	}
+
+	const unsigned int oldNumThreads = GetMaxNumberOfThreads();
+
+	for (unsigned int numThreads : { 1u, 2u, 3u, 8u })
+	{
+		SetMaxNumberOfThreads(numThreads);
+
+		std::vector<int> result(numSlabs + 1, 0);
+		std::vector<int> numSlabCalls(numItems, 0);
+		std::vector<size_t> lastVisited(numSlabs, numItems);
+		std::vector<char> isInOrder(numSlabs, 1);
+
+		ParallelScatter(numItems, numSlabs, [&](size_t i)
+		{
+			++numSlabCalls[i];
+			return slabs[i];
+		}, [&](size_t i)
+		{
+			// Items of a slab are visited in increasing order
+			size_t& last = lastVisited[slabs[i]];
+			if (last != numItems && last >= i)
+			{
+				isInOrder[slabs[i]] = 0;
+			}
+			last = i;
+
+			result[slabs[i]] += values[i];
+			result[slabs[i] + 1] += 2 * values[i];
+		});
+
+		for (size_t i = 0; i < numSlabs; ++i)
+		{
+			EXPECT_EQ(1, isInOrder[i]);
+		}
+		for (size_t i = 0; i < numItems; ++i)
+		{
+			EXPECT_EQ(1, numSlabCalls[i]);
+		}
+		for (size_t i = 0; i <= numSlabs; ++i)
+		{
+			EXPECT_EQ(expected[i], result[i]);
+		}
+	}
+
+	SetMaxNumberOfThreads(oldNumThreads);
+}
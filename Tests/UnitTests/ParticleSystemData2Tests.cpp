@@ -2,6 +2,8 @@
 
 #include <Core/Particle/ParticleSystemData2.h>
 
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(ParticleSystemData2, Constructors)
@@ -255,6 +257,71 @@ TEST(ParticleSystemData2, BuildNeighborLists)
 	}
 }
 
+TEST(ParticleSystemData2, SortParticles)
+{
+	std::mt19937 rng{ 0 };
+	std::uniform_real_distribution<> d{ 0.0, 1.0 };
+
+	Array1<Vector2D> positions(200);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = Vector2D(d(rng), d(rng));
+	}
+
+	ParticleSystemData2 particleSystem;
+	particleSystem.AddParticles(positions);
+	const size_t idx = particleSystem.AddScalarData();
+
+	auto attr = particleSystem.ScalarDataAt(idx);
+	for (size_t i = 0; i < attr.size(); ++i)
+	{
+		attr[i] = static_cast<double>(i);
+	}
+
+	const double radius = 0.2;
+	particleSystem.BuildNeighborSearcher(radius);
+	particleSystem.BuildNeighborLists(radius);
+	const auto oldNeighborLists = particleSystem.GetNeighborLists().ToNestedLists();
+
+	particleSystem.SortParticles(0.1);
+
+	const auto& sortedIndices = particleSystem.GetSortedIndices();
+	ASSERT_EQ(positions.size(), sortedIndices.size());
+
+	std::vector<size_t> newIndices(sortedIndices.size());
+	for (size_t i = 0; i < sortedIndices.size(); ++i)
+	{
+		newIndices[sortedIndices[i]] = i;
+	}
+
+	const auto newPositions = particleSystem.GetPositions();
+	const auto newAttr = particleSystem.ScalarDataAt(idx);
+	const auto& neighborLists = particleSystem.GetNeighborLists();
+	ASSERT_EQ(positions.size(), neighborLists.size());
+
+	for (size_t i = 0; i < sortedIndices.size(); ++i)
+	{
+		EXPECT_EQ(positions[sortedIndices[i]], newPositions[i]);
+		EXPECT_EQ(static_cast<double>(sortedIndices[i]), newAttr[i]);
+
+		const auto& oldNeighbors = oldNeighborLists[sortedIndices[i]];
+		const auto neighbors = neighborLists[i];
+		ASSERT_EQ(oldNeighbors.size(), neighbors.size());
+
+		for (size_t j = 0; j < neighbors.size(); ++j)
+		{
+			EXPECT_EQ(newIndices[oldNeighbors[j]], neighbors[j]);
+		}
+	}
+
+	// The searcher follows the new order
+	particleSystem.GetNeighborSearcher()->ForEachNearbyPoint(
+		newPositions[0], radius, [&](size_t j, const Vector2D& pt)
+	{
+		EXPECT_EQ(newPositions[j], pt);
+	});
+}
+
 TEST(ParticleSystemData2, Serialization)
 {
 	ParticleSystemData2 particleSystem;
@@ -1,6 +1,10 @@
 #include "pch.h"
 
 #include <Core/Particle/ParticleSystemData3.h>
+#include <Core/Searcher/PointHashGridSearcher3.h>
+#include <Core/Searcher/PointParallelHashGridSearcher3.h>
+
+#include <random>
 
 using namespace CubbyFlow;
 
@@ -207,6 +211,41 @@ TEST(ParticleSystemData3, BuildNeighborSearcher)
 	}
 }
 
+TEST(ParticleSystemData3, BuildNeighborSearcherKeepsDefaultGrid)
+{
+	ParticleSystemData3 particleSystem;
+	ParticleSystemData3::VectorData positions =
+	{
+		{ 0.1, 0.0, 0.4 },
+		{ 0.6, 0.2, 0.6 },
+		{ 1.0, 0.3, 0.4 },
+		{ 0.9, 0.2, 0.2 }
+	};
+	particleSystem.AddParticles(positions);
+
+	// The grid of the previous build is updated in place
+	const double radius = 0.4;
+	particleSystem.BuildNeighborSearcher(radius);
+	const auto searcher = particleSystem.GetNeighborSearcher();
+	particleSystem.BuildNeighborSearcher(radius);
+	EXPECT_EQ(searcher, particleSystem.GetNeighborSearcher());
+
+	// A grid with other parameters is replaced
+	const auto userSearcher = std::make_shared<PointParallelHashGridSearcher3>(Size3(8, 8, 8), 2.0 * radius);
+	userSearcher->SetMaxChurnRatio(0.1);
+	particleSystem.SetNeighborSearcher(userSearcher);
+	particleSystem.BuildNeighborSearcher(radius);
+	EXPECT_NE(userSearcher, particleSystem.GetNeighborSearcher());
+
+	const auto newSearcher = std::dynamic_pointer_cast<PointParallelHashGridSearcher3>(particleSystem.GetNeighborSearcher());
+	ASSERT_NE(nullptr, newSearcher);
+	EXPECT_EQ(Size3(64, 64, 64), newSearcher->GetResolution());
+	EXPECT_DOUBLE_EQ(2.0 * radius, newSearcher->GetGridSpacing());
+
+	particleSystem.BuildNeighborSearcher(2.0 * radius);
+	EXPECT_NE(newSearcher, particleSystem.GetNeighborSearcher());
+}
+
 TEST(ParticleSystemData3, BuildNeighborLists)
 {
 	ParticleSystemData3 particleSystem;
@@ -256,6 +295,112 @@ TEST(ParticleSystemData3, BuildNeighborLists)
 	}
 }
 
+TEST(ParticleSystemData3, BuildNeighborListsWithHashGridSearcher)
+{
+	ParticleSystemData3 particleSystem;
+	ParticleSystemData3::VectorData positions(200);
+
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<> dist(0.0, 1.0);
+	for (auto& position : positions)
+	{
+		position = Vector3D(dist(rng), dist(rng), dist(rng));
+	}
+	particleSystem.AddParticles(positions);
+
+	// The hash grid searchers build the lists from one batched query
+	const double radius = 0.2;
+	const auto searcher = std::make_shared<PointHashGridSearcher3>(Size3(8, 8, 8), 2.0 * radius);
+	searcher->Build(positions);
+	particleSystem.SetNeighborSearcher(searcher);
+	particleSystem.BuildNeighborLists(radius);
+
+	const auto& neighborLists = particleSystem.GetNeighborLists();
+	EXPECT_EQ(positions.size(), neighborLists.size());
+
+	for (size_t i = 0; i < neighborLists.size(); ++i)
+	{
+		const auto& neighbors = neighborLists[i];
+		size_t numberOfNeighbors = 0;
+
+		for (size_t ii = 0; ii < positions.size(); ++ii)
+		{
+			if (ii != i && positions[ii].DistanceTo(positions[i]) <= radius)
+			{
+				EXPECT_TRUE(neighbors.end() != std::find(neighbors.begin(), neighbors.end(), ii));
+				++numberOfNeighbors;
+			}
+		}
+
+		EXPECT_EQ(numberOfNeighbors, neighbors.size());
+	}
+}
+
+TEST(ParticleSystemData3, SortParticles)
+{
+	std::mt19937 rng{ 0 };
+	std::uniform_real_distribution<> d{ 0.0, 1.0 };
+
+	Array1<Vector3D> positions(200);
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = Vector3D(d(rng), d(rng), d(rng));
+	}
+
+	ParticleSystemData3 particleSystem;
+	particleSystem.AddParticles(positions);
+	const size_t idx = particleSystem.AddScalarData();
+
+	auto attr = particleSystem.ScalarDataAt(idx);
+	for (size_t i = 0; i < attr.size(); ++i)
+	{
+		attr[i] = static_cast<double>(i);
+	}
+
+	const double radius = 0.2;
+	particleSystem.BuildNeighborSearcher(radius);
+	particleSystem.BuildNeighborLists(radius);
+	const auto oldNeighborLists = particleSystem.GetNeighborLists().ToNestedLists();
+
+	particleSystem.SortParticles(0.1);
+
+	const auto& sortedIndices = particleSystem.GetSortedIndices();
+	ASSERT_EQ(positions.size(), sortedIndices.size());
+
+	std::vector<size_t> newIndices(sortedIndices.size());
+	for (size_t i = 0; i < sortedIndices.size(); ++i)
+	{
+		newIndices[sortedIndices[i]] = i;
+	}
+
+	const auto newPositions = particleSystem.GetPositions();
+	const auto newAttr = particleSystem.ScalarDataAt(idx);
+	const auto& neighborLists = particleSystem.GetNeighborLists();
+	ASSERT_EQ(positions.size(), neighborLists.size());
+
+	for (size_t i = 0; i < sortedIndices.size(); ++i)
+	{
+		EXPECT_EQ(positions[sortedIndices[i]], newPositions[i]);
+		EXPECT_EQ(static_cast<double>(sortedIndices[i]), newAttr[i]);
+
+		const auto& oldNeighbors = oldNeighborLists[sortedIndices[i]];
+		const auto neighbors = neighborLists[i];
+		ASSERT_EQ(oldNeighbors.size(), neighbors.size());
+
+		for (size_t j = 0; j < neighbors.size(); ++j)
+		{
+			EXPECT_EQ(newIndices[oldNeighbors[j]], neighbors[j]);
+		}
+	}
+
+	// The searcher follows the new order
+	particleSystem.GetNeighborSearcher()->ForEachNearbyPoint(
+		newPositions[0], radius, [&](size_t j, const Vector3D& pt)
+	{
+		EXPECT_EQ(newPositions[j], pt);
+	});
+}
+
 TEST(ParticleSystemData3, Serialization)
 {
 	ParticleSystemData3 particleSystem;
@@ -2,6 +2,8 @@
 
 #include <Core/Searcher/PointHashGridSearcher3.h>
 
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(PointHashGridSearcher3, ForEachNearByPoint)
@@ -74,4 +76,46 @@ TEST(PointHashGridSearcher3, Build)
 	EXPECT_EQ(21, searcher.GetHashKeyFromBucketIndex(Point3I(1, 1, 37)));
 	EXPECT_EQ(5, searcher.GetHashKeyFromBucketIndex(Point3I(37, 1, 0)));
 	EXPECT_EQ(8, searcher.GetHashKeyFromBucketIndex(Point3I(-104, 374, 0)));
-}
\ No newline at end of file
+}
+
+TEST(PointHashGridSearcher3, FindNearbyPoints)
+{
+	std::mt19937 rng{ 0 };
+	std::uniform_real_distribution<> d{ -1.0, 3.0 };
+
+	Array1<Vector3D> points, origins;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		points.Append(Vector3D(d(rng), d(rng), d(rng)));
+	}
+	for (size_t i = 0; i < 300; ++i)
+	{
+		origins.Append(Vector3D(d(rng), d(rng), d(rng)));
+	}
+
+	PointHashGridSearcher3 searcher(Size3(8, 8, 8), 0.25);
+	searcher.Build(points.Accessor());
+
+	std::vector<size_t> offsets, indices;
+	searcher.FindNearbyPoints(origins.ConstAccessor(), 0.25, &offsets, &indices);
+
+	ASSERT_EQ(origins.size() + 1, offsets.size());
+	EXPECT_EQ(0u, offsets[0]);
+	EXPECT_EQ(indices.size(), offsets.back());
+
+	for (size_t i = 0; i < origins.size(); ++i)
+	{
+		std::vector<size_t> expected;
+		searcher.ForEachNearbyPoint(origins[i], 0.25, [&](size_t j, const Vector3D&)
+		{
+			expected.push_back(j);
+		});
+
+		const std::vector<size_t> actual(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+		EXPECT_EQ(expected, actual);
+	}
+
+	searcher.FindNearbyPoints(ConstArrayAccessor1<Vector3D>(), 0.25, &offsets, &indices);
+	EXPECT_EQ(1u, offsets.size());
+	EXPECT_TRUE(indices.empty());
+}
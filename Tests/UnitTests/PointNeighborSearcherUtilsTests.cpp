@@ -0,0 +1,65 @@
+#include "pch.h"
+
+#include <Core/Searcher/PointNeighborSearcherUtils.h>
+
+#include <algorithm>
+
+using namespace CubbyFlow;
+
+namespace
+{
+	template <typename Searcher>
+	void TestVisitPointNeighborSearcher3(const PointNeighborSearcher3Ptr& searcherPtr)
+	{
+		const PointNeighborSearcher3& searcher = *searcherPtr;
+		const Vector3D origin(0.5, 0.5, 0.5);
+		const double radius = 0.3;
+
+		std::vector<size_t> expected;
+		searcher.ForEachNearbyPoint(origin, radius, [&](size_t i, const Vector3D&)
+		{
+			expected.push_back(i);
+		});
+
+		bool isConcrete = false;
+		std::vector<size_t> actual;
+		VisitPointNeighborSearcher(searcher, [&](const auto& s)
+		{
+			isConcrete = std::is_same<std::decay_t<decltype(s)>, Searcher>::value;
+			s.ForEachNearbyPoint(origin, radius, [&](size_t i, const Vector3D&)
+			{
+				actual.push_back(i);
+			});
+		});
+
+		EXPECT_TRUE(isConcrete);
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		EXPECT_EQ(expected, actual);
+	}
+}
+
+TEST(PointNeighborSearcherUtils, VisitPointNeighborSearcher3)
+{
+	Array1<Vector3D> points = {
+		Vector3D(0.4, 0.5, 0.5), Vector3D(0.9, 0.1, 0.2), Vector3D(0.6, 0.6, 0.4),
+		Vector3D(0.5, 0.3, 0.5), Vector3D(0.0, 0.0, 1.0), Vector3D(0.55, 0.5, 0.45)
+	};
+
+	// Searchers are only seen through the base class, as in the solvers
+	PointNeighborSearcher3Ptr hashGrid = std::make_shared<PointHashGridSearcher3>(4, 4, 4, 0.6);
+	hashGrid->Build(points);
+	TestVisitPointNeighborSearcher3<PointHashGridSearcher3>(hashGrid);
+
+	PointNeighborSearcher3Ptr parallelHashGrid = std::make_shared<PointParallelHashGridSearcher3>(4, 4, 4, 0.6);
+	parallelHashGrid->Build(points);
+	TestVisitPointNeighborSearcher3<PointParallelHashGridSearcher3>(parallelHashGrid);
+
+	PointNeighborSearcher3Ptr kdTree = std::make_shared<PointKdTreeSearcher3>();
+	kdTree->Build(points);
+	TestVisitPointNeighborSearcher3<PointKdTreeSearcher3>(kdTree);
+
+	PointNeighborSearcher3Ptr simpleList = std::make_shared<PointSimpleListSearcher3>();
+	simpleList->Build(points);
+	TestVisitPointNeighborSearcher3<PointSimpleListSearcher3>(simpleList);
+}
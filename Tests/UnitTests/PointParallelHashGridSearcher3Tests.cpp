@@ -2,6 +2,9 @@
 
 #include <Core/Searcher/PointParallelHashGridSearcher3.h>
 
+#include <algorithm>
+#include <random>
+
 using namespace CubbyFlow;
 
 TEST(PointParallelHashGridSearcher3, ForEachNearByPoint)
@@ -126,4 +129,111 @@ TEST(PointParallelHashGridSearcher3, Serialization)
 	});
 
 	EXPECT_EQ(2, cnt);
-}
\ No newline at end of file
+}
+
+TEST(PointParallelHashGridSearcher3, FindNearbyPoints)
+{
+	std::mt19937 rng{ 0 };
+	std::uniform_real_distribution<> d{ -1.0, 3.0 };
+
+	Array1<Vector3D> points, origins;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		points.Append(Vector3D(d(rng), d(rng), d(rng)));
+	}
+	for (size_t i = 0; i < 300; ++i)
+	{
+		origins.Append(Vector3D(d(rng), d(rng), d(rng)));
+	}
+
+	PointParallelHashGridSearcher3 searcher(Size3(8, 8, 8), 0.25);
+	searcher.Build(points.Accessor());
+
+	std::vector<size_t> offsets, indices;
+	searcher.FindNearbyPoints(origins.ConstAccessor(), 0.25, &offsets, &indices);
+
+	ASSERT_EQ(origins.size() + 1, offsets.size());
+	EXPECT_EQ(0u, offsets[0]);
+	EXPECT_EQ(indices.size(), offsets.back());
+
+	for (size_t i = 0; i < origins.size(); ++i)
+	{
+		std::vector<size_t> expected;
+		searcher.ForEachNearbyPoint(origins[i], 0.25, [&](size_t j, const Vector3D&)
+		{
+			expected.push_back(j);
+		});
+
+		const std::vector<size_t> actual(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+		EXPECT_EQ(expected, actual);
+	}
+
+	searcher.FindNearbyPoints(ConstArrayAccessor1<Vector3D>(), 0.25, &offsets, &indices);
+	EXPECT_EQ(1u, offsets.size());
+	EXPECT_TRUE(indices.empty());
+}
+
+TEST(PointParallelHashGridSearcher3, IncrementalBuild)
+{
+	std::mt19937 rng{ 0 };
+	std::uniform_real_distribution<> d{ 0.0, 2.0 };
+	std::uniform_real_distribution<> jitter{ -0.05, 0.05 };
+
+	Array1<Vector3D> points;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		points.Append(Vector3D(d(rng), d(rng), d(rng)));
+	}
+
+	PointParallelHashGridSearcher3 searcher(Size3(8, 8, 8), 0.25);
+	searcher.SetMaxChurnRatio(0.5);
+	EXPECT_DOUBLE_EQ(0.5, searcher.GetMaxChurnRatio());
+
+	searcher.Build(points.Accessor());
+	EXPECT_EQ(1u, searcher.GetNumberOfFullBuilds());
+	EXPECT_EQ(0u, searcher.GetNumberOfIncrementalUpdates());
+
+	// Small moves: a few points change bucket
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		points[i] += Vector3D(jitter(rng), jitter(rng), jitter(rng));
+	}
+
+	searcher.Build(points.Accessor());
+	EXPECT_EQ(1u, searcher.GetNumberOfFullBuilds());
+	EXPECT_EQ(1u, searcher.GetNumberOfIncrementalUpdates());
+
+	PointParallelHashGridSearcher3 reference(Size3(8, 8, 8), 0.25);
+	reference.Build(points.Accessor());
+
+	EXPECT_EQ(reference.Keys(), searcher.Keys());
+	EXPECT_EQ(reference.StartIndexTable(), searcher.StartIndexTable());
+	EXPECT_EQ(reference.EndIndexTable(), searcher.EndIndexTable());
+
+	for (size_t i = 0; i < points.size(); i += 10)
+	{
+		std::vector<size_t> expected, actual;
+		reference.ForEachNearbyPoint(points[i], 0.25, [&](size_t j, const Vector3D&)
+		{
+			expected.push_back(j);
+		});
+		searcher.ForEachNearbyPoint(points[i], 0.25, [&](size_t j, const Vector3D&)
+		{
+			actual.push_back(j);
+		});
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		EXPECT_EQ(expected, actual);
+	}
+
+	// Large moves: falls back to the full build
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		points[i] = Vector3D(d(rng), d(rng), d(rng));
+	}
+
+	searcher.Build(points.Accessor());
+	EXPECT_EQ(2u, searcher.GetNumberOfFullBuilds());
+	EXPECT_EQ(1u, searcher.GetNumberOfIncrementalUpdates());
+}
@@ -1,7 +1,10 @@
 #include "pch.h"
+#include "UnitTestsUtils.h"
 
+#include <Core/Array/Array1.h>
 #include <Core/Collider/RigidBodyCollider3.h>
 #include <Core/Geometry/Plane3.h>
+#include <Core/Geometry/TriangleMesh3.h>
 
 using namespace CubbyFlow;
 
@@ -102,6 +105,48 @@ TEST(RigidBodyCollider3, ResolveCollision)
 	}
 }
 
+TEST(RigidBodyCollider3, ResolveCollisions)
+{
+	std::string objStr = GetSphereTriMesh5x5Obj();
+	std::istringstream objStream(objStr);
+
+	auto mesh = std::make_shared<TriangleMesh3>();
+	mesh->ReadObj(&objStream);
+
+	const Surface3Ptr surfaces[] = { mesh, std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, 0, 0)) };
+	for (const Surface3Ptr& surface : surfaces)
+	{
+		RigidBodyCollider3 collider(surface);
+		collider.linearVelocity = { 0.5, -1, 0 };
+		collider.SetFrictionCoefficient(0.3);
+
+		const size_t numSamples = GetNumberOfSamplePoints3();
+		Array1<Vector3D> positions(numSamples);
+		Array1<Vector3D> velocities(numSamples);
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			positions[i] = 0.5 * GetSamplePoints3()[i];
+			velocities[i] = GetSampleDirs3()[i];
+		}
+
+		Array1<Vector3D> expectedPositions(positions);
+		Array1<Vector3D> expectedVelocities(velocities);
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			collider.ResolveCollision(0.05, 0.5, &expectedPositions[i], &expectedVelocities[i]);
+		}
+
+		collider.ResolveCollisions(0.05, 0.5, positions.Accessor(), velocities.Accessor());
+
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			EXPECT_VECTOR3_NEAR(expectedPositions[i], positions[i], 1e-12);
+			EXPECT_VECTOR3_NEAR(expectedVelocities[i], velocities[i], 1e-9);
+		}
+	}
+}
+
 TEST(RigidBodyCollider3, VelocityAt)
 {
 	RigidBodyCollider3 collider(std::make_shared<Plane3>(Vector3D(0, 1, 0), Vector3D(0, 0, 0)));
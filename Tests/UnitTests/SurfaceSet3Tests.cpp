@@ -408,4 +408,52 @@ TEST(SurfaceSet3, BoundingBox)
 
 	EXPECT_BOUNDING_BOX3_NEAR(answer, debug, 1e-9);
 	EXPECT_BOUNDING_BOX3_NEAR(answer, sset2.BoundingBox(), 1e-9);
-}
\ No newline at end of file
+}
+
+TEST(SurfaceSet3, MovingSurfaces)
+{
+	SurfaceSet3 sset;
+	std::vector<Sphere3Ptr> spheres;
+
+	size_t numSamples = GetNumberOfSamplePoints3();
+	for (size_t i = 0; i < numSamples / 2; ++i)
+	{
+		auto sph = Sphere3::Builder()
+			.WithRadius(0.05)
+			.WithCenter(GetSamplePoints3()[i])
+			.MakeShared();
+		sset.AddSurface(sph);
+		spheres.push_back(sph);
+	}
+
+	sset.UpdateQueryEngine();
+
+	// Moves the spheres, which the set only notices on the update
+	for (size_t i = 0; i < spheres.size(); ++i)
+	{
+		spheres[i]->transform = Transform3(GetSampleDirs3()[i], QuaternionD());
+	}
+
+	sset.UpdateQueryEngine();
+
+	BoundingBox3D answer;
+	for (const auto& sph : spheres)
+	{
+		answer.Merge(sph->BoundingBox());
+	}
+
+	EXPECT_BOUNDING_BOX3_NEAR(answer, sset.BoundingBox(), 1e-9);
+
+	for (size_t i = numSamples / 2; i < numSamples; ++i)
+	{
+		const Vector3D& pt = GetSamplePoints3()[i];
+
+		double minDist = std::numeric_limits<double>::max();
+		for (const auto& sph : spheres)
+		{
+			minDist = std::min(minDist, sph->ClosestDistance(pt));
+		}
+
+		EXPECT_DOUBLE_EQ(minDist, sset.ClosestDistance(pt));
+	}
+}
@@ -1,7 +1,12 @@
 #include "pch.h"
 #include "UnitTestsUtils.h"
 
+#include <Core/Array/Array3.h>
 #include <Core/Geometry/TriangleMesh3.h>
+#include <Core/MarchingCubes/MarchingCubes.h>
+
+#include <cstdio>
+#include <fstream>
 
 using namespace CubbyFlow;
 
@@ -28,6 +33,231 @@ TEST(TriangleMesh3, ReadObj)
 	EXPECT_EQ(108u, mesh.NumberOfTriangles());
 }
 
+TEST(TriangleMesh3, ReadObjPolygons)
+{
+	// Comments, CRLF line endings, polygons and negative indices
+	std::string objStr =
+		"# polygons\r\n"
+		"o polygons\r\n"
+		"v 0 0 0\r\n"
+		"v 1 0 0\r\n"
+		"v 1 1 0\r\n"
+		"  v 0 1 0 1.0\r\n"
+		"vn 0 0 1\r\n"
+		"g quad\r\n"
+		"s off\r\n"
+		"f 1//1 2//1 3//1 4//1 # quad\r\n"
+		"v 0.5 1.5e0 -0\r\n"
+		"f -5//-1 -4//1 -3//1 -1//1 -2//1\r\n";
+	std::istringstream objStream(objStr);
+
+	TriangleMesh3 mesh;
+	EXPECT_TRUE(mesh.ReadObj(&objStream));
+
+	EXPECT_EQ(5u, mesh.NumberOfPoints());
+	EXPECT_EQ(1u, mesh.NumberOfNormals());
+	EXPECT_EQ(0u, mesh.NumberOfUVs());
+	ASSERT_EQ(5u, mesh.NumberOfTriangles());
+
+	EXPECT_VECTOR3_EQ(Vector3D(0, 1, 0), mesh.Point(3));
+	EXPECT_VECTOR3_EQ(Vector3D(0.5, 1.5, 0), mesh.Point(4));
+
+	const Point3UI expected[] = { { 0, 1, 2 }, { 0, 2, 3 }, { 0, 1, 2 }, { 0, 2, 4 }, { 0, 4, 3 } };
+	for (size_t i = 0; i < 5; ++i)
+	{
+		EXPECT_EQ(expected[i], mesh.PointIndex(i));
+		EXPECT_EQ(Point3UI(0, 0, 0), mesh.NormalIndex(i));
+	}
+
+	// Invalid files leave the mesh unchanged
+	for (const char* invalidStr : { "v 0 0 0\nf 1 1\n", "v 0 0\n", "v 0 0 0\nf 1 2 3\n", "v 0 0 0\nf 1 1 x\n" })
+	{
+		std::istringstream invalidStream(invalidStr);
+		EXPECT_FALSE(mesh.ReadObj(&invalidStream));
+		EXPECT_EQ(5u, mesh.NumberOfPoints());
+		EXPECT_EQ(5u, mesh.NumberOfTriangles());
+	}
+
+	// The indices of an appended mesh are offset
+	std::istringstream appendStream("v 2 0 0\nv 3 0 0\nv 2 1 0\nf 1 2 3\n");
+	EXPECT_TRUE(mesh.ReadObj(&appendStream));
+	EXPECT_EQ(8u, mesh.NumberOfPoints());
+	EXPECT_EQ(Point3UI(5, 6, 7), mesh.PointIndex(5));
+}
+
+TEST(TriangleMesh3, ReadObjFile)
+{
+	// Large enough to be split into several chunks
+	Array3<double> sphere(40, 40, 40);
+	sphere.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		sphere(i, j, k) = (Vector3D(i, j, k) - Vector3D(19.5, 19.5, 19.5)).Length() - 15.0;
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(sphere, Vector3D(1, 1, 1), Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+
+	const std::string fileName = "TriangleMesh3ReadObjFile.obj";
+	{
+		std::ofstream file(fileName);
+		file.precision(17);
+		mesh.WriteObj(&file);
+	}
+
+	TriangleMesh3 mesh2;
+	EXPECT_TRUE(mesh2.ReadObj(fileName));
+	std::remove(fileName.c_str());
+
+	ASSERT_EQ(mesh.NumberOfPoints(), mesh2.NumberOfPoints());
+	ASSERT_EQ(mesh.NumberOfNormals(), mesh2.NumberOfNormals());
+	ASSERT_EQ(mesh.NumberOfUVs(), mesh2.NumberOfUVs());
+	ASSERT_EQ(mesh.NumberOfTriangles(), mesh2.NumberOfTriangles());
+
+	for (size_t i = 0; i < mesh.NumberOfPoints(); ++i)
+	{
+		EXPECT_EQ(mesh.Point(i), mesh2.Point(i));
+		EXPECT_EQ(mesh.Normal(i), mesh2.Normal(i));
+	}
+
+	for (size_t i = 0; i < mesh.NumberOfTriangles(); ++i)
+	{
+		EXPECT_EQ(mesh.PointIndex(i), mesh2.PointIndex(i));
+		EXPECT_EQ(mesh.NormalIndex(i), mesh2.NormalIndex(i));
+		EXPECT_EQ(mesh.UVIndex(i), mesh2.UVIndex(i));
+	}
+
+	TriangleMesh3 mesh3;
+	EXPECT_FALSE(mesh3.ReadObj(std::string("NotExistingFile.obj")));
+}
+
+TEST(TriangleMesh3, WritePlyAndReadPly)
+{
+	Array3<double> sphere(12, 12, 12);
+	sphere.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		sphere(i, j, k) = (Vector3D(i, j, k) - Vector3D(5.5, 5.5, 5.5)).Length() - 4.0;
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(sphere, Vector3D(0.1, 0.1, 0.1), Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+
+	const std::string fileName = "TriangleMesh3WritePly.ply";
+	EXPECT_TRUE(mesh.WritePly(fileName));
+
+	TriangleMesh3 mesh2;
+	EXPECT_TRUE(mesh2.ReadPly(fileName));
+	std::remove(fileName.c_str());
+
+	ASSERT_EQ(mesh.NumberOfPoints(), mesh2.NumberOfPoints());
+	ASSERT_EQ(mesh.NumberOfNormals(), mesh2.NumberOfNormals());
+	ASSERT_EQ(mesh.NumberOfUVs(), mesh2.NumberOfUVs());
+	ASSERT_EQ(mesh.NumberOfTriangles(), mesh2.NumberOfTriangles());
+
+	for (size_t i = 0; i < mesh.NumberOfPoints(); ++i)
+	{
+		EXPECT_EQ(mesh.Point(i), mesh2.Point(i));
+		EXPECT_EQ(mesh.Normal(i), mesh2.Normal(i));
+		EXPECT_EQ(mesh.UV(i), mesh2.UV(i));
+	}
+
+	for (size_t i = 0; i < mesh.NumberOfTriangles(); ++i)
+	{
+		EXPECT_EQ(mesh.PointIndex(i), mesh2.PointIndex(i));
+		EXPECT_EQ(mesh.NormalIndex(i), mesh2.NormalIndex(i));
+		EXPECT_EQ(mesh.UVIndex(i), mesh2.UVIndex(i));
+	}
+
+	// The normals and UVs of the cube are not indexed as its points
+	std::istringstream objStream(GetCubeTriMesh3x3x3Obj());
+	TriangleMesh3 cube;
+	cube.ReadObj(&objStream);
+
+	std::stringstream plyStream;
+	cube.WritePly(&plyStream);
+
+	TriangleMesh3 cube2;
+	EXPECT_TRUE(cube2.ReadPly(&plyStream));
+	EXPECT_EQ(cube.NumberOfPoints(), cube2.NumberOfPoints());
+	EXPECT_EQ(0u, cube2.NumberOfNormals());
+	EXPECT_EQ(0u, cube2.NumberOfUVs());
+	EXPECT_EQ(cube.NumberOfTriangles(), cube2.NumberOfTriangles());
+	EXPECT_DOUBLE_EQ(cube.Area(), cube2.Area());
+}
+
+TEST(TriangleMesh3, ReadPlyBigEndian)
+{
+	std::string plyStr =
+		"ply\n"
+		"format binary_big_endian 1.0\n"
+		"comment quad with an extra edge element\n"
+		"element vertex 4\n"
+		"property float x\n"
+		"property float y\n"
+		"property float z\n"
+		"property uchar red\n"
+		"element face 1\n"
+		"property uchar flags\n"
+		"property list uchar uint vertex_indices\n"
+		"element edge 1\n"
+		"property int vertex1\n"
+		"property int vertex2\n"
+		"end_header\n";
+
+	const auto appendBigEndian = [&](const void* value, size_t size)
+	{
+		const uint16_t one = 1;
+		const bool isLittleEndian = (*reinterpret_cast<const uint8_t*>(&one) == 1);
+		const char* bytes = static_cast<const char*>(value);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			plyStr += bytes[isLittleEndian ? size - 1 - i : i];
+		}
+	};
+
+	const float positions[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+	for (const auto& position : positions)
+	{
+		for (float value : position)
+		{
+			appendBigEndian(&value, sizeof(value));
+		}
+		plyStr += static_cast<char>(255);
+	}
+
+	plyStr += static_cast<char>(7);
+	plyStr += static_cast<char>(4);
+	for (uint32_t index : { 0u, 1u, 2u, 3u })
+	{
+		appendBigEndian(&index, sizeof(index));
+	}
+
+	for (int32_t index : { 0, 2 })
+	{
+		appendBigEndian(&index, sizeof(index));
+	}
+
+	std::istringstream plyStream(plyStr);
+	TriangleMesh3 mesh;
+	EXPECT_TRUE(mesh.ReadPly(&plyStream));
+
+	ASSERT_EQ(4u, mesh.NumberOfPoints());
+	EXPECT_EQ(0u, mesh.NumberOfNormals());
+	ASSERT_EQ(2u, mesh.NumberOfTriangles());
+	EXPECT_VECTOR3_EQ(Vector3D(1, 1, 0), mesh.Point(2));
+	EXPECT_EQ(Point3UI(0, 1, 2), mesh.PointIndex(0));
+	EXPECT_EQ(Point3UI(0, 2, 3), mesh.PointIndex(1));
+	EXPECT_DOUBLE_EQ(1.0, mesh.Area());
+
+	// Truncated data leaves the mesh unchanged
+	std::istringstream truncatedStream(plyStr.substr(0, plyStr.size() - 10));
+	EXPECT_FALSE(mesh.ReadPly(&truncatedStream));
+	EXPECT_EQ(4u, mesh.NumberOfPoints());
+
+	std::istringstream asciiStream("ply\nformat ascii 1.0\nelement vertex 0\nend_header\n");
+	EXPECT_FALSE(mesh.ReadPly(&asciiStream));
+}
+
 TEST(TriangleMesh3, ClosestPoint)
 {
 	std::string objStr = GetCubeTriMesh3x3x3Obj();
@@ -213,6 +443,116 @@ TEST(TriangleMesh3, ClosestIntersection)
 	}
 }
 
+TEST(TriangleMesh3, BatchedQueries)
+{
+	// A smooth mesh, whose normals at the shared vertices and edges do not
+	// depend on the triangle
+	Array3<double> sphere(16, 16, 16);
+	sphere.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		sphere(i, j, k) = (Vector3D(i, j, k) / 15.0 - Vector3D(0.5, 0.5, 0.5)).Length() - 0.4;
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(sphere, Vector3D(1, 1, 1) / 15.0, Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+	mesh.transform = Transform3(Vector3D(0.1, -0.2, 0.3), QuaternionD(Vector3D(1, 2, 3).Normalized(), 0.4));
+	mesh.isNormalFlipped = true;
+
+	size_t numSamples = GetNumberOfSamplePoints3();
+	Array1<Vector3D> points(numSamples);
+	Array1<Ray3D> rays(numSamples);
+
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		points[i] = GetSamplePoints3()[i];
+		rays[i] = Ray3D(GetSamplePoints3()[i], GetSampleDirs3()[i]);
+	}
+
+	Array1<Vector3D> closestPoints(numSamples);
+	Array1<Vector3D> closestNormals(numSamples);
+	Array1<double> closestDistances(numSamples);
+	Array1<SurfaceRayIntersection3> closestIntersections(numSamples);
+
+	mesh.ClosestPoints(points.ConstAccessor(), closestPoints.Accessor());
+	mesh.ClosestNormals(points.ConstAccessor(), closestNormals.Accessor());
+	mesh.ClosestDistances(points.ConstAccessor(), closestDistances.Accessor());
+	mesh.ClosestIntersections(rays.ConstAccessor(), closestIntersections.Accessor());
+
+	Array1<Vector3D> combinedPoints(numSamples);
+	Array1<Vector3D> combinedNormals(numSamples);
+	Array1<double> combinedDistances(numSamples);
+	mesh.ClosestPointsAndNormals(points.ConstAccessor(), combinedPoints.Accessor(), combinedNormals.Accessor(), combinedDistances.Accessor());
+
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		EXPECT_VECTOR3_NEAR(mesh.ClosestPoint(points[i]), closestPoints[i], 1e-12);
+		EXPECT_VECTOR3_NEAR(mesh.ClosestNormal(points[i]), closestNormals[i], 1e-9);
+		EXPECT_NEAR(mesh.ClosestDistance(points[i]), closestDistances[i], 1e-12);
+
+		EXPECT_VECTOR3_EQ(closestPoints[i], combinedPoints[i]);
+		EXPECT_VECTOR3_EQ(closestNormals[i], combinedNormals[i]);
+		EXPECT_DOUBLE_EQ(closestDistances[i], combinedDistances[i]);
+
+		auto expected = mesh.ClosestIntersection(rays[i]);
+		EXPECT_DOUBLE_EQ(expected.distance, closestIntersections[i].distance);
+		EXPECT_VECTOR3_EQ(expected.point, closestIntersections[i].point);
+		EXPECT_VECTOR3_EQ(expected.normal, closestIntersections[i].normal);
+		EXPECT_EQ(expected.isIntersecting, closestIntersections[i].isIntersecting);
+	}
+}
+
+TEST(TriangleMesh3, MovingPoints)
+{
+	std::string objStr = GetSphereTriMesh5x5Obj();
+	std::istringstream objStream(objStr);
+
+	TriangleMesh3 mesh;
+	mesh.ReadObj(&objStream);
+	mesh.UpdateQueryEngine();
+
+	const auto bruteForceSearch = [&](const Vector3D& pt)
+	{
+		double minDist = std::numeric_limits<double>::max();
+
+		for (size_t i = 0; i < mesh.NumberOfTriangles(); ++i)
+		{
+			minDist = std::min(minDist, mesh.Triangle(i).ClosestDistance(pt));
+		}
+
+		return minDist;
+	};
+
+	const auto expectValidQueries = [&]()
+	{
+		BoundingBox3D expectedBound;
+		for (size_t i = 0; i < mesh.NumberOfPoints(); ++i)
+		{
+			expectedBound.Merge(static_cast<const TriangleMesh3&>(mesh).Point(i));
+		}
+
+		EXPECT_BOUNDING_BOX3_EQ(expectedBound, mesh.BoundingBox());
+
+		size_t numSamples = GetNumberOfSamplePoints3();
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			EXPECT_DOUBLE_EQ(bruteForceSearch(GetSamplePoints3()[i]), mesh.ClosestDistance(GetSamplePoints3()[i]));
+		}
+	};
+
+	// Deforms the mesh point by point
+	for (size_t i = 0; i < mesh.NumberOfPoints(); ++i)
+	{
+		Vector3D& pt = mesh.Point(i);
+		pt = Vector3D(1.5 * pt.x, pt.y + 0.3 * pt.x * pt.x, pt.z);
+	}
+	expectValidQueries();
+
+	mesh.Translate(Vector3D(0.2, -0.1, 0.4));
+	mesh.Rotate(QuaternionD(Vector3D(1, 1, 0).Normalized(), 0.7));
+	mesh.Scale(2.0);
+	expectValidQueries();
+}
+
 TEST(TriangleMesh3, BoundingBox)
 {
 	std::string objStr = GetCubeTriMesh3x3x3Obj();
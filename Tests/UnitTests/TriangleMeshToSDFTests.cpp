@@ -0,0 +1,66 @@
+#include "pch.h"
+
+#include <Core/Array/Array3.h>
+#include <Core/Geometry/TriangleMeshToSDF.h>
+#include <Core/Grid/CellCenteredScalarGrid3.h>
+#include <Core/Grid/VertexCenteredScalarGrid3.h>
+#include <Core/MarchingCubes/MarchingCubes.h>
+
+using namespace CubbyFlow;
+
+TEST(TriangleMeshToSDF, Sphere)
+{
+	Array3<double> sphere(21, 21, 21);
+	sphere.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		sphere(i, j, k) = (Vector3D(i, j, k) * 0.1 - Vector3D(1, 1, 1)).Length() - 0.7;
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(sphere, Vector3D(0.1, 0.1, 0.1), Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+
+	VertexCenteredScalarGrid3 grid(32, 32, 32, 1.0 / 16, 1.0 / 16, 1.0 / 16);
+	TriangleMeshToSDF(mesh, &grid);
+
+	grid.ForEachDataPointIndex([&](size_t i, size_t j, size_t k)
+	{
+		const double expected = (grid.GetDataPosition()(i, j, k) - Vector3D(1, 1, 1)).Length() - 0.7;
+		EXPECT_NEAR(expected, grid(i, j, k), 0.02);
+	});
+}
+
+TEST(TriangleMeshToSDF, ParallelMatchesSerial)
+{
+	Array3<double> surface(30, 34, 38);
+	surface.ForEachIndex([&](size_t i, size_t j, size_t k)
+	{
+		const Vector3D x(0.05 * i, 0.05 * j, 0.05 * k);
+		surface(i, j, k) = (x - Vector3D(0.7, 0.8, 0.9)).Length() - 0.6 + 0.1 * std::sin(9.0 * x.x) * std::cos(7.0 * x.y);
+	});
+
+	TriangleMesh3 mesh;
+	MarchingCubes(surface, Vector3D(0.05, 0.05, 0.05), Vector3D(), &mesh, 0.0, DIRECTION_NONE);
+
+	for (unsigned int exactBand : { 1u, 3u })
+	{
+		VertexCenteredScalarGrid3 serialGrid(41, 37, 45, 0.04, 0.04, 0.04, -0.1, -0.05, 0.0);
+		VertexCenteredScalarGrid3 parallelGrid(serialGrid);
+		TriangleMeshToSDF(mesh, &serialGrid, exactBand, ExecutionPolicy::Serial);
+		TriangleMeshToSDF(mesh, &parallelGrid, exactBand, ExecutionPolicy::Parallel);
+
+		serialGrid.ForEachDataPointIndex([&](size_t i, size_t j, size_t k)
+		{
+			EXPECT_EQ(serialGrid(i, j, k), parallelGrid(i, j, k));
+		});
+
+		CellCenteredScalarGrid3 serialCells(23, 29, 17, 0.07, 0.07, 0.07, -0.2, 0.0, -0.1);
+		CellCenteredScalarGrid3 parallelCells(serialCells);
+		TriangleMeshToSDF(mesh, &serialCells, exactBand, ExecutionPolicy::Serial);
+		TriangleMeshToSDF(mesh, &parallelCells, exactBand, ExecutionPolicy::Parallel);
+
+		serialCells.ForEachDataPointIndex([&](size_t i, size_t j, size_t k)
+		{
+			EXPECT_EQ(serialCells(i, j, k), parallelCells(i, j, k));
+		});
+	}
+}